@@ -20,9 +20,15 @@ tests.CONFIG = recursive
 tests.recurse = tests
 tests.depends = geometry
 
-QMAKE_EXTRA_TARGETS += src plugins tests
+benchmark.target = benchmark
+benchmark.CONFIG = recursive
+benchmark.recurse = benchmark
+benchmark.depends = src plugins
+
+QMAKE_EXTRA_TARGETS += src plugins tests benchmark
 SUBDIRS = geometry \
 src \
           plugins \
-          tests
+          tests \
+          benchmark
             
\ No newline at end of file
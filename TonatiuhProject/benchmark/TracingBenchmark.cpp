@@ -0,0 +1,709 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+/*!
+ * Tonatiuh tracing throughput benchmark.
+ *
+ * Traces a fixed number of rays through a set of reference scenes and reports, for each
+ * scene and number of threads, the traced rays per second, the stored photons per second,
+ * the scaling efficiency with respect to the single thread run and the process peak resident
+ * set size.
+ *
+ * The reference scenes are the tests/SolarFurnace_normal.tnh model and heliostat fields
+ * generated with the Heliostat_Field_Component plugin. Every run uses the "Not export" photon map export mode.
+ * The rays are traced in chunks and each chunk has its own Mersenne Twister generator, seeded from -seed and the
+ * chunk number. The traced rays, and the stored photons, are the same for any number of threads. The -packet option
+ * sets the number of primary rays intersected together as a packet, 1 traces each ray alone. The -bands
+ * option traces the rays with the sun power split in n equal wavelength bands, 0 is not a spectral trace.
+ * With -attenuation 1 the atmospheric attenuation multiplies the power of the rays instead of killing them and with
+ * -attenuation 2 it is not computed during the trace, the photons store their path length to apply it afterwards.
+ *
+ * Each scene is traced in its own process, started with the internal -scene option, so that the peak resident set
+ * size of a scene does not include the memory of the previous scenes. The -scene value is 0 for the model and the
+ * number of heliostats for a field.
+ *
+ * Usage:
+ * \verbatim
+   TracingBenchmark [-rays n] [-threads n] [-seed n] [-packet n] [-bands n] [-attenuation n] [-heliostats n1,n2,...] [-model file.tnh]
+   \endverbatim
+ */
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#if defined( WIN32 )
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QMutex>
+#include <QPair>
+#include <QProcess>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <QVariant>
+#include <QVector>
+
+#include <Inventor/Qt/SoQt.h>
+#include <Inventor/SoOutput.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/actions/SoWriteAction.h>
+#include <Inventor/nodekits/SoNodeKitListPart.h>
+#include <Inventor/nodes/SoTransform.h>
+
+#include "gc.h"
+
+#include "BBox.h"
+#include "Document.h"
+#include "InstanceNode.h"
+#include "Matrix4x4.h"
+#include "PhotonMapExport.h"
+#include "PhotonMapExportFactory.h"
+#include "PluginManager.h"
+#include "RandomMersenneTwister.h"
+#include "RayTracer.h"
+#include "RayTracerNoTr.h"
+#include "SceneModel.h"
+#include "TAnalyzerKit.h"
+#include "TAnalyzerLevel.h"
+#include "TAnalyzerParameter.h"
+#include "TAnalyzerResult.h"
+#include "TAnalyzerResultKit.h"
+#include "TComponentFactory.h"
+#include "TCube.h"
+#include "TDefaultMaterial.h"
+#include "TDefaultSunShape.h"
+#include "TDefaultTracker.h"
+#include "TDefaultTransmissivity.h"
+#include "tgf.h"
+#include "Timer.h"
+#include "TLightKit.h"
+#include "TLightShape.h"
+#include "TMaterial.h"
+#include "TPhotonMap.h"
+#include "trf.h"
+#include "TSceneKit.h"
+#include "TSceneTracker.h"
+#include "TSeparatorKit.h"
+#include "TShape.h"
+#include "TShapeKit.h"
+#include "TSquare.h"
+#include "TSunShape.h"
+#include "TTrackerForAiming.h"
+#include "TTracker.h"
+#include "TTransmissivity.h"
+
+struct BenchmarkOptions
+{
+	unsigned long numberOfRays;
+	int maximumThreads;
+	unsigned long seed;
+	int packetSize;
+	int numberOfBands;
+	int attenuationMode;
+	QVector< int > fieldSizes;
+	QString modelFileName;
+	int scene;
+};
+
+//! Rays traced with their own generator.
+struct TraceChunk
+{
+	double numberOfRays;
+	unsigned long seed;
+};
+
+struct BenchmarkRun
+{
+	double time;
+	unsigned long photons;
+};
+
+const int lightWidthDivisions = 200;
+const int lightHeightDivisions = 200;
+const unsigned long photonBufferSize = 5000000;
+const double heliostatSpacing = 12.0;
+const double towerHeight = 150.0;
+const long int chunkRandomNumbers = 100000;
+
+/*!
+ * Returns the maximum resident set size of the process in MB. As each scene is traced in its own process, it is the
+ * peak of the runs of the scene up to this one.
+ */
+double PeakResidentSetSize()
+{
+#if defined( WIN32 )
+	PROCESS_MEMORY_COUNTERS counters;
+	if( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )	return 0.0;
+	return counters.PeakWorkingSetSize / ( 1024.0 * 1024.0 );
+#else
+	struct rusage usage;
+	if( getrusage( RUSAGE_SELF, &usage ) != 0 )	return 0.0;
+	#if defined( __APPLE__ )
+		return usage.ru_maxrss / ( 1024.0 * 1024.0 );
+	#else
+		return usage.ru_maxrss / 1024.0;
+	#endif
+#endif
+}
+
+/*!
+ * Reads the benchmark options from the command line arguments.
+ */
+bool ReadOptions( QStringList arguments, BenchmarkOptions* options )
+{
+	options->numberOfRays = 1000000;
+	options->maximumThreads = QThread::idealThreadCount();
+	options->seed = 5489UL;
+	options->packetSize = 1;
+	options->numberOfBands = 0;
+	options->attenuationMode = 0;
+	options->fieldSizes<< 1000 << 10000 << 100000;
+	options->modelFileName = QDir( TEST_DIR ).absoluteFilePath( "SolarFurnace_normal.tnh" );
+	options->scene = -1;
+
+	for( int i = 1; i < arguments.count(); ++i )
+	{
+		if( i + 1 >= arguments.count() )	return false;
+
+		QString option = arguments[i];
+		QString value = arguments[++i];
+		if( option == QLatin1String( "-rays" ) )	options->numberOfRays = value.toULong();
+		else if( option == QLatin1String( "-threads" ) )	options->maximumThreads = value.toInt();
+		else if( option == QLatin1String( "-seed" ) )	options->seed = value.toULong();
+		else if( option == QLatin1String( "-packet" ) )	options->packetSize = value.toInt();
+		else if( option == QLatin1String( "-bands" ) )	options->numberOfBands = value.toInt();
+		else if( option == QLatin1String( "-attenuation" ) )	options->attenuationMode = value.toInt();
+		else if( option == QLatin1String( "-model" ) )	options->modelFileName = value;
+		else if( option == QLatin1String( "-scene" ) )	options->scene = value.toInt();
+		else if( option == QLatin1String( "-heliostats" ) )
+		{
+			options->fieldSizes.clear();
+			QStringList sizes = value.split( ",", QString::SkipEmptyParts );
+			for( int s = 0; s < sizes.count(); ++s )
+				options->fieldSizes<< sizes[s].toInt();
+		}
+		else
+			return false;
+	}
+
+	return ( options->numberOfRays > 0 ) && ( options->maximumThreads > 0 );
+}
+
+/*!
+ * Creates an instance of the Coin node type \a typeName. The type is registered by its plugin.
+ */
+SoNode* CreateNode( const char* typeName )
+{
+	SoType nodeType = SoType::fromName( SbName( typeName ) );
+	if( nodeType.isBad() || !nodeType.canCreateInstance() )	return 0;
+	return static_cast< SoNode* >( nodeType.createInstance() );
+}
+
+/*!
+ * Creates a surface node with a \a width x \a height flat rectangle. If \a materialType is not null,
+ * the surface has a material of that type.
+ */
+TShapeKit* CreateFlatSurface( double width, double height, const char* materialType )
+{
+	SoNode* shape = CreateNode( "ShapeFlatRectangle" );
+	if( !shape )	return 0;
+	shape->getField( "width" )->set( QString::number( width ).toLatin1().constData() );
+	shape->getField( "height" )->set( QString::number( height ).toLatin1().constData() );
+
+	TShapeKit* surface = new TShapeKit;
+	surface->setPart( "shape", shape );
+
+	if( materialType )
+	{
+		SoNode* material = CreateNode( materialType );
+		if( !material )	return 0;
+		material->getField( "m_reflectivity" )->set( "0.9" );
+		material->getField( "m_sigmaSlope" )->set( "2.0" );
+		surface->setPart( "material", material );
+	}
+
+	return surface;
+}
+
+/*!
+ * Writes the heliostat component and the coordinates of a \a nHeliostats heliostat field into \a workDirectory.
+ * The heliostats are placed in a square grid around the tower.
+ */
+bool WriteFieldFiles( int nHeliostats, QDir workDirectory, QString* coordinatesFileName, QString* componentFileName )
+{
+	*componentFileName = workDirectory.absoluteFilePath( "BenchmarkHeliostat.tcmp" );
+	*coordinatesFileName = workDirectory.absoluteFilePath( QString( "BenchmarkField%1.txt" ).arg( nHeliostats ) );
+
+	TShapeKit* facet = CreateFlatSurface( 10.0, 10.0, "MaterialStandardSpecular" );
+	if( !facet )	return false;
+
+	TSeparatorKit* heliostat = new TSeparatorKit;
+	heliostat->ref();
+	heliostat->setName( "BenchmarkHeliostat" );
+	SoNodeKitListPart* heliostatChildList = static_cast< SoNodeKitListPart* >( heliostat->getPart( "childList", true ) );
+	heliostatChildList->addChild( facet );
+
+	SoOutput componentOutput;
+	if( !componentOutput.openFile( componentFileName->toLatin1().constData() ) )
+	{
+		heliostat->unref();
+		return false;
+	}
+	SoWriteAction writeAction( &componentOutput );
+	writeAction.apply( heliostat );
+	componentOutput.closeFile();
+	heliostat->unref();
+
+	QFile coordinatesFile( *coordinatesFileName );
+	if( !coordinatesFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) )	return false;
+	QTextStream coordinatesOut( &coordinatesFile );
+
+	int rowElements = int( ceil( sqrt( double( nHeliostats + 1 ) ) ) );
+	int nWritten = 0;
+	for( int row = 0; ( row < rowElements ) && ( nWritten < nHeliostats ); ++row )
+	{
+		for( int column = 0; ( column < rowElements ) && ( nWritten < nHeliostats ); ++column )
+		{
+			double x = ( column - 0.5 * ( rowElements - 1 ) ) * heliostatSpacing;
+			double z = ( row - 0.5 * ( rowElements - 1 ) ) * heliostatSpacing;
+			if( ( fabs( x ) < heliostatSpacing ) && ( fabs( z ) < heliostatSpacing ) )	continue;
+
+			coordinatesOut<< x << "\t" << 5.0 << "\t" << z << "\n";
+			nWritten++;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Replaces the concentrator of the \a document scene with a \a nHeliostats heliostat field and a receiver at the top of the tower.
+ */
+bool CreateFieldScene( Document* document, PluginManager* pluginManager, QString modelFileName, int nHeliostats, QDir workDirectory )
+{
+	if( !document->ReadFile( modelFileName ) )	return false;
+	TSceneKit* coinScene = document->GetSceneKit();
+
+	TSeparatorKit* sunNode = static_cast< TSeparatorKit* >( coinScene->getPart( "childList[0]", false ) );
+	if( !sunNode )	return false;
+	SoNodeKitListPart* sunNodeChildList = static_cast< SoNodeKitListPart* >( sunNode->getPart( "childList", true ) );
+	if( !sunNodeChildList || ( sunNodeChildList->getNumChildren() < 1 ) )	return false;
+
+	TSeparatorKit* concentratorRoot = static_cast< TSeparatorKit* >( sunNodeChildList->getChild( 0 ) );
+	SoNodeKitListPart* concentratorChildList = static_cast< SoNodeKitListPart* >( concentratorRoot->getPart( "childList", true ) );
+	while( concentratorChildList->getNumChildren() > 0 )
+		concentratorChildList->removeChild( 0 );
+
+	QString coordinatesFileName;
+	QString componentFileName;
+	if( !WriteFieldFiles( nHeliostats, workDirectory, &coordinatesFileName, &componentFileName ) )	return false;
+
+	QVector< TComponentFactory* > componentFactoryList = pluginManager->GetComponentFactories();
+	TComponentFactory* fieldFactory = 0;
+	for( int i = 0; i < componentFactoryList.size(); ++i )
+		if( componentFactoryList[i]->TComponentName() == QLatin1String( "Heliostat_Field_Component" ) )
+			fieldFactory = componentFactoryList[i];
+	if( !fieldFactory )	return false;
+
+	QVector< QVariant > parametersList;
+	parametersList<< coordinatesFileName << componentFileName << 0.0 << towerHeight << 0.0;
+	TSeparatorKit* field = fieldFactory->CreateTComponent( pluginManager, parametersList.size(), parametersList );
+	if( !field )	return false;
+	concentratorChildList->addChild( field );
+
+	TShapeKit* receiver = CreateFlatSurface( 30.0, 30.0, 0 );
+	if( !receiver )	return false;
+	TSeparatorKit* receiverNode = new TSeparatorKit;
+	receiverNode->setName( "Receiver" );
+	SoTransform* receiverTransform = static_cast< SoTransform* >( receiverNode->getPart( "transform", true ) );
+	receiverTransform->translation.setValue( 0.0, towerHeight, 0.0 );
+	SoNodeKitListPart* receiverChildList = static_cast< SoNodeKitListPart* >( receiverNode->getPart( "childList", true ) );
+	receiverChildList->addChild( receiver );
+	concentratorChildList->addChild( receiverNode );
+
+	return true;
+}
+
+/*!
+ * Resizes the light of the \a coinScene to cover all the concentrator.
+ */
+void UpdateLightSize( TSceneKit* coinScene )
+{
+	TLightKit* lightKit = static_cast< TLightKit* >( coinScene->getPart( "lightList[0]", false ) );
+	TSeparatorKit* concentratorRoot = static_cast< TSeparatorKit* >( coinScene->getPart( "childList[0]", false ) );
+	if( !lightKit || !concentratorRoot )	return;
+
+	SoGetBoundingBoxAction* bbAction = new SoGetBoundingBoxAction( SbViewportRegion() ) ;
+	concentratorRoot->getBoundingBox( bbAction );
+	SbBox3f box = bbAction->getXfBoundingBox().project();
+	delete bbAction;
+
+	if( !box.isEmpty() )
+	{
+		BBox sceneBox;
+		sceneBox.pMin = Point3D( box.getMin()[0], box.getMin()[1], box.getMin()[2] );
+		sceneBox.pMax = Point3D( box.getMax()[0], box.getMax()[1], box.getMax()[2] );
+		lightKit->Update( sceneBox );
+	}
+}
+
+/*!
+ * Traces each chunk of rays with a new tracer and a generator seeded with the seed of the chunk, so that the rays
+ * of a chunk do not depend on the thread that traces it or on the other chunks.
+ */
+class ChunkTracer
+{
+public:
+	ChunkTracer( InstanceNode* rootNode, InstanceNode* lightNode, TLightShape* lightShape, TSunShape* sunShape,
+			Transform lightToWorld, TTransmissivity* transmissivity, TPhotonMap* photonMap, QMutex* mutexPhotonMap,
+			int packetSize, std::vector< double > sunBandFractions, int attenuationMode )
+	:m_rootNode( rootNode ),
+	 m_lightNode( lightNode ),
+	 m_lightShape( lightShape ),
+	 m_sunShape( sunShape ),
+	 m_lightToWorld( lightToWorld ),
+	 m_transmissivity( transmissivity ),
+	 m_photonMap( photonMap ),
+	 m_mutexPhotonMap( mutexPhotonMap ),
+	 m_packetSize( packetSize ),
+	 m_sunBandFractions( sunBandFractions ),
+	 m_attenuationMode( attenuationMode )
+	{
+
+	}
+
+	typedef void result_type;
+	void operator()( const TraceChunk& chunk )
+	{
+		RandomMersenneTwister rand( chunk.seed, chunkRandomNumbers );
+		QMutex mutex;
+		QVector< InstanceNode* > exportSurfaceList;
+		if( m_transmissivity )
+		{
+			RayTracer rayTracer( m_rootNode, m_lightNode, m_lightShape, m_sunShape, m_lightToWorld,
+					m_transmissivity,
+					rand,
+					&mutex, m_photonMap, m_mutexPhotonMap,
+					exportSurfaceList );
+			rayTracer.SetPacketSize( m_packetSize );
+			rayTracer.SetSpectralBands( m_sunBandFractions );
+			rayTracer.SetAttenuationWeighting( m_attenuationMode == 1 );
+			rayTracer.SetPostTraceAttenuation( m_attenuationMode == 2 );
+			rayTracer( chunk.numberOfRays );
+		}
+		else
+		{
+			RayTracerNoTr rayTracer( m_rootNode, m_lightNode, m_lightShape, m_sunShape, m_lightToWorld,
+					rand,
+					&mutex, m_photonMap, m_mutexPhotonMap,
+					exportSurfaceList );
+			rayTracer.SetPacketSize( m_packetSize );
+			rayTracer.SetSpectralBands( m_sunBandFractions );
+			rayTracer( chunk.numberOfRays );
+		}
+	}
+
+private:
+	InstanceNode* m_rootNode;
+	InstanceNode* m_lightNode;
+	TLightShape* m_lightShape;
+	TSunShape* m_sunShape;
+	Transform m_lightToWorld;
+	TTransmissivity* m_transmissivity;
+	TPhotonMap* m_photonMap;
+	QMutex* m_mutexPhotonMap;
+	int m_packetSize;
+	std::vector< double > m_sunBandFractions;
+	int m_attenuationMode;
+};
+
+/*!
+ * Traces \a numberOfRays rays through the \a document scene with \a nThreads threads.
+ * The seeds of the chunks of rays are taken from a generator seeded with \a seed. The primary rays are intersected in packets of \a packetSize rays.
+ * If \a numberOfBands is greater than zero the rays carry the power of that number of equal bands.
+ * The \a attenuationMode selects how the atmospheric attenuation is computed: 0 kills the rays, 1 applies it to the power
+ * of the rays and 2 leaves it for after the trace.
+ */
+bool TraceScene( Document* document, SceneModel* sceneModel, PhotonMapExportFactory* exportFactory,
+		unsigned long seed, unsigned long numberOfRays, int nThreads, int packetSize, int numberOfBands, int attenuationMode,
+		BenchmarkRun* run )
+{
+	TSceneKit* coinScene = document->GetSceneKit();
+	TLightKit* lightKit = static_cast< TLightKit* >( coinScene->getPart( "lightList[0]", false ) );
+	if( !lightKit )	return false;
+
+	TSunShape* sunShape = static_cast< TSunShape* >( lightKit->getPart( "tsunshape", false ) );
+	TLightShape* raycastingSurface = static_cast< TLightShape* >( lightKit->getPart( "icon", false ) );
+	SoTransform* lightTransform = static_cast< SoTransform* >( lightKit->getPart( "transform", false ) );
+	if( !sunShape || !raycastingSurface || !lightTransform )	return false;
+
+	TTransmissivity* transmissivity = 0;
+	if( coinScene->getPart( "transmissivity", false ) )
+		transmissivity = static_cast< TTransmissivity* > ( coinScene->getPart( "transmissivity", false ) );
+
+	InstanceNode* rootSeparatorInstance = sceneModel->NodeFromIndex( sceneModel->IndexFromNodeUrl( QString( "//SunNode" ) ) );
+	if( !rootSeparatorInstance || !rootSeparatorInstance->GetParent() )	return false;
+	InstanceNode* lightInstance = rootSeparatorInstance->GetParent()->children[0];
+
+	trf::ComputeSceneTreeMap( rootSeparatorInstance, Transform( new Matrix4x4 ), true );
+
+	QStringList disabledNodes = QString( lightKit->disabledNodes.getValue().getString() ).split( ";", QString::SkipEmptyParts );
+	QVector< QPair< TShapeKit*, Transform > > surfacesList;
+	trf::ComputeFistStageSurfaceList( rootSeparatorInstance, disabledNodes, &surfacesList );
+	lightKit->ComputeLightSourceArea( lightWidthDivisions, lightHeightDivisions, surfacesList );
+	if( surfacesList.count() < 1 )	return false;
+
+	Transform lightToWorld = tgf::TransformFromSoTransform( lightTransform );
+	lightInstance->SetIntersectionTransform( lightToWorld.GetInverse() );
+
+	PhotonMapExport* exportMode = exportFactory->GetExportPhotonMapMode();
+	TPhotonMap photonMap;
+	photonMap.SetBufferSize( photonBufferSize );
+	if( !photonMap.SetExportMode( exportMode ) )
+	{
+		delete exportMode;
+		return false;
+	}
+	photonMap.SetConcentratorToWorld( rootSeparatorInstance->GetIntersectionTransform() );
+
+	RandomMersenneTwister seedGenerator( seed, 1 );
+	QVector< TraceChunk > chunks;
+	const int maximumValueProgressScale = 100;
+	unsigned long t1 = numberOfRays / maximumValueProgressScale;
+	for( int progressCount = 0; progressCount < maximumValueProgressScale; ++progressCount )
+	{
+		TraceChunk chunk = { double( t1 ), seedGenerator.RandomUInt() };
+		chunks<< chunk;
+	}
+	if( ( t1 * maximumValueProgressScale ) < numberOfRays )
+	{
+		TraceChunk chunk = { double( numberOfRays - ( t1 * maximumValueProgressScale ) ), seedGenerator.RandomUInt() };
+		chunks<< chunk;
+	}
+
+	QMutex mutexPhotonMap;
+	std::vector< double > sunBandFractions;
+	for( int b = 0; b < numberOfBands; ++b )
+		sunBandFractions.push_back( 1.0 / numberOfBands );
+
+	QThreadPool::globalInstance()->setMaxThreadCount( nThreads );
+
+	Timer timer;
+	timer.Start();
+
+	ChunkTracer chunkTracer( rootSeparatorInstance, lightInstance, raycastingSurface, sunShape, lightToWorld,
+			transmissivity, &photonMap, &mutexPhotonMap, packetSize, sunBandFractions, attenuationMode );
+	QFuture< void > trace = QtConcurrent::map( chunks, chunkTracer );
+	trace.waitForFinished();
+
+	double wPhoton = ( raycastingSurface->GetValidArea() * sunShape->GetIrradiance() ) / numberOfRays;
+	photonMap.EndStore( wPhoton );
+
+	timer.Stop();
+
+	run->time = timer.Time();
+	run->photons = photonMap.GetNumberOfStoredPhotons();
+
+	delete exportMode;
+	return true;
+}
+
+/*!
+ * Runs the benchmark for the \a document scene with 1, 2, 4... up to options.maximumThreads threads.
+ * Returns false if the scene cannot be traced.
+ */
+bool RunSceneBenchmark( QString sceneName, Document* document, PhotonMapExportFactory* exportFactory, const BenchmarkOptions& options )
+{
+	UpdateLightSize( document->GetSceneKit() );
+
+	SceneModel sceneModel;
+	sceneModel.SetCoinScene( *document->GetSceneKit() );
+	sceneModel.ReconnectAllTrackers();
+
+	QVector< int > threadsList;
+	for( int nThreads = 1; nThreads < options.maximumThreads; nThreads *= 2 )
+		threadsList<< nThreads;
+	threadsList<< options.maximumThreads;
+
+	double singleThreadRaysPerSecond = 0.0;
+	for( int t = 0; t < threadsList.size(); ++t )
+	{
+		BenchmarkRun run;
+		if( !TraceScene( document, &sceneModel, exportFactory, options.seed, options.numberOfRays, threadsList[t], options.packetSize,
+				options.numberOfBands, options.attenuationMode, &run ) )
+		{
+			std::cerr<< sceneName.toStdString() << ": the scene is not ready for ray tracing." << std::endl;
+			return false;
+		}
+
+		double raysPerSecond = ( run.time > 0.0 ) ? options.numberOfRays / run.time : 0.0;
+		double photonsPerSecond = ( run.time > 0.0 ) ? run.photons / run.time : 0.0;
+		if( t == 0 )	singleThreadRaysPerSecond = raysPerSecond * threadsList[t];
+		double efficiency = ( singleThreadRaysPerSecond > 0.0 ) ? raysPerSecond / ( singleThreadRaysPerSecond * threadsList[t] ) : 0.0;
+
+		std::cout<< sceneName.toStdString() << "\t"
+				<< threadsList[t] << "\t"
+				<< options.numberOfRays << "\t"
+				<< run.time << "\t"
+				<< raysPerSecond << "\t"
+				<< photonsPerSecond << "\t"
+				<< efficiency << "\t"
+				<< PeakResidentSetSize() << std::endl;
+	}
+
+	return true;
+}
+
+/*!
+ * Traces each scene in a new process of the benchmark, started with the same \a arguments and the -scene option.
+ * Returns the number of scenes that could not be traced.
+ */
+int RunSceneProcesses( QStringList arguments, const BenchmarkOptions& options )
+{
+	std::cout<< "scene\tthreads\trays\ttime(s)\trays/s\tphotons/s\tefficiency\tpeakRSS(MB)" << std::endl;
+
+	QVector< int > scenes;
+	scenes<< 0;
+	scenes+= options.fieldSizes;
+
+	arguments.removeFirst();
+	int failedScenes = 0;
+	for( int s = 0; s < scenes.size(); ++s )
+	{
+		QProcess sceneProcess;
+		sceneProcess.setProcessChannelMode( QProcess::ForwardedChannels );
+		sceneProcess.start( QCoreApplication::applicationFilePath(),
+				QStringList( arguments )<< QLatin1String( "-scene" ) << QString::number( scenes[s] ) );
+		if( !sceneProcess.waitForFinished( -1 ) || ( sceneProcess.exitStatus() != QProcess::NormalExit ) ||
+				( sceneProcess.exitCode() != 0 ) )
+			failedScenes++;
+	}
+
+	return failedScenes;
+}
+
+int main( int argc, char** argv )
+{
+	QApplication a( argc, argv );
+
+	BenchmarkOptions options;
+	if( !ReadOptions( a.arguments(), &options ) )
+	{
+		std::cerr<< "Usage: TracingBenchmark [-rays n] [-threads n] [-seed n] [-packet n] [-bands n] [-attenuation n] [-heliostats n1,n2,...] [-model file.tnh]" << std::endl;
+		return 1;
+	}
+
+	if( options.scene < 0 )	return RunSceneProcesses( a.arguments(), options );
+
+	SoQt::init( (QWidget *) NULL );
+
+	TSceneKit::initClass();
+	TMaterial::initClass();
+	TDefaultMaterial::initClass();
+	TSeparatorKit::initClass();
+	TShape::initClass();
+	TCube::initClass();
+	TLightShape::initClass();
+	TShapeKit::initClass();
+	TAnalyzerKit::initClass();
+	TAnalyzerResultKit::initClass();
+	TAnalyzerParameter::initClass();
+	TAnalyzerResult::initClass();
+	TAnalyzerLevel::initClass();
+	TSquare::initClass();
+	TLightKit::initClass();
+	TSunShape::initClass();
+	TDefaultSunShape::initClass();
+	TTracker::initClass();
+	TTrackerForAiming::initClass();
+	TDefaultTracker::initClass();
+	TSceneTracker::initClass();
+	TTransmissivity::initClass();
+	TDefaultTransmissivity::initClass();
+
+	QDir pluginsDirectory( qApp->applicationDirPath() );
+	pluginsDirectory.cd( "plugins" );
+	PluginManager pluginManager;
+	pluginManager.LoadAvailablePlugins( pluginsDirectory );
+
+	PhotonMapExportFactory* exportFactory = 0;
+	QVector< PhotonMapExportFactory* > exportFactoryList = pluginManager.GetExportPMModeFactories();
+	for( int i = 0; i < exportFactoryList.size(); ++i )
+		if( exportFactoryList[i]->GetName() == QLatin1String( "Not export" ) )	exportFactory = exportFactoryList[i];
+	if( !exportFactory )
+	{
+		std::cerr<< "The PhotonMapExportNull plugin is not available in " << pluginsDirectory.absolutePath().toStdString() << std::endl;
+		return 1;
+	}
+
+	if( options.scene == 0 )
+	{
+		Document modelDocument;
+		if( !modelDocument.ReadFile( options.modelFileName ) )
+		{
+			std::cerr<< "Cannot open the model " << options.modelFileName.toStdString() << std::endl;
+			return 1;
+		}
+		if( !RunSceneBenchmark( QFileInfo( options.modelFileName ).baseName(), &modelDocument, exportFactory, options ) )	return 1;
+	}
+	else
+	{
+		Document fieldDocument;
+		if( !CreateFieldScene( &fieldDocument, &pluginManager, options.modelFileName, options.scene, QDir( QDir::tempPath() ) ) )
+		{
+			std::cerr<< "Cannot create a " << options.scene << " heliostats field." << std::endl;
+			return 1;
+		}
+		if( !RunSceneBenchmark( QString( "Field%1" ).arg( options.scene ), &fieldDocument, exportFactory, options ) )	return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include "OrthonormalBasis.h"
+
+/*!
+ * Creates the basis of the coordinate axes.
+ */
+OrthonormalBasis::OrthonormalBasis()
+: xAxis( 1.0, 0.0, 0.0 ), yAxis( 0.0, 1.0, 0.0 ), zAxis( 0.0, 0.0, 1.0 )
+{
+
+}
+
+/*!
+ * Creates a basis whose y axis has the direction of \a yDirection. The x and z axes are computed with
+ * the branchless method of Duff et al., that is continuous except where the y axis changes its z sign.
+ */
+OrthonormalBasis::OrthonormalBasis( const Vector3D& yDirection )
+: yAxis( Normalize( yDirection ) )
+{
+	double sign = ( yAxis.z < 0.0 ) ? -1.0 : 1.0;
+	double a = -1.0 / ( sign + yAxis.z );
+	double b = yAxis.x * yAxis.y * a;
+
+	zAxis = Vector3D( 1.0 + sign * yAxis.x * yAxis.x * a, sign * b, -sign * yAxis.x );
+	xAxis = Vector3D( b, sign + yAxis.y * yAxis.y * a, -yAxis.y );
+}
+
+/*!
+ * Creates a basis whose y axis has the direction of \a yDirection and whose x axis is the component of
+ * \a xDirection orthogonal to it. If \a xDirection has not such a component, the x axis is chosen as
+ * in the constructor with only the y direction.
+ */
+OrthonormalBasis::OrthonormalBasis( const Vector3D& yDirection, const Vector3D& xDirection )
+: yAxis( Normalize( yDirection ) )
+{
+	Vector3D x = xDirection - DotProduct( xDirection, yAxis ) * yAxis;
+	double length = x.length();
+	if( !( length > 1e-12 * xDirection.length() ) )
+	{
+		*this = OrthonormalBasis( yAxis );
+		return;
+	}
+
+	xAxis = x / length;
+	zAxis = CrossProduct( xAxis, yAxis );
+}
+
+OrthonormalBasis::~OrthonormalBasis()
+{
+
+}
+
+/*!
+ * Returns the vector whose coordinates in this basis are \a local.
+ */
+Vector3D OrthonormalBasis::ToWorld( const Vector3D& local ) const
+{
+	return Vector3D( local.x * xAxis.x + local.y * yAxis.x + local.z * zAxis.x,
+					local.x * xAxis.y + local.y * yAxis.y + local.z * zAxis.y,
+					local.x * xAxis.z + local.y * yAxis.z + local.z * zAxis.z );
+}
+
+/*!
+ * Returns the coordinates of \a world in this basis.
+ */
+Vector3D OrthonormalBasis::ToLocal( const Vector3D& world ) const
+{
+	return Vector3D( DotProduct( world, xAxis ), DotProduct( world, yAxis ), DotProduct( world, zAxis ) );
+}
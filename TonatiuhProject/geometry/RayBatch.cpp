@@ -0,0 +1,112 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include "Point3D.h"
+#include "Ray.h"
+#include "RayBatch.h"
+#include "Vector3D.h"
+
+/*!
+ * Creates an empty batch.
+ */
+RayBatch::RayBatch()
+{
+
+}
+
+/*!
+ * Creates a batch with \a size rays.
+ */
+RayBatch::RayBatch( int size )
+{
+	Resize( size );
+}
+
+RayBatch::~RayBatch()
+{
+
+}
+
+/*!
+ * Changes the number of rays in the batch to \a size.
+ */
+void RayBatch::Resize( int size )
+{
+	originX.resize( size );
+	originY.resize( size );
+	originZ.resize( size );
+	directionX.resize( size );
+	directionY.resize( size );
+	directionZ.resize( size );
+	mint.resize( size );
+	maxt.resize( size );
+}
+
+/*!
+ * Returns the number of rays in the batch.
+ */
+int RayBatch::Size() const
+{
+	return int( maxt.size() );
+}
+
+/*!
+ * Stores \a ray as the ray \a index of the batch.
+ */
+void RayBatch::SetRay( int index, const Ray& ray )
+{
+	originX[index] = ray.origin.x;
+	originY[index] = ray.origin.y;
+	originZ[index] = ray.origin.z;
+	directionX[index] = ray.direction().x;
+	directionY[index] = ray.direction().y;
+	directionZ[index] = ray.direction().z;
+	mint[index] = ray.mint;
+	maxt[index] = ray.maxt;
+}
+
+/*!
+ * Returns the ray \a index of the batch.
+ */
+Ray RayBatch::GetRay( int index ) const
+{
+	return Ray( Point3D( originX[index], originY[index], originZ[index] ),
+			Vector3D( directionX[index], directionY[index], directionZ[index] ),
+			mint[index], maxt[index] );
+}
@@ -39,6 +39,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef GF_H_
 #define GF_H_
 
+#include <cmath>
 #include <string>
 
 namespace gf
@@ -47,6 +48,25 @@ namespace gf
     void Warning( std::string warningMessage );
     bool IsOdd( int number );
     bool Quadratic( double A, double B, double C, double* t0, double* t1);
+    bool QuadraticRoots( double A, double B, double C, double* t0, double* t1);
+}
+
+/**
+ * Branch free version of gf::Quadratic to be used inside the batch intersection loops.
+ *
+ * Computes the roots of the equation even if they are not real and returns false in that case.
+ **/
+inline bool gf::QuadraticRoots( double A, double B, double C, double* t0, double* t1 )
+{
+	double discrim = B*B - 4.0*A*C;
+	double rootDiscrim = sqrt( ( discrim < 0. ) ? 0. : discrim );
+
+	double q = ( B < 0 ) ? -0.5 * ( B - rootDiscrim ) : -0.5 * ( B + rootDiscrim );
+	double r0 = q / A;
+	double r1 = C / q;
+	*t0 = ( r0 > r1 ) ? r1 : r0;
+	*t1 = ( r0 > r1 ) ? r0 : r1;
+	return ( discrim >= 0. );
 }
 
 #endif /*GF_H_*/
@@ -82,28 +82,14 @@ ComponentHeliostatField::~ComponentHeliostatField()
 TSeparatorKit* ComponentHeliostatField::CreateField()
 {
 	//Define heliostat tracker for the field
-	QVector< TTrackerFactory* > trackersFactoryList = m_pPluginManager->GetTrackerFactories();
-	if( trackersFactoryList.size() == 0 )
+	QString errorMessage;
+	TTrackerFactory* heliostatTrackerFactory = HeliostatTrackerFactory( &errorMessage );
+	if( !heliostatTrackerFactory )
 	{
-        QMessageBox::warning( 0, QString( "Campo Heliostatos" ),
-        		QString( "No se ha encontrado plugins de tipo tracker." ) );
+        QMessageBox::warning( 0, QString( "Campo Heliostatos" ), errorMessage );
 		return 0;
 	}
 
-	QVector< QString > trackerNames;
-	for( int i = 0; i < trackersFactoryList.size(); i++ )
-		trackerNames<< trackersFactoryList[i]->TTrackerName();
-
-	int selectedTracker = trackerNames.indexOf( QLatin1String( "Heliostat_tracker" ) );
-	if( selectedTracker < 0 )
-	{
-        QMessageBox::warning( 0, QString( "Campo Heliostatos" ),
-        		QString( "No se ha encontrado el plugin de tipo 'Heliostat_tracker' " ) );
-		return 0;
-	}
-
-	TTrackerFactory* heliostatTrackerFactory = trackersFactoryList[ selectedTracker ];
-
 
 	HeliostatFieldWizard wizard;
 	if( !wizard.exec() )
@@ -113,27 +99,57 @@ TSeparatorKit* ComponentHeliostatField::CreateField()
 		return 0;
 	}
 
-	//Aiming point
-	Point3D aimingPoint = wizard.GetHeliostatsAimingPoint();
+	TSeparatorKit* heliostatsNodeSeparator = BuildField( heliostatTrackerFactory, wizard.GetCoordinatesFile(),
+			wizard.GetHeliostatComponentFile(), wizard.GetHeliostatsAimingPoint(), &errorMessage );
+	if( !heliostatsNodeSeparator )
+		QMessageBox::information( 0, QString( "Campo Heliostatos" ), errorMessage );
 
-	//Read heliostat component
+	return heliostatsNodeSeparator;
 
-	//TSeparatorKit::initClass();
+}
+
+
+/*!
+ * Creates the heliostat field without user interaction. The \a argumentList must contain:
+ * the heliostat coordinates file name, the heliostat component file name and the x, y and z
+ * coordinates of the aiming point.
+ */
+TSeparatorKit* ComponentHeliostatField::CreateField( QVector< QVariant >  argumentList )
+{
+	if( argumentList.size() != 5 )	return 0;
+
+	QString errorMessage;
+	TTrackerFactory* heliostatTrackerFactory = HeliostatTrackerFactory( &errorMessage );
+	if( !heliostatTrackerFactory )	return 0;
+
+	Point3D aimingPoint( argumentList[2].toDouble(), argumentList[3].toDouble(), argumentList[4].toDouble() );
+	return BuildField( heliostatTrackerFactory, argumentList[0].toString(), argumentList[1].toString(), aimingPoint,
+			&errorMessage );
+}
 
-	TSeparatorKit* heliostatComponentNode = OpenHeliostatComponent( wizard.GetHeliostatComponentFile() );
+/*!
+ * Creates the field with a heliostat of the component saved in \a componentFileName at each center of the
+ * \a coordinatesFileName file. The heliostats trackers are created with \a heliostatTrackerFactory and aim to \a aimingPoint.
+ *
+ * Returns 0 and sets \a errorMessage if a file cannot be read.
+ */
+TSeparatorKit* ComponentHeliostatField::BuildField( TTrackerFactory* heliostatTrackerFactory,
+		QString coordinatesFileName, QString componentFileName, Point3D aimingPoint,
+		QString* errorMessage )
+{
+	//Read heliostat component
+	TSeparatorKit* heliostatComponentNode = OpenHeliostatComponent( componentFileName );
 	if( !heliostatComponentNode )
 	{
-		QMessageBox::information( 0, QString( "Campo Heliostatos" ),
-				QString( "Error al leer el componente para los heliostatos." ) );
+		*errorMessage = QString( "Error al leer el componente para los heliostatos." );
 		return 0;
 	}
 
 
-	QFile coordinatesFile( wizard.GetCoordinatesFile() );
+	QFile coordinatesFile( coordinatesFileName );
 	if( !coordinatesFile.open( QIODevice::ReadOnly ) )
 	{
-		QMessageBox::information( 0, QString( "Campo Heliostatos" ),
-				QString( "Error al leer el archivo de coordenadas de los heliostatos." ) );
+		*errorMessage = QString( "Error al leer el archivo de coordenadas de los heliostatos." );
 		return 0;
 	}
 
@@ -154,35 +170,13 @@ TSeparatorKit* ComponentHeliostatField::CreateField()
 
 
 	SoType separatorType = SoType::fromName( SbName ( "TSeparatorKit" ) );
-
-	/*TSeparatorKit* rootSeparator = static_cast< TSeparatorKit* > ( separatorType.createInstance() );
-	//TSeparatorKit* rootSeparator = new TSeparatorKit;
-	rootSeparator->setName( "CampoHeliostatos" );
-	rootSeparator->ref();
-
-	SoNodeKitListPart* rootPartList = static_cast< SoNodeKitListPart* >( rootSeparator->getPart( "childList", true ) );
-	if( !rootPartList ) return 0;
-	*/
-
-
 	TSeparatorKit* heliostatsNodeSeparator = static_cast< TSeparatorKit* > ( separatorType.createInstance() );
-	//TSeparatorKit* heliostatsNodeSeparator = new TSeparatorKit;
-	//rootPartList->addChild(heliostatsNodeSeparator);
 	heliostatsNodeSeparator->setName( "Heliostatos" );
 	heliostatsNodeSeparator->ref();
 
-
-
 	CreateHeliostatZones( hCenterList, heliostatsNodeSeparator, heliostatTrackerFactory, aimingPoint, heliostatComponentNode, 1 );
 
 	return heliostatsNodeSeparator;
-
-}
-
-
-TSeparatorKit* ComponentHeliostatField::CreateField( QVector< QVariant >  argumentList )
-{
-	return 0;
 }
 
 
@@ -310,6 +304,32 @@ void ComponentHeliostatField::CreateHeliostatZones( std::vector< Point3D >  heli
 	}
 }
 
+/*!
+ * Returns the factory of the "Heliostat_tracker" trackers. Returns 0 and sets \a errorMessage if it is not available.
+ */
+TTrackerFactory* ComponentHeliostatField::HeliostatTrackerFactory( QString* errorMessage ) const
+{
+	QVector< TTrackerFactory* > trackersFactoryList = m_pPluginManager->GetTrackerFactories();
+	if( trackersFactoryList.size() == 0 )
+	{
+		*errorMessage = QString( "No se ha encontrado plugins de tipo tracker." );
+		return 0;
+	}
+
+	QVector< QString > trackerNames;
+	for( int i = 0; i < trackersFactoryList.size(); i++ )
+		trackerNames<< trackersFactoryList[i]->TTrackerName();
+
+	int selectedTracker = trackerNames.indexOf( QLatin1String( "Heliostat_tracker" ) );
+	if( selectedTracker < 0 )
+	{
+		*errorMessage = QString( "No se ha encontrado el plugin de tipo 'Heliostat_tracker' " );
+		return 0;
+	}
+
+	return trackersFactoryList[ selectedTracker ];
+}
+
 TSeparatorKit* ComponentHeliostatField::OpenHeliostatComponent( QString fileName )
 {
 	if ( fileName.isEmpty() ) return 0;
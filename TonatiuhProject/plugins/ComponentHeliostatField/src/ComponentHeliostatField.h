@@ -60,6 +60,9 @@ public:
 	TSeparatorKit* CreateField( QVector< QVariant >  argumentList );
 
 private:
+	TSeparatorKit* BuildField( TTrackerFactory* heliostatTrackerFactory,
+			QString coordinatesFileName, QString componentFileName, Point3D aimingPoint,
+			QString* errorMessage );
 	void CreateHeliostatZones( std::vector< Point3D >  heliostatCenterList,
 			TSeparatorKit* parentNode,
 			TTrackerFactory* heliostatTrackerFactory,
@@ -67,6 +70,7 @@ private:
 			TSeparatorKit* heliostatComponentNode,
 			int eje );
 
+	TTrackerFactory* HeliostatTrackerFactory( QString* errorMessage ) const;
 	TSeparatorKit* OpenHeliostatComponent( QString fileName );
 
 	PluginManager* m_pPluginManager;
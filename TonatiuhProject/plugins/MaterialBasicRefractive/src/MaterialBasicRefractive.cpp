@@ -36,6 +36,8 @@ Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimen
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <algorithm>
+
 #include <QMessageBox>
 #include <QString>
 
@@ -45,10 +47,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "DifferentialGeometry.h"
 #include "MaterialBasicRefractive.h"
+#include "OrthonormalBasis.h"
 #include "RandomDeviate.h"
 #include "Ray.h"
-#include "tgf.h"
-#include "Transform.h"
+#include "SpectralWeights.h"
 
 
 SO_NODE_SOURCE( MaterialBasicRefractive );
@@ -74,6 +76,10 @@ MaterialBasicRefractive::MaterialBasicRefractive()
   	SO_NODE_DEFINE_ENUM_VALUE(Distribution, NORMAL);
   	SO_NODE_SET_SF_ENUM_TYPE( distribution, Distribution);
 	SO_NODE_ADD_FIELD( distribution, (PILLBOX) );
+	SO_NODE_ADD_FIELD( bandReflectivityFront, ("") );
+	SO_NODE_ADD_FIELD( bandReflectivityBack, ("") );
+	SO_NODE_ADD_FIELD( bandTransmissivityFront, ("") );
+	SO_NODE_ADD_FIELD( bandTransmissivityBack, ("") );
 
 	SO_NODE_ADD_FIELD( m_ambientColor, (0.2f, 0.2f, 0.2f) );
 	SO_NODE_ADD_FIELD( m_diffuseColor, (0.8f, 0.8f, 0.8f) );
@@ -114,6 +120,8 @@ MaterialBasicRefractive::MaterialBasicRefractive()
 	SoFieldSensor* m_transparencySensor = new SoFieldSensor( updateTransparency, this );
 	m_transparencySensor->setPriority( 1 );
 	m_transparencySensor->attach( &m_transparency );
+
+	ComputeTraceParameters();
 }
 
 MaterialBasicRefractive::~MaterialBasicRefractive()
@@ -219,28 +227,28 @@ bool MaterialBasicRefractive::OutputRay( const Ray& incident, DifferentialGeomet
 	double randomNumber = rand.RandomDouble();
 	if( dg->shapeFrontSide )
 	{
-		if ( randomNumber < reflectivityFront.getValue()  )
+		if ( randomNumber < m_reflectivityFront  )
 		{
-			*outputRay = *ReflectedRay( incident, dg, rand );
+			ReflectedRay( incident, dg, rand, outputRay );
 			return true;
 		}
-		else if ( randomNumber < ( reflectivityFront.getValue() + transmissivityFront.getValue() ) )
+		else if ( randomNumber < ( m_reflectivityFront + m_transmissivityFront ) )
 		{
-			*outputRay = *RefractedtRay( incident, dg, rand );
+			RefractedtRay( incident, dg, rand, outputRay );
 			return true;
 		}
 		else return false;
 	}
 	else
 	{
-		if ( randomNumber < reflectivityBack.getValue()  )
+		if ( randomNumber < m_reflectivityBack  )
 		{
-			*outputRay = *ReflectedRay( incident, dg, rand );
+			ReflectedRay( incident, dg, rand, outputRay );
 			return true;
 		}
-		else if ( randomNumber < ( reflectivityBack.getValue() + transmissivityBack.getValue() ) )
+		else if ( randomNumber < ( m_reflectivityBack + m_transmissivityBack ) )
 		{
-			*outputRay = *RefractedtRay( incident, dg, rand );
+			RefractedtRay( incident, dg, rand, outputRay );
 			return true;
 		}
 		else return false;
@@ -248,47 +256,67 @@ bool MaterialBasicRefractive::OutputRay( const Ray& incident, DifferentialGeomet
 	}
 }
 
-Ray* MaterialBasicRefractive::ReflectedRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand ) const
+/*!
+ * Reflects or refracts the \a incident ray with the reflectivity and transmissivity of each band of the side it hits.
+ * Each band keeps its power on average and the output ray keeps the total weight. The bands without a value in the
+ * band fields use the last band value or, if the band field is empty, the reflectivity or transmissivity field.
+ * Without band values for the side or without bands in the \a weights, OutputRay is used.
+ */
+bool MaterialBasicRefractive::OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+		SpectralWeights* weights ) const
+{
+	const std::vector< double >& bandReflectivity = dg->shapeFrontSide ? m_bandReflectivityFront : m_bandReflectivityBack;
+	const std::vector< double >& bandTransmissivity = dg->shapeFrontSide ? m_bandTransmissivityFront : m_bandTransmissivityBack;
+	if( ( bandReflectivity.empty() && bandTransmissivity.empty() ) || !weights || ( weights->nBands < 1 ) )
+		return OutputRay( incident, dg, rand, outputRay );
+
+	double reflectivity = dg->shapeFrontSide ? m_reflectivityFront : m_reflectivityBack;
+	double transmissivity = dg->shapeFrontSide ? m_transmissivityFront : m_transmissivityBack;
+
+	double reflectivityFactors[SpectralWeights::m_maxBands];
+	double transmissivityFactors[SpectralWeights::m_maxBands];
+	for( int b = 0; b < weights->nBands; ++b )
+	{
+		if( bandReflectivity.empty() )	reflectivityFactors[b] = reflectivity;
+		else	reflectivityFactors[b] = bandReflectivity[ std::min( b, int( bandReflectivity.size() ) - 1 ) ];
+
+		if( bandTransmissivity.empty() )	transmissivityFactors[b] = transmissivity;
+		else	transmissivityFactors[b] = bandTransmissivity[ std::min( b, int( bandTransmissivity.size() ) - 1 ) ];
+	}
+
+	const double* interactionFactors[2] = { reflectivityFactors, transmissivityFactors };
+	int interaction = weights->SelectInteraction( interactionFactors, 2, rand );
+	if( interaction == 0 )	ReflectedRay( incident, dg, rand, outputRay );
+	else if( interaction == 1 )	RefractedtRay( incident, dg, rand, outputRay );
+	else	return false;
+
+	return true;
+}
+
+/*!
+ * Returns the differential geometry fields needed by OutputRay.
+ * The normal and the surface tangents are used to compute the reflected and refracted directions.
+ */
+int MaterialBasicRefractive::RequiredGeometry() const
+{
+	return DifferentialGeometry::SURFACE_TANGENTS;
+}
+
+void MaterialBasicRefractive::ReflectedRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* reflected ) const
 {
 	NormalVector dgNormal;
 
 	if( dg->shapeFrontSide )	dgNormal = dg->normal;
 	else	dgNormal = - dg->normal;
 	//Compute reflected ray (local coordinates )
-	Ray* reflected = new Ray();
 	reflected->origin = dg->point;
 
 	NormalVector normalVector;
-	double sSlope = sigmaSlope.getValue() / 1000;
-	if( sSlope > 0.0 )
+	if( m_slopeError.GetSigma() > 0.0 )
 	{
-		NormalVector errorNormal;
-		if ( distribution.getValue() == 0 )
-		{
-			double phi = gc::TwoPi * rand.RandomDouble();
-			double theta = sSlope * rand.RandomDouble();
-
-			errorNormal.x = sin( theta ) * sin( phi ) ;
-			errorNormal.y = cos( theta );
-			errorNormal.z = sin( theta ) * cos( phi );
-		 }
-		 else if (distribution.getValue() == 1 )
-		 {
-			 errorNormal.x = sSlope * tgf::AlternateBoxMuller( rand );
-			 errorNormal.y = 1.0;
-			 errorNormal.z = sSlope * tgf::AlternateBoxMuller( rand );
-
-		 }
-		Vector3D r = dgNormal;
-		Vector3D s = Normalize( dg->dpdu );
-		Vector3D t = Normalize( dg->dpdv );
-		Transform trasform( s.x, s.y, s.z, 0.0,
-								r.x, r.y, r.z, 0.0,
-								t.x, t.y, t.z, 0.0,
-								0.0, 0.0, 0.0, 1.0);
-
-		NormalVector normalDirection = trasform.GetInverse()( errorNormal );
-		normalVector = Normalize( normalDirection );
+		Vector3D errorNormal = m_slopeError.Sample( rand );
+		OrthonormalBasis surfaceBasis( dgNormal, dg->dpdu );
+		normalVector = Normalize( NormalVector( surfaceBasis.ToWorld( errorNormal ) ) );
 	}
 	else
 	{
@@ -297,11 +325,10 @@ Ray* MaterialBasicRefractive::ReflectedRay( const Ray& incident, DifferentialGeo
 
 	double cosTheta = DotProduct( normalVector, incident.direction() );
 	reflected->setDirection( Normalize( incident.direction() - 2.0 * normalVector * cosTheta ) );
-	return reflected;
 
 }
 
-Ray* MaterialBasicRefractive::RefractedtRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& /* rand */  ) const
+void MaterialBasicRefractive::RefractedtRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& /* rand */, Ray* refracted ) const
 {
 	NormalVector s;
 	double n1;
@@ -310,18 +337,17 @@ Ray* MaterialBasicRefractive::RefractedtRay( const Ray& incident, DifferentialGe
 	if( dg->shapeFrontSide )
 	{
 		s = dg->normal;
-		n1 = nFront.getValue();
-		n2 = nBack.getValue();
+		n1 = m_nFront;
+		n2 = m_nBack;
 	}
 	else
 	{
 		s = - dg->normal;
-		n1 = nBack.getValue();
-		n2 = nFront.getValue();
+		n1 = m_nBack;
+		n2 = m_nFront;
 	}
 
 	//Compute refracted ray (local coordinates )
-	Ray* refracted = new Ray();
 	refracted->origin = dg->point;
 
 	if( DotProduct(  incident.direction(), dg->normal ) < 0 ) s = - dg->normal;
@@ -339,6 +365,24 @@ Ray* MaterialBasicRefractive::RefractedtRay( const Ray& incident, DifferentialGe
 	{
 		refracted->setDirection( Normalize( incident.direction() - 2.0 * cosTheta * s ) );
 	}
+}
 
-	return refracted;
+/*!
+ * Stores the reflectivities, transmissivities and refractive indexes of both sides and the slope error
+ * distribution, with the error in radians. The band values, separated by spaces, commas or semicolons,
+ * are limited to the [0, 1] range.
+ */
+void MaterialBasicRefractive::ComputeTraceParameters()
+{
+	m_reflectivityFront = reflectivityFront.getValue();
+	m_reflectivityBack = reflectivityBack.getValue();
+	m_transmissivityFront = transmissivityFront.getValue();
+	m_transmissivityBack = transmissivityBack.getValue();
+	m_nFront = nFront.getValue();
+	m_nBack = nBack.getValue();
+	m_bandReflectivityFront = SpectralWeights::ReadBandFactors( bandReflectivityFront.getValue().getString() );
+	m_bandReflectivityBack = SpectralWeights::ReadBandFactors( bandReflectivityBack.getValue().getString() );
+	m_bandTransmissivityFront = SpectralWeights::ReadBandFactors( bandTransmissivityFront.getValue().getString() );
+	m_bandTransmissivityBack = SpectralWeights::ReadBandFactors( bandTransmissivityBack.getValue().getString() );
+	m_slopeError = ErrorDistribution( distribution.getValue(), sigmaSlope.getValue() / 1000 );
 }
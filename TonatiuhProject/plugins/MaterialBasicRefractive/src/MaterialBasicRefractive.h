@@ -39,11 +39,14 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef MaterialBasicRefractive_H_
 #define MaterialBasicRefractive_H_
 
+#include <vector>
+
 #include <Inventor/fields/SoSFDouble.h>
 #include <Inventor/fields/SoSFFloat.h>
 #include <Inventor/fields/SoSFEnum.h>
 #include <Inventor/fields/SoSFString.h>
 
+#include "ErrorDistribution.h"
 #include "TMaterial.h"
 #include "trt.h"
 
@@ -64,6 +67,9 @@ public:
     QString getIcon();
 	//Ray* OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand  ) const;
     bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const;
+	bool OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+			SpectralWeights* weights ) const;
+    int RequiredGeometry() const;
 
 	trt::TONATIUH_REAL reflectivityFront;
 	trt::TONATIUH_REAL reflectivityBack;
@@ -74,6 +80,10 @@ public:
 	trt::TONATIUH_REAL sigmaSlope;
 	//trt::TONATIUH_REAL m_sigmaSpecularity; ** yet to implemented
 	SoSFEnum distribution;
+	SoSFString bandReflectivityFront;
+	SoSFString bandReflectivityBack;
+	SoSFString bandTransmissivityFront;
+	SoSFString bandTransmissivityBack;
 	SoMFColor m_ambientColor;
 	SoMFColor m_diffuseColor;
 	SoMFColor m_specularColor;
@@ -98,9 +108,22 @@ protected:
 	static void updateShininess( void* data, SoSensor* );
 	static void updateTransparency( void* data, SoSensor* );
 
-	Ray* ReflectedRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand  ) const;
-	Ray* RefractedtRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand  ) const;
-
+	void ReflectedRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* reflected ) const;
+	void RefractedtRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* refracted ) const;
+	void ComputeTraceParameters();
+
+private:
+	double m_reflectivityFront;
+	double m_reflectivityBack;
+	double m_transmissivityFront;
+	double m_transmissivityBack;
+	double m_nFront;
+	double m_nBack;
+	std::vector< double > m_bandReflectivityFront;
+	std::vector< double > m_bandReflectivityBack;
+	std::vector< double > m_bandTransmissivityFront;
+	std::vector< double > m_bandTransmissivityBack;
+	ErrorDistribution m_slopeError;
 };
 
 #endif /*MaterialBasicRefractive_H_*/
@@ -44,10 +44,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "DifferentialGeometry.h"
 #include "MaterialStandardRoughSpecular.h"
+#include "OrthonormalBasis.h"
 #include "RandomDeviate.h"
 #include "Ray.h"
-#include "tgf.h"
-#include "Transform.h"
+#include "SpectralWeights.h"
 #include "Vector3D.h"
 
 
@@ -69,6 +69,7 @@ MaterialStandardRoughSpecular::MaterialStandardRoughSpecular()
   	SO_NODE_DEFINE_ENUM_VALUE( Distribution, NORMAL );
   	SO_NODE_SET_SF_ENUM_TYPE( distribution, Distribution) ;
 	SO_NODE_ADD_FIELD( distribution, (PILLBOX) );
+	SO_NODE_ADD_FIELD( bandReflectivity, ("") );
 
 	SO_NODE_ADD_FIELD( mAmbientColor, (0.2f, 0.2f, 0.2f) );
 	SO_NODE_ADD_FIELD( mDiffuseColor, (0.8f, 0.8f, 0.8f) );
@@ -99,6 +100,8 @@ MaterialStandardRoughSpecular::MaterialStandardRoughSpecular()
 	SoFieldSensor* m_transparencySensor = new SoFieldSensor( updateTransparency, this );
 	m_transparencySensor->setPriority( 1 );
 	m_transparencySensor->attach( &mTransparency );
+
+	ComputeTraceParameters();
 }
 
 MaterialStandardRoughSpecular::~MaterialStandardRoughSpecular()
@@ -156,26 +159,41 @@ void MaterialStandardRoughSpecular::updateTransparency( void* data, SoSensor* )
 bool MaterialStandardRoughSpecular::OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
 {
 	double randomNumber = rand.RandomDouble();
-	if ( randomNumber >= reflectivity.getValue()  ) return false;
+	if ( randomNumber >= m_reflectivity  ) return false;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
+
+/*!
+ * Reflects the \a incident ray with the reflectivity of each band defined in the bandReflectivity field.
+ * Without values per band or without bands in the \a weights, the reflectivity field is used.
+ */
+bool MaterialStandardRoughSpecular::OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+		SpectralWeights* weights ) const
+{
+	if( m_bandReflectivity.empty() || !weights || ( weights->nBands < 1 ) )	return OutputRay( incident, dg, rand, outputRay );
+	if( !weights->Attenuate( &m_bandReflectivity[0], int( m_bandReflectivity.size() ), rand ) )	return false;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
 
+/*!
+ * Computes in \a outputRay the reflection of the \a incident ray with the slope and specularity errors.
+ */
+void MaterialStandardRoughSpecular::ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
+{
 	//Compute reflected ray (local coordinates )
 	outputRay->origin = dg->point;
 
 	NormalVector normalVector;
 
-	double sigmaNormal = sigmaSlope.getValue() / 1000;
-	if( sigmaNormal > 0.0 )
+	if( m_slopeError.GetSigma() > 0.0 )
 	{
-		NormalVector errorNormal = Normalize( NormalVector( ComputeErrorVector( sigmaNormal, rand ) ) );
-		Vector3D r = dg->normal;
-		Vector3D s = Normalize( dg->dpdu );
-		Vector3D t = Normalize( dg->dpdv );
-		Transform trasform( s.x, s.y, s.z, 0.0,
-							r.x, r.y, r.z, 0.0,
-							t.x, t.y, t.z, 0.0,
-							0.0, 0.0, 0.0, 1.0);
-
-		normalVector = trasform.GetInverse()( errorNormal );
+		Vector3D errorNormal = Normalize( m_slopeError.Sample( rand ) );
+		OrthonormalBasis surfaceBasis( dg->normal, dg->dpdu );
+		normalVector = NormalVector( surfaceBasis.ToWorld( errorNormal ) );
 	}
 	else
 	{
@@ -190,44 +208,34 @@ bool MaterialStandardRoughSpecular::OutputRay( const Ray& incident, Differential
 
 
 	//Add error to reflected ray
-	double sigmaReflected= sigmaSpecularity.getValue() / 1000;
-	if( sigmaReflected > 0.0 )
+	if( m_specularityError.GetSigma() > 0.0 )
 	{
-		Vector3D errorReflectedRay = ComputeErrorVector( sigmaReflected, rand );
-
-		Vector3D r = outputRay->direction();
-		Vector3D s = Normalize( CrossProduct( outputRay->direction(), dg->normal ) );
-		Vector3D t = Normalize( CrossProduct( outputRay->direction(), s ) );
-		Transform trasform( s.x, s.y, s.z, 0.0,
-								r.x, r.y, r.z, 0.0,
-								t.x, t.y, t.z, 0.0,
-								0.0, 0.0, 0.0, 1.0);
-
-		Vector3D errorReflectedRayDirection = trasform.GetInverse()( errorReflectedRay );
-		outputRay->setDirection( errorReflectedRayDirection );
+		Vector3D errorReflectedRay = m_specularityError.Sample( rand );
+
+		OrthonormalBasis reflectedBasis( outputRay->direction(), CrossProduct( outputRay->direction(), dg->normal ) );
+		outputRay->setDirection( Normalize( reflectedBasis.ToWorld( errorReflectedRay ) ) );
 	}
+}
 
-	return true;
+/*!
+ * Returns the differential geometry fields needed by OutputRay.
+ * The normal and the surface tangents are used to compute the reflected direction.
+ */
+int MaterialStandardRoughSpecular::RequiredGeometry() const
+{
+	return DifferentialGeometry::SURFACE_TANGENTS;
 }
 
-Vector3D MaterialStandardRoughSpecular::ComputeErrorVector( double simgaError, RandomDeviate& rand ) const
+/*!
+ * Stores the reflectivity and the slope and specularity error distributions, with the errors in radians.
+ * The bandReflectivity values, separated by spaces, commas or semicolons, are limited to the [0, 1] range.
+ */
+void MaterialStandardRoughSpecular::ComputeTraceParameters()
 {
-	Vector3D errorVector;
-	if( distribution.getValue() == 0 )
-	{
-		double phi = gc::TwoPi * rand.RandomDouble();
-		double theta = simgaError * rand.RandomDouble();
-
-		errorVector.x = sin( theta ) * sin( phi ) ;
-		errorVector.y = cos( theta );
-		errorVector.z = sin( theta ) * cos( phi );
-	 }
-	 else if( distribution.getValue() == 1 )
-	 {
-		 errorVector.x = simgaError * tgf::AlternateBoxMuller( rand );
-		 errorVector.y = 1.0;
-		 errorVector.z = simgaError * tgf::AlternateBoxMuller( rand );
-
-	 }
-	return errorVector;
+	m_reflectivity = reflectivity.getValue();
+
+	m_bandReflectivity = SpectralWeights::ReadBandFactors( bandReflectivity.getValue().getString() );
+
+	m_slopeError = ErrorDistribution( distribution.getValue(), sigmaSlope.getValue() / 1000 );
+	m_specularityError = ErrorDistribution( distribution.getValue(), sigmaSpecularity.getValue() / 1000 );
 }
@@ -39,11 +39,14 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef MaterialStandardRoughSpecular_H_
 #define MaterialStandardRoughSpecular_H_
 
+#include <vector>
+
 #include <Inventor/fields/SoSFDouble.h>
 #include <Inventor/fields/SoSFEnum.h>
 #include <Inventor/fields/SoSFFloat.h>
 #include <Inventor/fields/SoSFString.h>
 
+#include "ErrorDistribution.h"
 #include "TMaterial.h"
 #include "trt.h"
 
@@ -65,11 +68,15 @@ public:
 
     QString getIcon();
 	bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const;
+	bool OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+			SpectralWeights* weights ) const;
+	int RequiredGeometry() const;
 
 	trt::TONATIUH_REAL reflectivity;
 	trt::TONATIUH_REAL sigmaSlope;
 	trt::TONATIUH_REAL sigmaSpecularity;
 	SoSFEnum distribution;
+	SoSFString bandReflectivity;
 
 	SoMFColor mAmbientColor;
 	SoMFColor mDiffuseColor;
@@ -82,7 +89,7 @@ public:
 protected:
    	virtual ~MaterialStandardRoughSpecular();
 
-   	Vector3D ComputeErrorVector( double simgaError, RandomDeviate& rand ) const;
+	void ComputeTraceParameters();
 
 	static void updateReflectivity( void* data, SoSensor* );
 	static void updateAmbientColor( void* data, SoSensor* );
@@ -92,6 +99,13 @@ protected:
 	static void updateShininess( void* data, SoSensor* );
 	static void updateTransparency( void* data, SoSensor* );
 
+private:
+	void ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const;
+
+	double m_reflectivity;
+	std::vector< double > m_bandReflectivity;
+	ErrorDistribution m_slopeError;
+	ErrorDistribution m_specularityError;
 };
 
 #endif /*MaterialStandardRoughSpecular_H_*/
@@ -17,18 +17,22 @@ INCLUDEPATH += . \
 HEADERS = src/*.h \				
             $$(TONATIUH_ROOT)/src/source/geometry/tgf.h \												
 			$$(TONATIUH_ROOT)/src/source/raytracing/DifferentialGeometry.h \
+			$$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.h \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TMaterial.h \
             $$(TONATIUH_ROOT)/src/source/raytracing/trt.h \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TShape.h  \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TShapeKit.h  \
+			$$(TONATIUH_ROOT)/src/source/statistics/ErrorDistribution.h \
 			$$(TONATIUH_ROOT)/src/source/statistics/RandomDeviate.h
 			
 SOURCES = src/*.cpp \										
             $$(TONATIUH_ROOT)/src/source/geometry/tgf.cpp \						
 			$$(TONATIUH_ROOT)/src/source/raytracing/DifferentialGeometry.cpp \
+			$$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.cpp \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TMaterial.cpp \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TShape.cpp  \
-			$$(TONATIUH_ROOT)/src/source/raytracing/TShapeKit.cpp
+			$$(TONATIUH_ROOT)/src/source/raytracing/TShapeKit.cpp  \
+			$$(TONATIUH_ROOT)/src/source/statistics/ErrorDistribution.cpp
 
 RESOURCES += src/MaterialStandardSpecular.qrc
 
@@ -44,10 +44,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "DifferentialGeometry.h"
 #include "MaterialStandardSpecular.h"
+#include "OrthonormalBasis.h"
 #include "RandomDeviate.h"
 #include "Ray.h"
-#include "tgf.h"
-#include "Transform.h"
+#include "SpectralWeights.h"
 
 
 SO_NODE_SOURCE(MaterialStandardSpecular);
@@ -67,6 +67,7 @@ MaterialStandardSpecular::MaterialStandardSpecular()
   	SO_NODE_DEFINE_ENUM_VALUE(Distribution, NORMAL);
   	SO_NODE_SET_SF_ENUM_TYPE(m_distribution, Distribution);
 	SO_NODE_ADD_FIELD( m_distribution, (PILLBOX) );
+	SO_NODE_ADD_FIELD( m_bandReflectivity, ("") );
 
 	SO_NODE_ADD_FIELD( m_ambientColor, (0.2f, 0.2f, 0.2f) );
 	SO_NODE_ADD_FIELD( m_diffuseColor, (0.8f, 0.8f, 0.8f) );
@@ -97,6 +98,8 @@ MaterialStandardSpecular::MaterialStandardSpecular()
 	SoFieldSensor* m_transparencySensor = new SoFieldSensor( updateTransparency, this );
 	m_transparencySensor->setPriority( 1 );
 	m_transparencySensor->attach( &m_transparency );
+
+	ComputeTraceParameters();
 }
 
 MaterialStandardSpecular::~MaterialStandardSpecular()
@@ -154,44 +157,42 @@ void MaterialStandardSpecular::updateTransparency( void* data, SoSensor* )
 bool MaterialStandardSpecular::OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
 {
 	double randomNumber = rand.RandomDouble();
-	if ( randomNumber >= m_reflectivity.getValue()  ) return false;//return 0;
+	if ( randomNumber >= m_reflectivityValue  ) return false;//return 0;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
+
+/*!
+ * Reflects the \a incident ray with the reflectivity of each band defined in the m_bandReflectivity field.
+ * Without values per band or without bands in the \a weights, the m_reflectivity field is used.
+ */
+bool MaterialStandardSpecular::OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+		SpectralWeights* weights ) const
+{
+	if( m_bandReflectivityValues.empty() || !weights || ( weights->nBands < 1 ) )	return OutputRay( incident, dg, rand, outputRay );
+	if( !weights->Attenuate( &m_bandReflectivityValues[0], int( m_bandReflectivityValues.size() ), rand ) )	return false;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
 
+/*!
+ * Computes in \a outputRay the reflection of the \a incident ray with the slope error.
+ */
+void MaterialStandardSpecular::ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
+{
 	//Compute reflected ray (local coordinates )
 	//Ray* reflected = new Ray();
 	//reflected.origin = dg->point;
 	outputRay->origin = dg->point;
 
 	NormalVector normalVector;
-	double sigmaSlope = m_sigmaSlope.getValue() / 1000;
-	if( sigmaSlope > 0.0 )
+	if( m_slopeError.GetSigma() > 0.0 )
 	{
-		NormalVector errorNormal;
-		if ( m_distribution.getValue() == 0 )
-		{
-			double phi = gc::TwoPi * rand.RandomDouble();
-			double theta = sigmaSlope * rand.RandomDouble();
-
-			errorNormal.x = sin( theta ) * sin( phi ) ;
-			errorNormal.y = cos( theta );
-			errorNormal.z = sin( theta ) * cos( phi );
-		 }
-		 else if (m_distribution.getValue() == 1 )
-		 {
-			 errorNormal.x = sigmaSlope * tgf::AlternateBoxMuller( rand );
-			 errorNormal.y = 1.0;
-			 errorNormal.z = sigmaSlope * tgf::AlternateBoxMuller( rand );
-
-		 }
-		Vector3D r = dg->normal;
-		Vector3D s = Normalize( dg->dpdu );
-		Vector3D t = Normalize( dg->dpdv );
-		Transform trasform( s.x, s.y, s.z, 0.0,
-								r.x, r.y, r.z, 0.0,
-								t.x, t.y, t.z, 0.0,
-								0.0, 0.0, 0.0, 1.0);
-
-		NormalVector normalDirection = trasform.GetInverse()( errorNormal );
-		normalVector = Normalize( normalDirection );
+		Vector3D errorNormal = m_slopeError.Sample( rand );
+		OrthonormalBasis surfaceBasis( dg->normal, dg->dpdu );
+		normalVector = Normalize( NormalVector( surfaceBasis.ToWorld( errorNormal ) ) );
 	}
 	else
 	{
@@ -200,6 +201,25 @@ bool MaterialStandardSpecular::OutputRay( const Ray& incident, DifferentialGeome
 
 	double cosTheta = DotProduct( normalVector, incident.direction() );
 	outputRay->setDirection( Normalize( incident.direction() - 2.0 * normalVector * cosTheta ) );
-	return true;
 
 }
+
+/*!
+ * Returns the differential geometry fields needed by OutputRay.
+ * The normal and the surface tangents are used to compute the reflected direction.
+ */
+int MaterialStandardSpecular::RequiredGeometry() const
+{
+	return DifferentialGeometry::SURFACE_TANGENTS;
+}
+
+/*!
+ * Stores the reflectivity and the slope error distribution, with the error in radians.
+ * The m_bandReflectivity values, separated by spaces, commas or semicolons, are limited to the [0, 1] range.
+ */
+void MaterialStandardSpecular::ComputeTraceParameters()
+{
+	m_reflectivityValue = m_reflectivity.getValue();
+	m_bandReflectivityValues = SpectralWeights::ReadBandFactors( m_bandReflectivity.getValue().getString() );
+	m_slopeError = ErrorDistribution( m_distribution.getValue(), m_sigmaSlope.getValue() / 1000 );
+}
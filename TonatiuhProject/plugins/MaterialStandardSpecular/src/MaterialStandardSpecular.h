@@ -39,11 +39,14 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef MATERIALSTANDARDSPECULAR_H_
 #define MATERIALSTANDARDSPECULAR_H_
 
+#include <vector>
+
 #include <Inventor/fields/SoSFDouble.h>
 #include <Inventor/fields/SoSFEnum.h>
 #include <Inventor/fields/SoSFFloat.h>
 #include <Inventor/fields/SoSFString.h>
 
+#include "ErrorDistribution.h"
 #include "TMaterial.h"
 #include "trt.h"
 
@@ -64,10 +67,14 @@ public:
 
     QString getIcon();
 	bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const;
+	bool OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+			SpectralWeights* weights ) const;
+	int RequiredGeometry() const;
 
 	trt::TONATIUH_REAL m_reflectivity;
 	trt::TONATIUH_REAL m_sigmaSlope;
 	SoSFEnum m_distribution;
+	SoSFString m_bandReflectivity;
 
 	SoMFColor  m_ambientColor;
 	SoMFColor  m_diffuseColor;
@@ -82,6 +89,8 @@ protected:
 
    	double m_sigmaOpt;
 
+	void ComputeTraceParameters();
+
 	static void updateReflectivity( void* data, SoSensor* );
 	static void updateAmbientColor( void* data, SoSensor* );
 	static void updateDiffuseColor( void* data, SoSensor* );
@@ -90,6 +99,12 @@ protected:
 	static void updateShininess( void* data, SoSensor* );
 	static void updateTransparency( void* data, SoSensor* );
 
+private:
+	void ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const;
+
+	double m_reflectivityValue;
+	std::vector< double > m_bandReflectivityValues;
+	ErrorDistribution m_slopeError;
 };
 
 #endif /*MATERIALSTANDARDSPECULAR_H_*/
@@ -0,0 +1,278 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include <QMessageBox>
+#include <QString>
+
+#include <Inventor/sensors/SoFieldSensor.h>
+
+#include "DifferentialGeometry.h"
+#include "MaterialTabulatedSpecular.h"
+#include "OrthonormalBasis.h"
+#include "RandomDeviate.h"
+#include "Ray.h"
+#include "SpectralWeights.h"
+#include "Vector3D.h"
+
+
+SO_NODE_SOURCE(MaterialTabulatedSpecular);
+
+void MaterialTabulatedSpecular::initClass()
+{
+	SO_NODE_INIT_CLASS( MaterialTabulatedSpecular, TMaterial, "Material" );
+}
+
+MaterialTabulatedSpecular::MaterialTabulatedSpecular()
+{
+	SO_NODE_CONSTRUCTOR( MaterialTabulatedSpecular );
+	SO_NODE_ADD_FIELD( reflectanceFile, ("") );
+	SO_NODE_ADD_FIELD( reflectivity, (1.0) );
+	SO_NODE_ADD_FIELD( sigmaSlope, (2.0) );
+	SO_NODE_ADD_FIELD( sigmaSpecularity, (0.0) );
+
+	SO_NODE_DEFINE_ENUM_VALUE( Distribution, PILLBOX );
+	SO_NODE_DEFINE_ENUM_VALUE( Distribution, NORMAL );
+	SO_NODE_SET_SF_ENUM_TYPE( distribution, Distribution );
+	SO_NODE_ADD_FIELD( distribution, (PILLBOX) );
+	SO_NODE_ADD_FIELD( bandReflectivity, ("") );
+
+	SO_NODE_ADD_FIELD( mAmbientColor, (0.2f, 0.2f, 0.2f) );
+	SO_NODE_ADD_FIELD( mDiffuseColor, (0.8f, 0.8f, 0.8f) );
+	SO_NODE_ADD_FIELD( mSpecularColor, (0.0, 0.0, 0.0) );
+	SO_NODE_ADD_FIELD( mEmissiveColor, (0.0, 0.0, 0.0) );
+	SO_NODE_ADD_FIELD( mShininess, (0.2f) );
+	SO_NODE_ADD_FIELD( mTransparency, (0.0f) );
+
+	SoFieldSensor* reflectanceFileSensor = new SoFieldSensor( updateReflectanceFile, this );
+	reflectanceFileSensor->setPriority( 1 );
+	reflectanceFileSensor->attach( &reflectanceFile );
+	SoFieldSensor* reflectivitySensor = new SoFieldSensor( updateReflectivity, this );
+	reflectivitySensor->setPriority( 1 );
+	reflectivitySensor->attach( &reflectivity );
+
+	SoFieldSensor* ambientColorSensor = new SoFieldSensor( updateAmbientColor, this );
+	ambientColorSensor->setPriority( 1 );
+	ambientColorSensor->attach( &mAmbientColor );
+	SoFieldSensor* diffuseColorSensor = new SoFieldSensor( updateDiffuseColor, this );
+	diffuseColorSensor->setPriority( 1 );
+	diffuseColorSensor->attach( &mDiffuseColor );
+	SoFieldSensor* specularColorSensor = new SoFieldSensor( updateSpecularColor, this );
+	specularColorSensor->setPriority( 1 );
+	specularColorSensor->attach( &mSpecularColor );
+	SoFieldSensor* emissiveColorSensor = new SoFieldSensor( updateEmissiveColor, this );
+	emissiveColorSensor->setPriority( 1 );
+	emissiveColorSensor->attach( &mEmissiveColor );
+	SoFieldSensor* shininessSensor = new SoFieldSensor( updateShininess, this );
+	shininessSensor->setPriority( 1 );
+	shininessSensor->attach( &mShininess );
+	SoFieldSensor* transparencySensor = new SoFieldSensor( updateTransparency, this );
+	transparencySensor->setPriority( 1 );
+	transparencySensor->attach( &mTransparency );
+
+	ComputeTraceParameters();
+}
+
+MaterialTabulatedSpecular::~MaterialTabulatedSpecular()
+{
+}
+
+QString MaterialTabulatedSpecular::getIcon()
+{
+	return QString(":icons/MaterialTabulatedSpecular.png");
+}
+
+/*!
+ * Reads the reflectance table from the new file. If the file cannot be read, the last valid file is restored.
+ */
+void MaterialTabulatedSpecular::updateReflectanceFile( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+
+	QString fileName( material->reflectanceFile.getValue().getString() );
+	if( fileName.isEmpty() )
+	{
+		material->m_reflectanceTable.Clear();
+		material->m_lastValidReflectanceFile = fileName;
+		return;
+	}
+
+	QString errorMessage;
+	if( !material->m_reflectanceTable.Read( fileName, &errorMessage ) )
+	{
+		QMessageBox::warning( 0, QString( "Tonatiuh" ), errorMessage );
+		material->reflectanceFile.setValue( material->m_lastValidReflectanceFile.toStdString().c_str() );
+		return;
+	}
+
+	material->m_lastValidReflectanceFile = fileName;
+}
+
+void MaterialTabulatedSpecular::updateReflectivity( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	if( material->reflectivity.getValue() < 0.0 ) material->reflectivity = 0.0;
+	if( material->reflectivity.getValue() > 1.0 ) material->reflectivity = 1.0;
+}
+
+void MaterialTabulatedSpecular::updateAmbientColor( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->ambientColor.setValue( material->mAmbientColor[0] );
+}
+
+void MaterialTabulatedSpecular::updateDiffuseColor( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->diffuseColor.setValue( material->mDiffuseColor[0] );
+}
+
+void MaterialTabulatedSpecular::updateSpecularColor( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->specularColor.setValue( material->mSpecularColor[0] );
+}
+
+void MaterialTabulatedSpecular::updateEmissiveColor( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->emissiveColor.setValue( material->mEmissiveColor[0] );
+}
+
+void MaterialTabulatedSpecular::updateShininess( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->shininess.setValue( material->mShininess[0] );
+}
+
+void MaterialTabulatedSpecular::updateTransparency( void* data, SoSensor* )
+{
+	MaterialTabulatedSpecular* material = static_cast< MaterialTabulatedSpecular* >( data );
+	material->transparency.setValue( material->mTransparency[0] );
+}
+
+/*!
+ * Reflects the \a incident ray with the reflectance of its incidence angle with the surface normal.
+ * The absorption test is done before sampling the errors, so the absorbed rays do not consume error samples.
+ */
+bool MaterialTabulatedSpecular::OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
+{
+	double cosIncidence = fabs( DotProduct( dg->normal, incident.direction() ) );
+	double randomNumber = rand.RandomDouble();
+	if ( randomNumber >= m_reflectivity * m_reflectanceTable.Value( cosIncidence ) ) return false;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
+
+/*!
+ * Reflects the \a incident ray with the reflectance of its incidence angle multiplied by the bandReflectivity value
+ * of each band. Without values per band or without bands in the \a weights, the reflectivity field is used.
+ */
+bool MaterialTabulatedSpecular::OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+		SpectralWeights* weights ) const
+{
+	if( m_bandReflectivity.empty() || !weights || ( weights->nBands < 1 ) )	return OutputRay( incident, dg, rand, outputRay );
+
+	double reflectance = m_reflectanceTable.Value( fabs( DotProduct( dg->normal, incident.direction() ) ) );
+	int numberOfFactors = std::min( int( m_bandReflectivity.size() ), int( SpectralWeights::m_maxBands ) );
+	double bandFactors[SpectralWeights::m_maxBands];
+	for( int b = 0; b < numberOfFactors; ++b )	bandFactors[b] = m_bandReflectivity[b] * reflectance;
+	if( !weights->Attenuate( bandFactors, numberOfFactors, rand ) )	return false;
+
+	ReflectRay( incident, dg, rand, outputRay );
+	return true;
+}
+
+/*!
+ * Computes in \a outputRay the reflection of the \a incident ray with the slope and specularity errors.
+ */
+void MaterialTabulatedSpecular::ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const
+{
+	//Compute reflected ray (local coordinates )
+	outputRay->origin = dg->point;
+
+	NormalVector normalVector;
+	if( m_slopeError.GetSigma() > 0.0 )
+	{
+		Vector3D errorNormal = Normalize( m_slopeError.Sample( rand ) );
+		OrthonormalBasis surfaceBasis( dg->normal, dg->dpdu );
+		normalVector = NormalVector( surfaceBasis.ToWorld( errorNormal ) );
+	}
+	else
+	{
+		normalVector = dg->normal;
+	}
+
+	double cosTheta = DotProduct( normalVector, incident.direction() );
+	outputRay->setDirection( Normalize( incident.direction() - 2.0 * normalVector * cosTheta ) );
+
+	//Add error to reflected ray
+	if( m_specularityError.GetSigma() > 0.0 )
+	{
+		Vector3D errorReflectedRay = m_specularityError.Sample( rand );
+
+		OrthonormalBasis reflectedBasis( outputRay->direction(), CrossProduct( outputRay->direction(), dg->normal ) );
+		outputRay->setDirection( Normalize( reflectedBasis.ToWorld( errorReflectedRay ) ) );
+	}
+}
+
+/*!
+ * Returns the differential geometry fields needed by OutputRay.
+ * The normal and the surface tangents are used to compute the reflected direction.
+ */
+int MaterialTabulatedSpecular::RequiredGeometry() const
+{
+	return DifferentialGeometry::SURFACE_TANGENTS;
+}
+
+/*!
+ * Stores the reflectivity factor and the slope and specularity error distributions, with the errors in radians.
+ * The reflectance table is built when the file changes. The bandReflectivity values, separated by spaces, commas
+ * or semicolons, are limited to the [0, 1] range.
+ */
+void MaterialTabulatedSpecular::ComputeTraceParameters()
+{
+	m_reflectivity = reflectivity.getValue();
+	m_bandReflectivity = SpectralWeights::ReadBandFactors( bandReflectivity.getValue().getString() );
+	m_slopeError = ErrorDistribution( distribution.getValue(), sigmaSlope.getValue() / 1000 );
+	m_specularityError = ErrorDistribution( distribution.getValue(), sigmaSpecularity.getValue() / 1000 );
+}
@@ -0,0 +1,127 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef MATERIALTABULATEDSPECULAR_H_
+#define MATERIALTABULATEDSPECULAR_H_
+
+#include <vector>
+
+#include <QString>
+
+#include <Inventor/fields/SoSFDouble.h>
+#include <Inventor/fields/SoSFEnum.h>
+#include <Inventor/fields/SoSFFloat.h>
+#include <Inventor/fields/SoSFString.h>
+
+#include "ErrorDistribution.h"
+#include "ReflectanceTable.h"
+#include "TMaterial.h"
+#include "trt.h"
+
+class SoSensor;
+
+/*!
+ * Specular material whose reflectance depends on the incidence angle.
+ *
+ * The reflectance for each incidence angle is read from the file \a reflectanceFile, as described
+ * in ReflectanceTable, and multiplied by \a reflectivity, that can be used for the cleanliness of
+ * the surface. Without a file the material reflects the fraction \a reflectivity of the rays for all the angles.
+ * In spectral traces the values of \a bandReflectivity, if defined, replace \a reflectivity for each band.
+ *
+ * The slope and specularity errors are the same as in the standard rough specular material.
+ */
+class MaterialTabulatedSpecular : public TMaterial
+{
+	SO_NODE_HEADER(MaterialTabulatedSpecular);
+
+public:
+	enum Distribution {
+		PILLBOX = 0,
+		NORMAL = 1,
+	   };
+	MaterialTabulatedSpecular( );
+	static void initClass();
+
+	QString getIcon();
+	bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const;
+	bool OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+			SpectralWeights* weights ) const;
+	int RequiredGeometry() const;
+
+	SoSFString reflectanceFile;
+	trt::TONATIUH_REAL reflectivity;
+	trt::TONATIUH_REAL sigmaSlope;
+	trt::TONATIUH_REAL sigmaSpecularity;
+	SoSFEnum distribution;
+	SoSFString bandReflectivity;
+
+	SoMFColor mAmbientColor;
+	SoMFColor mDiffuseColor;
+	SoMFColor mSpecularColor;
+	SoMFColor mEmissiveColor;
+	SoMFFloat mShininess;
+	SoMFFloat mTransparency;
+
+protected:
+	virtual ~MaterialTabulatedSpecular();
+
+	void ComputeTraceParameters();
+
+	static void updateReflectanceFile( void* data, SoSensor* );
+	static void updateReflectivity( void* data, SoSensor* );
+	static void updateAmbientColor( void* data, SoSensor* );
+	static void updateDiffuseColor( void* data, SoSensor* );
+	static void updateSpecularColor( void* data, SoSensor* );
+	static void updateEmissiveColor( void* data, SoSensor* );
+	static void updateShininess( void* data, SoSensor* );
+	static void updateTransparency( void* data, SoSensor* );
+
+private:
+	void ReflectRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay ) const;
+
+	ReflectanceTable m_reflectanceTable;
+	QString m_lastValidReflectanceFile;
+
+	double m_reflectivity;
+	std::vector< double > m_bandReflectivity;
+	ErrorDistribution m_slopeError;
+	ErrorDistribution m_specularityError;
+};
+
+#endif /* MATERIALTABULATEDSPECULAR_H_ */
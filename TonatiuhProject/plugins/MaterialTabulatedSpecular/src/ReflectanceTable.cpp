@@ -0,0 +1,162 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+
+#include "gc.h"
+
+#include "ReflectanceTable.h"
+
+ReflectanceTable::ReflectanceTable()
+{
+}
+
+ReflectanceTable::~ReflectanceTable()
+{
+}
+
+bool ReflectanceTable::IsEmpty() const
+{
+	return m_grid.empty();
+}
+
+void ReflectanceTable::Clear()
+{
+	m_grid.clear();
+}
+
+/*!
+ * Builds the cosine grid from the reflectances measured at the incidence angles \a angles, in degrees.
+ * The grid values are the linear interpolation in angle of the measured values.
+ *
+ * Returns false and leaves the table unchanged if the vectors are empty or have different sizes, or
+ * if any angle is not between 0 and 90 degrees or any reflectance is not between 0 and 1.
+ */
+bool ReflectanceTable::Create( const std::vector< double >& angles, const std::vector< double >& reflectances )
+{
+	if( angles.empty() || ( angles.size() != reflectances.size() ) ) return false;
+
+	std::vector< std::pair< double, double > > points;
+	for( unsigned int i = 0; i < angles.size(); ++i )
+	{
+		if( !( angles[i] >= 0.0 && angles[i] <= 90.0 ) ) return false;
+		if( !( reflectances[i] >= 0.0 && reflectances[i] <= 1.0 ) ) return false;
+		points.push_back( std::make_pair( angles[i] * gc::Degree, reflectances[i] ) );
+	}
+	std::sort( points.begin(), points.end() );
+
+	std::vector< double > grid( m_numberOfIntervals + 1 );
+	unsigned int next = 0;
+	for( int k = m_numberOfIntervals; k >= 0; --k )
+	{
+		// The angle grows as the cosine decreases, so the points are visited in order
+		double theta = acos( double( k ) / m_numberOfIntervals );
+		while( ( next < points.size() ) && ( points[next].first <= theta ) ) ++next;
+
+		if( next == 0 ) grid[k] = points.front().second;
+		else if( next == points.size() ) grid[k] = points.back().second;
+		else
+		{
+			const std::pair< double, double >& p0 = points[next - 1];
+			const std::pair< double, double >& p1 = points[next];
+			double f = ( theta - p0.first ) / ( p1.first - p0.first );
+			grid[k] = p0.second + f * ( p1.second - p0.second );
+		}
+	}
+
+	m_grid.swap( grid );
+	return true;
+}
+
+/*!
+ * Reads the incidence angles and reflectances in \a fileName and builds the table with them.
+ * The values of each line can be separated by spaces, tabs, commas or semicolons.
+ *
+ * If the file cannot be read, \a errorMessage describes the error, the table is not changed and false is returned.
+ */
+bool ReflectanceTable::Read( QString fileName, QString* errorMessage )
+{
+	QFile inputFile( fileName );
+	if( !inputFile.open( QIODevice::ReadOnly ) )
+	{
+		*errorMessage = QString( "The file %1 cannot be opened." ).arg( fileName );
+		return false;
+	}
+
+	std::vector< double > angles;
+	std::vector< double > reflectances;
+
+	QTextStream in( &inputFile );
+	int lineNumber = 0;
+	while( !in.atEnd() )
+	{
+		++lineNumber;
+		QString line = in.readLine().trimmed();
+		if( line.isEmpty() || line.startsWith( QLatin1Char( '#' ) ) ) continue;
+
+		QStringList lineData = line.split( QRegExp( "[\\s,;]+" ), QString::SkipEmptyParts );
+		bool okAngle = false, okReflectance = false;
+		if( lineData.size() == 2 )
+		{
+			angles.push_back( lineData[0].toDouble( &okAngle ) );
+			reflectances.push_back( lineData[1].toDouble( &okReflectance ) );
+		}
+		if( !okAngle || !okReflectance )
+		{
+			*errorMessage = QString( "Invalid values in line %1 of file %2." ).arg( QString::number( lineNumber ), fileName );
+			return false;
+		}
+	}
+	inputFile.close();
+
+	if( !Create( angles, reflectances ) )
+	{
+		*errorMessage = QString( "The file %1 does not define a valid reflectance table. The angles must be between 0 and 90 degrees "
+				"and the reflectances between 0 and 1." ).arg( fileName );
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef REFLECTANCETABLE_H_
+#define REFLECTANCETABLE_H_
+
+#include <vector>
+
+#include <QString>
+
+/*!
+ * Reflectance of a surface as a function of the incidence angle, read from a text file.
+ *
+ * Each line of the file has the incidence angle, in degrees from the surface normal, and the
+ * reflectance for that angle. Empty lines and lines that start with '#' are ignored. The angles
+ * do not need to be sorted or equally spaced.
+ *
+ * Create interpolates the measured values in a grid uniformly spaced in the cosine of the
+ * incidence angle, so Value only needs the cosine given by the dot product of the ray direction
+ * and the surface normal and a linear interpolation between two grid values. The reflectance of
+ * the angles outside the measured range is the reflectance of the closest measured angle.
+ * An empty table has reflectance one for all the angles.
+ */
+class ReflectanceTable
+{
+public:
+	ReflectanceTable();
+	~ReflectanceTable();
+
+	bool IsEmpty() const;
+	void Clear();
+	bool Create( const std::vector< double >& angles, const std::vector< double >& reflectances );
+	bool Read( QString fileName, QString* errorMessage );
+
+	double Value( double cosTheta ) const
+	{
+		if( m_grid.empty() ) return 1.0;
+
+		double x = cosTheta * m_numberOfIntervals;
+		if( x <= 0.0 ) return m_grid[0];
+		int i = int( x );
+		if( i >= m_numberOfIntervals ) return m_grid[m_numberOfIntervals];
+		double f = x - i;
+		return m_grid[i] + f * ( m_grid[i + 1] - m_grid[i] );
+	}
+
+private:
+	enum { m_numberOfIntervals = 1024 };
+
+	std::vector< double > m_grid;
+};
+
+#endif /* REFLECTANCETABLE_H_ */
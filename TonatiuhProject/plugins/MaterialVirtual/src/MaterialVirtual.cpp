@@ -141,3 +141,12 @@ bool MaterialVirtual::OutputRay( const Ray& incident, DifferentialGeometry* dg,
 	return true;
 
 }
+
+/*!
+ * Returns the differential geometry fields needed by OutputRay.
+ * Only the intersection point is used to compute the output ray.
+ */
+int MaterialVirtual::RequiredGeometry() const
+{
+	return DifferentialGeometry::POINT_ONLY;
+}
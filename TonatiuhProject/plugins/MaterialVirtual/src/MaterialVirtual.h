@@ -30,6 +30,7 @@ public:
 
     QString getIcon();
 	bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const;
+	int RequiredGeometry() const;
 
 	SoMFColor  m_ambientColor;
 	SoMFColor  m_diffuseColor;
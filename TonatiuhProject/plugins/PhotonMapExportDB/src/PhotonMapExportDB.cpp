@@ -53,7 +53,9 @@ PhotonMapExportDB::PhotonMapExportDB()
  m_exportedPhoton( 0 ),
  m_isDBOpened( false ),
  m_isWPhoton( false ),
- m_pDB( 0 )
+ m_pDB( 0 ),
+ m_numberOfBands( 0 ),
+ m_bandWeightsStmt( 0 )
 {
 
 }
@@ -96,19 +98,31 @@ QStringList PhotonMapExportDB::GetParameterNames()
 }
 /*!
  * Saves \a rayLists data into the database.
+ *
+ * If the path length is saved, the Photons table has a pathLength column with the length of the ray segment that
+ * arrives to each photon, to apply the atmospheric attenuation after the trace.
+ *
+ * For spectral traces the weights of each photon are saved in the BandWeights table, with the photon identifier and
+ * a column per band. The power of the photon in a band is its weight multiplied by the power per photon.
  */
-void PhotonMapExportDB::SavePhotonMap( std::vector< Photon* > raysLists )
+void PhotonMapExportDB::SavePhotonMap( const PhotonArena& raysLists )
 {
 
 	if( !m_isDBOpened )	Open();
+	PrepareBandWeights( raysLists );
 
-	if( m_saveCoordinates && m_saveSide && m_savePrevNexID && m_saveSurfaceID )
+	if( m_saveCoordinates && m_saveSide && m_savePrevNexID && m_saveSurfaceID && !m_savePathLength )
 		SaveAllData( raysLists );
-	else if( m_saveCoordinates && m_saveSide && !m_savePrevNexID && m_saveSurfaceID )
+	else if( m_saveCoordinates && m_saveSide && !m_savePrevNexID && m_saveSurfaceID && !m_savePathLength )
 		SaveNotNextPrevID( raysLists );
 	else
 		SaveSelectedData( raysLists );
 
+	if( m_bandWeightsStmt )
+	{
+		sqlite3_finalize( m_bandWeightsStmt );
+		m_bandWeightsStmt = 0;
+	}
 }
 
 
@@ -190,6 +204,7 @@ void PhotonMapExportDB::InsertSurface( InstanceNode* instance )
 
 
 	int surfaceID = m_surfaceIdentfier.size();
+	m_surfaceIDs.insert( instance, surfaceID );
 	QString surfaceURL = QString(" ").append( instance->GetNodeURL() );
 
 	std::stringstream surfaces;
@@ -201,6 +216,16 @@ void PhotonMapExportDB::InsertSurface( InstanceNode* instance )
 
 }
 
+/*!
+ * Returns the position of \a photon in the coordinates of the surface with identifier \a surfaceID.
+ * The photons without surface keep their world position.
+ */
+Point3D PhotonMapExportDB::ObjectPosition( const Photon* photon, unsigned long surfaceID ) const
+{
+	if( surfaceID < 1 )	return photon->Position();
+	return m_surfaceWorldToObject[surfaceID - 1]( photon->Position() );
+}
+
 /*!
  * Opens database
  */
@@ -236,6 +261,9 @@ bool PhotonMapExportDB::Open()
 			if( m_savePrevNexID )
 				createPhotonsTableCmmd.append( QLatin1String( ", previousID INTEGER, nextID INTEGER" ) );
 
+			if( m_savePathLength )
+				createPhotonsTableCmmd.append( QLatin1String( ", pathLength REAL" ) );
+
 			if( m_saveSurfaceID )
 				createPhotonsTableCmmd.append( QLatin1String( ", surfaceID INTEGER,"
 						" FOREIGN KEY( surfaceID ) REFERENCES surfaces ( id ) " )  );
@@ -305,6 +333,43 @@ bool PhotonMapExportDB::Open()
 	return 1;
 }
 
+/*!
+ * Creates the BandWeights table if the photons of \a raysLists have band weights and prepares the statement to
+ * insert them. The table has the columns of the bands of the first spectral photons exported.
+ */
+void PhotonMapExportDB::PrepareBandWeights( const PhotonArena& raysLists )
+{
+	if( raysLists.size() < 1 )	return;
+
+	int numberOfBands = raysLists.BandWeights( 0 ).nBands;
+	if( numberOfBands < 1 )	return;
+	if( m_numberOfBands < 1 )	m_numberOfBands = numberOfBands;
+
+	QString createBandWeightsTableCmmd( QLatin1String( "CREATE TABLE IF NOT EXISTS BandWeights( photonID INTEGER PRIMARY KEY" ) );
+	QString insertCommand( QLatin1String( "INSERT INTO BandWeights VALUES( @photonID" ) );
+	for( int b = 0; b < m_numberOfBands; ++b )
+	{
+		createBandWeightsTableCmmd.append( QString( ", band%1 REAL" ).arg( QString::number( b + 1 ) ) );
+		insertCommand.append( QString( ", @band%1" ).arg( QString::number( b + 1 ) ) );
+	}
+	createBandWeightsTableCmmd.append( QLatin1String( ", FOREIGN KEY( photonID ) REFERENCES Photons ( id ) );" ) );
+	insertCommand.append( QLatin1String( " )" ) );
+
+	char* zErrMsg = 0;
+	int rc = sqlite3_exec( m_pDB, createBandWeightsTableCmmd.toStdString().c_str(), 0, 0, &zErrMsg );
+	if( rc != SQLITE_OK )
+	{
+		QString message( "Error creating band weights table:\n " );
+		message.append( QString( zErrMsg ) );
+		QMessageBox::warning( NULL, QLatin1String( "Tonatiuh" ), message );
+		sqlite3_free( zErrMsg );
+		return;
+	}
+
+	const char* tail = 0;
+	sqlite3_prepare( m_pDB, insertCommand.toStdString().c_str(), -1, &m_bandWeightsStmt, &tail );
+}
+
 void PhotonMapExportDB::RemoveExistingFiles()
 {
 
@@ -326,7 +391,7 @@ void PhotonMapExportDB::RemoveExistingFiles()
 /*!
  * Saves for each photon all the data.
  */
-void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
+void PhotonMapExportDB::SaveAllData( const PhotonArena& raysLists )
 {
 
 	const char* tail = 0;
@@ -345,13 +410,13 @@ void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
 	{
 		for( unsigned int i = 0; i < raysLists.size(); i++ )
 		{
-			Photon* photon = raysLists[i];
+			const Photon* photon = raysLists[i];
 			if( photon->id < 1 )	previousPhotonID = 0;
 
 			sqlite3_bind_text( stmt, 1, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveCoordinates
-			Point3D photonPos =  m_concentratorToWorld( photon->pos );
+			Point3D photonPos =  m_concentratorToWorld( photon->Position() );
 			sqlite3_bind_text( stmt, 2, QString::number( photonPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 3, QString::number( photonPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 4, QString::number( photonPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -367,21 +432,14 @@ void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
 			sqlite3_bind_text( stmt, 7, QString::number( nextPhotonID ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveSurfaceID
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-					InsertSurface( photon->intersectedSurface );
-
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-
-			}
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 			sqlite3_bind_text( stmt, 8, QString::number( urlId ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 
 			sqlite3_step( stmt );
 			sqlite3_clear_bindings( stmt );
 			sqlite3_reset( stmt );
+			SaveBandWeights( m_exportedPhoton, raysLists.BandWeights( i ) );
 
 			previousPhotonID = m_exportedPhoton;
 		}
@@ -391,30 +449,16 @@ void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
 		for( unsigned int i = 0; i < raysLists.size(); i++ )
 		{
 			std::stringstream ss;
-			Photon* photon = raysLists[i];
+			const Photon* photon = raysLists[i];
 			if( photon->id < 1 )	previousPhotonID = 0;
 
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-					0.0, 1.0, 0.0, 0.0,
-					0.0, 0.0, 1.0, 0.0,
-					0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
-
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-					InsertSurface( photon->intersectedSurface );
-
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-				worldToObject = m_surfaceWorldToObject[urlId];
-				urlId++;
-			}
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 
 			sqlite3_bind_text( stmt, 1, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveCoordinates
-			Point3D photonPos = worldToObject(  photon->pos );
+			Point3D photonPos = ObjectPosition( photon, urlId );
 			sqlite3_bind_text( stmt, 2, QString::number( photonPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 3, QString::number( photonPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 4, QString::number( photonPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -436,6 +480,7 @@ void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
 			sqlite3_step( stmt );
 			sqlite3_clear_bindings( stmt );
 			sqlite3_reset( stmt );
+			SaveBandWeights( m_exportedPhoton, raysLists.BandWeights( i ) );
 			previousPhotonID = m_exportedPhoton;
 		}
 	}
@@ -449,10 +494,30 @@ void PhotonMapExportDB::SaveAllData( std::vector< Photon* > raysLists )
 	}
 }
 
+/*!
+ * Saves in the BandWeights table the \a bandWeights of the photon with identifier \a photonID.
+ * Nothing is saved for traces that are not spectral.
+ */
+void PhotonMapExportDB::SaveBandWeights( unsigned long photonID, const SpectralWeights& bandWeights )
+{
+	if( !m_bandWeightsStmt )	return;
+
+	sqlite3_bind_text( m_bandWeightsStmt, 1, QString::number( photonID ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
+	for( int b = 0; b < m_numberOfBands; ++b )
+	{
+		double weight = ( b < bandWeights.nBands ) ? double( bandWeights.weight[b] ) : 0.0;
+		sqlite3_bind_text( m_bandWeightsStmt, b + 2, QString::number( weight ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
+	}
+
+	sqlite3_step( m_bandWeightsStmt );
+	sqlite3_clear_bindings( m_bandWeightsStmt );
+	sqlite3_reset( m_bandWeightsStmt );
+}
+
 /*!
  * Saves for each photon all the data, except previous and next photon identifier.
  */
-void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
+void PhotonMapExportDB::SaveNotNextPrevID( const PhotonArena& raysLists )
 {
 
 	const char* tail = 0;
@@ -471,13 +536,13 @@ void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
 
 		for( unsigned int i = 0; i < nPhotonElements; i++ )
 		{
-			Photon* photon = raysLists[i];
+			const Photon* photon = raysLists[i];
 
 
 			sqlite3_bind_text( stmt, 1, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveCoordinates
-			Point3D photonPos =  m_concentratorToWorld( photon->pos );
+			Point3D photonPos =  m_concentratorToWorld( photon->Position() );
 			sqlite3_bind_text( stmt, 2, QString::number( photonPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 3, QString::number( photonPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 4, QString::number( photonPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -486,21 +551,14 @@ void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
 			sqlite3_bind_text( stmt, 5, QString::number( photon->side ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveSurfaceID
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-					InsertSurface( photon->intersectedSurface );
-
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-
-			}
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 			sqlite3_bind_text( stmt, 6, QString::number( urlId ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 
 			sqlite3_step( stmt );
 			sqlite3_clear_bindings( stmt );
 			sqlite3_reset( stmt );
+			SaveBandWeights( m_exportedPhoton, raysLists.BandWeights( i ) );
 		}
 	}
 	else
@@ -508,28 +566,14 @@ void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
 		for( unsigned int i = 0; i < nPhotonElements; i++ )
 		{
 			std::stringstream ss;
-			Photon* photon = raysLists[i];
-
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-					0.0, 1.0, 0.0, 0.0,
-					0.0, 0.0, 1.0, 0.0,
-					0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
+			const Photon* photon = raysLists[i];
 
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-					InsertSurface( photon->intersectedSurface );
-
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-				worldToObject = m_surfaceWorldToObject[urlId];
-				urlId++;
-			}
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			sqlite3_bind_text( stmt, 1, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 			//m_saveCoordinates
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			sqlite3_bind_text( stmt, 2, QString::number( localPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 3, QString::number( localPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, 4, QString::number( localPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -544,6 +588,7 @@ void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
 			sqlite3_step( stmt );
 			sqlite3_clear_bindings( stmt );
 			sqlite3_reset( stmt );
+			SaveBandWeights( m_exportedPhoton, raysLists.BandWeights( i ) );
 
 
 		}
@@ -561,7 +606,7 @@ void PhotonMapExportDB::SaveNotNextPrevID( std::vector< Photon* > raysLists )
 /*!
  * Saves for each photon the selected data.
  */
-void PhotonMapExportDB::SaveSelectedData( std::vector< Photon* > raysLists )
+void PhotonMapExportDB::SaveSelectedData( const PhotonArena& raysLists )
 {
 
 
@@ -572,6 +617,7 @@ void PhotonMapExportDB::SaveSelectedData( std::vector< Photon* > raysLists )
 	if( m_saveCoordinates )	insertCommand.append( ", @x, @y, @z" );
 	if( m_saveSide )	insertCommand.append( ", @side" );
 	if( m_savePrevNexID )	insertCommand.append( ", @prev, @next" );
+	if( m_savePathLength )	insertCommand.append( ", @pathLength" );
 	if( m_saveSurfaceID )	insertCommand.append( ", @surfaceID" );
 	insertCommand.append( ")" );
 
@@ -587,30 +633,16 @@ void PhotonMapExportDB::SaveSelectedData( std::vector< Photon* > raysLists )
 	for( unsigned int i = 0; i < raysLists.size(); i++ )
 	{
 		int parameterIndex = 0;
-		Photon* photon = raysLists[i];
+		const Photon* photon = raysLists[i];
 		if( photon->id < 1 )	previousPhotonID = 0;
 
-		unsigned long urlId = 0;
-		Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-				0.0, 1.0, 0.0, 0.0,
-				0.0, 0.0, 1.0, 0.0,
-				0.0, 0.0, 0.0, 1.0 );
-		if( photon->intersectedSurface )
-		{
-
-			if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				InsertSurface( photon->intersectedSurface );
-
-			urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-			worldToObject = m_surfaceWorldToObject[urlId];
-			urlId++;
-		}
+		unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 		sqlite3_bind_text( stmt, ++parameterIndex, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
 		if( m_saveCoordinates && m_saveCoordinatesInGlobal )
 		{
-			Point3D photonPos =  m_concentratorToWorld( photon->pos );
+			Point3D photonPos =  m_concentratorToWorld( photon->Position() );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -618,7 +650,7 @@ void PhotonMapExportDB::SaveSelectedData( std::vector< Photon* > raysLists )
 		}
 		else if( m_saveCoordinates && !m_saveCoordinatesInGlobal )
 		{
-			Point3D photonPos = worldToObject( photon->pos );
+			Point3D photonPos = ObjectPosition( photon, urlId );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.x ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.y ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photonPos.z ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
@@ -637,14 +669,16 @@ void PhotonMapExportDB::SaveSelectedData( std::vector< Photon* > raysLists )
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( nextPhotonID ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 		}
 
+		if( m_savePathLength )
+			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( photon->pathLength ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
+
 		if( m_saveSurfaceID )
 			sqlite3_bind_text( stmt, ++parameterIndex, QString::number( urlId ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
 
-		sqlite3_bind_text( stmt, 1, QString::number(++m_exportedPhoton ).toStdString().c_str(), -1, SQLITE_TRANSIENT );
-
 		sqlite3_step( stmt );
 		sqlite3_clear_bindings( stmt );
 		sqlite3_reset( stmt );
+		SaveBandWeights( m_exportedPhoton, raysLists.BandWeights( i ) );
 
 		previousPhotonID = m_exportedPhoton;
 	}
@@ -675,3 +709,18 @@ void PhotonMapExportDB::SetDBFileName( QString filename )
 {
 	m_dbFileName = filename;
 }
+
+/*!
+ * Returns the identifier of \a surface in the Surfaces table, 0 for photons without surface. The surfaces are
+ * inserted in the table the first time they are found.
+ */
+unsigned long PhotonMapExportDB::SurfaceID( InstanceNode* surface )
+{
+	if( !surface )	return 0;
+
+	QHash< InstanceNode*, unsigned long >::const_iterator surfaceID = m_surfaceIDs.constFind( surface );
+	if( surfaceID != m_surfaceIDs.constEnd() )	return surfaceID.value();
+
+	InsertSurface( surface );
+	return m_surfaceIdentfier.size();
+}
@@ -39,6 +39,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef PHOTONMAPEXPORTDB_H_
 #define PHOTONMAPEXPORTDB_H_
 
+#include <QHash>
 #include <QMap>
 #include <QString>
 
@@ -55,7 +56,7 @@ public:
 
 	void EndExport();
 	static QStringList GetParameterNames();
-	void SavePhotonMap( std::vector< Photon* > raysLists );
+	void SavePhotonMap( const PhotonArena& raysLists );
 	void SetPowerPerPhoton( double wPhoton );
 	void SetSaveParameterValue( QString parameterName, QString parameterValue );
 	bool StartExport();
@@ -63,13 +64,17 @@ public:
 private:
     bool Close();
     void InsertSurface( InstanceNode* instance );
+	Point3D ObjectPosition( const Photon* photon, unsigned long surfaceID ) const;
 	bool Open();
-	void SaveAllData( std::vector< Photon* > raysLists );
-	void SaveNotNextPrevID( std::vector< Photon* > raysLists );
-	void SaveSelectedData( std::vector< Photon* > raysLists );
+	void PrepareBandWeights( const PhotonArena& raysLists );
+	void SaveBandWeights( unsigned long photonID, const SpectralWeights& bandWeights );
+	void SaveAllData( const PhotonArena& raysLists );
+	void SaveNotNextPrevID( const PhotonArena& raysLists );
+	void SaveSelectedData( const PhotonArena& raysLists );
 	void SetDBDirectory( QString path );
 	void SetDBFileName( QString filename );
 	void RemoveExistingFiles();
+	unsigned long SurfaceID( InstanceNode* surface );
 
 	QString m_dbFileName;
 	QString m_dbDirectory;
@@ -77,7 +82,10 @@ private:
 	bool m_isDBOpened;
 	bool m_isWPhoton;
     sqlite3* m_pDB;
+	int m_numberOfBands;
+	sqlite3_stmt* m_bandWeightsStmt;
 	QVector< InstanceNode* > m_surfaceIdentfier;
+	QHash< InstanceNode*, unsigned long > m_surfaceIDs;
 	QVector< Transform > m_surfaceWorldToObject;
 
 };
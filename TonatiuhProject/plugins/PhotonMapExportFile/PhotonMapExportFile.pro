@@ -23,7 +23,9 @@ HEADERS = src/*.h  \
 			$$(TONATIUH_ROOT)/src/source/gui/SceneModel.h \
 			$$(TONATIUH_ROOT)/src/source/raytracing/DifferentialGeometry.h \
             $$(TONATIUH_ROOT)/src/source/raytracing/Photon.h \
+            $$(TONATIUH_ROOT)/src/source/raytracing/PhotonArena.h \
             $$(TONATIUH_ROOT)/src/source/raytracing/PhotonMapExport.h  \
+            $$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.h \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TCube.h \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TDefaultMaterial.h\
 			$$(TONATIUH_ROOT)/src/source/raytracing/TDefaultSunShape.h \
@@ -52,7 +54,9 @@ SOURCES = src/*.cpp  \
             $$(TONATIUH_ROOT)/src/source/gui/PhotonMapExportParametersWidget.cpp \
 			$$(TONATIUH_ROOT)/src/source/gui/SceneModel.cpp \
             $$(TONATIUH_ROOT)/src/source/raytracing/Photon.cpp \
+            $$(TONATIUH_ROOT)/src/source/raytracing/PhotonArena.cpp \
             $$(TONATIUH_ROOT)/src/source/raytracing/PhotonMapExport.cpp \
+            $$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.cpp \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TCube.cpp \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TDefaultMaterial.cpp \
 			$$(TONATIUH_ROOT)/src/source/raytracing/TDefaultSunShape.cpp \
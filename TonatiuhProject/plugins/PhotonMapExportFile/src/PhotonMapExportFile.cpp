@@ -37,6 +37,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
 #include <iostream>
+#include <vector>
 
 #include <QDataStream>
 #include <QTextStream>
@@ -60,7 +61,9 @@ PhotonMapExportFile::PhotonMapExportFile()
  m_exportDirecotryName( QLatin1String( "" ) ),
  m_exportedPhotons( 0 ),
  m_nPhotonsPerFile( -1 ),
- m_oneFile( true )
+ m_oneFile( true ),
+ m_numberOfBands( 0 ),
+ m_rawFormat( false )
 {
 
 }
@@ -82,6 +85,8 @@ QStringList PhotonMapExportFile::GetParameterNames()
 	parametersNames<<QLatin1String( "ExportDirectory" );
 	parametersNames<<QLatin1String( "ExportFile" );
 	parametersNames<<QLatin1String( "FileSize" );
+	parametersNames<<QLatin1String( "FileFormat" );
+	parametersNames<<QLatin1String( "SavePathLength" );
 
 	return parametersNames;
 }
@@ -105,6 +110,9 @@ void PhotonMapExportFile::EndExport()
 	QString tmpFilename( QLatin1String( "tmpexportpotonmap.dat" ) );
 	QFile exportFile( exportFilename );
 
+	if( m_rawFormat && !m_rawFile.Close( m_powerPerPhoton ) )
+		std::cerr<<"PhotonMapExportFile: the photons cannot be written to the file "<<RawFileName().toStdString()<<"."<<std::endl;
+
 
 	WriteFileFormat( exportFilename );
 	exportFile.open( QIODevice::Append );
@@ -116,9 +124,13 @@ void PhotonMapExportFile::EndExport()
 /*!
  * Saves \a raysList photons to file.
  */
-void PhotonMapExportFile::SavePhotonMap( std::vector< Photon* > raysLists )
+void PhotonMapExportFile::SavePhotonMap( const PhotonArena& raysLists )
 {
-	if( m_oneFile )
+	if( !raysLists.empty() )	m_numberOfBands = raysLists.BandWeights( 0 ).nBands;
+
+	if( m_rawFormat )
+		SaveRawPhotonMap( raysLists );
+	else if( m_oneFile )
 	{
 		QDir exportDirectory( m_exportDirecotryName );
 		QString filename = m_photonsFilename;
@@ -176,6 +188,14 @@ void PhotonMapExportFile::SetSaveParameterValue( QString parameterName, QString
 		}
 
 	}
+
+	//Raw little-endian files or QDataStream files.
+	else if( parameterName == parameters[3] )
+		m_rawFormat = ( parameterValue == QLatin1String( "Raw" ) );
+
+	//Save the path length of the photons.
+	else if( parameterName == parameters[4] )
+		SetSavePathLengthEnabled( parameterValue == QLatin1String( "true" ) );
 }
 
 /*!
@@ -188,10 +208,30 @@ bool PhotonMapExportFile::StartExport()
 	return 1;
 }
 
+/*!
+ * Returns the names of the values saved for each photon, in the order they are saved.
+ */
+QStringList PhotonMapExportFile::ColumnNames() const
+{
+	QStringList columnNames;
+	columnNames<<QLatin1String( "id" );
+	if( m_saveCoordinates  )
+		columnNames<<QLatin1String( "x" )<<QLatin1String( "y" )<<QLatin1String( "z" );
+	if(  m_saveSide )	columnNames<<QLatin1String( "side" );
+	if( m_savePrevNexID )
+		columnNames<<QLatin1String( "previous ID" )<<QLatin1String( "next ID" );
+	if( m_saveSurfaceID )	columnNames<<QLatin1String( "surface ID" );
+	if( m_savePathLength )	columnNames<<QLatin1String( "path length" );
+	for( int b = 0; b < m_numberOfBands; ++b )
+		columnNames<<QString( QLatin1String( "band %1 weight" ) ).arg( QString::number( b + 1 ) );
+
+	return columnNames;
+}
+
 /*!
  * Export \a a raysList all data to file \a filename.
  */
-void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector< Photon* > raysLists )
+void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, const PhotonArena& raysLists )
 {
 	QFile exportFile( filename );
 	exportFile.open( QIODevice::Append );
@@ -205,26 +245,15 @@ void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector
 		for( unsigned long i = 0; i < nPhotonElements; ++i )
 		{
 
-			Photon* photon = raysLists[i];
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					m_surfaceWorldToObject.push_back( photon->intersectedSurface->GetIntersectionTransform() );
-				}
-				else
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-			}
+			const Photon* photon = raysLists[i];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 			if( photon->id < 1 )	previousPhotonID = 0;
 
 
 			//m_saveCoordinates
-			Point3D scenePos = m_concentratorToWorld( photon->pos );
+			Point3D scenePos = m_concentratorToWorld( photon->Position() );
 			out<<scenePos.x << scenePos.y << scenePos.z;
 
 			//m_saveSide
@@ -241,6 +270,9 @@ void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( i ) );
+
 			previousPhotonID = m_exportedPhotons;
 		}
 
@@ -251,36 +283,15 @@ void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector
 		for( unsigned long i = 0; i < nPhotonElements; ++i )
 		{
 
-			Photon* photon = raysLists[i];
+			const Photon* photon = raysLists[i];
 
 			out<<double( ++m_exportedPhotons );
 			if( photon->id < 1 )	previousPhotonID = 0;
 
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-					0.0, 1.0, 0.0, 0.0,
-					0.0, 0.0, 1.0, 0.0,
-					0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
-
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-					m_surfaceWorldToObject.push_back( worldToObject );
-				}
-				else
-				{
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-					worldToObject = m_surfaceWorldToObject[urlId];
-					urlId++;
-				}
-			}
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			//m_saveCoordinates
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 
 			//m_saveSide
@@ -295,6 +306,9 @@ void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( i ) );
+
 			previousPhotonID = m_exportedPhotons;
 		}
 	}
@@ -305,7 +319,7 @@ void PhotonMapExportFile::ExportAllPhotonsAllData( QString filename, std::vector
 /*!
  * Exports \a raysLists photons data except previous and next photon identifier to file \a filename.
  */
-void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, std::vector< Photon* > raysLists )
+void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, const PhotonArena& raysLists )
 {
 
 	QFile exportFile( filename );
@@ -317,33 +331,24 @@ void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, std::
 		unsigned long nPhotons = raysLists.size();
 		for( unsigned long i = 0; i < nPhotons; ++i )
 		{
-			Photon* photon = raysLists[i];
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					m_surfaceWorldToObject.push_back( photon->intersectedSurface->GetIntersectionTransform() );
-				}
-				else
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-
-			}
+			const Photon* photon = raysLists[i];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 
 			//m_saveCoordinates
-			Point3D scenePos = m_concentratorToWorld( photon->pos );
+			Point3D scenePos = m_concentratorToWorld( photon->Position() );
 			out<<scenePos.x << scenePos.y << scenePos.z;
-			//out<<photon->pos.x << photon->pos.y << photon->pos.z;
+			//out<<double( photon->x ) << double( photon->y ) << double( photon->z );
 
 			//m_saveSide
 			out<<double( photon->side );
 
 			//m_saveSurfaceID
 			out<<double( urlId );
+
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( i ) );
 		}
 	}
 	else
@@ -352,33 +357,12 @@ void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, std::
 		unsigned long nPhotons = raysLists.size();
 		for( unsigned long i = 0; i < nPhotons; ++i )
 		{
-			Photon* photon = raysLists[i];
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-							0.0, 1.0, 0.0, 0.0,
-							0.0, 0.0, 1.0, 0.0,
-							0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-					m_surfaceWorldToObject.push_back( worldToObject );
-				}
-				else
-				{
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-					worldToObject = m_surfaceWorldToObject[urlId];
-					urlId++;
-				}
-
-			}
+			const Photon* photon = raysLists[i];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 			out<<double( ++m_exportedPhotons );
 
 			//m_saveCoordinates
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 
 			//m_saveSide
@@ -386,6 +370,9 @@ void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, std::
 
 			//m_saveSurfaceID
 			out<<double( urlId );
+
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( i ) );
 		}
 
 	}
@@ -397,7 +384,7 @@ void PhotonMapExportFile::ExportAllPhotonsNotNextPrevID( QString filename, std::
  * Exports \a raysLists all photons data to file \a filename.
  * For each photon only selected parameters will be exported.
  */
-void PhotonMapExportFile::ExportAllPhotonsSelectedData( QString filename, std::vector< Photon* > raysLists )
+void PhotonMapExportFile::ExportAllPhotonsSelectedData( QString filename, const PhotonArena& raysLists )
 {
 
 	QFile exportFile( filename );
@@ -409,37 +396,16 @@ void PhotonMapExportFile::ExportAllPhotonsSelectedData( QString filename, std::v
 	unsigned long nPhotons = raysLists.size();
 	for( unsigned long i = 0; i < nPhotons; ++i )
 	{
-		Photon* photon = raysLists[i];
-		unsigned long urlId = 0;
-		Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-							0.0, 1.0, 0.0, 0.0,
-							0.0, 0.0, 1.0, 0.0,
-							0.0, 0.0, 0.0, 1.0 );
-		if( photon->intersectedSurface )
-		{
-			if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-			{
-				m_surfaceIdentfier.push_back( photon->intersectedSurface );
-				urlId = m_surfaceIdentfier.size();
-				worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-				m_surfaceWorldToObject.push_back( worldToObject );
-			}
-			else
-			{
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-				worldToObject = m_surfaceWorldToObject[urlId];
-				urlId++;
-			}
-
-		}
+		const Photon* photon = raysLists[i];
+		unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 		out<<double( ++m_exportedPhotons );
 		if( photon->id < 1 )	previousPhotonID = 0;
 
-		if( m_saveCoordinates && m_saveCoordinatesInGlobal )	out<<photon->pos.x << photon->pos.y << photon->pos.z;
+		if( m_saveCoordinates && m_saveCoordinatesInGlobal )	out<<double( photon->x ) << double( photon->y ) << double( photon->z );
 		else if( m_saveCoordinates && !m_saveCoordinatesInGlobal )
 		{
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 		}
 
@@ -457,6 +423,8 @@ void PhotonMapExportFile::ExportAllPhotonsSelectedData( QString filename, std::v
 
 		if( m_saveSurfaceID )
 			out<<double( urlId );
+		WritePathLength( out, photon );
+		WriteBandWeights( out, raysLists.BandWeights( i ) );
 
 		previousPhotonID = m_exportedPhotons;
 
@@ -467,7 +435,7 @@ void PhotonMapExportFile::ExportAllPhotonsSelectedData( QString filename, std::v
 /*!
  * Exports \a numberOfPhotons photons from \a raysLists to file \a filename starting from [\a startIndexRaysList, \a endIndexRaysList ].
  */
-void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::vector< Photon* > raysLists,
+void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, const PhotonArena& raysLists,
 		unsigned long startIndex, 	unsigned long numberOfPhotons )
 {
 
@@ -483,27 +451,16 @@ void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::v
 		unsigned long exportedPhotonsToFile = 0;
 		while( exportedPhotonsToFile < numberOfPhotons )
 		{
-			Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					m_surfaceWorldToObject.push_back( photon->intersectedSurface->GetIntersectionTransform() );
-				}
-				else
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-			}
+			const Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 			if( photon->id < 1 )	previousPhotonID = 0;
 
 			//m_saveCoordinates
-			Point3D scenePos = m_concentratorToWorld( photon->pos );
+			Point3D scenePos = m_concentratorToWorld( photon->Position() );
 			out<<scenePos.x << scenePos.y << scenePos.z;
-			//out<<photon->pos.x << photon->pos.y << photon->pos.z;
+			//out<<double( photon->x ) << double( photon->y ) << double( photon->z );
 
 			//m_saveSide
 			double side = double( photon->side );
@@ -520,6 +477,9 @@ void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::v
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( startIndex + exportedPhotonsToFile ) );
+
 			previousPhotonID = m_exportedPhotons;
 			exportedPhotonsToFile++;
 
@@ -531,34 +491,14 @@ void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::v
 		unsigned long exportedPhotonsToFile = 0;
 		while( exportedPhotonsToFile < numberOfPhotons )
 		{
-			Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-							0.0, 1.0, 0.0, 0.0,
-							0.0, 0.0, 1.0, 0.0,
-							0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-					m_surfaceWorldToObject.push_back( worldToObject );
-				}
-				else
-				{
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-					worldToObject = m_surfaceWorldToObject[urlId];
-					urlId++;
-				}
-			}
+			const Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 			if( photon->id < 1 )	previousPhotonID = 0;
 
 			//m_saveCoordinates
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 
 			//m_saveSide
@@ -575,6 +515,9 @@ void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::v
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( startIndex + exportedPhotonsToFile ) );
+
 			previousPhotonID = m_exportedPhotons;
 			exportedPhotonsToFile++;
 		}
@@ -587,7 +530,7 @@ void PhotonMapExportFile::ExportSelectedPhotonsAllData( QString filename, std::v
 /*!
  * Exports \a numberOfPhotons photons from \a raysLists to file \a filename starting from [\a startIndexRaysList, \a endIndexRaysList ].
  */
-void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename, std::vector< Photon* > raysLists,
+void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename, const PhotonArena& raysLists,
 		unsigned long startIndex, unsigned long numberOfPhotons )
 {
 	QFile exportFile( filename );
@@ -600,26 +543,15 @@ void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename,
 		unsigned long exportedPhotonsToFile = 0;
 		while( exportedPhotonsToFile < numberOfPhotons )
 		{
-			Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
-			unsigned long urlId = 0;
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					m_surfaceWorldToObject.push_back( photon->intersectedSurface->GetIntersectionTransform() );
-				}
-				else
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) + 1;
-			}
+			const Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 
 			//m_saveCoordinates
-			Point3D scenePos = m_concentratorToWorld( photon->pos );
+			Point3D scenePos = m_concentratorToWorld( photon->Position() );
 			out<<scenePos.x << scenePos.y << scenePos.z;
-			//out<<photon->pos.x << photon->pos.y << photon->pos.z;
+			//out<<double( photon->x ) << double( photon->y ) << double( photon->z );
 
 			//m_saveSide
 			double side = double( photon->side );
@@ -628,6 +560,9 @@ void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename,
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( startIndex + exportedPhotonsToFile ) );
+
 			exportedPhotonsToFile++;
 		}
 	}
@@ -636,33 +571,13 @@ void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename,
 		unsigned long exportedPhotonsToFile = 0;
 		while( exportedPhotonsToFile < numberOfPhotons )
 		{
-			Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
-			unsigned long urlId = 0;
-			Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-							0.0, 1.0, 0.0, 0.0,
-							0.0, 0.0, 1.0, 0.0,
-							0.0, 0.0, 0.0, 1.0 );
-			if( photon->intersectedSurface )
-			{
-				if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-				{
-					m_surfaceIdentfier.push_back( photon->intersectedSurface );
-					urlId = m_surfaceIdentfier.size();
-					worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-					m_surfaceWorldToObject.push_back( worldToObject );
-				}
-				else
-				{
-					urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-					worldToObject = m_surfaceWorldToObject[urlId];
-					urlId++;
-				}
-			}
+			const Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
+			unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 			out<<double( ++m_exportedPhotons );
 
 			//m_saveCoordinates
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 
 			//m_saveSide
@@ -672,6 +587,9 @@ void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename,
 			//m_saveSurfaceID
 			out<<double( urlId );
 
+			WritePathLength( out, photon );
+			WriteBandWeights( out, raysLists.BandWeights( startIndex + exportedPhotonsToFile ) );
+
 			exportedPhotonsToFile++;
 		}
 
@@ -684,7 +602,7 @@ void PhotonMapExportFile::ExportSelectedPhotonsNotNextPrevID( QString filename,
  * Exports \a numberOfPhotons photons from \a raysLists to file \a filename starting from [\a startIndexRaysList, \a endIndexRaysList ].
  *  * For each photon only selected parameters will be exported.
  */
-void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, std::vector< Photon* > raysLists,
+void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, const PhotonArena& raysLists,
 		unsigned long startIndex, 	unsigned long numberOfPhotons )
 {
 
@@ -698,28 +616,8 @@ void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, s
 	unsigned long exportedPhotonsToFile = 0;
 	while( exportedPhotonsToFile < numberOfPhotons )
 	{
-		Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
-		unsigned long urlId = 0;
-		Transform worldToObject( 1.0, 0.0, 0.0, 0.0,
-						0.0, 1.0, 0.0, 0.0,
-						0.0, 0.0, 1.0, 0.0,
-						0.0, 0.0, 0.0, 1.0 );
-		if( photon->intersectedSurface )
-		{
-			if( !m_surfaceIdentfier.contains( photon->intersectedSurface ) )
-			{
-				m_surfaceIdentfier.push_back( photon->intersectedSurface );
-				urlId = m_surfaceIdentfier.size();
-				worldToObject = photon->intersectedSurface->GetIntersectionTransform();
-				m_surfaceWorldToObject.push_back( worldToObject );
-			}
-			else
-			{
-				urlId = m_surfaceIdentfier.indexOf( photon->intersectedSurface ) ;
-				worldToObject = m_surfaceWorldToObject[urlId];
-				urlId++;
-			}
-		}
+		const Photon* photon = raysLists[startIndex + exportedPhotonsToFile];
+		unsigned long urlId = SurfaceID( photon->intersectedSurface );
 
 		out<<double( ++m_exportedPhotons );
 		if( photon->id < 1 )	previousPhotonID = 0;
@@ -727,13 +625,13 @@ void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, s
 		if( m_saveCoordinates && m_saveCoordinatesInGlobal )
 		{
 
-			Point3D scenePos = m_concentratorToWorld( photon->pos );
+			Point3D scenePos = m_concentratorToWorld( photon->Position() );
 			out<<scenePos.x << scenePos.y << scenePos.z;
-			//out<<photon->pos.x << photon->pos.y << photon->pos.z;
+			//out<<double( photon->x ) << double( photon->y ) << double( photon->z );
 		}
 		else if( m_saveCoordinates && !m_saveCoordinatesInGlobal )
 		{
-			Point3D localPos = worldToObject( photon->pos );
+			Point3D localPos = ObjectPosition( photon, urlId );
 			out<<localPos.x << localPos.y << localPos.z;
 		}
 
@@ -753,6 +651,8 @@ void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, s
 
 		if( m_saveSurfaceID )
 			out<<double( urlId );
+		WritePathLength( out, photon );
+		WriteBandWeights( out, raysLists.BandWeights( startIndex + exportedPhotonsToFile ) );
 
 		previousPhotonID = m_exportedPhotons;
 		exportedPhotonsToFile++;
@@ -761,6 +661,52 @@ void PhotonMapExportFile::ExportSelectedPhotonsSelectedData( QString filename, s
 
 }
 
+/*!
+ * Returns the extension of the photons files: ".bin" for raw files and ".dat" for QDataStream files.
+ */
+QString PhotonMapExportFile::FileExtension() const
+{
+	if( m_rawFormat )	return QLatin1String( ".bin" );
+	return QLatin1String( ".dat" );
+}
+
+/*!
+ * Returns the position of \a photon in the coordinates of the surface with identifier \a surfaceID.
+ * The photons without surface keep their world position.
+ */
+Point3D PhotonMapExportFile::ObjectPosition( const Photon* photon, unsigned long surfaceID ) const
+{
+	if( surfaceID < 1 )	return photon->Position();
+	return m_surfaceWorldToObject[surfaceID - 1]( photon->Position() );
+}
+
+/*!
+ * Opens the raw file of the current file number to save photons with \a columnNames.
+ */
+bool PhotonMapExportFile::OpenRawFile( QStringList columnNames )
+{
+	QString filename = RawFileName();
+	if( !m_rawFile.Open( filename, columnNames ) )
+	{
+		std::cerr<<"PhotonMapExportFile: the file "<<filename.toStdString()<<" cannot be opened."<<std::endl;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Returns the path of the raw file of the current file number.
+ */
+QString PhotonMapExportFile::RawFileName() const
+{
+	QDir exportDirectory( m_exportDirecotryName );
+	QString filename = m_photonsFilename + FileExtension();
+	if( !m_oneFile )
+		filename = QString( QLatin1String( "%1_%2%3" ) ).arg( m_photonsFilename, QString::number( m_currentFile ), FileExtension() );
+
+	return exportDirectory.absoluteFilePath( filename );
+}
+
 /*!
  * Remove existing files that this export type can used.
  */
@@ -771,7 +717,7 @@ void PhotonMapExportFile::RemoveExistingFiles()
 	QString filename = m_photonsFilename;
 	if( m_oneFile )
 	{
-		QString exportFilename = exportDirectory.absoluteFilePath( filename.append( QLatin1String( ".dat" ) ) );
+		QString exportFilename = exportDirectory.absoluteFilePath( filename.append( FileExtension() ) );
 		QFile exportFile( exportFilename );
 		if(exportFile.exists()&&!exportFile.remove()) {
 				QString message= QString( "Error deleting %1.\nThe file is in use. Please, close it before continuing. \n" ).arg( QString( exportFilename ) );
@@ -783,7 +729,7 @@ void PhotonMapExportFile::RemoveExistingFiles()
 	{
 
 		QStringList filters;
-		filters << filename.append( QLatin1String( "_*.dat" ) );
+		filters << filename.append( QLatin1String( "_*" ) ).append( FileExtension() );
 		exportDirectory.setNameFilters(filters);
 
 		QFileInfoList partialFilesList = exportDirectory.entryInfoList();
@@ -800,11 +746,75 @@ void PhotonMapExportFile::RemoveExistingFiles()
 	}
 }
 
+/*!
+ * Saves \a raysLists photons to raw little-endian files. The file is kept open between buffers and the photons are
+ * written through the large buffer of PhotonMapRawFile. When the file size is limited, a new file is started each
+ * m_nPhotonsPerFile photons.
+ */
+void PhotonMapExportFile::SaveRawPhotonMap( const PhotonArena& raysLists )
+{
+	QStringList columnNames = ColumnNames();
+	std::vector< double > row( columnNames.count() );
+
+	double previousPhotonID = 0;
+	unsigned long nPhotons = raysLists.size();
+	for( unsigned long i = 0; i < nPhotons; ++i )
+	{
+		if( !m_rawFile.IsOpen() && !OpenRawFile( columnNames ) )	return;
+		if( !m_oneFile && !( m_rawFile.NumberOfRows() < m_nPhotonsPerFile ) )
+		{
+			if( !m_rawFile.Close( m_powerPerPhoton ) )
+			{
+				std::cerr<<"PhotonMapExportFile: the photons cannot be written to the file "<<RawFileName().toStdString()<<"."<<std::endl;
+				return;
+			}
+			m_currentFile++;
+			if( !OpenRawFile( columnNames ) )	return;
+		}
+
+		const Photon* photon = raysLists[i];
+		if( photon->id < 1 )	previousPhotonID = 0;
+		unsigned long urlId = SurfaceID( photon->intersectedSurface );
+
+		int c = 0;
+		row[c++] = double( ++m_exportedPhotons );
+		if( m_saveCoordinates )
+		{
+			Point3D position;
+			if( m_saveCoordinatesInGlobal )	position = m_concentratorToWorld( photon->Position() );
+			else	position = ObjectPosition( photon, urlId );
+			row[c++] = position.x;
+			row[c++] = position.y;
+			row[c++] = position.z;
+		}
+		if( m_saveSide )	row[c++] = double( photon->side );
+		if( m_savePrevNexID )
+		{
+			row[c++] = previousPhotonID;
+			if( ( i < nPhotons - 1 ) && ( raysLists[i+1]->id > 0  ) )	row[c++] = double( m_exportedPhotons +1 );
+			else	row[c++] = 0.0;
+		}
+		if( m_saveSurfaceID )	row[c++] = double( urlId );
+		if( m_savePathLength )	row[c++] = double( photon->pathLength );
+
+		const SpectralWeights& bandWeights = raysLists.BandWeights( i );
+		for( int b = 0; b < m_numberOfBands; ++b )
+			row[c++] = ( b < bandWeights.nBands ) ? double( bandWeights.weight[b] ) : 0.0;
+
+		if( !m_rawFile.WriteRow( &row[0] ) )
+		{
+			std::cerr<<"PhotonMapExportFile: the photons cannot be written to the file "<<RawFileName().toStdString()<<"."<<std::endl;
+			return;
+		}
+		previousPhotonID = m_exportedPhotons;
+	}
+}
+
 /*!
  * Exports \a raysLists photons data to files with the same number of photons in each file.
  * Each file stores \a m_nPhotonsPerFile photons.
  */
-void PhotonMapExportFile::SaveToVariousFiles( std::vector <Photon* > raysLists )
+void PhotonMapExportFile::SaveToVariousFiles( const PhotonArena& raysLists )
 {
 
 	QDir exportDirectory( m_exportDirecotryName );
@@ -862,8 +872,32 @@ void PhotonMapExportFile::SaveToVariousFiles( std::vector <Photon* > raysLists )
 
 }
 
+/*!
+ * Returns the 1-based identifier of \a surface in the surfaces list of the export, 0 for photons without surface.
+ * The first time a surface is found it is added to the list with its world to object transformation.
+ */
+unsigned long PhotonMapExportFile::SurfaceID( InstanceNode* surface )
+{
+	if( !surface )	return 0;
+
+	QHash< InstanceNode*, unsigned long >::const_iterator surfaceID = m_surfaceIDs.constFind( surface );
+	if( surfaceID != m_surfaceIDs.constEnd() )	return surfaceID.value();
+
+	m_surfaceIdentfier.push_back( surface );
+	m_surfaceWorldToObject.push_back( surface->GetIntersectionTransform() );
+	m_surfaceIDs.insert( surface, m_surfaceIdentfier.size() );
+	return m_surfaceIdentfier.size();
+}
+
 /*!
  * Writes the file or first file header with the format.
+ *
+ * The path length of the photons, when it is saved, follows the surface ID.
+ * For spectral traces each photon has a weight per band after the other values. The power of the photon in a
+ * band is its weight multiplied by the power per photon.
+ *
+ * Raw files have the same values for each photon. They store them as little-endian doubles after the header
+ * described in PhotonMapRawFile.
  */
 void PhotonMapExportFile::WriteFileFormat( QString exportFilename )
 {
@@ -872,23 +906,9 @@ void PhotonMapExportFile::WriteFileFormat( QString exportFilename )
 	exportFile.open( QIODevice::WriteOnly );
 	QTextStream out( &exportFile );
 	out<<QString( QLatin1String( "START PARAMETERS\n" ) );
-	out<<QString( QLatin1String( "id\n" ) );
-	if( m_saveCoordinates  )
-	{
-		out<<QString( QLatin1String( "x\n" ) );
-		out<<QString( QLatin1String( "y\n" ) );
-		out<<QString( QLatin1String( "z\n" ) );
-	}
-	if(  m_saveSide )	out<<QString( QLatin1String( "side\n" ) );
-	if( m_savePrevNexID )
-	{
-		out<<QString( QLatin1String( "previous ID\n" ) );
-		out<<QString( QLatin1String( "next ID\n" ) );
-	}
-	if( m_saveSurfaceID )
-	{
-		out<<QString( QLatin1String( "surface ID\n" ) );
-	}
+	QStringList columnNames = ColumnNames();
+	for( int c = 0; c < columnNames.count(); ++c )
+		out<<QString( QLatin1String( "%1\n" ) ).arg( columnNames[c] );
 
 	out<<QString( QLatin1String( "END PARAMETERS\n" ) );
 
@@ -903,3 +923,20 @@ void PhotonMapExportFile::WriteFileFormat( QString exportFilename )
 
 	out<<QString( QLatin1String( "END SURFACES\n" ) );
 }
+
+/*!
+ * Writes to \a out the length of the ray segment that arrives to the \a photon through the atmosphere, if it is enabled.
+ */
+void PhotonMapExportFile::WritePathLength( QDataStream& out, const Photon* photon ) const
+{
+	if( m_savePathLength )	out<<double( photon->pathLength );
+}
+
+/*!
+ * Writes to \a out the band weights of a photon. Nothing is written for traces that are not spectral.
+ */
+void PhotonMapExportFile::WriteBandWeights( QDataStream& out, const SpectralWeights& bandWeights ) const
+{
+	for( int b = 0; b < bandWeights.nBands; ++b )
+		out<<double( bandWeights.weight[b] );
+}
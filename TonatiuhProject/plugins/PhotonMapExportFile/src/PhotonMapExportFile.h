@@ -40,10 +40,13 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef EXPORTPHOTONMAPFILE_H_
 #define EXPORTPHOTONMAPFILE_H_
 
+#include <QDataStream>
+#include <QHash>
 #include <QMap>
 #include <QString>
 
 #include "PhotonMapExport.h"
+#include "PhotonMapRawFile.h"
 
 class Photon;
 
@@ -57,37 +60,50 @@ public:
 	static QStringList GetParameterNames();
 
 	void EndExport();
-	void SavePhotonMap( std::vector< Photon* > raysLists );
+	void SavePhotonMap( const PhotonArena& raysLists );
 	void SetPowerPerPhoton( double wPhoton );
 	void SetSaveParameterValue( QString parameterName, QString parameterValue );
 	bool StartExport();
 
 private:
-	void ExportAllPhotonsAllData( QString filename, std::vector< Photon* > raysLists );
-	void ExportAllPhotonsNotNextPrevID( QString filename, std::vector< Photon* > raysLists );
-	void ExportAllPhotonsSelectedData( QString filename, std::vector< Photon* > raysLists );
-	void ExportSelectedPhotonsAllData( QString filename, std::vector< Photon* > raysLists,
+	QStringList ColumnNames() const;
+	void ExportAllPhotonsAllData( QString filename, const PhotonArena& raysLists );
+	void ExportAllPhotonsNotNextPrevID( QString filename, const PhotonArena& raysLists );
+	void ExportAllPhotonsSelectedData( QString filename, const PhotonArena& raysLists );
+	void ExportSelectedPhotonsAllData( QString filename, const PhotonArena& raysLists,
 			unsigned long startIndex, 	unsigned long numberOfPhotons );
-	void ExportSelectedPhotonsNotNextPrevID( QString filename, std::vector< Photon* > raysLists,
+	void ExportSelectedPhotonsNotNextPrevID( QString filename, const PhotonArena& raysLists,
 			unsigned long startIndex, 	unsigned long numberOfPhotons );
-	void ExportSelectedPhotonsSelectedData( QString filename, std::vector <Photon* > raysLists,
+	void ExportSelectedPhotonsSelectedData( QString filename, const PhotonArena& raysLists,
 			unsigned long startIndex, 	unsigned long numberOfPhotons );
 
 
+    QString FileExtension() const;
+    Point3D ObjectPosition( const Photon* photon, unsigned long surfaceID ) const;
+    bool OpenRawFile( QStringList columnNames );
+    QString RawFileName() const;
     void RemoveExistingFiles();
-    void SaveToVariousFiles( std::vector <Photon* > raysLists );
+    void SaveRawPhotonMap( const PhotonArena& raysLists );
+    void SaveToVariousFiles( const PhotonArena& raysLists );
+    unsigned long SurfaceID( InstanceNode* surface );
+    void WriteBandWeights( QDataStream& out, const SpectralWeights& bandWeights ) const;
     void WriteFileFormat( QString exportFilename );
+    void WritePathLength( QDataStream& out, const Photon* photon ) const;
 
 
 	QString m_photonsFilename;
 	double m_powerPerPhoton;
 	QVector< InstanceNode* > m_surfaceIdentfier;
+	QHash< InstanceNode*, unsigned long > m_surfaceIDs;
 	QVector< Transform > m_surfaceWorldToObject;
 	int m_currentFile;
 	QString m_exportDirecotryName;
 	unsigned long m_exportedPhotons;
 	unsigned long m_nPhotonsPerFile;
 	bool m_oneFile;
+	int m_numberOfBands;
+	bool m_rawFormat;
+	PhotonMapRawFile m_rawFile;
 
 };
 
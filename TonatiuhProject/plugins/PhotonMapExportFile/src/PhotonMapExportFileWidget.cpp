@@ -94,6 +94,20 @@ QString PhotonMapExportFileWidget::GetParameterValue( QString parameter ) const
 		else	return QString::number( nOfPhotonsSpin->value() );
 	}
 
+	//Raw little-endian files or QDataStream files.
+	else if( parameter == parametersName[3] )
+	{
+		if( rawFormatCheck->isChecked() )	return QLatin1String( "Raw" );
+		else	return QLatin1String( "Stream" );
+	}
+
+	//Save the path length of the photons.
+	else if( parameter == parametersName[4] )
+	{
+		if( pathLengthCheck->isChecked() )	return QLatin1String( "true" );
+		else	return QLatin1String( "false" );
+	}
+
 	return QString();
 }
 
@@ -0,0 +1,232 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cstring>
+
+#include <QtEndian>
+
+#include "PhotonMapRawFile.h"
+
+namespace
+{
+	const char rawFileMagic[8] = { 'T', 'N', 'H', 'P', 'H', 'M', 'A', 'P' };
+	const quint32 rawFileVersion = 1;
+	const int powerPerPhotonOffset = 24;
+	const int columnNamesOffset = 40;
+
+	//! Stores \a value little-endian in \a destination.
+	void StoreDouble( double value, char* destination )
+	{
+		quint64 bits;
+		std::memcpy( &bits, &value, sizeof( double ) );
+		qToLittleEndian( bits, reinterpret_cast< uchar* >( destination ) );
+	}
+}
+
+/*!
+ * Creates a raw file writer without file.
+ */
+PhotonMapRawFile::PhotonMapRawFile()
+:m_writeError( false ),
+ m_memory( new char[m_bufferSize + m_headerSize] ),
+ m_buffer( 0 ),
+ m_bufferUsed( 0 ),
+ m_numberOfColumns( 0 ),
+ m_numberOfRows( 0 ),
+ m_writtenRowsSize( 0 ),
+ m_powerPerPhoton( 0.0 )
+{
+	// The buffer starts at a multiple of the header size, so that the writes are aligned with the disk pages.
+	quintptr address = reinterpret_cast< quintptr >( m_memory );
+	m_buffer = m_memory + ( m_headerSize - address % m_headerSize ) % m_headerSize;
+}
+
+/*!
+ * Destroys the writer. An open file is closed keeping the power per photon of its header.
+ */
+PhotonMapRawFile::~PhotonMapRawFile()
+{
+	Close( m_powerPerPhoton );
+	delete[] m_memory;
+}
+
+/*!
+ * Writes the rows of the buffer and updates the header with the \a powerPerPhoton and the number of rows.
+ *
+ * Returns false if any write to the file failed since it was opened.
+ */
+bool PhotonMapRawFile::Close( double powerPerPhoton )
+{
+	if( !IsOpen() )	return true;
+	Flush();
+	m_powerPerPhoton = powerPerPhoton;
+
+	char values[16];
+	StoreDouble( powerPerPhoton, values );
+	qToLittleEndian( quint64( m_numberOfRows ), reinterpret_cast< uchar* >( values + 8 ) );
+	if( !m_file.seek( powerPerPhotonOffset ) || ( m_file.write( values, 16 ) != 16 ) )	m_writeError = true;
+
+	m_file.close();
+	return !m_writeError;
+}
+
+/*!
+ * Returns true if the writer has an open file.
+ */
+bool PhotonMapRawFile::IsOpen() const
+{
+	return m_file.isOpen();
+}
+
+/*!
+ * Returns the number of rows of the file, including the rows written before it was opened.
+ */
+unsigned long PhotonMapRawFile::NumberOfRows() const
+{
+	return m_numberOfRows;
+}
+
+/*!
+ * Opens \a filename to write rows with the columns \a columnNames. If the file was written with the same columns,
+ * the new rows are added at the end of the file. Otherwise the file is replaced.
+ *
+ * Returns false if the file cannot be opened.
+ */
+bool PhotonMapRawFile::Open( QString filename, QStringList columnNames )
+{
+	if( IsOpen() )	Close( m_powerPerPhoton );
+	if( columnNamesOffset + columnNames.count() * m_columnNameSize > m_headerSize )	return false;
+
+	m_file.setFileName( filename );
+	m_numberOfColumns = columnNames.count();
+	m_numberOfRows = 0;
+	m_writtenRowsSize = 0;
+	m_powerPerPhoton = 0.0;
+	m_bufferUsed = 0;
+	m_writeError = false;
+
+	char header[m_headerSize];
+	std::memset( header, 0, m_headerSize );
+	std::memcpy( header, rawFileMagic, sizeof( rawFileMagic ) );
+	qToLittleEndian( rawFileVersion, reinterpret_cast< uchar* >( header + 8 ) );
+	qToLittleEndian( quint32( m_headerSize ), reinterpret_cast< uchar* >( header + 12 ) );
+	qToLittleEndian( quint32( m_numberOfColumns ), reinterpret_cast< uchar* >( header + 16 ) );
+	for( int c = 0; c < m_numberOfColumns; ++c )
+	{
+		QByteArray name = columnNames[c].toLatin1().left( m_columnNameSize - 1 );
+		std::memcpy( header + columnNamesOffset + c * m_columnNameSize, name.constData(), name.size() );
+	}
+
+	if( m_file.exists() && ( m_file.size() >= m_headerSize ) && m_file.open( QIODevice::ReadWrite | QIODevice::Unbuffered ) )
+	{
+		char existingHeader[m_headerSize];
+		bool sameColumns = ( m_file.read( existingHeader, m_headerSize ) == m_headerSize ) &&
+				( std::memcmp( existingHeader, header, powerPerPhotonOffset ) == 0 ) &&
+				( std::memcmp( existingHeader + columnNamesOffset, header + columnNamesOffset,
+						m_headerSize - columnNamesOffset ) == 0 );
+		if( sameColumns )
+		{
+			quint64 powerBits = qFromLittleEndian< quint64 >( reinterpret_cast< const uchar* >( existingHeader + powerPerPhotonOffset ) );
+			std::memcpy( &m_powerPerPhoton, &powerBits, sizeof( double ) );
+			m_numberOfRows = (unsigned long) qFromLittleEndian< quint64 >(
+					reinterpret_cast< const uchar* >( existingHeader + powerPerPhotonOffset + 8 ) );
+			m_writtenRowsSize = qint64( m_numberOfRows ) * m_numberOfColumns * sizeof( double );
+			return m_file.seek( m_headerSize + m_writtenRowsSize );
+		}
+		m_file.close();
+	}
+
+	if( !m_file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered ) )	return false;
+	return ( m_file.write( header, m_headerSize ) == m_headerSize );
+}
+
+/*!
+ * Adds a row with the \a values of the columns of the file. The buffer is only written when it is full, so a row
+ * can be split between two writes.
+ *
+ * Returns false if the row cannot be added because a write to the file failed.
+ */
+bool PhotonMapRawFile::WriteRow( const double* values )
+{
+	if( m_writeError )	return false;
+	unsigned long rowSize = m_numberOfColumns * sizeof( double );
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	const char* row = reinterpret_cast< const char* >( values );
+#else
+	char row[m_headerSize];
+	for( int c = 0; c < m_numberOfColumns; ++c )
+		StoreDouble( values[c], row + c * sizeof( double ) );
+#endif
+
+	unsigned long copied = 0;
+	while( copied < rowSize )
+	{
+		unsigned long n = qMin< unsigned long >( m_bufferSize - m_bufferUsed, rowSize - copied );
+		std::memcpy( m_buffer + m_bufferUsed, row + copied, n );
+		m_bufferUsed += n;
+		copied += n;
+		if( ( m_bufferUsed == m_bufferSize ) && !Flush() )	return false;
+	}
+
+	++m_numberOfRows;
+	return true;
+}
+
+/*!
+ * Writes the rows of the buffer to the file.
+ *
+ * If the write fails, the number of rows is reduced to the complete rows in the file and the writer stops adding
+ * rows. Returns false if the write fails.
+ */
+bool PhotonMapRawFile::Flush()
+{
+	if( m_writeError )	return false;
+	if( m_bufferUsed < 1 )	return true;
+
+	qint64 written = m_file.write( m_buffer, m_bufferUsed );
+	if( written > 0 )	m_writtenRowsSize += written;
+	if( written != qint64( m_bufferUsed ) )
+	{
+		m_writeError = true;
+		m_numberOfRows = (unsigned long) ( m_writtenRowsSize / ( m_numberOfColumns * sizeof( double ) ) );
+	}
+	m_bufferUsed = 0;
+	return !m_writeError;
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef PHOTONMAPRAWFILE_H_
+#define PHOTONMAPRAWFILE_H_
+
+#include <QFile>
+#include <QStringList>
+
+/*!
+ * Writes photon map rows to a raw binary file that can be mapped in memory.
+ *
+ * The file starts with a header of m_headerSize bytes and the rows follow it. All the values are little-endian:
+ *
+ * - 8 bytes: "TNHPHMAP".
+ * - uint32: format version.
+ * - uint32: header size in bytes.
+ * - uint32: number of columns.
+ * - uint32: reserved.
+ * - float64: power per photon.
+ * - uint64: number of rows.
+ * - 32 bytes per column: the column name, padded with zeros.
+ *
+ * Each row has a float64 per column. The rows are collected in a large aligned buffer and written to the file
+ * when the buffer is full, so the file is written in a few large writes. In a new file the writes start at
+ * multiples of the header size. The power per photon and the number of
+ * rows are written in the header when the file is closed.
+ *
+ * When a write fails, the file keeps the rows written before the failure and the following rows are not added.
+ */
+class PhotonMapRawFile
+{
+public:
+	PhotonMapRawFile();
+	~PhotonMapRawFile();
+
+	bool Close( double powerPerPhoton );
+	bool IsOpen() const;
+	unsigned long NumberOfRows() const;
+	bool Open( QString filename, QStringList columnNames );
+	bool WriteRow( const double* values );
+
+	enum { m_headerSize = 4096, m_columnNameSize = 32, m_bufferSize = 1 << 22 };
+
+private:
+	PhotonMapRawFile( const PhotonMapRawFile& );
+	PhotonMapRawFile& operator=( const PhotonMapRawFile& );
+
+	bool Flush();
+
+	QFile m_file;
+	bool m_writeError;
+	char* m_memory;
+	char* m_buffer;
+	unsigned long m_bufferUsed;
+	int m_numberOfColumns;
+	unsigned long m_numberOfRows;
+	qint64 m_writtenRowsSize;
+	double m_powerPerPhoton;
+};
+
+#endif /* PHOTONMAPRAWFILE_H_ */
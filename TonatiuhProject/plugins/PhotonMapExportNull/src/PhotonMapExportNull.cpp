@@ -74,7 +74,7 @@ void PhotonMapExportNull::EndExport()
 /*!
  * Nothing is done
  */
-void PhotonMapExportNull::SavePhotonMap( std::vector< Photon* > /*raysLists*/ )
+void PhotonMapExportNull::SavePhotonMap( const PhotonArena& /*raysLists*/ )
 {
 
 }
@@ -39,13 +39,11 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <algorithm>
 #include <iostream>
 
-#include <QMap>
 #include <QVector>
 
 #include <Inventor/actions/SoAction.h>
 #include <Inventor/actions/SoGLRenderAction.h>
 #include <Inventor/elements/SoGLCoordinateElement.h>
-#include <Inventor/fields/SoMFVec3d.h>
 
 #include "BBox.h"
 #include "BezierPatch.h"
@@ -54,6 +52,56 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "Ray.h"
 #include "Vector3D.h"
 
+/*!
+ * Subpatch of a patch projected onto two planes that contain a ray. For each control point,
+ * the first two coordinates are its distances to the planes and the third one is the ray
+ * parameter of its projection onto the ray.
+ */
+struct ProjectedPatch
+{
+	double points[16][3];
+	double u0;
+	double u1;
+	double v0;
+	double v1;
+	double tMin;
+	int depth;
+};
+
+/*!
+ * Subdivision depth from which the intersection is refined with Newton iterations,
+ * maximum subdivision depth and size of the subdivision stack.
+ */
+const int newtonDepth = 3;
+const int maxSubdivisionDepth = 10;
+const int subdivisionStackSize = 3 * maxSubdivisionDepth + 4;
+
+/*!
+ * Returns true if the convex hull of \a patch contains the ray between \a tMin and \a tMax.
+ * Stores in patch.tMin the minimum ray parameter of the hull.
+ */
+static bool HullContainsRay( ProjectedPatch* patch, double tMin, double tMax )
+{
+	double minU = patch->points[0][0];
+	double maxU = minU;
+	double minV = patch->points[0][1];
+	double maxV = minV;
+	double minT = patch->points[0][2];
+	double maxT = minT;
+	for( int i = 1; i < 16; ++i )
+	{
+		minU = std::min( minU, patch->points[i][0] );
+		maxU = std::max( maxU, patch->points[i][0] );
+		minV = std::min( minV, patch->points[i][1] );
+		maxV = std::max( maxV, patch->points[i][1] );
+		minT = std::min( minT, patch->points[i][2] );
+		maxT = std::max( maxT, patch->points[i][2] );
+	}
+	patch->tMin = minT;
+
+	return !( minU > 0.0 || maxU < 0.0 || minV > 0.0 || maxV < 0.0 || maxT < tMin || minT > tMax );
+}
+
 SO_NODE_SOURCE(BezierPatch);
 
 void BezierPatch::initClass()
@@ -85,11 +133,7 @@ BezierPatch::~BezierPatch()
 
 BBox BezierPatch::GetComputeBBox()
 {
-	BBox box;
-	int nControlPoints = m_controlPoints.getNum();
-	for (int i = 0; i < nControlPoints; i++)
-		box = Union( box , Point3D( m_controlPoints[i][0], m_controlPoints[i][1],m_controlPoints[i][2] )  );
-	return box;
+	return m_bbox;
 }
 
 
@@ -145,6 +189,14 @@ void BezierPatch::SetControlPoints( QVector< Point3D > boundedPoints )
 	m_controlPoints.set1Value( 14, SbVec3f( p32.x, p32.y, p32.z ) );
 	m_controlPoints.set1Value( 15, SbVec3f( p33.x, p33.y, p33.z ) );
 
+	// Control points in double precision for the intersection
+	const Point3D points[16] = { p00, p01, p02, p03, p10, p11, p12, p13, p20, p21, p22, p23, p30, p31, p32, p33 };
+	m_bbox = BBox();
+	for( int i = 0; i < 16; ++i )
+	{
+		m_points[i] = Vector3D( points[i] );
+		m_bbox = Union( m_bbox, points[i] );
+	}
 }
 
 void BezierPatch::GeneratePrimitives( SoAction* action )
@@ -158,6 +210,15 @@ void BezierPatch::GLRender (SoGLRenderAction* action)
 	SoNurbsSurface::GLRender( action );
 }
 
+/*!
+ * Computes the closest intersection of \a objectRay with the patch.
+ *
+ * The patch is projected onto two orthogonal planes that contain the ray and is subdivided
+ * while the convex hull of the projected control points contains the ray. The subpatches
+ * are kept in a fixed size stack and the closest ones along the ray are visited first.
+ * From newtonDepth the intersection parameters are refined with Newton iterations on the
+ * patch, starting from the subpatch center.
+ */
 bool BezierPatch::Intersect(const Ray& objectRay, double* tHit, DifferentialGeometry* dg) const
 {
 	Vector3D t;
@@ -171,227 +232,112 @@ bool BezierPatch::Intersect(const Ray& objectRay, double* tHit, DifferentialGeom
 		if( fabs(objectRay.direction().y )< fabs(objectRay.direction().z )	) t = Vector3D( 0.0, 1.0, 0.0 );
 		else	t = Vector3D( 0.0, 0.0, 1.0 );
 	}
-	Vector3D nu = CrossProduct( t, objectRay.direction() );
-	Vector3D nv = CrossProduct( nu, objectRay.direction() );
-
-
-	double au = nu[0];
-	double av = nv[0];
-	double bu = nu[1];
-	double bv = nv[1];
-	double cu = nu[2];
-	double cv = nv[2];
-	double du = DotProduct( -nu, Vector3D( objectRay.origin ) );
-	double dv = DotProduct( -nv, Vector3D( objectRay.origin ) );
-
-	SoMFVec3d p;
-	p.set1Value( 0, SbVec3d( m_controlPoints[0] ) );
-	p.set1Value( 1, SbVec3d( m_controlPoints[1] ) );
-	p.set1Value( 2, SbVec3d( m_controlPoints[2] ) );
-	p.set1Value( 3, SbVec3d( m_controlPoints[3] ) );
-
-	p.set1Value( 4, SbVec3d( m_controlPoints[4] ) );
-	p.set1Value( 5, SbVec3d( m_controlPoints[5] ) );
-	p.set1Value( 6, SbVec3d( m_controlPoints[6] ) );
-	p.set1Value( 7, SbVec3d( m_controlPoints[7] ) );
-
-	p.set1Value( 8, SbVec3d( m_controlPoints[8] ) );
-	p.set1Value( 9, SbVec3d( m_controlPoints[9] ) );
-	p.set1Value( 10, SbVec3d( m_controlPoints[10] ) );
-	p.set1Value( 11, SbVec3d( m_controlPoints[11] ) );
-
-	p.set1Value( 12, SbVec3d( m_controlPoints[12] ) );
-	p.set1Value( 13, SbVec3d( m_controlPoints[13] ) );
-	p.set1Value( 14, SbVec3d( m_controlPoints[14] ) );
-	p.set1Value( 15, SbVec3d( m_controlPoints[15] ) );
-
-	SoMFVec3d q;
-	SoMFVec3d r;
-	SoMFVec3d* q1 = new SoMFVec3d;
-	SoMFVec3d* r1 = new SoMFVec3d;
-	SoMFVec3d* q2 = new SoMFVec3d;
-	SoMFVec3d* r2 = new SoMFVec3d;
-
-	HullSplitU( p, &q, &r );
-	HullSplitV( q, q1, q2 );
-	HullSplitV( r, r1, r2 );
-
-
-	QVector< SoMFVec3d* > buffer1;
-	buffer1.push_back( q1 );
-	buffer1.push_back( q2 );
-	buffer1.push_back( r1 );
-	buffer1.push_back( r2 );
-
-
-	int nIterations = 100;
-	double previousDistance = 0;
-	double currentDistance = gc::Infinity;
+	Vector3D nu = Normalize( CrossProduct( t, objectRay.direction() ) );
+	Vector3D nv = Normalize( CrossProduct( nu, objectRay.direction() ) );
 
-	double tol = 0.000000001;
-	int iteration = 0;
-	while( ( iteration < nIterations ) && ( fabs( previousDistance - currentDistance ) > tol ) )
-	{
-
-		QVector< SoMFVec3d* > buffer2;
-		for( int patch = 0; patch < buffer1.size(); patch++ )
-		{
-			SoMFVec3d* ip = buffer1[patch];
-			if( !ip )	return false;
-			SoMFVec3d iq;
-			SoMFVec3d ir;
-			SoMFVec3d* iq1 = new SoMFVec3d;
-			SoMFVec3d* ir1 = new SoMFVec3d;
-			SoMFVec3d* iq2 = new SoMFVec3d;
-			SoMFVec3d* ir2 = new SoMFVec3d;
-
-			HullSplitU( *ip, &iq, &ir );
-			HullSplitV( iq, iq1, iq2 );
-			HullSplitV( ir, ir1, ir2 );
+	Vector3D origin( objectRay.origin );
+	double du = DotProduct( -nu, origin );
+	double dv = DotProduct( -nv, origin );
+	double invDirectionLength2 = 1.0 / objectRay.direction().lengthSquared();
 
+	//Evaluate Tolerance
+	double tol = 0.00001;
+	double tMin = objectRay.mint + tol;
+	double tMax = objectRay.maxt;
 
-			buffer2.push_back( iq1 );
-			buffer2.push_back( iq2 );
-			buffer2.push_back( ir1 );
-			buffer2.push_back( ir2 );
+	ProjectedPatch stack[subdivisionStackSize];
+	int stackSize = 0;
 
-		}
-
-		//Hull clasification
-		QMap< double, SoMFVec3d* > distancesMap;
+	ProjectedPatch& patch = stack[stackSize++];
+	for( int i = 0; i < 16; ++i )
+	{
+		patch.points[i][0] = DotProduct( nu, m_points[i] ) + du;
+		patch.points[i][1] = DotProduct( nv, m_points[i] ) + dv;
+		patch.points[i][2] = DotProduct( m_points[i] - origin, objectRay.direction() ) * invDirectionLength2;
+	}
+	patch.u0 = 0.0;
+	patch.u1 = 1.0;
+	patch.v0 = 0.0;
+	patch.v1 = 1.0;
+	patch.depth = 0;
+	if( !HullContainsRay( &patch, tMin, tMax ) ) return false;
+
+	bool intersected = false;
+	double uHit = 0.0;
+	double vHit = 0.0;
+	while( stackSize > 0 )
+	{
+		const ProjectedPatch& current = stack[--stackSize];
+		if( current.tMin > tMax ) continue;
 
-		for( int patch = 0; patch< buffer2.size(); patch++ )
+		if( current.depth >= newtonDepth )
 		{
-
-			SoMFVec3d* iPatch = buffer2.value( patch );
-
-			if( !iPatch )	return false;
-			double pu1, pu2, pv1, pv2;
-
-			SbVec3d p00 = iPatch->operator[]( 0 );
-			pu2 = au * p00[0] + bu * p00[1] + cu * p00[2] + du;
-			pv2 = av * p00[0] + bv * p00[1] + cv * p00[2]+ dv;
-
-			double intersectsU = false;
-			double intersectsV = false;
-			for( int i = 0; i < 16; i++ )
-			{
-				SbVec3d iPoint = iPatch->operator[]( i );
-				pu1 = pu2;
-				pu2 = au * iPoint[0] + bu * iPoint[1] + cu * iPoint[2] + du;
-				pv1 = pv2;
-				pv2 = av * iPoint[0] + bv * iPoint[1] + cv * iPoint[2]+ dv;
-				if( ( pu1 * pu2 < 0 )  )	intersectsU = true;
-				if(  pv1 * pv2 < 0 )	intersectsV = true;
-			}
-			//Compute patch center and distance to patch center point
-			if( intersectsU && intersectsV )
+			double u = 0.5 * ( current.u0 + current.u1 );
+			double v = 0.5 * ( current.v0 + current.v1 );
+			if( NewtonRefinement( nu, du, nv, dv, &u, &v ) &&
+					!( u < current.u0 - tol || u > current.u1 + tol || v < current.v0 - tol || v > current.v1 + tol ) )
 			{
-				SbVec3d vCenter = ( 1 / 64.0 ) * ( iPatch->operator[]( 0 ) +  3 * iPatch->operator[]( 4 )
-								+ 3 * iPatch->operator[]( 8 ) + iPatch->operator[]( 12 )
-								+ 3 * iPatch->operator[]( 1 ) +  9 * iPatch->operator[]( 5 )
-								+ 9 * iPatch->operator[]( 9 ) +  3 * iPatch->operator[]( 13 )
-								+ 3 * iPatch->operator[]( 2 ) +  9 * iPatch->operator[]( 6 )
-								+ 9 * iPatch->operator[]( 10 ) +  3 * iPatch->operator[]( 14 )
-								+ iPatch->operator[]( 3 ) +  3 * iPatch->operator[]( 7 )
-								+ 3 * iPatch->operator[]( 11 ) + iPatch->operator[]( 15 ) );
-				Point3D center( vCenter[0], vCenter[1], vCenter[2] );
-				if( DotProduct( Vector3D( center - objectRay.origin ), objectRay.direction() ) >= 0 )
+				double thit = DotProduct( Vector3D( GetPoint3D( u, v ) ) - origin, objectRay.direction() ) * invDirectionLength2;
+				if( !( thit < tMin ) && !( thit > tMax ) )
 				{
-					SoMFVec3d* intersectedPatch = new SoMFVec3d;
-					intersectedPatch->copyFrom( *iPatch );
-					distancesMap.insert( Distance( center, objectRay.origin ),intersectedPatch );
+					// Now check if the function is being called from IntersectP,
+					// in which case the pointers tHit and dg are 0
+					if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+
+					intersected = true;
+					tMax = thit;
+					uHit = u;
+					vHit = v;
 				}
+				continue;
 			}
-
+			if( current.depth >= maxSubdivisionDepth ) continue;
 		}
-		for( int index = 0; index < buffer2.size(); index++ )
-		{
-			delete buffer2[index];
-		}
-
-		std::vector< double > distances = QVector< double >::fromList( distancesMap.keys() ).toStdVector();
-		std::sort( distances.begin(), distances.end() );
 
-		for (int i = 0; i < buffer1.size(); ++i)
+		// Split the subpatch in four. The children replace it in the stack.
+		ProjectedPatch parent = current;
+		double q[16][3];
+		double r[16][3];
+		HullSplitU( parent.points, q, r );
+		ProjectedPatch* children = stack + stackSize;
+		HullSplitV( q, children[0].points, children[1].points );
+		HullSplitV( r, children[2].points, children[3].points );
+
+		double uMiddle = 0.5 * ( parent.u0 + parent.u1 );
+		double vMiddle = 0.5 * ( parent.v0 + parent.v1 );
+		for( int c = 0; c < 4; ++c )
 		{
-			delete 	buffer1[i];
+			children[c].u0 = ( c < 2 ) ? parent.u0 : uMiddle;
+			children[c].u1 = ( c < 2 ) ? uMiddle : parent.u1;
+			children[c].v0 = ( c % 2 == 0 ) ? parent.v0 : vMiddle;
+			children[c].v1 = ( c % 2 == 0 ) ? vMiddle : parent.v1;
+			children[c].depth = parent.depth + 1;
 		}
-		buffer1.clear();
 
-		unsigned int patches = 4;
-		if( patches > distances.size() )	patches = distances.size();
-		for( unsigned int i = 0; i < patches; ++i)
+		// Keep the children that can contain the intersection, the closest on the top of the stack
+		int nChildren = 0;
+		for( int c = 0; c < 4; ++c )
 		{
-			if( distances[i] != gc::Infinity ) buffer1.push_back( distancesMap.value( distances[i] ) );
-
-		}
-		for( unsigned int i = patches; i < distances.size(); ++i)
-		{
-			delete distancesMap.value( distances[i] );
+			if( !HullContainsRay( &children[c], tMin, tMax ) ) continue;
+			if( nChildren != c ) children[nChildren] = children[c];
+			for( int j = nChildren; j > 0 && children[j - 1].tMin < children[j].tMin; --j )
+				std::swap( children[j - 1], children[j] );
+			nChildren++;
 		}
-		if( buffer1.size() == 0 )	return false;
-
-		previousDistance = currentDistance;
-		currentDistance = distances[0];
-		iteration++;
+		stackSize += nChildren;
 	}
 
-	SoMFVec3d* iPatch = buffer1.value( 0 );
-	if( !iPatch )
-	{
-		for (int i = 0; i < buffer1.size(); ++i)
-		{
-			delete 	buffer1[i];
-		}
-		return false;
-	}
+	if( !intersected ) return false;
 
-	// Now check if the fucntion is being called from IntersectP,
-		// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) )
-	{
-		for (int i = 0; i < buffer1.size(); ++i)
-		{
-			delete 	buffer1[i];
-		}
-		return true;
-	}
-
-	SbVec3d vCenter = ( 1 / 64.0 ) * ( iPatch->operator[]( 0 ) +  3 * iPatch->operator[]( 4 )
-									+ 3 * iPatch->operator[]( 8 ) + iPatch->operator[]( 12 )
-									+ 3 * iPatch->operator[]( 1 ) +  9 * iPatch->operator[]( 5 )
-									+ 9 * iPatch->operator[]( 9 ) +  3 * iPatch->operator[]( 13 )
-									+ 3 * iPatch->operator[]( 2 ) +  9 * iPatch->operator[]( 6 )
-									+ 9 * iPatch->operator[]( 10 ) +  3 * iPatch->operator[]( 14 )
-									+ iPatch->operator[]( 3 ) +  3 * iPatch->operator[]( 7 )
-									+ 3 * iPatch->operator[]( 11 ) + iPatch->operator[]( 15 ) );
-
-	Point3D intersectionPoint( vCenter[0], vCenter[1], vCenter[2] );
-
-
-	double thit;
-	if( objectRay.direction().x != 0 ) thit = ( intersectionPoint.x - objectRay.origin.x ) / objectRay.direction().x;
-	else if ( objectRay.direction().y != 0 ) thit = ( intersectionPoint.y - objectRay.origin.y ) / objectRay.direction().y;
-	else	thit = ( intersectionPoint.z - objectRay.origin.z ) / objectRay.direction().z;
-
-	if( thit < 0.001 ) return false;
-	if( ( thit > objectRay.maxt ) || ( (thit - objectRay.mint) < tol ) )
-	{
-		for (int i = 0; i < buffer1.size(); ++i)
-		{
-			delete 	buffer1[i];
-		}
-		return false;
-	}
+	Point3D intersectionPoint = GetPoint3D( uHit, vHit );
 
-	Vector3D dpdu = DPDU( 0.5, 0.5, *iPatch);
-	Vector3D dpdv = DPDV( 0.5, 0.5, *iPatch);
+	Vector3D dpdu = DPDU( uHit, vHit, m_points );
+	Vector3D dpdv = DPDV( uHit, vHit, m_points );
 
 	// Compute cylinder \dndu and \dndv
-	Vector3D d2Pduu = D2PDUU( 0.5, 0.5, *iPatch );
-	Vector3D d2Pduv= D2PDUV( 0.5, 0.5, *iPatch );
-	Vector3D d2Pdvv= D2PDVV( 0.5, 0.5, *iPatch );
+	Vector3D d2Pduu = D2PDUU( uHit, vHit, m_points );
+	Vector3D d2Pduv= D2PDUV( uHit, vHit, m_points );
+	Vector3D d2Pdvv= D2PDVV( uHit, vHit, m_points );
 
 	// Compute coefficients for fundamental forms
 	double E = DotProduct( dpdu, dpdu );
@@ -415,11 +361,9 @@ bool BezierPatch::Intersect(const Ray& objectRay, double* tHit, DifferentialGeom
 								dpdv,
 								dndu,
 								dndv,
-								0.5, 0.5, 0 );
-	*tHit = thit;
-
-
-	for (int i = 0; i < buffer1.size(); ++i)	delete 	buffer1[i];
+								uHit, vHit, 0 );
+	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+	*tHit = tMax;
 
 	return true;
 
@@ -430,54 +374,58 @@ bool BezierPatch::IntersectP( const Ray& objectRay ) const
 	return Intersect( objectRay, 0, 0 );
 }
 
+/*!
+ * Refines with Newton iterations the parameters \a u and \a v of the patch point that lies
+ * on the planes defined by the normals \a nu and \a nv and the distances \a du and \a dv.
+ * Returns false if the iterations do not converge inside the patch.
+ */
+bool BezierPatch::NewtonRefinement( const Vector3D& nu, double du, const Vector3D& nv, double dv, double* u, double* v ) const
+{
+	double tol = 0.000000001;
+	int nIterations = 10;
+	for( int iteration = 0; iteration < nIterations; ++iteration )
+	{
+		Vector3D point( GetPoint3D( *u, *v ) );
+		double fu = DotProduct( nu, point ) + du;
+		double fv = DotProduct( nv, point ) + dv;
+		if( ( fabs( fu ) + fabs( fv ) ) < tol ) return true;
+
+		Vector3D dpdu = DPDU( *u, *v, m_points );
+		Vector3D dpdv = DPDV( *u, *v, m_points );
+		double a = DotProduct( nu, dpdu );
+		double b = DotProduct( nu, dpdv );
+		double c = DotProduct( nv, dpdu );
+		double d = DotProduct( nv, dpdv );
+		double det = a * d - b * c;
+		if( det == 0.0 ) return false;
+
+		*u -= ( d * fu - b * fv ) / det;
+		*v -= ( a * fv - c * fu ) / det;
+		if( *u < 0.0 || *u > 1.0 || *v < 0.0 || *v > 1.0 ) return false;
+	}
+	return false;
+}
 
+/*!
+ * Returns the patch point for the parameters \a u and \a v.
+ */
 Point3D BezierPatch::GetPoint3D (double u, double v) const
 {
-	SbVec3f point = m_controlPoints[0] * (-1 + u) * (-1 + u) * (-1 + u) * (-1 + v) * (-1 + v) * (-1 + v)
-		- 3 * m_controlPoints[4] * (-1 + u)* (-1 + u) * u * (-1 + v) * (-1 + v) * (-1 + v)
-		+ 3 * m_controlPoints[8] * (-1 + u) *  u * u * (-1 + v) * (-1 + v) * (-1 + v)
-		 - m_controlPoints[12] * u * u * u * (-1 + v) * (-1 + v) * (-1 + v)
-		 - 3 * m_controlPoints[1] * (-1 + u) * (-1 + u) * (-1 + u) * (-1 + v)* (-1 + v) * v
-		 + 9 * m_controlPoints[5] * (-1 + u) * (-1 + u) * u * (-1 + v)* (-1 + v) * v
-		 - 9 * m_controlPoints[9] * (-1 + u) * u * u * (-1 + v)* (-1 + v) * v
-		 + 3 * m_controlPoints[13] * u * u * u * (-1 + v) * (-1 + v) * v
-		 + 3 * m_controlPoints[2] * (-1 + u)  * (-1 + u)  * (-1 + u)* (-1 + v) * v * v
-		 - 9 * m_controlPoints[6] * (-1 + u)  * (-1 + u) * u * (-1 + v) * v * v
-		 + 9 * m_controlPoints[10] * (-1 + u) * u * u * (-1 + v) * v * v
-		 - 3 * m_controlPoints[14] * u * u * u * (-1 + v) * v * v
-		 - m_controlPoints[3] * (-1 + u) * (-1 + u) * (-1 + u) * v * v * v
-		 + 3 * m_controlPoints[7] * (-1 + u) * (-1 + u)* u * v * v * v
-		 - 3 * m_controlPoints[11] * (-1 + u) * u * u * v * v * v
-		 + m_controlPoints[15] * u * u * u * v * v * v;
-
-	return Point3D( point[0], point[1], point[2] );
+	double bu[4] = { ( 1 - u ) * ( 1 - u ) * ( 1 - u ), 3 * u * ( 1 - u ) * ( 1 - u ), 3 * u * u * ( 1 - u ), u * u * u };
+	double bv[4] = { ( 1 - v ) * ( 1 - v ) * ( 1 - v ), 3 * v * ( 1 - v ) * ( 1 - v ), 3 * v * v * ( 1 - v ), v * v * v };
+
+	Vector3D point( 0.0, 0.0, 0.0 );
+	for( int i = 0; i < 4; ++i )
+		for( int j = 0; j < 4; ++j )
+			point += ( bu[i] * bv[j] ) * m_points[4 * i + j];
+
+	return Point3D( point.x, point.y, point.z );
 }
 
 NormalVector BezierPatch::GetNormal( double u, double v ) const
 {
-	SoMFVec3d p;
-	p.set1Value( 0, SbVec3d( m_controlPoints[0] ) );
-	p.set1Value( 1, SbVec3d( m_controlPoints[1] ) );
-	p.set1Value( 2, SbVec3d( m_controlPoints[2] ) );
-	p.set1Value( 3, SbVec3d( m_controlPoints[3] ) );
-
-	p.set1Value( 4, SbVec3d( m_controlPoints[4] ) );
-	p.set1Value( 5, SbVec3d( m_controlPoints[5] ) );
-	p.set1Value( 6, SbVec3d( m_controlPoints[6] ) );
-	p.set1Value( 7, SbVec3d( m_controlPoints[7] ) );
-
-	p.set1Value( 8, SbVec3d( m_controlPoints[8] ) );
-	p.set1Value( 9, SbVec3d( m_controlPoints[9] ) );
-	p.set1Value( 10, SbVec3d( m_controlPoints[10] ) );
-	p.set1Value( 11, SbVec3d( m_controlPoints[11] ) );
-
-	p.set1Value( 12, SbVec3d( m_controlPoints[12] ) );
-	p.set1Value( 13, SbVec3d( m_controlPoints[13] ) );
-	p.set1Value( 14, SbVec3d( m_controlPoints[14] ) );
-	p.set1Value( 15, SbVec3d( m_controlPoints[15] ) );
-
-	Vector3D dpdu = DPDU( u, v, p );
-	Vector3D dpdv = DPDV( u, v, p );
+	Vector3D dpdu = DPDU( u, v, m_points );
+	Vector3D dpdv = DPDV( u, v, m_points );
 
 	return NormalVector( Normalize( CrossProduct( dpdu, dpdv ) ) );
 }
@@ -550,9 +498,9 @@ QVector< Vector3D > BezierPatch::CornerDerivates( QVector< Point3D > boundedPoin
 	return cornerDerivates;
 }
 
-Vector3D BezierPatch::DPDU( double u, double v, SoMFVec3d& controlPoints ) const
+Vector3D BezierPatch::DPDU( double u, double v, const Vector3D* controlPoints ) const
 {
-	SbVec3d dpdu = 3 * controlPoints[0] * pow(-1 + u, 2 ) * pow(-1 + v, 3 )
+	Vector3D dpdu = 3 * controlPoints[0] * pow(-1 + u, 2 ) * pow(-1 + v, 3 )
 		- 3 * controlPoints[12] *  pow( u, 2 ) * pow(-1 + v, 3 )
 		+ 3 * controlPoints[8] * u * (-2 + 3 * u ) * pow(-1 + v, 3 )
 		- 3 * controlPoints[4] * (-1 + u) * (-1 + 3 * u) * pow(-1 + v, 3 )
@@ -569,12 +517,12 @@ Vector3D BezierPatch::DPDU( double u, double v, SoMFVec3d& controlPoints ) const
 		+ 3 * controlPoints[15]* u * u * v * v * v
 		+ 3 * controlPoints[7] * (-1 + u) * (-1 + 3 * u) * v * v * v;
 
-	return Vector3D( dpdu[0], dpdu[1], dpdu[2] );
+	return dpdu;
 }
 
-Vector3D BezierPatch::DPDV( double u, double v, SoMFVec3d& controlPoints ) const
+Vector3D BezierPatch::DPDV( double u, double v, const Vector3D* controlPoints ) const
 {
-	SbVec3d dpdv = 3 * controlPoints[0]  * pow(-1 + u, 3 ) * pow(-1 + v, 2 )
+	Vector3D dpdv = 3 * controlPoints[0]  * pow(-1 + u, 3 ) * pow(-1 + v, 2 )
 	- 9 * controlPoints[4]  * pow(-1 + u, 2 ) * u * pow(-1 + v, 2 )
 	+ 9 * controlPoints[8]  * (-1 + u) * u * u * pow(-1 + v, 2 )
 	- 3 * controlPoints[12]  * u * u * u * pow(-1 + v, 2 )
@@ -591,12 +539,12 @@ Vector3D BezierPatch::DPDV( double u, double v, SoMFVec3d& controlPoints ) const
 	- 9 * controlPoints[9]  * (-1 + u) * u * u * (-1 + v) * (-1 + 3 * v)
 	+ 3 * controlPoints[13]  * u * u * u * (-1 + v) * (-1 + 3 * v);
 
-	return Vector3D( dpdv[0], dpdv[1], dpdv[2] );
+	return dpdv;
 }
 
-Vector3D BezierPatch::D2PDUU( double u, double v, SoMFVec3d& controlPoints ) const
+Vector3D BezierPatch::D2PDUU( double u, double v, const Vector3D* controlPoints ) const
 {
-	SbVec3d d2Pduu = 6 * controlPoints[0] * (-1 + u) * pow(-1 + v, 3)
+	Vector3D d2Pduu = 6 * controlPoints[0] * (-1 + u) * pow(-1 + v, 3)
 	- 6 * controlPoints[12] * u * pow(-1 + v, 3)
 	- 6* controlPoints[4] * (-2 + 3 * u ) * pow(-1 + v, 3)
 	+ 6 * controlPoints[8] * (-1 + 3 * u) * pow(-1 + v, 3 )
@@ -614,12 +562,12 @@ Vector3D BezierPatch::D2PDUU( double u, double v, SoMFVec3d& controlPoints ) con
 	+ 6 * controlPoints[7] *(-2 + 3 * u) * v * v * v;
 
 
-	return Vector3D( d2Pduu[0], d2Pduu[1], d2Pduu[2] );
+	return d2Pduu;
 }
 
-Vector3D BezierPatch::D2PDUV( double u, double v, SoMFVec3d& controlPoints ) const
+Vector3D BezierPatch::D2PDUV( double u, double v, const Vector3D* controlPoints ) const
 {
-	SbVec3d d2Pduv = 9 * controlPoints[0] * pow(-1 + u, 2) * pow(-1 + v, 2)
+	Vector3D d2Pduv = 9 * controlPoints[0] * pow(-1 + u, 2) * pow(-1 + v, 2)
 	- 9 * controlPoints[12] * u * u * pow(-1 + v, 2 )
 	+ 9 * controlPoints[8] * u * (-2 + 3 * u) * pow(-1 + v, 2)
 	- 9 * controlPoints[4] * (-1 + u) * (-1 + 3 * u) * pow(-1 + v, 2)
@@ -636,12 +584,12 @@ Vector3D BezierPatch::D2PDUV( double u, double v, SoMFVec3d& controlPoints ) con
 	- 9 * controlPoints[9] * u * (-2 + 3 * u) * (-1 + v) * (-1 + 3 * v)
 	+ 9 * controlPoints[5] * (-1 + u) * (-1 + 3 * u) * (-1 + v) * (-1 + 3 * v);
 
-	return Vector3D( d2Pduv[0], d2Pduv[1], d2Pduv[2] );
+	return d2Pduv;
 }
 
-Vector3D BezierPatch::D2PDVV( double u, double v, SoMFVec3d& controlPoints ) const
+Vector3D BezierPatch::D2PDVV( double u, double v, const Vector3D* controlPoints ) const
 {
-	SbVec3d d2Pdvv = 6 * controlPoints[14] * u * u * u * (1 - 3 * v)
+	Vector3D d2Pdvv = 6 * controlPoints[14] * u * u * u * (1 - 3 * v)
 	+ 6 * controlPoints[0] * pow(-1 + u, 3) * (-1 + v)
 	- 18 * controlPoints[4] * pow(-1 + u, 2) * u *(-1 + v)
 	+ 18 * controlPoints[8] * (-1 + u) * u * u * (-1 + v)
@@ -659,70 +607,71 @@ Vector3D BezierPatch::D2PDVV( double u, double v, SoMFVec3d& controlPoints ) con
 	+ 18 * controlPoints[10] * (-1 + u) * u *u * (-1 + 3 * v);
 
 
-	return Vector3D( d2Pdvv[0], d2Pdvv[1], d2Pdvv[2] );
+	return d2Pdvv;
 }
 
-void BezierPatch::HullSplitU( const SoMFVec3d& p, SoMFVec3d* q, SoMFVec3d* r ) const
+/*!
+ * Splits the patch with control points \a p at u = 0.5 in the patches \a q and \a r.
+ */
+void BezierPatch::HullSplitU( const double p[][3], double q[][3], double r[][3] ) const
 {
 	for( int iv = 0; iv < 4; iv++ )
 	{
-		const SbVec3d* values = p.getValues( 0 );
-		SbVec3d p0 = values[iv] ;
-		q->set1Value( iv, p0 );
-
-		SbVec3d p1 = values[4 + iv ] ;
-		SbVec3d q1 = ( ( p0 + p1 ) / 2 );
-		q->set1Value( 4 + iv, q1 );
-
-		SbVec3d p2 = values[8 + iv] ;
-		SbVec3d q2 = ( q1  / 2 ) + ( ( p1 + p2 ) / 4 );
-		q->set1Value( 8 + iv, q2 );
-
-
-		SbVec3d p3 = values[12 + iv ] ;
-		r->set1Value( 12 + iv , p3 );
-
-		SbVec3d r2 = ( p2 + p3 ) / 2;
-		r->set1Value( 8 + iv , r2 );
-
-		SbVec3d r1 = ( r2 / 2 ) + ( ( p1 + p2 ) / 4 );
-		r->set1Value( 4 + iv , r1 );
-
-		SbVec3d q3 = ( q2 + r1 ) / 2 ;
-		q->set1Value( 12 + iv, q3 );
-		r->set1Value( iv ,q3 );
+		for( int k = 0; k < 3; k++ )
+		{
+			double p0 = p[iv][k];
+			double p1 = p[4 + iv][k];
+			double p2 = p[8 + iv][k];
+			double p3 = p[12 + iv][k];
+
+			double q1 = ( p0 + p1 ) / 2;
+			double q2 = ( q1 / 2 ) + ( ( p1 + p2 ) / 4 );
+			double r2 = ( p2 + p3 ) / 2;
+			double r1 = ( r2 / 2 ) + ( ( p1 + p2 ) / 4 );
+			double q3 = ( q2 + r1 ) / 2;
+
+			q[iv][k] = p0;
+			q[4 + iv][k] = q1;
+			q[8 + iv][k] = q2;
+			q[12 + iv][k] = q3;
+
+			r[iv][k] = q3;
+			r[4 + iv][k] = r1;
+			r[8 + iv][k] = r2;
+			r[12 + iv][k] = p3;
+		}
 	}
-
 }
 
-void BezierPatch::HullSplitV( const SoMFVec3d& p, SoMFVec3d* q, SoMFVec3d* r ) const
+/*!
+ * Splits the patch with control points \a p at v = 0.5 in the patches \a q and \a r.
+ */
+void BezierPatch::HullSplitV( const double p[][3], double q[][3], double r[][3] ) const
 {
-	for( int iv = 0; iv < 4; iv++ )
+	for( int iu = 0; iu < 4; iu++ )
 	{
-		const SbVec3d* values = p.getValues( 0 );
-		SbVec3d p0 = values[4 * iv] ;
-		q->set1Value( 4 * iv, p0 );
-
-		SbVec3d p1 = values[4 * iv + 1] ;
-		SbVec3d q1 = ( ( p0 + p1 ) / 2 );
-		q->set1Value( 4 * iv + 1, q1 );
-
-		SbVec3d p2 = values[4 * iv + 2] ;
-		SbVec3d q2 = ( q1  / 2 ) + ( ( p1 + p2 ) / 4 );
-		q->set1Value( 4 * iv + 2, q2 );
-
-		SbVec3d p3 = values[4 * iv + 3] ;
-		r->set1Value( 4 * iv + 3, p3 );
-
-		SbVec3d r2 = ( p2 + p3 ) / 2;
-		r->set1Value( 4 * iv + 2, r2 );
-
-		SbVec3d r1 = ( r2 / 2 ) + ( ( p1 + p2 ) / 4 );
-		r->set1Value( 4 * iv + 1 , r1 );
-
-		SbVec3d q3 = ( q2 + r1 ) / 2 ;
-		q->set1Value( 4 * iv + 3, q3 );
-
-		r->set1Value( 4 * iv ,q3 );
+		for( int k = 0; k < 3; k++ )
+		{
+			double p0 = p[4 * iu][k];
+			double p1 = p[4 * iu + 1][k];
+			double p2 = p[4 * iu + 2][k];
+			double p3 = p[4 * iu + 3][k];
+
+			double q1 = ( p0 + p1 ) / 2;
+			double q2 = ( q1 / 2 ) + ( ( p1 + p2 ) / 4 );
+			double r2 = ( p2 + p3 ) / 2;
+			double r1 = ( r2 / 2 ) + ( ( p1 + p2 ) / 4 );
+			double q3 = ( q2 + r1 ) / 2;
+
+			q[4 * iu][k] = p0;
+			q[4 * iu + 1][k] = q1;
+			q[4 * iu + 2][k] = q2;
+			q[4 * iu + 3][k] = q3;
+
+			r[4 * iu][k] = q3;
+			r[4 * iu + 1][k] = r1;
+			r[4 * iu + 2][k] = r2;
+			r[4 * iu + 3][k] = p3;
+		}
 	}
 }
@@ -42,12 +42,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <Inventor/fields/SoMFVec3f.h>
 #include <Inventor/nodes/SoNurbsSurface.h>
 
-#include "TShape.h"
-
-struct BBox;
+#include "BBox.h"
 #include "Point3D.h"
+#include "TShape.h"
 #include "Vector3D.h"
-class SoMFVec3d;
 
 class BezierPatch : public SoNurbsSurface
 {
@@ -80,17 +78,21 @@ protected:
 private:
 	QVector< Vector3D > CornerDerivates( QVector< Point3D > boundedPoints );
 
-	Vector3D DPDU( double u, double v, SoMFVec3d& controlPoints  ) const;
-	Vector3D DPDV( double u, double v, SoMFVec3d& controlPoints  ) const;
-	Vector3D D2PDUU( double u, double v, SoMFVec3d& controlPoints ) const;
-	Vector3D D2PDUV( double u, double v, SoMFVec3d& controlPoints  ) const;
-	Vector3D D2PDVV( double u, double v, SoMFVec3d& controlPoints  ) const;
+	bool NewtonRefinement( const Vector3D& nu, double du, const Vector3D& nv, double dv, double* u, double* v ) const;
+
+	Vector3D DPDU( double u, double v, const Vector3D* controlPoints ) const;
+	Vector3D DPDV( double u, double v, const Vector3D* controlPoints ) const;
+	Vector3D D2PDUU( double u, double v, const Vector3D* controlPoints ) const;
+	Vector3D D2PDUV( double u, double v, const Vector3D* controlPoints ) const;
+	Vector3D D2PDVV( double u, double v, const Vector3D* controlPoints ) const;
 
-	void HullSplitU( const SoMFVec3d& p, SoMFVec3d* q, SoMFVec3d* r ) const;
-	void HullSplitV( const SoMFVec3d& p, SoMFVec3d* q, SoMFVec3d* r) const;
+	void HullSplitU( const double p[][3], double q[][3], double r[][3] ) const;
+	void HullSplitV( const double p[][3], double q[][3], double r[][3] ) const;
 
 	int m_order;
     SoMFVec3f m_controlPoints;
+    Vector3D m_points[16];
+    BBox m_bbox;
 };
 
 #endif /* BEZIERPATCH_H_ */
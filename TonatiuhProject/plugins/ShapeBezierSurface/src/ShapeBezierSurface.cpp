@@ -52,7 +52,25 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "Ray.h"
 #include "ShapeBezierSurface.h"
 
+/*!
+ * Orders the patches by the \a axis coordinate of their bounding box centers.
+ */
+struct PatchCenterLess
+{
+	PatchCenterLess( int axis )
+	:m_axis( axis )
+	{
+	}
+
+	bool operator()( BezierPatch* patchA, BezierPatch* patchB ) const
+	{
+		BBox boxA = patchA->GetComputeBBox();
+		BBox boxB = patchB->GetComputeBBox();
+		return ( boxA.pMin[m_axis] + boxA.pMax[m_axis] ) < ( boxB.pMin[m_axis] + boxB.pMax[m_axis] );
+	}
 
+	int m_axis;
+};
 
 SO_NODE_SOURCE(ShapeBezierSurface);
 
@@ -92,13 +110,8 @@ double ShapeBezierSurface::GetArea() const
 
 BBox ShapeBezierSurface::GetBBox() const
 {
-	BBox bBox;
-	for (int i = 0; i < m_surfacesVector.size(); i++)
-	{
-		BBox pBox =  m_surfacesVector[i]->GetComputeBBox();
-		bBox = Union( bBox, pBox );
-	}
-	return bBox;
+	if( m_patchNodes.isEmpty() ) return BBox();
+	return m_patchNodes[0].bounds;
 }
 
 void ShapeBezierSurface::DefineSurfacePatches( QVector< Point3D > inputData, int nUCurves, int nVCurves )
@@ -154,57 +167,153 @@ void ShapeBezierSurface::DefineSurfacePatches( QVector< Point3D > inputData, int
 	 }
 
 	m_surfacesVector = curveNetwork->GetSurface();
+	BuildPatchHierarchy();
 }
 
 
 
 bool ShapeBezierSurface::Intersect(const Ray& objectRay, double* tHit, DifferentialGeometry* dg) const
 {
-	double tHitInitial = objectRay.maxt;
-	double tHitShape = objectRay.maxt;
+	double tHitShape;
 	DifferentialGeometry dgShape;
+	if( !IntersectPatches( objectRay, &tHitShape, &dgShape ) ) return false;
 
-	//int surface = 0;
-	for( int surface = 0; surface < m_surfacesVector.size(); ++surface )
-	{
+	dgShape.pShape = this;
 
-		//Check if the ray intersects with the patch BoundingBox
-		BBox bbox = m_surfacesVector[surface]->GetComputeBBox();
-		bool intersectBBox = bbox.IntersectP( objectRay );
+	*tHit = tHitShape;
+	*dg = dgShape;
 
-		if( intersectBBox )
-		{
-			double tHitPatch;
-			DifferentialGeometry dgPatch;
-			bool intersected = m_surfacesVector[surface]->Intersect( objectRay, &tHitPatch, &dgPatch );
+	return true;
+}
 
-			if( intersected && tHitShape > tHitPatch )
-			{
-				tHitShape = tHitPatch;
-				dgShape = dgPatch;
-			}
-		}
+bool ShapeBezierSurface::IntersectP( const Ray& objectRay ) const
+{
+	return IntersectPatches( objectRay, 0, 0 );
+}
+
+/*!
+ * Builds the bounding volume hierarchy over the surface patches. The patches are
+ * reordered so that the patches of each node are consecutive.
+ */
+void ShapeBezierSurface::BuildPatchHierarchy()
+{
+	m_patchNodes.clear();
+	if( m_surfacesVector.isEmpty() ) return;
+
+	m_patchNodes.reserve( 2 * m_surfacesVector.size() - 1 );
+	BuildPatchNode( 0, m_surfacesVector.size() );
+}
+
+/*!
+ * Builds the hierarchy node for the patches from \a first to \a last - 1 splitting them by
+ * the median along the widest axis of their centers. Returns the index of the node.
+ */
+int ShapeBezierSurface::BuildPatchNode( int first, int last )
+{
+	int nodeIndex = m_patchNodes.size();
+	m_patchNodes.push_back( PatchNode() );
+
+	BBox bounds;
+	BBox centerBounds;
+	for( int i = first; i < last; ++i )
+	{
+		BBox patchBounds = m_surfacesVector[i]->GetComputeBBox();
+		bounds = Union( bounds, patchBounds );
+		centerBounds = Union( centerBounds, Point3D( 0.5 * ( patchBounds.pMin.x + patchBounds.pMax.x ),
+				0.5 * ( patchBounds.pMin.y + patchBounds.pMax.y ),
+				0.5 * ( patchBounds.pMin.z + patchBounds.pMax.z ) ) );
 	}
+	m_patchNodes[nodeIndex].bounds = bounds;
 
-	if( tHitShape < tHitInitial )
+	if( last - first == 1 )
 	{
-		dgShape.pShape = this;
+		m_patchNodes[nodeIndex].offset = first;
+		m_patchNodes[nodeIndex].nPatches = 1;
+		m_patchNodes[nodeIndex].axis = 0;
+		return nodeIndex;
+	}
 
-		*tHit = tHitShape;
-		*dg = dgShape;
+	int axis = centerBounds.MaximumExtent();
+	int middle = ( first + last ) / 2;
+	std::nth_element( m_surfacesVector.begin() + first, m_surfacesVector.begin() + middle,
+			m_surfacesVector.begin() + last, PatchCenterLess( axis ) );
 
-		return true;
-	}
-	return false;
+	BuildPatchNode( first, middle );
+	int secondChild = BuildPatchNode( middle, last );
 
+	m_patchNodes[nodeIndex].offset = secondChild;
+	m_patchNodes[nodeIndex].nPatches = 0;
+	m_patchNodes[nodeIndex].axis = axis;
+	return nodeIndex;
 }
 
-bool ShapeBezierSurface::IntersectP( const Ray& objectRay ) const
+/*!
+ * Computes the closest intersection of \a objectRay with the surface patches traversing the
+ * patches hierarchy. If \a tHit and \a dg are 0 returns at the first intersection found.
+ */
+bool ShapeBezierSurface::IntersectPatches( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
 {
-	for( int i = 0; i < m_surfacesVector.size(); ++i )
-		if( m_surfacesVector[i]->IntersectP( objectRay ) ) return true;
+	if( m_patchNodes.isEmpty() ) return false;
+	bool isShadowRay = ( tHit == 0 ) && ( dg == 0 );
+
+	Ray ray( objectRay );
+	bool dirIsNeg[3] = { ray.invDirection().x < 0.0, ray.invDirection().y < 0.0, ray.invDirection().z < 0.0 };
+
+	bool intersected = false;
+	int stack[64];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	while( true )
+	{
+		const PatchNode& node = m_patchNodes[nodeIndex];
+		if( node.bounds.IntersectP( ray ) )
+		{
+			if( node.nPatches > 0 )
+			{
+				BezierPatch* patch = m_surfacesVector[node.offset];
+				if( isShadowRay )
+				{
+					if( patch->IntersectP( ray ) ) return true;
+				}
+				else
+				{
+					double tHitPatch;
+					DifferentialGeometry dgPatch;
+					if( patch->Intersect( ray, &tHitPatch, &dgPatch ) )
+					{
+						intersected = true;
+						ray.maxt = tHitPatch;
+						*tHit = tHitPatch;
+						*dg = dgPatch;
+					}
+				}
+
+				if( stackSize == 0 ) break;
+				nodeIndex = stack[--stackSize];
+			}
+			else
+			{
+				// Visit first the child closest to the ray origin
+				if( dirIsNeg[node.axis] )
+				{
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					nodeIndex = nodeIndex + 1;
+				}
+			}
+		}
+		else
+		{
+			if( stackSize == 0 ) break;
+			nodeIndex = stack[--stackSize];
+		}
+	}
 
-	return false;
+	return intersected;
 }
 
 Point3D ShapeBezierSurface::Sample( double /*u*/, double /*v*/ ) const
@@ -43,6 +43,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include <Inventor/fields/SoSFString.h>
 
+#include "BBox.h"
 #include "Vector3D.h"
 
 #include "TShape.h"
@@ -87,10 +88,28 @@ protected:
 	virtual ~ShapeBezierSurface();
 
 private:
+	/*!
+	 * Node of the bounding volume hierarchy over the surface patches. For leaves,
+	 * offset is the patch index in m_surfacesVector. For interior nodes, the first
+	 * child follows the node and offset is the index of the second child.
+	 */
+	struct PatchNode
+	{
+		BBox bounds;
+		int offset;
+		int nPatches;
+		int axis;
+	};
+
    	bool IsValidInputDataFile( QString fileName ) const;
    	bool ReadInputDataFile( QString fileName, QVector< Point3D >* inputData, int* nUCurves, int* nVCurves ) const;
 
+	void BuildPatchHierarchy();
+	int BuildPatchNode( int first, int last );
+	bool IntersectPatches( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const;
+
 	QVector< BezierPatch* > m_surfacesVector;
+	QVector< PatchNode > m_patchNodes;
     QString lastValidInputFile;
 };
 
@@ -49,6 +49,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "DifferentialGeometry.h"
 #include "NormalVector.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeCone.h"
 
 
@@ -73,6 +74,7 @@ ShapeCone::ShapeCone(  )
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (OUTSIDE) );
 
+	ComputeTraceParameters();
 }
 
 ShapeCone::~ShapeCone()
@@ -117,10 +119,32 @@ QString ShapeCone::GetIcon() const
 }
 
 bool ShapeCone::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) )	gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeCone::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 	// Compute quadratic ShapeCone coefficients
-	double theta = atan2( height.getValue(), ( baseRadius.getValue() - topRadius.getValue() ) );
-	double invTan = 1 / tan(theta);
+	double invTan = m_invTan;
 
 	double A = (     objectRay.direction().x * objectRay.direction().x )
 				 + ( objectRay.direction().z * objectRay.direction().z )
@@ -128,13 +152,13 @@ bool ShapeCone::Intersect( const Ray& objectRay, double* tHit, DifferentialGeome
 
 	double B = 2.0 * ( (    objectRay.origin.x * objectRay.direction().x )
 						+ ( objectRay.origin.z * objectRay.direction().z )
-						+ ( baseRadius.getValue() * invTan * objectRay.direction().y )
+						+ ( m_baseRadius * invTan * objectRay.direction().y )
 						- ( invTan * invTan * objectRay.origin.y * objectRay.direction().y ) );
 
 	double C = (    objectRay.origin.x * objectRay.origin.x )
 				+ ( objectRay.origin.z * objectRay.origin.z )
-				- ( baseRadius.getValue() * baseRadius.getValue() )
-				+ ( 2 * baseRadius.getValue() * invTan * objectRay.origin.y )
+				- ( m_baseRadius * m_baseRadius )
+				+ ( 2 * m_baseRadius * invTan * objectRay.origin.y )
 				- ( invTan * invTan * objectRay.origin.y * objectRay.origin.y );
 
 	// Solve quadratic equation for _t_ values
@@ -157,7 +181,7 @@ bool ShapeCone::Intersect( const Ray& objectRay, double* tHit, DifferentialGeome
 	double phi = atan2( hitPoint.x, hitPoint.z );
 
 	// Test intersection against clipping parameters
-	if( hitPoint.y < 0 || hitPoint.y > height.getValue() || phi > phiMax.getValue() )
+	if( hitPoint.y < 0 || hitPoint.y > m_height || phi > m_phiMax )
 	{
 		if ( thit == t1 ) return false;
 		if ( t1 > objectRay.maxt ) return false;
@@ -165,44 +189,66 @@ bool ShapeCone::Intersect( const Ray& objectRay, double* tHit, DifferentialGeome
 
 		hitPoint = objectRay( thit );
 		phi = atan2( hitPoint.x, hitPoint.z );
-		if ( hitPoint.y < 0 || hitPoint.y > height.getValue() || phi > phiMax.getValue() ) return false;
+		if ( hitPoint.y < 0 || hitPoint.y > m_height || phi > m_phiMax ) return false;
 	}
-	// Now check if the function is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) )	gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
-
-	// Compute definitive ShapeCone hit position and $\phi$
-    hitPoint = objectRay( thit );
 
 	// Find parametric representation of ShapeCone hit
-	double u = phi / phiMax.getValue();
-	double v = hitPoint.y / height.getValue();
+	double u = phi / m_phiMax;
+	double v = hitPoint.y / m_height;
+
+	double sinPhi = sin( m_phiMax * u );
+	double cosPhi = cos( m_phiMax * u );
+	double r = m_baseRadius - m_baseRadius * v + m_topRadius * v;
 
 	// Compute ShapeCone \dpdu and \dpdv
-	Vector3D dpdu( phiMax.getValue() * ( baseRadius.getValue() - baseRadius.getValue()* v + topRadius.getValue()* v )
-						* cos( phiMax.getValue() * u ),
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( m_phiMax * r * cosPhi,
 					0.0,
-					-phiMax.getValue() * ( baseRadius.getValue() - baseRadius.getValue() * v + topRadius.getValue() * v )
-						* sin( phiMax.getValue() * u ) );
+					-m_phiMax * r * sinPhi );
+	hit->dpdv = Vector3D(  -m_height * m_invTan * sinPhi,
+					m_height,
+					-m_height * m_invTan * cosPhi );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
 
-	Vector3D dpdv(  -height.getValue()  / tan ( atan2( height.getValue(), ( baseRadius.getValue() - topRadius.getValue() ) ) )
-							* sin( phiMax.getValue() *  u ),
-							height.getValue(),
-					-height.getValue()* cos( phiMax.getValue()* u )
-							 / tan ( atan2( height.getValue(), ( baseRadius.getValue() - topRadius.getValue() ) ) ) );
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeCone::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
+
+	double sinPhi = sin( m_phiMax * hit.u );
+	double cosPhi = cos( m_phiMax * hit.u );
+	double r = m_baseRadius - m_baseRadius * hit.v + m_topRadius * hit.v;
 
 	// Compute ShapeCone \dndu and \dndv
 
-	Vector3D d2Pduu( -phiMax.getValue() * phiMax.getValue() * ( baseRadius.getValue() - baseRadius.getValue() * v + topRadius.getValue() * v )
-			* sin( phiMax.getValue() * u ),
+	Vector3D d2Pduu( -m_phiMax * m_phiMax * r * sinPhi,
 	   0.0,
-	   -phiMax.getValue() * phiMax.getValue() * ( baseRadius.getValue() - baseRadius.getValue() * v + topRadius.getValue() * v )
-		   * cos( phiMax.getValue() * u ) );
+	   -m_phiMax * m_phiMax * r * cosPhi );
 
-	Vector3D d2Pduv( phiMax.getValue() * ( -baseRadius.getValue() + topRadius.getValue() ) * cos( phiMax.getValue() * u ),
+	Vector3D d2Pduv( m_phiMax * ( -m_baseRadius + m_topRadius ) * cosPhi,
 			0.0,
-			phiMax.getValue() * ( baseRadius.getValue() - topRadius.getValue() ) * sin( phiMax.getValue()* u ) );
+			m_phiMax * ( m_baseRadius - m_topRadius ) * sinPhi );
 
 	Vector3D d2Pdvv( 0.0, 0.0, 0.0 );
 
@@ -211,37 +257,87 @@ bool ShapeCone::Intersect( const Ray& objectRay, double* tHit, DifferentialGeome
 	double F = DotProduct( dpdu, dpdv );
 	double G = DotProduct( dpdv, dpdv );
 
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
 	double e = DotProduct( N, d2Pduu );
 	double f = DotProduct( N, d2Pduv );
 	double g = DotProduct( N, d2Pdvv );
 
 	// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 			        (e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 	                (f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the cone.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeCone::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double baseRadius = m_baseRadius;
+	const double height = m_height;
+	const double phiMax = m_phiMax;
+	const double invTan = m_invTan;
+	const bool isPhiClipped = ( m_phiMax < gc::Pi );
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Compute quadratic ShapeCone coefficients
+		double A = ( dx[i] * dx[i] ) + ( dz[i] * dz[i] ) - ( dy[i] * dy[i] * invTan * invTan );
+		double B = 2.0 * ( ( ox[i] * dx[i] ) + ( oz[i] * dz[i] )
+					+ ( baseRadius * invTan * dy[i] ) - ( invTan * invTan * oy[i] * dy[i] ) );
+		double C = ( ox[i] * ox[i] ) + ( oz[i] * oz[i] ) - ( baseRadius * baseRadius )
+					+ ( 2 * baseRadius * invTan * oy[i] ) - ( invTan * invTan * oy[i] * oy[i] );
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+		isValid = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol );
+
+		// Test both intersections against clipping parameters
+		double y0 = oy[i] + dy[i] * tFirst;
+		bool isFirstHit = isValid && !( y0 < 0 || y0 > height );
+
+		double y1 = oy[i] + dy[i] * t1;
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) && !( y1 < 0 || y1 > height );
+
+		// The angle is only computed when the cone sector can reject an intersection
+		if( isPhiClipped )
+		{
+			double phi0 = atan2( ox[i] + dx[i] * tFirst, oz[i] + dz[i] * tFirst );
+			double phi1 = atan2( ox[i] + dx[i] * t1, oz[i] + dz[i] * t1 );
 
-    // Update _tHit_ for quadric intersection
-    *tHit = thit;
+			isFirstHit = isFirstHit && !( phi0 > phiMax );
+			isSecondHit = isSecondHit && !( phi1 > phiMax );
+		}
 
-	return true;
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeCone::IntersectP( const Ray& worldRay ) const
 {
-	return Intersect( worldRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( worldRay, &thit, &hit );
 }
 
 Point3D ShapeCone::Sample( double u, double v ) const
@@ -284,6 +380,18 @@ bool ShapeCone::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the cone dimensions and the slope used by the intersection functions.
+ */
+void ShapeCone::ComputeTraceParameters()
+{
+	m_baseRadius = baseRadius.getValue();
+	m_topRadius = topRadius.getValue();
+	m_height = height.getValue();
+	m_phiMax = phiMax.getValue();
+	m_invTan = 1 / tan( atan2( m_height, ( m_baseRadius - m_topRadius ) ) );
+}
+
 void ShapeCone::computeBBox(SoAction *, SbBox3f &box, SbVec3f& /*center*/ )
 {
 	BBox bBox = GetBBox();
@@ -58,6 +58,10 @@ public:
 
 	bool Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -77,9 +81,17 @@ protected:
 	NormalVector GetNormal( double u, double v ) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	void generatePrimitives(SoAction *action);
 	virtual ~ShapeCone();
+
+private:
+	double m_baseRadius;
+	double m_topRadius;
+	double m_height;
+	double m_phiMax;
+	double m_invTan;
 };
 
 #endif /*ShapeCone_H_*/
@@ -48,6 +48,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeCylinder.h"
 #include "Vector3D.h"
 
@@ -69,6 +70,8 @@ ShapeCylinder::ShapeCylinder( )
 	SO_NODE_DEFINE_ENUM_VALUE( Side, OUTSIDE );
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (OUTSIDE) );
+
+	ComputeTraceParameters();
 }
 
 ShapeCylinder::~ShapeCylinder()
@@ -101,7 +104,7 @@ BBox ShapeCylinder::GetBBox() const
 	double ymax = ( phiMax.getValue() < ( gc::Pi / 2.0 ) )? radius.getValue() * sinPhiMax : radius.getValue();
 
 	double zmin = 0.0;
-	double zmax = length.getValue();
+	double zmax = m_length;
 
 	return BBox( Point3D( xmin, ymin, zmin ), Point3D( xmax, ymax, zmax ) );
 }
@@ -112,12 +115,35 @@ QString ShapeCylinder::GetIcon() const
 }
 
 bool ShapeCylinder::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the fucntion is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) )
+		gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeCylinder::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 	// Compute quadratic cylinder coefficients
-	Vector3D vObjectRayOrigin = Vector3D( objectRay.origin );
 	double A = objectRay.direction().x*objectRay.direction().x + objectRay.direction().y*objectRay.direction().y;
     double B = 2.0 * ( objectRay.direction().x* objectRay.origin.x + objectRay.direction().y * objectRay.origin.y);
-	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.y * objectRay.origin.y - radius.getValue() * radius.getValue();
+	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.y * objectRay.origin.y - m_radius2;
 
 	// Solve quadratic equation for _t_ values
 	double t0, t1;
@@ -136,11 +162,11 @@ bool ShapeCylinder::Intersect( const Ray& objectRay, double* tHit, DifferentialG
 	//Evaluate Tolerance
 	double tol = 0.00001;
 	double zmin = 0.0;
-	double zmax = length.getValue();
+	double zmax = m_length;
 
 
 	// Test intersection against clipping parameters
-	if( (thit - objectRay.mint) < tol  || hitPoint.z < zmin || hitPoint.z > zmax || phi > phiMax.getValue() )
+	if( (thit - objectRay.mint) < tol  || hitPoint.z < zmin || hitPoint.z > zmax || phi > m_phiMax )
 	{
 		if ( thit == t1 ) return false;
 		if ( t1 > objectRay.maxt ) return false;
@@ -148,38 +174,57 @@ bool ShapeCylinder::Intersect( const Ray& objectRay, double* tHit, DifferentialG
 
 		hitPoint = objectRay( thit );
 		phi = atan2( hitPoint.y, hitPoint.x );
-		if ( (thit - objectRay.mint) < tol  || hitPoint.z < zmin || hitPoint.z > zmax || phi > phiMax.getValue() ) return false;
+		if ( phi < 0. ) phi += gc::TwoPi;
+		if ( (thit - objectRay.mint) < tol  || hitPoint.z < zmin || hitPoint.z > zmax || phi > m_phiMax ) return false;
 	}
-	// Now check if the fucntion is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) )
-		gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
-
-	// Compute definitive cylinder hit position and $\phi$
-    hitPoint = objectRay( thit );
-
-	phi = atan2( hitPoint.y, hitPoint.x );
-	if ( phi < 0. ) phi += gc::TwoPi;
 
 	// Find parametric representation of Cylinder hit
-	double u = phi / phiMax.getValue();
-	double v = hitPoint.z /length.getValue();
+	double u = phi / m_phiMax;
+	double v = hitPoint.z / m_length;
 
 	// Compute cylinder \dpdu and \dpdv
-	//double zradius = sqrt( hitPoint.x*hitPoint.x + hitPoint.y*hitPoint.y );
-	//double invzradius = 1.0 / zradius;
+	double sinPhi = sin( m_phiMax * u );
+	double cosPhi = cos( m_phiMax * u );
 
-	Vector3D dpdu( -phiMax.getValue() * radius.getValue() * sin ( phiMax.getValue() * u ),
-						phiMax.getValue() * radius.getValue() * cos( phiMax.getValue() * u ),
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( -m_phiMax * m_radius * sinPhi,
+						m_phiMax * m_radius * cosPhi,
 						0.0 );
-	Vector3D dpdv( 0.0, 0.0, length.getValue() );
+	hit->dpdv = Vector3D( 0.0, 0.0, m_length );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
+
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeCylinder::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
+
+	double sinPhi = sin( m_phiMax * hit.u );
+	double cosPhi = cos( m_phiMax * hit.u );
 
 	// Compute cylinder \dndu and \dndv
-	Vector3D d2Pduu( -phiMax.getValue() * phiMax.getValue() * radius.getValue()
-							* cos( phiMax.getValue() * u ),
-						-phiMax.getValue() * phiMax.getValue() * radius.getValue()
-							* sin( phiMax.getValue() * u ),
+	Vector3D d2Pduu( -m_phiMax * m_phiMax * m_radius * cosPhi,
+						-m_phiMax * m_phiMax * m_radius * sinPhi,
 						0.0 );
 	Vector3D d2Pduv( 0.0, 0.0, 0.0 );
 	Vector3D d2Pdvv( 0.0, 0.0, 0.0 );
@@ -188,7 +233,6 @@ bool ShapeCylinder::Intersect( const Ray& objectRay, double* tHit, DifferentialG
 	double E = DotProduct( dpdu, dpdu );
 	double F = DotProduct( dpdu, dpdv );
 	double G = DotProduct( dpdv, dpdv );
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
 
 	double e = DotProduct( N, d2Pduu );
 	double f = DotProduct( N, d2Pduv );
@@ -196,29 +240,81 @@ bool ShapeCylinder::Intersect( const Ray& objectRay, double* tHit, DifferentialG
 
 		// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 			        (e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 	                (f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the cylinder.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeCylinder::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
 
-    // Update _tHit_ for quadric intersection
-    *tHit = thit;
+	//Evaluate Tolerance
+	const double tol = 0.00001;
 
-	return true;
+	const double radius2 = m_radius2;
+	const double length = m_length;
+	const double phiMax = m_phiMax;
+	const bool isPhiClipped = ( m_phiMax < gc::TwoPi );
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Compute quadratic cylinder coefficients
+		double A = dx[i] * dx[i] + dy[i] * dy[i];
+		double B = 2.0 * ( dx[i] * ox[i] + dy[i] * oy[i] );
+		double C = ox[i] * ox[i] + oy[i] * oy[i] - radius2;
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+
+		// Test both intersections against clipping parameters
+		double z0 = oz[i] + dz[i] * tFirst;
+		bool isFirstHit = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol ) &&
+				!( z0 < 0.0 || z0 > length );
+
+		double z1 = oz[i] + dz[i] * t1;
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) && !( ( t1 - mint[i] ) < tol ) &&
+				!( z1 < 0.0 || z1 > length );
+
+		// The angle is only computed for cylinder sectors
+		if( isPhiClipped )
+		{
+			double phi0 = atan2( oy[i] + dy[i] * tFirst, ox[i] + dx[i] * tFirst );
+			if( phi0 < 0. ) phi0 += gc::TwoPi;
+			double phi1 = atan2( oy[i] + dy[i] * t1, ox[i] + dx[i] * t1 );
+			if( phi1 < 0. ) phi1 += gc::TwoPi;
+
+			isFirstHit = isFirstHit && !( phi0 > phiMax );
+			isSecondHit = isSecondHit && !( phi1 > phiMax );
+		}
+
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeCylinder::IntersectP( const Ray& worldRay ) const
 {
-	return Intersect( worldRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( worldRay, &thit, &hit );
 }
 
 Point3D ShapeCylinder::Sample( double u, double v ) const
@@ -257,6 +353,17 @@ NormalVector ShapeCylinder::GetNormal (double u, double /* v */) const
 
 }
 
+/*!
+ * Updates the radius, length and angle values used by the intersection functions.
+ */
+void ShapeCylinder::ComputeTraceParameters()
+{
+	m_radius = radius.getValue();
+	m_radius2 = m_radius * m_radius;
+	m_length = length.getValue();
+	m_phiMax = phiMax.getValue();
+}
+
 void ShapeCylinder::computeBBox(SoAction *, SbBox3f &box, SbVec3f& /*center*/ )
 {
 	BBox bBox = GetBBox();
@@ -61,6 +61,10 @@ public:
 
 	bool Intersect( const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -80,9 +84,16 @@ protected:
 	Point3D GetPoint3D ( double u, double v ) const;
 	NormalVector GetNormal( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void generatePrimitives(SoAction *action);
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	virtual ~ShapeCylinder();
+
+private:
+	double m_radius;
+	double m_radius2;
+	double m_length;
+	double m_phiMax;
 };
 
 #endif /*SHAPECYLINDER_H_*/
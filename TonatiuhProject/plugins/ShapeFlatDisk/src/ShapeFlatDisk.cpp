@@ -49,6 +49,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeFlatDisk.h"
 #include "Vector3D.h"
 
@@ -68,6 +69,8 @@ ShapeFlatDisk::ShapeFlatDisk( )
 	SO_NODE_DEFINE_ENUM_VALUE( Side, BACK );
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (FRONT) );
+
+	ComputeTraceParameters();
 }
 
 ShapeFlatDisk::~ShapeFlatDisk()
@@ -97,6 +100,28 @@ QString ShapeFlatDisk::GetIcon() const
 }
 
 bool ShapeFlatDisk::Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the fucntion is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Sphere::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ */
+bool ShapeFlatDisk::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 	// Solve equation for _t_ value
 	if ( ( objectRay.origin.y == 0 ) && ( objectRay.direction().y == 0 ) ) return false;
@@ -112,12 +137,7 @@ bool ShapeFlatDisk::Intersect(const Ray& objectRay, double *tHit, DifferentialGe
     Point3D hitPoint = objectRay( t );
 
 	// Test intersection against clipping parameters
-	if( sqrt(hitPoint.x*hitPoint.x + hitPoint.z*hitPoint.z) > radius.getValue()) return false;
-
-	// Now check if the fucntion is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Sphere::Intersect(...) called with null pointers" );
+	if( ( hitPoint.x*hitPoint.x + hitPoint.z*hitPoint.z ) > m_radius2 ) return false;
 
 	// Find parametric representation of the rectangle hit point
 	double phi = atan2( hitPoint.z, hitPoint.x );
@@ -125,37 +145,88 @@ bool ShapeFlatDisk::Intersect(const Ray& objectRay, double *tHit, DifferentialGe
 	double iradius = sqrt( hitPoint.x*hitPoint.x + hitPoint.z*hitPoint.z );
 
 	double u = phi/gc::TwoPi;
-	double v = iradius/radius.getValue();
+	double v = iradius / m_radius;
 
 	// Compute rectangle \dpdu and \dpdv
-	Vector3D dpdu ( -v * radius.getValue() * sin( u * gc::TwoPi ) * gc::TwoPi, 0.0, v * radius.getValue() * cos( u * gc::TwoPi ) * gc::TwoPi );
-	Vector3D dpdv ( radius.getValue()* cos( u * gc::TwoPi ), 0.0,  radius.getValue() * sin( u * gc::TwoPi ) );
-
-	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	double sinPhi = sin( u * gc::TwoPi );
+	double cosPhi = cos( u * gc::TwoPi );
 
-	// Compute \dndu and \dndv from fundamental form coefficients
-	Vector3D dndu ( 0.0, 0.0, 0.0 );
-	Vector3D dndv ( 0.0, 0.0, 0.0 );
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( -v * m_radius * sinPhi * gc::TwoPi, 0.0, v * m_radius * cosPhi * gc::TwoPi );
+	hit->dpdv = Vector3D( m_radius * cosPhi, 0.0,  m_radius * sinPhi );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
-
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+	*tHit = t;
+	return true;
+}
 
-    // Update _tHit_ for quadric intersection
-    *tHit = t;
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ * The disk is flat, so the normal derivatives are zero.
+ */
+void ShapeFlatDisk::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->dndu = Vector3D( 0.0, 0.0, 0.0 );
+	dg->dndv = Vector3D( 0.0, 0.0, 0.0 );
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	dg->normal = Normalize( NormalVector( CrossProduct( hit.dpdu, hit.dpdv ) ) );
+}
 
-	return true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the disk.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeFlatDisk::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double radius2 = m_radius2;
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Solve equation for _t_ value
+		double t = -oy[i] / dy[i];
+
+		// Compute disk hit position
+		double x = ox[i] + dx[i] * t;
+		double z = oz[i] + dz[i] * t;
+
+		isHit[i] = !( ( oy[i] == 0 ) && ( dy[i] == 0 ) ) &&
+				!( t > maxt[i] || t < mint[i] ) && !( ( t - mint[i] ) < tol ) &&
+				!( ( x * x + z * z ) > radius2 );
+		tHit[i] = t;
+	}
 }
 
 bool ShapeFlatDisk::IntersectP( const Ray& objectRay ) const
 {
-	return Intersect( objectRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( objectRay, &thit, &hit );
 }
 
 Point3D ShapeFlatDisk::Sample( double u, double v ) const
@@ -190,6 +261,15 @@ bool ShapeFlatDisk::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the radius values used by the intersection functions.
+ */
+void ShapeFlatDisk::ComputeTraceParameters()
+{
+	m_radius = radius.getValue();
+	m_radius2 = m_radius * m_radius;
+}
+
 void ShapeFlatDisk::computeBBox(SoAction *, SbBox3f &box, SbVec3f& center )
 {
 	BBox bBox = GetBBox();
@@ -61,6 +61,10 @@ public:
 
 	bool Intersect(const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 	Point3D Sample( double u, double v ) const;
 
 	enum Side{
@@ -76,9 +80,14 @@ protected:
 	NormalVector GetNormal(double u, double v) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	void generatePrimitives(SoAction *action);
 	~ShapeFlatDisk();
+
+private:
+	double m_radius;
+	double m_radius2;
 };
 
 #endif /*SHAPEFLATDISK_H_*/
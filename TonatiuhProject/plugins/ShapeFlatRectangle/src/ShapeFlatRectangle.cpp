@@ -48,6 +48,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeFlatRectangle.h"
 #include "Vector3D.h"
 
@@ -69,6 +70,8 @@ ShapeFlatRectangle::ShapeFlatRectangle( )
 	SO_NODE_DEFINE_ENUM_VALUE( Side, BACK );
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (FRONT) );
+
+	ComputeTraceParameters();
 }
 
 ShapeFlatRectangle::~ShapeFlatRectangle()
@@ -98,6 +101,28 @@ QString ShapeFlatRectangle::GetIcon() const
 }
 
 bool ShapeFlatRectangle::Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the fucntion is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Sphere::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ */
+bool ShapeFlatRectangle::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 	// Solve equation for _t_ value
 	if ( ( objectRay.origin.y == 0 ) && ( objectRay.direction().y == 0 ) ) return false;
@@ -114,46 +139,86 @@ bool ShapeFlatRectangle::Intersect(const Ray& objectRay, double *tHit, Different
     Point3D hitPoint = objectRay( t );
 
 	// Test intersection against clipping parameters
-	if( hitPoint.x < -height.getValue()/2 || hitPoint.x > height.getValue()/2 || hitPoint.z < -width.getValue()/2 || hitPoint.z > width.getValue()/2 ) return false;
-
-	// Now check if the fucntion is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Sphere::Intersect(...) called with null pointers" );
-
+	if( hitPoint.x < -m_halfHeight || hitPoint.x > m_halfHeight || hitPoint.z < -m_halfWidth || hitPoint.z > m_halfWidth ) return false;
 
 	// Find parametric representation of the rectangle hit point
-	double u = ( hitPoint.x + height.getValue()/2 ) / ( height.getValue() );
-	double v = ( hitPoint.z + width.getValue()/2 ) / ( width.getValue() );
+	hit->u = ( hitPoint.x + m_halfHeight ) / m_height;
+	hit->v = ( hitPoint.z + m_halfWidth ) / m_width;
 
 	// Compute rectangle \dpdu and \dpdv
-	Vector3D dpdu ( 0.0, 0.0, height.getValue() );
-	Vector3D dpdv ( width.getValue(), 0.0, 0.0 );
+	hit->dpdu = Vector3D( 0.0, 0.0, m_height );
+	hit->dpdv = Vector3D( m_width, 0.0, 0.0 );
+	hit->shapeFrontSide = ( DotProduct( m_normal, objectRay.direction() ) > 0 ) ? false : true;
 
-	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
-	// Compute \dndu and \dndv from fundamental form coefficients
-	Vector3D dndu ( 0.0, 0.0, 0.0 );
-	Vector3D dndv ( 0.0, 0.0, 0.0 );
-
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+	*tHit = t;
+	return true;
+}
 
-    // Update _tHit_ for quadric intersection
-    *tHit = t;
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ * The rectangle is flat, so the normal derivatives are zero.
+ */
+void ShapeFlatRectangle::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int /*fields*/, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->normal = m_normal;
+	dg->dndu = Vector3D( 0.0, 0.0, 0.0 );
+	dg->dndv = Vector3D( 0.0, 0.0, 0.0 );
+	dg->shapeFrontSide = hit.shapeFrontSide;
+}
 
-	return true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the rectangle.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeFlatRectangle::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double halfWidth = m_halfWidth;
+	const double halfHeight = m_halfHeight;
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Solve equation for _t_ value
+		double t = -oy[i] / dy[i];
+
+		// Compute rectangle hit position
+		double x = ox[i] + dx[i] * t;
+		double z = oz[i] + dz[i] * t;
+
+		isHit[i] = !( ( oy[i] == 0 ) && ( dy[i] == 0 ) ) &&
+				!( t > maxt[i] || t < mint[i] ) && !( ( t - mint[i] ) < tol ) &&
+				!( x < -halfHeight || x > halfHeight || z < -halfWidth || z > halfWidth );
+		tHit[i] = t;
+	}
 }
 
 bool ShapeFlatRectangle::IntersectP( const Ray& objectRay ) const
 {
-	return Intersect( objectRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( objectRay, &thit, &hit );
 }
 
 Point3D ShapeFlatRectangle::Sample( double u, double v ) const
@@ -185,6 +250,21 @@ bool ShapeFlatRectangle::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the rectangle dimensions and the normal used by the intersection functions.
+ */
+void ShapeFlatRectangle::ComputeTraceParameters()
+{
+	m_width = width.getValue();
+	m_height = height.getValue();
+	m_halfWidth = m_width / 2;
+	m_halfHeight = m_height / 2;
+
+	Vector3D dpdu ( 0.0, 0.0, m_height );
+	Vector3D dpdv ( m_width, 0.0, 0.0 );
+	m_normal = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+}
+
 void ShapeFlatRectangle::computeBBox(SoAction*, SbBox3f& box, SbVec3f& center )
 {
 	BBox bBox = GetBBox();
@@ -43,6 +43,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <Inventor/fields/SoSFEnum.h>
 #include <Inventor/fields/SoSFFloat.h>
 
+#include "NormalVector.h"
 #include "TShape.h"
 #include "trt.h"
 
@@ -60,6 +61,10 @@ public:
 
 	bool Intersect(const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -77,10 +82,17 @@ protected:
 	NormalVector GetNormal( double u, double v ) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void generatePrimitives(SoAction *action);
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	~ShapeFlatRectangle();
 
+private:
+	double m_width;
+	double m_height;
+	double m_halfWidth;
+	double m_halfHeight;
+	NormalVector m_normal;
 };
 
 #endif /*SHAPEFLARRECTANGULE_H_*/
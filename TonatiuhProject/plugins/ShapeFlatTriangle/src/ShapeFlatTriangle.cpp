@@ -55,6 +55,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "NormalVector.h"
 #include "Point3D.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeFlatTriangle.h"
 #include "Vector3D.h"
 
@@ -93,6 +94,8 @@ ShapeFlatTriangle::ShapeFlatTriangle(  )
 	m_lastValidA = a;
 	m_lastValidB = b;
 	m_lastValidC = c;
+
+	ComputeTraceParameters();
 }
 
 /**
@@ -138,17 +141,32 @@ QString ShapeFlatTriangle::GetIcon() const
 
 bool ShapeFlatTriangle::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
 {
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeFlatTriangle::Intersect(...) called with null pointers" );
 
-	Vector3D vAB = Vector3D( b.getValue()[0], b.getValue()[1], b.getValue()[2] ) - Vector3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
-	Vector3D vAC = Vector3D( c.getValue()[0], c.getValue()[1], c.getValue()[2] ) - Vector3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
 
-	Vector3D vN = CrossProduct( vAB, vAC );
-	double d = -vN.x * a.getValue()[0] - vN.y * a.getValue()[1] - vN.z * a.getValue()[2];
-	//if( objectRay.direction.z ==0.0 ) return false;
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
 
-	double thit = (-d - vN.x * objectRay.origin.x - vN.y * objectRay.origin.y - vN.z * objectRay.origin.z )
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ */
+bool ShapeFlatTriangle::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
+	const Vector3D& vN = m_vN;
+
+	double thit = (-m_d - vN.x * objectRay.origin.x - vN.y * objectRay.origin.y - vN.z * objectRay.origin.z )
 			/ (vN.x * objectRay.direction().x  + vN.y * objectRay.direction().y + vN.z * objectRay.direction().z );
-	//double thit = - objectRay.origin.z / objectRay.direction.z;
 
 	//Evaluate Tolerance
 	double tol = 0.00001;
@@ -156,77 +174,114 @@ bool ShapeFlatTriangle::Intersect( const Ray& objectRay, double* tHit, Different
 	if( (thit - objectRay.mint) < tol ) return false;
 
 	Point3D hitPoint = objectRay( thit );
-	//Vector3D vAB = Vector3D( b.getValue()[0], b.getValue()[1], b.getValue()[2] ) - Vector3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
-	//Vector3D vAC = Vector3D( c.getValue()[0], c.getValue()[1], c.getValue()[2] ) - Vector3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
 
 	// is hitPoint inside triangle?
-	//double uu, uv, vv, wu, wv, D;
-	double uu = DotProduct( vAB, vAB );
-	double uv = DotProduct( vAB, vAC );
-	double vv = DotProduct( vAC, vAC );
-	Vector3D  w = Vector3D( hitPoint ) - Vector3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
-	double wu = DotProduct( w, vAB );
-	double wv = DotProduct( w, vAC );
-	double D = uv * uv - uu * vv;
+	Vector3D  w = hitPoint - m_vA;
+	double wu = DotProduct( w, m_vAB );
+	double wv = DotProduct( w, m_vAC );
 
 	// get and test parametric coords
-	double u = (uv * wv - vv * wu) / D;
+	double u = ( m_uv * wv - m_vv * wu ) * m_invD;
 	if( u < 0.0 || u > 1.0 )	return false;
 
-	double v = ( uv * wu - uu * wv ) / D;
+	double v = ( m_uv * wu - m_uu * wv ) * m_invD;
 	if( v < 0.0 || ( u + v) > 1.0)	return false;
 
-	// Now check if the function is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeFlatTriangle::Intersect(...) called with null pointers" );
-
-	Vector3D dpdu = vAB;
-	Vector3D dpdv = vAC;
-
-	// Compute ShapeCone \dndu and \dndv
-	Vector3D d2Pduu( 0.0, 0.0, 0.0 );
-	Vector3D d2Pduv( 0.0, 0.0, 0.0 );
-	Vector3D d2Pdvv( 0.0, 0.0, 0.0 );
-
-	// Compute coefficients for fundamental forms
-	double E = DotProduct( dpdu, dpdu );
-	double F = DotProduct( dpdu, dpdv );
-	double G = DotProduct( dpdv, dpdv );
-
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = m_vAB;
+	hit->dpdv = m_vAC;
+	hit->shapeFrontSide = ( DotProduct( m_normal, objectRay.direction() ) > 0 ) ? false : true;
 
+	*tHit = thit;
+	return true;
+}
 
-	double e = DotProduct( N, d2Pduu );
-	double f = DotProduct( N, d2Pduv );
-	double g = DotProduct( N, d2Pdvv );
-
-	// Compute \dndu and \dndv from fundamental form coefficients
-	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
-			        (e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
-	                (f*F - g*E) * invEGF2 * dpdv;
-
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
-
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ * The triangle is flat, so the normal derivatives are zero.
+ */
+void ShapeFlatTriangle::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int /*fields*/, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->normal = m_normal;
+	dg->dndu = Vector3D( 0.0, 0.0, 0.0 );
+	dg->dndv = Vector3D( 0.0, 0.0, 0.0 );
+	dg->shapeFrontSide = hit.shapeFrontSide;
+}
 
-    // Update _tHit_ for quadric intersection
-    *tHit = thit;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the triangle.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeFlatTriangle::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
 
-	return true;
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double nX = m_vN.x;
+	const double nY = m_vN.y;
+	const double nZ = m_vN.z;
+	const double d = m_d;
+	const double aX = m_vA.x;
+	const double aY = m_vA.y;
+	const double aZ = m_vA.z;
+	const double abX = m_vAB.x;
+	const double abY = m_vAB.y;
+	const double abZ = m_vAB.z;
+	const double acX = m_vAC.x;
+	const double acY = m_vAC.y;
+	const double acZ = m_vAC.z;
+	const double uu = m_uu;
+	const double uv = m_uv;
+	const double vv = m_vv;
+	const double invD = m_invD;
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		double t = ( -d - nX * ox[i] - nY * oy[i] - nZ * oz[i] ) / ( nX * dx[i] + nY * dy[i] + nZ * dz[i] );
+
+		// is hitPoint inside triangle?
+		double wX = ox[i] + dx[i] * t - aX;
+		double wY = oy[i] + dy[i] * t - aY;
+		double wZ = oz[i] + dz[i] * t - aZ;
+		double wu = wX * abX + wY * abY + wZ * abZ;
+		double wv = wX * acX + wY * acY + wZ * acZ;
+
+		// get and test parametric coords
+		double u = ( uv * wv - vv * wu ) * invD;
+		double v = ( uv * wu - uu * wv ) * invD;
+
+		isHit[i] = !( t > maxt[i] ) && !( ( t - mint[i] ) < tol ) &&
+				!( u < 0.0 || u > 1.0 ) && !( v < 0.0 || ( u + v ) > 1.0 );
+		tHit[i] = t;
+	}
 }
 
 bool ShapeFlatTriangle::IntersectP( const Ray& worldRay ) const
 {
-	return Intersect( worldRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( worldRay, &thit, &hit );
 }
 
 Point3D ShapeFlatTriangle::Sample( double u, double v ) const
@@ -363,6 +418,25 @@ bool ShapeFlatTriangle::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the triangle edges, plane and barycentric coefficients used by the intersection functions.
+ */
+void ShapeFlatTriangle::ComputeTraceParameters()
+{
+	m_vA = Point3D( a.getValue()[0], a.getValue()[1], a.getValue()[2] );
+	m_vAB = Point3D( b.getValue()[0], b.getValue()[1], b.getValue()[2] ) - m_vA;
+	m_vAC = Point3D( c.getValue()[0], c.getValue()[1], c.getValue()[2] ) - m_vA;
+
+	m_vN = CrossProduct( m_vAB, m_vAC );
+	m_normal = Normalize( NormalVector( m_vN ) );
+	m_d = -m_vN.x * m_vA.x - m_vN.y * m_vA.y - m_vN.z * m_vA.z;
+
+	m_uu = DotProduct( m_vAB, m_vAB );
+	m_uv = DotProduct( m_vAB, m_vAC );
+	m_vv = DotProduct( m_vAC, m_vAC );
+	m_invD = 1.0 / ( m_uv * m_uv - m_uu * m_vv );
+}
+
 void ShapeFlatTriangle::computeBBox(SoAction *, SbBox3f &box, SbVec3f& /*center*/)
 {
 	BBox bBox = GetBBox();
@@ -42,8 +42,11 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include <Inventor/fields/SoSFEnum.h>
 
+#include "NormalVector.h"
+#include "Point3D.h"
 #include "TShape.h"
 #include "trt.h"
+#include "Vector3D.h"
 
 class SoSensor;
 
@@ -61,6 +64,10 @@ public:
 
 	bool Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -77,6 +84,7 @@ protected:
 	NormalVector GetNormal( double u, double v ) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	void generatePrimitives(SoAction *action);
 	virtual ~ShapeFlatTriangle();
@@ -86,6 +94,17 @@ private:
 	trt::TONATIUH_REALVECTOR3 m_lastValidA;
 	trt::TONATIUH_REALVECTOR3 m_lastValidB;
 	trt::TONATIUH_REALVECTOR3 m_lastValidC;
+
+	Point3D m_vA;
+	Vector3D m_vAB;
+	Vector3D m_vAC;
+	Vector3D m_vN;
+	NormalVector m_normal;
+	double m_d;
+	double m_uu;
+	double m_uv;
+	double m_vv;
+	double m_invD;
 };
 
 #endif /* SHAPEFLATTRIANGLE_H_ */
@@ -0,0 +1,525 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+#include <QFileInfo>
+
+#include "gc.h"
+#include "gf.h"
+
+#include "HeightFieldData.h"
+#include "Ray.h"
+
+/*!
+ * Node of the height hierarchy waiting to be visited, with the ray interval inside it.
+ */
+struct TraversalNode
+{
+	int level;
+	int column;
+	int row;
+	double tMin;
+	double tMax;
+};
+
+/*!
+ * Returns the loaded height fields indexed by their file path.
+ */
+static std::map< QString, HeightFieldData* >& LoadedHeightFields()
+{
+	static std::map< QString, HeightFieldData* > loadedHeightFields;
+	return loadedHeightFields;
+}
+
+/*!
+ * Returns the height field of the file \a fileName. If the file is already loaded the
+ * existing data is returned, otherwise the file is mapped in memory and its height hierarchy built.
+ *
+ * If the file cannot be read, \a errorMessage describes the error and a null pointer is returned.
+ */
+Ptr< HeightFieldData > HeightFieldData::Load( QString fileName, QString* errorMessage )
+{
+	QString filePath = QFileInfo( fileName ).canonicalFilePath();
+	if( filePath.isEmpty() )
+	{
+		*errorMessage = QString( "The file %1 does not exist." ).arg( fileName );
+		return Ptr< HeightFieldData >();
+	}
+
+	std::map< QString, HeightFieldData* >::iterator it = LoadedHeightFields().find( filePath );
+	if( it != LoadedHeightFields().end() ) return Ptr< HeightFieldData >( it->second );
+
+	Ptr< HeightFieldData > data( new HeightFieldData( filePath ) );
+	if( !data->Map( errorMessage ) ) return Ptr< HeightFieldData >();
+	data->BuildHierarchy();
+
+	LoadedHeightFields()[filePath] = &( *data );
+	return data;
+}
+
+HeightFieldData::HeightFieldData( QString fileName )
+:m_fileName( fileName ),
+ m_mappedFile( 0 ),
+ m_values( 0 ),
+ m_nColumns( 0 ),
+ m_nRows( 0 ),
+ m_xMin( 0.0 ),
+ m_xMax( 0.0 ),
+ m_yMin( 0.0 ),
+ m_yMax( 0.0 ),
+ m_cellWidth( 0.0 ),
+ m_cellLength( 0.0 ),
+ m_area( 0.0 )
+{
+}
+
+HeightFieldData::~HeightFieldData()
+{
+	std::map< QString, HeightFieldData* >::iterator it = LoadedHeightFields().find( m_fileName );
+	if( ( it != LoadedHeightFields().end() ) && ( it->second == this ) ) LoadedHeightFields().erase( it );
+
+	if( m_mappedFile ) m_file.unmap( m_mappedFile );
+	m_file.close();
+}
+
+QString HeightFieldData::FileName() const
+{
+	return m_fileName;
+}
+
+/*!
+ * Returns the number of grid points along the x axis.
+ */
+int HeightFieldData::NumberOfColumns() const
+{
+	return m_nColumns;
+}
+
+/*!
+ * Returns the number of grid points along the y axis.
+ */
+int HeightFieldData::NumberOfRows() const
+{
+	return m_nRows;
+}
+
+/*!
+ * Returns the area of the surface, computed with two triangles for each grid cell.
+ */
+double HeightFieldData::GetArea() const
+{
+	return m_area;
+}
+
+BBox HeightFieldData::GetBBox() const
+{
+	return m_bbox;
+}
+
+double HeightFieldData::Height( int column, int row ) const
+{
+	return m_values[( row * m_nColumns + column ) * m_valuesPerPoint];
+}
+
+/*!
+ * Returns the measured normal at the grid point \a column, \a row as stored in the file.
+ */
+NormalVector HeightFieldData::Normal( int column, int row ) const
+{
+	const float* value = m_values + ( row * m_nColumns + column ) * m_valuesPerPoint;
+	return NormalVector( value[1], value[2], value[3] );
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the surface. \a u and \a v are the
+ * parameters of the intersection, the x and y position scaled to the [0, 1] range.
+ *
+ * The hierarchy is traversed from the top level, visiting the children of each node in the
+ * order the ray crosses them. This way the cells are visited in ray order, as a 2D DDA would do,
+ * but the groups of cells that are under or above the ray are skipped at once.
+ */
+bool HeightFieldData::Intersect( const Ray& objectRay, double* tHit, double* u, double* v ) const
+{
+	if( m_levels.empty() ) return false;
+
+	TraversalNode stack[m_maxTraversalDepth];
+	int stackSize = 0;
+
+	TraversalNode root = { int( m_levels.size() ) - 1, 0, 0, 0.0, 0.0 };
+	if( !NodeInterval( root.level, root.column, root.row, objectRay, &root.tMin, &root.tMax ) ) return false;
+	stack[stackSize++] = root;
+
+	while( stackSize > 0 )
+	{
+		TraversalNode node = stack[--stackSize];
+		if( node.level == 0 )
+		{
+			if( IntersectCell( node.column, node.row, objectRay, node.tMin, node.tMax, tHit, u, v ) ) return true;
+			continue;
+		}
+
+		const HierarchyLevel& childLevel = m_levels[node.level - 1];
+		TraversalNode children[4];
+		int nChildren = 0;
+		for( int j = 0; j < 2; ++j )
+		{
+			for( int i = 0; i < 2; ++i )
+			{
+				TraversalNode child = { node.level - 1, 2 * node.column + i, 2 * node.row + j, 0.0, 0.0 };
+				if( ( child.column >= childLevel.nColumns ) || ( child.row >= childLevel.nRows ) ) continue;
+				if( !NodeInterval( child.level, child.column, child.row, objectRay, &child.tMin, &child.tMax ) ) continue;
+
+				int position = nChildren++;
+				while( ( position > 0 ) && ( children[position - 1].tMin > child.tMin ) )
+				{
+					children[position] = children[position - 1];
+					position--;
+				}
+				children[position] = child;
+			}
+		}
+
+		// The closest child is on the top of the stack
+		while( nChildren > 0 ) stack[stackSize++] = children[--nChildren];
+	}
+
+	return false;
+}
+
+/*!
+ * Returns the surface point for the parameters \a u and \a v.
+ */
+Point3D HeightFieldData::GetPoint3D( double u, double v ) const
+{
+	int column;
+	int row;
+	double s;
+	double t;
+	CellCoordinates( u, v, &column, &row, &s, &t );
+
+	double h00 = Height( column, row );
+	double h10 = Height( column + 1, row );
+	double h01 = Height( column, row + 1 );
+	double h11 = Height( column + 1, row + 1 );
+
+	return Point3D( m_xMin + u * ( m_xMax - m_xMin ),
+			m_yMin + v * ( m_yMax - m_yMin ),
+			( 1 - s ) * ( 1 - t ) * h00 + s * ( 1 - t ) * h10 + ( 1 - s ) * t * h01 + s * t * h11 );
+}
+
+/*!
+ * Computes the derivatives of the bilinear surface for the parameters \a u and \a v.
+ */
+void HeightFieldData::GetTangents( double u, double v, Vector3D* dpdu, Vector3D* dpdv ) const
+{
+	int column;
+	int row;
+	double s;
+	double t;
+	CellCoordinates( u, v, &column, &row, &s, &t );
+
+	double h00 = Height( column, row );
+	double h10 = Height( column + 1, row );
+	double h01 = Height( column, row + 1 );
+	double h11 = Height( column + 1, row + 1 );
+
+	*dpdu = Vector3D( m_xMax - m_xMin, 0.0, ( ( 1 - t ) * ( h10 - h00 ) + t * ( h11 - h01 ) ) * ( m_nColumns - 1 ) );
+	*dpdv = Vector3D( 0.0, m_yMax - m_yMin, ( ( 1 - s ) * ( h01 - h00 ) + s * ( h11 - h10 ) ) * ( m_nRows - 1 ) );
+}
+
+/*!
+ * Computes the bilinear interpolation of the measured normals for the parameters \a u and \a v.
+ * If \a dndu and \a dndv are not null, they are set to the derivatives of the interpolated normal.
+ */
+void HeightFieldData::GetNormal( double u, double v, NormalVector* normal, Vector3D* dndu, Vector3D* dndv ) const
+{
+	int column;
+	int row;
+	double s;
+	double t;
+	CellCoordinates( u, v, &column, &row, &s, &t );
+
+	Vector3D n00( Normal( column, row ) );
+	Vector3D n10( Normal( column + 1, row ) );
+	Vector3D n01( Normal( column, row + 1 ) );
+	Vector3D n11( Normal( column + 1, row + 1 ) );
+
+	Vector3D n = ( 1 - s ) * ( 1 - t ) * n00 + s * ( 1 - t ) * n10 + ( 1 - s ) * t * n01 + s * t * n11;
+	*normal = Normalize( NormalVector( n ) );
+
+	if( dndu ) *dndu = ( m_nColumns - 1 ) * ( ( 1 - t ) * ( n10 - n00 ) + t * ( n11 - n01 ) );
+	if( dndv ) *dndv = ( m_nRows - 1 ) * ( ( 1 - s ) * ( n01 - n00 ) + s * ( n11 - n10 ) );
+}
+
+/*!
+ * Opens and maps the file in memory and checks its header.
+ */
+bool HeightFieldData::Map( QString* errorMessage )
+{
+	m_file.setFileName( m_fileName );
+	if( !m_file.open( QIODevice::ReadOnly ) )
+	{
+		*errorMessage = QString( "The file %1 cannot be opened." ).arg( m_fileName );
+		return false;
+	}
+
+	qint64 fileSize = m_file.size();
+	if( fileSize < m_headerSize )
+	{
+		*errorMessage = QString( "The file %1 is not a valid height field file." ).arg( m_fileName );
+		return false;
+	}
+
+	m_mappedFile = m_file.map( 0, fileSize );
+	if( !m_mappedFile )
+	{
+		*errorMessage = QString( "The file %1 cannot be mapped in memory." ).arg( m_fileName );
+		return false;
+	}
+
+	qint32 nColumns;
+	qint32 nRows;
+	double limits[4];
+	memcpy( &nColumns, m_mappedFile + 4, sizeof( qint32 ) );
+	memcpy( &nRows, m_mappedFile + 8, sizeof( qint32 ) );
+	memcpy( limits, m_mappedFile + 16, 4 * sizeof( double ) );
+
+	if( ( memcmp( m_mappedFile, "THF1", 4 ) != 0 ) || ( nColumns < 2 ) || ( nRows < 2 )
+			|| !( limits[1] > limits[0] ) || !( limits[3] > limits[2] )
+			|| ( fileSize != m_headerSize + qint64( nColumns ) * nRows * m_valuesPerPoint * qint64( sizeof( float ) ) ) )
+	{
+		*errorMessage = QString( "The file %1 is not a valid height field file." ).arg( m_fileName );
+		return false;
+	}
+
+	m_values = reinterpret_cast< const float* >( m_mappedFile + m_headerSize );
+	m_nColumns = nColumns;
+	m_nRows = nRows;
+	m_xMin = limits[0];
+	m_xMax = limits[1];
+	m_yMin = limits[2];
+	m_yMax = limits[3];
+	m_cellWidth = ( m_xMax - m_xMin ) / ( m_nColumns - 1 );
+	m_cellLength = ( m_yMax - m_yMin ) / ( m_nRows - 1 );
+	return true;
+}
+
+/*!
+ * Builds the minimum and maximum height hierarchy and computes the surface area and bounding box.
+ */
+void HeightFieldData::BuildHierarchy()
+{
+	HierarchyLevel cells;
+	cells.nColumns = m_nColumns - 1;
+	cells.nRows = m_nRows - 1;
+	cells.minHeight.resize( cells.nColumns * cells.nRows );
+	cells.maxHeight.resize( cells.nColumns * cells.nRows );
+
+	m_area = 0.0;
+	for( int row = 0; row < cells.nRows; ++row )
+	{
+		for( int column = 0; column < cells.nColumns; ++column )
+		{
+			double h00 = Height( column, row );
+			double h10 = Height( column + 1, row );
+			double h01 = Height( column, row + 1 );
+			double h11 = Height( column + 1, row + 1 );
+
+			int cell = row * cells.nColumns + column;
+			cells.minHeight[cell] = float( std::min( std::min( h00, h10 ), std::min( h01, h11 ) ) );
+			cells.maxHeight[cell] = float( std::max( std::max( h00, h10 ), std::max( h01, h11 ) ) );
+
+			Vector3D edgeU0( m_cellWidth, 0.0, h10 - h00 );
+			Vector3D edgeV0( 0.0, m_cellLength, h01 - h00 );
+			Vector3D edgeU1( -m_cellWidth, 0.0, h01 - h11 );
+			Vector3D edgeV1( 0.0, -m_cellLength, h10 - h11 );
+			m_area += 0.5 * ( CrossProduct( edgeU0, edgeV0 ).length() + CrossProduct( edgeU1, edgeV1 ).length() );
+		}
+	}
+
+	m_levels.clear();
+	m_levels.push_back( cells );
+	while( ( m_levels.back().nColumns > 1 ) || ( m_levels.back().nRows > 1 ) )
+	{
+		const HierarchyLevel& lower = m_levels.back();
+
+		HierarchyLevel upper;
+		upper.nColumns = ( lower.nColumns + 1 ) / 2;
+		upper.nRows = ( lower.nRows + 1 ) / 2;
+		upper.minHeight.resize( upper.nColumns * upper.nRows, float( gc::Infinity ) );
+		upper.maxHeight.resize( upper.nColumns * upper.nRows, float( -gc::Infinity ) );
+
+		for( int row = 0; row < lower.nRows; ++row )
+		{
+			for( int column = 0; column < lower.nColumns; ++column )
+			{
+				int lowerNode = row * lower.nColumns + column;
+				int upperNode = ( row / 2 ) * upper.nColumns + column / 2;
+				upper.minHeight[upperNode] = std::min( upper.minHeight[upperNode], lower.minHeight[lowerNode] );
+				upper.maxHeight[upperNode] = std::max( upper.maxHeight[upperNode], lower.maxHeight[lowerNode] );
+			}
+		}
+
+		m_levels.push_back( upper );
+	}
+
+	const HierarchyLevel& top = m_levels.back();
+	m_bbox = BBox( Point3D( m_xMin, m_yMin, top.minHeight[0] ), Point3D( m_xMax, m_yMax, top.maxHeight[0] ) );
+}
+
+/*!
+ * Intersects \a objectRay with the bilinear surface of the grid cell \a column, \a row.
+ * \a tMin and \a tMax are the limits of the ray inside the cell.
+ */
+bool HeightFieldData::IntersectCell( int column, int row, const Ray& objectRay, double tMin, double tMax,
+		double* tHit, double* u, double* v ) const
+{
+	double h00 = Height( column, row );
+	double h10 = Height( column + 1, row );
+	double h01 = Height( column, row + 1 );
+	double h11 = Height( column + 1, row + 1 );
+
+	// Cell coordinates of the ray
+	double s0 = ( objectRay.origin.x - ( m_xMin + column * m_cellWidth ) ) / m_cellWidth;
+	double ds = objectRay.direction().x / m_cellWidth;
+	double r0 = ( objectRay.origin.y - ( m_yMin + row * m_cellLength ) ) / m_cellLength;
+	double dr = objectRay.direction().y / m_cellLength;
+
+	// The difference between the surface and the ray heights is a quadratic function of the ray parameter
+	double a = h10 - h00;
+	double b = h01 - h00;
+	double c = h00 - h10 - h01 + h11;
+	double A = c * ds * dr;
+	double B = a * ds + b * dr + c * ( s0 * dr + r0 * ds ) - objectRay.direction().z;
+	double C = h00 + a * s0 + b * r0 + c * s0 * r0 - objectRay.origin.z;
+
+	double roots[2];
+	int nRoots = 0;
+	if( A != 0.0 )
+	{
+		if( gf::Quadratic( A, B, C, &roots[0], &roots[1] ) ) nRoots = 2;
+	}
+	else if( B != 0.0 )
+	{
+		roots[0] = - C / B;
+		nRoots = 1;
+	}
+
+	double tol = 0.00001;
+	double cellTolerance = 0.000000001;
+	for( int i = 0; i < nRoots; ++i )
+	{
+		double thit = roots[i];
+		if( ( thit - objectRay.mint ) < tol || thit > objectRay.maxt ) continue;
+		if( thit < tMin - tol || thit > tMax + tol ) continue;
+
+		double s = s0 + ds * thit;
+		double r = r0 + dr * thit;
+		if( ( s < -cellTolerance ) || ( s > 1.0 + cellTolerance ) || ( r < -cellTolerance ) || ( r > 1.0 + cellTolerance ) ) continue;
+
+		s = std::min( std::max( s, 0.0 ), 1.0 );
+		r = std::min( std::max( r, 0.0 ), 1.0 );
+		*tHit = thit;
+		*u = ( column + s ) / ( m_nColumns - 1 );
+		*v = ( row + r ) / ( m_nRows - 1 );
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+ * Computes the interval of \a objectRay inside the xy limits of the hierarchy node \a column, \a row of \a level.
+ * Returns false if the interval is empty or if the ray heights in the interval are out of the node heights.
+ */
+bool HeightFieldData::NodeInterval( int level, int column, int row, const Ray& objectRay, double* tMin, double* tMax ) const
+{
+	const HierarchyLevel& hierarchyLevel = m_levels[level];
+	int cellsInNode = 1 << level;
+
+	double x0 = m_xMin + column * cellsInNode * m_cellWidth;
+	double x1 = m_xMin + std::min( ( column + 1 ) * cellsInNode, m_nColumns - 1 ) * m_cellWidth;
+	double y0 = m_yMin + row * cellsInNode * m_cellLength;
+	double y1 = m_yMin + std::min( ( row + 1 ) * cellsInNode, m_nRows - 1 ) * m_cellLength;
+
+	double t0 = objectRay.mint;
+	double t1 = objectRay.maxt;
+
+	double tNear = ( x0 - objectRay.origin.x ) * objectRay.invDirection().x;
+	double tFar = ( x1 - objectRay.origin.x ) * objectRay.invDirection().x;
+	if( tNear > tFar ) std::swap( tNear, tFar );
+	if( tNear > t0 ) t0 = tNear;
+	if( tFar < t1 ) t1 = tFar;
+	if( t0 > t1 ) return false;
+
+	tNear = ( y0 - objectRay.origin.y ) * objectRay.invDirection().y;
+	tFar = ( y1 - objectRay.origin.y ) * objectRay.invDirection().y;
+	if( tNear > tFar ) std::swap( tNear, tFar );
+	if( tNear > t0 ) t0 = tNear;
+	if( tFar < t1 ) t1 = tFar;
+	if( t0 > t1 ) return false;
+
+	// The ray height is linear, its extreme values are at the interval limits
+	double z0 = objectRay.origin.z + objectRay.direction().z * t0;
+	double z1 = objectRay.origin.z + objectRay.direction().z * t1;
+	int node = row * hierarchyLevel.nColumns + column;
+	if( ( std::max( z0, z1 ) < hierarchyLevel.minHeight[node] ) || ( std::min( z0, z1 ) > hierarchyLevel.maxHeight[node] ) )
+		return false;
+
+	*tMin = t0;
+	*tMax = t1;
+	return true;
+}
+
+/*!
+ * Computes the grid cell that contains the parameters \a u and \a v and the position \a s, \a t inside the cell.
+ */
+void HeightFieldData::CellCoordinates( double u, double v, int* column, int* row, double* s, double* t ) const
+{
+	double x = u * ( m_nColumns - 1 );
+	double y = v * ( m_nRows - 1 );
+	*column = std::min( std::max( int( floor( x ) ), 0 ), m_nColumns - 2 );
+	*row = std::min( std::max( int( floor( y ) ), 0 ), m_nRows - 2 );
+	*s = x - *column;
+	*t = y - *row;
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef HEIGHTFIELDDATA_H_
+#define HEIGHTFIELDDATA_H_
+
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "BBox.h"
+#include "NormalVector.h"
+#include "Ptr.h"
+#include "RefCount.h"
+#include "Vector3D.h"
+
+class Ray;
+
+/*!
+ * Regular grid of measured heights and normals read from a binary file.
+ *
+ * The file is little endian and starts with a 48 bytes header: the characters "THF1",
+ * the number of grid columns (points along x) and rows (points along y) as 32 bits integers,
+ * 4 unused bytes and the grid limits xMin, xMax, yMin and yMax as 64 bits floats.
+ * The header is followed, row after row, by the height and the three normal components
+ * of each grid point as 32 bits floats.
+ *
+ * The file is mapped in memory and each file is loaded only once: the shapes that
+ * use the same file share the same HeightFieldData.
+ *
+ * The surface inside each grid cell is the bilinear interpolation of the cell corner heights.
+ * For the intersection with rays, the data keeps a hierarchy of minimum and maximum heights.
+ * Level zero has the bounds of each cell and each upper level the bounds of 2x2 cells of the
+ * level below. The ray only visits the cells whose height bounds overlap the ray height.
+ */
+class HeightFieldData : public RefCount
+{
+public:
+	static Ptr< HeightFieldData > Load( QString fileName, QString* errorMessage );
+	~HeightFieldData();
+
+	QString FileName() const;
+	int NumberOfColumns() const;
+	int NumberOfRows() const;
+
+	double GetArea() const;
+	BBox GetBBox() const;
+	double Height( int column, int row ) const;
+	NormalVector Normal( int column, int row ) const;
+
+	bool Intersect( const Ray& objectRay, double* tHit, double* u, double* v ) const;
+	Point3D GetPoint3D( double u, double v ) const;
+	void GetTangents( double u, double v, Vector3D* dpdu, Vector3D* dpdv ) const;
+	void GetNormal( double u, double v, NormalVector* normal, Vector3D* dndu, Vector3D* dndv ) const;
+
+private:
+	struct HierarchyLevel
+	{
+		int nColumns;
+		int nRows;
+		std::vector< float > minHeight;
+		std::vector< float > maxHeight;
+	};
+
+	enum { m_headerSize = 48, m_valuesPerPoint = 4, m_maxTraversalDepth = 128 };
+
+	HeightFieldData( QString fileName );
+	bool Map( QString* errorMessage );
+	void BuildHierarchy();
+	bool IntersectCell( int column, int row, const Ray& objectRay, double tMin, double tMax,
+			double* tHit, double* u, double* v ) const;
+	bool NodeInterval( int level, int column, int row, const Ray& objectRay, double* tMin, double* tMax ) const;
+	void CellCoordinates( double u, double v, int* column, int* row, double* s, double* t ) const;
+
+	QString m_fileName;
+	QFile m_file;
+	uchar* m_mappedFile;
+	const float* m_values;
+
+	int m_nColumns;
+	int m_nRows;
+	double m_xMin;
+	double m_xMax;
+	double m_yMin;
+	double m_yMax;
+	double m_cellWidth;
+	double m_cellLength;
+
+	std::vector< HierarchyLevel > m_levels;
+	BBox m_bbox;
+	double m_area;
+};
+
+#endif /* HEIGHTFIELDDATA_H_ */
@@ -0,0 +1,292 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <QMessageBox>
+#include <QString>
+
+#include <Inventor/SoPrimitiveVertex.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/elements/SoGLTextureCoordinateElement.h>
+#include <Inventor/sensors/SoFieldSensor.h>
+
+#include "gf.h"
+
+#include "BBox.h"
+#include "DifferentialGeometry.h"
+#include "NormalVector.h"
+#include "Ray.h"
+#include "ShapeHeightField.h"
+#include "Vector3D.h"
+
+SO_NODE_SOURCE(ShapeHeightField);
+
+/**
+ * Sets up initialization for data common to all instances of this class.
+ */
+void ShapeHeightField::initClass()
+{
+	SO_NODE_INIT_CLASS(ShapeHeightField, TShape, "TShape");
+}
+
+/**
+ * Default constructor, initializes node instance.
+ */
+ShapeHeightField::ShapeHeightField()
+{
+	SO_NODE_CONSTRUCTOR(ShapeHeightField);
+	SO_NODE_ADD_FIELD( inputDataFile, ("") );
+
+	SoFieldSensor* fileSensor = new SoFieldSensor( updateInputDataFile, this );
+	fileSensor->setPriority( 1 );
+	fileSensor->attach( &inputDataFile );
+}
+
+/**
+ * Destructor.
+ */
+ShapeHeightField::~ShapeHeightField()
+{
+}
+
+double ShapeHeightField::GetArea() const
+{
+	if( !m_heightField ) return 0.0;
+	return m_heightField->GetArea();
+}
+
+/*!
+ * Return the shape bounding box.
+ */
+BBox ShapeHeightField::GetBBox() const
+{
+	if( !m_heightField ) return BBox();
+	return m_heightField->GetBBox();
+}
+
+QString ShapeHeightField::GetIcon() const
+{
+	return ":/icons/ShapeHeightField.png";
+}
+
+bool ShapeHeightField::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeHeightField::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+	*tHit = thit;
+	return true;
+}
+
+bool ShapeHeightField::IntersectP( const Ray& objectRay ) const
+{
+	double thit = 0.0;
+	double u;
+	double v;
+	return m_heightField && m_heightField->Intersect( objectRay, &thit, &u, &v );
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the surface. The side is
+ * decided with the geometric normal of the interpolated surface.
+ */
+bool ShapeHeightField::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
+	if( !m_heightField ) return false;
+
+	double thit;
+	double u;
+	double v;
+	if( !m_heightField->Intersect( objectRay, &thit, &u, &v ) ) return false;
+
+	hit->u = u;
+	hit->v = v;
+	m_heightField->GetTangents( u, v, &hit->dpdu, &hit->dpdv );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
+
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ * The normal is the interpolated measured normal, not the normal of the interpolated heights.
+ */
+void ShapeHeightField::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	if( fields & DifferentialGeometry::NORMAL_DERIVATIVES )
+		m_heightField->GetNormal( hit.u, hit.v, &dg->normal, &dg->dndu, &dg->dndv );
+	else
+		m_heightField->GetNormal( hit.u, hit.v, &dg->normal, 0, 0 );
+}
+
+Point3D ShapeHeightField::Sample( double u, double v ) const
+{
+	if( !m_heightField ) return Point3D();
+	return m_heightField->GetPoint3D( u, v );
+}
+
+/*!
+ * Loads the height field of the new input file. If the file cannot be read, the last valid file is restored.
+ */
+void ShapeHeightField::updateInputDataFile( void* data, SoSensor* )
+{
+	ShapeHeightField* shape = (ShapeHeightField*) data;
+
+	QString fileName( shape->inputDataFile.getValue().getString() );
+	if( fileName.isEmpty() )
+	{
+		shape->m_heightField = Ptr< HeightFieldData >();
+		shape->m_lastValidInputFile = fileName;
+		return;
+	}
+
+	QString errorMessage;
+	Ptr< HeightFieldData > heightField = HeightFieldData::Load( fileName, &errorMessage );
+	if( !heightField )
+	{
+		QMessageBox::warning( 0, QString( "Tonatiuh" ), errorMessage );
+		shape->inputDataFile.setValue( shape->m_lastValidInputFile.toStdString().c_str() );
+		return;
+	}
+
+	shape->m_heightField = heightField;
+	shape->m_lastValidInputFile = fileName;
+}
+
+void ShapeHeightField::computeBBox( SoAction*, SbBox3f& box, SbVec3f& /*center*/ )
+{
+	if( !m_heightField )
+	{
+		box.makeEmpty();
+		return;
+	}
+
+	BBox bBox = GetBBox();
+	// These points define the min and max extents of the box.
+	SbVec3f min, max;
+
+	min.setValue( bBox.pMin.x, bBox.pMin.y, bBox.pMin.z );
+	max.setValue( bBox.pMax.x, bBox.pMax.y, bBox.pMax.z );
+
+	// Set the box to bound the two extreme points.
+	box.setBounds( min, max );
+}
+
+/*!
+ * Generates the surface quads. Large grids are displayed with one of every few grid points,
+ * with at most m_maxDisplayedCells quads along each axis.
+ */
+void ShapeHeightField::generatePrimitives( SoAction* action )
+{
+	if( !m_heightField ) return;
+
+	SoPrimitiveVertex pv;
+
+	// Access the state from the action.
+	SoState* state = action->getState();
+
+	// See if we have to use a texture coordinate function,
+	// rather than generating explicit texture coordinates.
+	SbBool useTexFunc = ( SoTextureCoordinateElement::getType( state ) ==
+			SoTextureCoordinateElement::FUNCTION );
+
+	// If we need to generate texture coordinates with a
+	// function, we'll need an SoGLTextureCoordinateElement.
+	// Otherwise, we'll set up the coordinates directly.
+	const SoTextureCoordinateElement* tce = 0;
+	if( useTexFunc ) tce = SoTextureCoordinateElement::getInstance( state );
+
+	// Parameters of the displayed grid points, the last grid point is always included
+	std::vector< double > uValues;
+	int nCells = m_heightField->NumberOfColumns() - 1;
+	int step = ( nCells + m_maxDisplayedCells - 1 ) / m_maxDisplayedCells;
+	for( int column = 0; column < nCells; column += step ) uValues.push_back( double( column ) / nCells );
+	uValues.push_back( 1.0 );
+
+	std::vector< double > vValues;
+	nCells = m_heightField->NumberOfRows() - 1;
+	step = ( nCells + m_maxDisplayedCells - 1 ) / m_maxDisplayedCells;
+	for( int row = 0; row < nCells; row += step ) vValues.push_back( double( row ) / nCells );
+	vValues.push_back( 1.0 );
+
+	beginShape( action, QUADS );
+	for( unsigned int j = 0; j + 1 < vValues.size(); ++j )
+	{
+		for( unsigned int i = 0; i + 1 < uValues.size(); ++i )
+		{
+			const double u[4] = { uValues[i], uValues[i + 1], uValues[i + 1], uValues[i] };
+			const double v[4] = { vValues[j], vValues[j], vValues[j + 1], vValues[j + 1] };
+			for( int k = 0; k < 4; ++k )
+			{
+				Point3D point = m_heightField->GetPoint3D( u[k], v[k] );
+				NormalVector normal;
+				m_heightField->GetNormal( u[k], v[k], &normal, 0, 0 );
+
+				SbVec3f vertex( point.x, point.y, point.z );
+				SbVec3f vertexNormal( normal.x, normal.y, normal.z );
+				SbVec4f texCoord = useTexFunc ? tce->get( vertex, vertexNormal ) : SbVec4f( u[k], v[k], 0.0, 1.0 );
+				pv.setPoint( vertex );
+				pv.setNormal( vertexNormal );
+				pv.setTextureCoords( texCoord );
+				shapeVertex( &pv );
+			}
+		}
+	}
+	endShape();
+}
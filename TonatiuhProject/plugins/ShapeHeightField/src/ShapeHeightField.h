@@ -0,0 +1,98 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef SHAPEHEIGHTFIELD_H_
+#define SHAPEHEIGHTFIELD_H_
+
+#include <QString>
+
+#include <Inventor/fields/SoSFString.h>
+
+#include "HeightFieldData.h"
+#include "Ptr.h"
+#include "TShape.h"
+
+class SoSensor;
+
+/*!
+ * Shape defined by a regular grid of measured heights and normals, such as the deflectometry
+ * measurement of a mirror facet.
+ *
+ * The grid is read from the binary file described in HeightFieldData. The surface heights are
+ * the bilinear interpolation of the grid heights and the surface normal is the bilinear
+ * interpolation of the measured normals. The shapes that use the same file share its data.
+ */
+class ShapeHeightField : public TShape
+{
+	SO_NODE_HEADER(ShapeHeightField);
+
+public:
+	ShapeHeightField();
+	static void initClass();
+
+	double GetArea() const;
+	double GetVolume() const { return 0.0; };
+	BBox GetBBox() const;
+	QString GetIcon() const;
+
+	bool Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const;
+	bool IntersectP( const Ray& objectRay ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
+
+	Point3D Sample( double u, double v ) const;
+
+	SoSFString inputDataFile;
+
+protected:
+	static void updateInputDataFile( void* data, SoSensor* );
+
+	void computeBBox( SoAction* action, SbBox3f& box, SbVec3f& center );
+	void generatePrimitives( SoAction* action );
+	virtual ~ShapeHeightField();
+
+private:
+	enum { m_maxDisplayedCells = 128 };
+
+	Ptr< HeightFieldData > m_heightField;
+	QString m_lastValidInputFile;
+};
+
+#endif /* SHAPEHEIGHTFIELD_H_ */
@@ -50,6 +50,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeHyperboloid.h"
 #include "Vector3D.h"
 
@@ -70,6 +71,8 @@ ShapeHyperboloid::ShapeHyperboloid( )
 	SO_NODE_DEFINE_ENUM_VALUE( Side, OUTSIDE );
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (OUTSIDE) );
+
+	ComputeTraceParameters();
 }
 
 ShapeHyperboloid::~ShapeHyperboloid()
@@ -115,6 +118,30 @@ QString ShapeHyperboloid::GetIcon() const
 }
 
 bool ShapeHyperboloid::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the fucntion is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+	// Update _tHit_ for quadric intersection
+	*tHit = thit;
+
+	return true;
+
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeHyperboloid::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 	double xo= objectRay.origin.x;
 	double yo= objectRay.origin.y;
@@ -124,13 +151,11 @@ bool ShapeHyperboloid::Intersect( const Ray& objectRay, double* tHit, Differenti
 	double yd= objectRay.direction().y;
 	double zd= objectRay.direction().z;
 
-	double cConic = fabs( distanceTwoFocus.getValue() /2 );
-	double aConic = cConic - focusLegth.getValue();
-	double bConic = sqrt( fabs( cConic * cConic - aConic * aConic ) );
+	double aConic = m_aConic;
 
-	double A =  ( bConic * bConic * yd * yd  - aConic * aConic * (xd * xd  + zd * zd ) );
-	double B = 2 * (aConic  * bConic * bConic * yd + bConic * bConic * yd * yo - aConic * aConic * (xd * xo + zd * zo ) );
-	double C = 2 * aConic * bConic * bConic * yo + bConic * bConic * yo * yo - aConic * aConic*  (xo * xo + zo * zo );
+	double A =  ( m_bConic2 * yd * yd  - m_aConic2 * (xd * xd  + zd * zd ) );
+	double B = 2 * (aConic  * m_bConic2 * yd + m_bConic2 * yd * yo - m_aConic2 * (xd * xo + zd * zo ) );
+	double C = 2 * aConic * m_bConic2 * yo + m_bConic2 * yo * yo - m_aConic2 *  (xo * xo + zo * zo );
 
 	// Solve quadratic equation for _t_ values
 	double t0, t1;
@@ -149,11 +174,8 @@ bool ShapeHyperboloid::Intersect( const Ray& objectRay, double* tHit, Differenti
 
 	if( (thit - objectRay.mint) < tol ) return false;
 
-	double r = reflectorMaxDiameter.getValue() / 2;
-	double ymax = -aConic + ( sqrt( aConic * aConic * bConic * bConic
-											*  ( bConic * bConic + r * r) )
-								/ ( bConic * bConic ) );
-
+	double r = m_radius;
+	double ymax = m_yMax;
 
 	double ymin  = 0.0;
 
@@ -169,72 +191,150 @@ bool ShapeHyperboloid::Intersect( const Ray& objectRay, double* tHit, Differenti
 		yradius = sqrt(hitPoint.x * hitPoint.x + hitPoint.z * hitPoint.z);
 		if( hitPoint.y < ymin || hitPoint.y > ymax ||  yradius > r ) return false;
 	}
-	// Now check if the fucntion is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function Cylinder::Intersect(...) called with null pointers" );
 
 	// Find parametric representation of hyperbola hit
-	double u = yradius / ( reflectorMaxDiameter.getValue() / 2 );
+	double u = yradius / m_radius;
 	double phi = atan2( hitPoint.z , hitPoint.x );
 	if( phi < 0.0 ) phi = phi + gc::TwoPi;
 	double v = phi / gc::TwoPi;
 
+	double sinPhi = sin( gc::TwoPi * v );
+	double cosPhi = cos( gc::TwoPi * v );
+	double diameter2 = m_diameter * m_diameter;
+
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( 0.5 * m_diameter * cosPhi,
+			( m_aConic2 * diameter2 * u )
+				/ ( 2 * sqrt( m_aConic2 * m_bConic2 * ( 4 * m_bConic2  +  ( diameter2 * u * u ) ) ) ),
+			0.5 * m_diameter * sinPhi );
+	hit->dpdv = Vector3D( - m_diameter * gc::Pi * u * sinPhi,
+			0.0,
+			m_diameter * gc::Pi * u * cosPhi );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
 
-	Vector3D dpdu = Dpdu( u, v );
-	Vector3D dpdv = Dpdv( u, v );
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeHyperboloid::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
+
+	double u = hit.u;
+	double sinPhi = sin( gc::TwoPi * hit.v );
+	double cosPhi = cos( gc::TwoPi * hit.v );
+	double diameter2 = m_diameter * m_diameter;
 
 	// Compute cylinder \dndu and \dndv
 	Vector3D d2Pduu( 0.0,
-					(2 * pow( aConic, 4) * pow( bConic, 4 ) *  reflectorMaxDiameter.getValue() *  reflectorMaxDiameter.getValue() )
-					/ ( pow( aConic, 2 )* pow( bConic, 2)
-							* pow( 4 *  bConic * bConic + reflectorMaxDiameter.getValue() * reflectorMaxDiameter.getValue() * u * u , 3 / 2.0 ) ),
+					( 2 * m_aConic2 * m_aConic2 * m_bConic2 * m_bConic2 * diameter2 )
+					/ ( m_aConic2 * m_bConic2
+							* pow( 4 * m_bConic2 + diameter2 * u * u , 3 / 2.0 ) ),
 					0.0 );
 
-	Vector3D d2Pduv( - reflectorMaxDiameter.getValue() *gc::Pi * sin( gc::TwoPi * v ),
+	Vector3D d2Pduv( - m_diameter * gc::Pi * sinPhi,
 					0.0,
-					reflectorMaxDiameter.getValue() *gc::Pi * cos( gc::TwoPi * v ) );
-	Vector3D d2Pdvv( -2.0 * reflectorMaxDiameter.getValue() * gc::Pi * gc::Pi * u * cos( gc::TwoPi * v),
+					m_diameter * gc::Pi * cosPhi );
+	Vector3D d2Pdvv( -2.0 * m_diameter * gc::Pi * gc::Pi * u * cosPhi,
 					0.0,
-					-2.0 * reflectorMaxDiameter.getValue() * gc::Pi * gc::Pi * u * sin( gc::TwoPi * v ) );
+					-2.0 * m_diameter * gc::Pi * gc::Pi * u * sinPhi );
 
 	// Compute coefficients for fundamental forms
 	double E = DotProduct( dpdu, dpdu );
 	double F = DotProduct( dpdu, dpdv );
 	double G = DotProduct( dpdv, dpdv );
 
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
 	double e = DotProduct( N, d2Pduu );
 	double f = DotProduct( N, d2Pduv );
 	double g = DotProduct( N, d2Pdvv );
 
 		// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 					(e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 					(f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-								dpdu,
-								dpdv,
-								dndu,
-								dndv,
-								u, v, this );
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the hyperboloid.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeHyperboloid::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
 
-	// Update _tHit_ for quadric intersection
-	*tHit = thit;
+	//Evaluate Tolerance
+	const double tol = 0.00001;
 
-	return true;
+	const double aConic = m_aConic;
+	const double aConic2 = m_aConic2;
+	const double bConic2 = m_bConic2;
+	const double radius2 = m_radius * m_radius;
+	const double yMax = m_yMax;
 
+	for( int i = 0; i < nRays; ++i )
+	{
+		double A =  ( bConic2 * dy[i] * dy[i]  - aConic2 * ( dx[i] * dx[i]  + dz[i] * dz[i] ) );
+		double B = 2 * ( aConic * bConic2 * dy[i] + bConic2 * dy[i] * oy[i] - aConic2 * ( dx[i] * ox[i] + dz[i] * oz[i] ) );
+		double C = 2 * aConic * bConic2 * oy[i] + bConic2 * oy[i] * oy[i] - aConic2 * ( ox[i] * ox[i] + oz[i] * oz[i] );
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+		isValid = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol );
+
+		// Test both intersections against clipping parameters
+		double x0 = ox[i] + dx[i] * tFirst;
+		double y0 = oy[i] + dy[i] * tFirst;
+		double z0 = oz[i] + dz[i] * tFirst;
+		bool isFirstHit = isValid && !( y0 < 0.0 || y0 > yMax || ( x0 * x0 + z0 * z0 ) > radius2 );
+
+		double x1 = ox[i] + dx[i] * t1;
+		double y1 = oy[i] + dy[i] * t1;
+		double z1 = oz[i] + dz[i] * t1;
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) &&
+				!( y1 < 0.0 || y1 > yMax || ( x1 * x1 + z1 * z1 ) > radius2 );
+
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeHyperboloid::IntersectP( const Ray& worldRay ) const
 {
-	return Intersect( worldRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( worldRay, &thit, &hit );
 }
 
 Point3D ShapeHyperboloid::Sample( double u, double v ) const
@@ -276,6 +376,22 @@ NormalVector ShapeHyperboloid::GetNormal (double u, double v) const
 	return Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
 }
 
+/*!
+ * Updates the conic coefficients and the clipping values used by the intersection functions.
+ */
+void ShapeHyperboloid::ComputeTraceParameters()
+{
+	double cConic = fabs( distanceTwoFocus.getValue() /2 );
+	m_aConic = cConic - focusLegth.getValue();
+	m_bConic = sqrt( fabs( cConic * cConic - m_aConic * m_aConic ) );
+	m_aConic2 = m_aConic * m_aConic;
+	m_bConic2 = m_bConic * m_bConic;
+
+	m_diameter = reflectorMaxDiameter.getValue();
+	m_radius = m_diameter / 2;
+	m_yMax = -m_aConic + ( sqrt( m_aConic2 * m_bConic2 * ( m_bConic2 + m_radius * m_radius ) ) / m_bConic2 );
+}
+
 void ShapeHyperboloid::computeBBox(SoAction *, SbBox3f &box, SbVec3f& /*center*/ )
 {
 	BBox bBox = GetBBox();
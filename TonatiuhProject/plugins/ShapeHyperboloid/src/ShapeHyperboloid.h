@@ -69,6 +69,10 @@ public:
 
 	bool Intersect( const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -84,6 +88,7 @@ protected:
 	Point3D GetPoint3D ( double u, double v ) const;
 	NormalVector GetNormal( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void generatePrimitives(SoAction *action);
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	virtual ~ShapeHyperboloid();
@@ -91,6 +96,14 @@ protected:
 private:
 	Vector3D Dpdu( double u, double v ) const;
 	Vector3D Dpdv( double u, double v ) const;
+
+	double m_aConic;
+	double m_bConic;
+	double m_aConic2;
+	double m_bConic2;
+	double m_diameter;
+	double m_radius;
+	double m_yMax;
 };
 
 #endif /* ShapeHyperboloid_H_ */
@@ -50,6 +50,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeParabolicDish.h"
 #include "Vector3D.h"
 
@@ -81,6 +82,8 @@ ShapeParabolicDish::ShapeParabolicDish()
 	SoFieldSensor* dishMaxRadiusSensor = new SoFieldSensor( updateMaxRadius, this );
 	dishMaxRadiusSensor->setPriority( 1 );
 	dishMaxRadiusSensor->attach( &dishMaxRadius );
+
+	ComputeTraceParameters();
 }
 
 ShapeParabolicDish::~ShapeParabolicDish()
@@ -122,10 +125,33 @@ QString ShapeParabolicDish::GetIcon() const
 
 bool ShapeParabolicDish::Intersect(const Ray& objectRay, double* tHit, DifferentialGeometry* dg) const
 {
-	double pMax = phiMax.getValue();
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ParabolicCyl::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+	// Update _tHit_ for quadric intersection
+	*tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeParabolicDish::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
+	double pMax = m_phiMax;
 	double A = objectRay.direction().x*objectRay.direction().x + objectRay.direction().z * objectRay.direction().z;
-    double B = 2.0 * ( objectRay.direction().x* objectRay.origin.x + objectRay.direction().z * objectRay.origin.z - 2 * focusLength.getValue() * objectRay.direction().y );
-	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.z * objectRay.origin.z - 4 * focusLength.getValue() * objectRay.origin.y;
+    double B = 2.0 * ( objectRay.direction().x* objectRay.origin.x + objectRay.direction().z * objectRay.origin.z - 0.5 * m_fourFocus * objectRay.direction().y );
+	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.z * objectRay.origin.z - m_fourFocus * objectRay.origin.y;
 
 
 	// Solve quadratic equation for _t_ values
@@ -150,7 +176,7 @@ bool ShapeParabolicDish::Intersect(const Ray& objectRay, double* tHit, Different
     else phi = gc::TwoPi + atan2( hitPoint.x, hitPoint.z );
 
     // Test intersection against clipping parameters
-	if( (thit - objectRay.mint) < tol ||  radius < dishMinRadius.getValue() || radius > dishMaxRadius.getValue() || phi > pMax )
+	if( (thit - objectRay.mint) < tol ||  radius < m_minRadius || radius > m_maxRadius || phi > pMax )
 		{
 			if ( thit == t1 ) return false;
 			if ( t1 > objectRay.maxt ) return false;
@@ -162,40 +188,66 @@ bool ShapeParabolicDish::Intersect(const Ray& objectRay, double* tHit, Different
 		    else if( hitPoint.x > 0 ) phi = atan2( hitPoint.x, hitPoint.z );
 		    else phi = gc::TwoPi + atan2( hitPoint.x, hitPoint.z );
 
-			if( (thit - objectRay.mint) < tol ||  radius < dishMinRadius.getValue() || radius > dishMaxRadius.getValue() || phi > pMax ) return false;
+			if( (thit - objectRay.mint) < tol ||  radius < m_minRadius || radius > m_maxRadius || phi > pMax ) return false;
 		}
 
-	// Now check if the function is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ParabolicCyl::Intersect(...) called with null pointers" );
-
-///////////////////////////////////////////////////////////////////////////////////////
-
 	// Find parametric representation of paraboloid hit
 	double u = phi / pMax;
-	double v = ( radius - dishMinRadius.getValue() )  /( dishMaxRadius.getValue() - dishMinRadius.getValue() );
+	double v = ( radius - m_minRadius )  / m_radiusRange;
 
 	// Compute Circular Parabolic Facet \dpdu and \dpdv
-	double r = v * ( dishMaxRadius.getValue() - dishMinRadius.getValue() ) + dishMinRadius.getValue();
-	Vector3D dpdu( pMax * r * cos( pMax * u ),
+	double r = v * m_radiusRange + m_minRadius;
+	double cosPhi = cos( pMax * u );
+	double sinPhi = sin( pMax * u );
+
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( pMax * r * cosPhi,
 					0,
-					-pMax * r * sin( pMax * u ) );
+					-pMax * r * sinPhi );
+	hit->dpdv = Vector3D( m_radiusRange * sinPhi,
+				   m_radiusRange * r * m_invTwoFocus,
+				   m_radiusRange * cosPhi );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
 
-	Vector3D dpdv( ( dishMaxRadius.getValue() - dishMinRadius.getValue() )  * sin( pMax * u ),
-				   ( ( dishMaxRadius.getValue() - dishMinRadius.getValue() ) * r  )
-							   / ( 2 * focusLength.getValue() ),
-					( dishMaxRadius.getValue() - dishMinRadius.getValue() ) * cos( pMax * u ) );
+	*tHit = thit;
+	return true;
+}
 
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeParabolicDish::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
+
+	double pMax = m_phiMax;
+	double r = hit.v * m_radiusRange + m_minRadius;
+	double cosPhi = cos( pMax * hit.u );
+	double sinPhi = sin( pMax * hit.u );
 
 	// Compute Circular Parabolic Facet \dndu and \dndv
-	Vector3D d2Pduu ( -pMax * pMax * r * sin( pMax * u ),
+	Vector3D d2Pduu ( -pMax * pMax * r * sinPhi,
 			0.0,
-			-pMax* pMax * r * cos( pMax * u ) );
-	Vector3D d2Pduv ( pMax* ( dishMaxRadius.getValue()- dishMinRadius.getValue() ) * cos( pMax * u ),
+			-pMax* pMax * r * cosPhi );
+	Vector3D d2Pduv ( pMax * m_radiusRange * cosPhi,
 					0.0,
-					-pMax * ( dishMaxRadius.getValue()- dishMinRadius.getValue() ) * sin( pMax * u ) );
-	Vector3D d2Pdvv (0, ( ( dishMaxRadius.getValue()- dishMinRadius.getValue() ) * ( dishMaxRadius.getValue()- dishMinRadius.getValue() ) ) /(2 * focusLength.getValue() ), 0 );
+					-pMax * m_radiusRange * sinPhi );
+	Vector3D d2Pdvv (0, m_radiusRange * m_radiusRange * m_invTwoFocus, 0 );
 
 
 	// Compute coefficients for fundamental forms
@@ -203,40 +255,92 @@ bool ShapeParabolicDish::Intersect(const Ray& objectRay, double* tHit, Different
 	double F = DotProduct(dpdu, dpdv);
 	double G = DotProduct(dpdv, dpdv);
 
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
 	double e = DotProduct(N, d2Pduu);
 	double f = DotProduct(N, d2Pduv);
 	double g = DotProduct(N, d2Pdvv);
 
 	// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 		(e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 		(f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry(hitPoint,
-	                           dpdu,
-							   dpdv,
-	                           dndu,
-							   dndv,
-	                           u, v, this);
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
-
-
-///////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Computes the intersection of each ray in \a objectRays with the parabolic dish.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeParabolicDish::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double fourFocus = m_fourFocus;
+	const double minRadius = m_minRadius;
+	const double maxRadius = m_maxRadius;
+	const double phiMax = m_phiMax;
+	const bool isPhiClipped = ( m_phiMax < gc::TwoPi );
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Compute quadratic coefficients
+		double A = dx[i] * dx[i] + dz[i] * dz[i];
+		double B = 2.0 * ( dx[i] * ox[i] + dz[i] * oz[i] - 0.5 * fourFocus * dy[i] );
+		double C = ox[i] * ox[i] + oz[i] * oz[i] - fourFocus * oy[i];
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+
+		// Test both intersections against clipping parameters
+		double x0 = ox[i] + dx[i] * tFirst;
+		double z0 = oz[i] + dz[i] * tFirst;
+		double radius0 = sqrt( x0 * x0 + z0 * z0 );
+		bool isFirstHit = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol ) &&
+				!( radius0 < minRadius || radius0 > maxRadius );
+
+		double x1 = ox[i] + dx[i] * t1;
+		double z1 = oz[i] + dz[i] * t1;
+		double radius1 = sqrt( x1 * x1 + z1 * z1 );
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) && !( ( t1 - mint[i] ) < tol ) &&
+				!( radius1 < minRadius || radius1 > maxRadius );
+
+		// The angle is only computed for dish sectors
+		if( isPhiClipped )
+		{
+			double phi0 = ( x0 > 0 ) ? atan2( x0, z0 ) : gc::TwoPi + atan2( x0, z0 );
+			if( ( z0 == 0.0 ) && ( x0 == 0.0 ) ) phi0 = 0.0;
+			double phi1 = ( x1 > 0 ) ? atan2( x1, z1 ) : gc::TwoPi + atan2( x1, z1 );
+			if( ( z1 == 0.0 ) && ( x1 == 0.0 ) ) phi1 = 0.0;
 
-	// Update _tHit_ for quadric intersection
-	*tHit = thit;
+			isFirstHit = isFirstHit && !( phi0 > phiMax );
+			isSecondHit = isSecondHit && !( phi1 > phiMax );
+		}
 
-	return true;
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeParabolicDish::IntersectP( const Ray& worldRay ) const
 {
-	return Intersect( worldRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( worldRay, &thit, &hit );
 }
 
 Point3D ShapeParabolicDish::Sample( double u, double v ) const
@@ -280,6 +384,19 @@ bool ShapeParabolicDish::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the dish radii, the angle and the focus terms used by the intersection functions.
+ */
+void ShapeParabolicDish::ComputeTraceParameters()
+{
+	m_phiMax = phiMax.getValue();
+	m_minRadius = dishMinRadius.getValue();
+	m_maxRadius = dishMaxRadius.getValue();
+	m_radiusRange = m_maxRadius - m_minRadius;
+	m_fourFocus = 4 * focusLength.getValue();
+	m_invTwoFocus = 1.0 / ( 2 * focusLength.getValue() );
+}
+
 void ShapeParabolicDish::computeBBox(SoAction*, SbBox3f& box, SbVec3f& /*center*/)
 {
 	BBox bBox = GetBBox();
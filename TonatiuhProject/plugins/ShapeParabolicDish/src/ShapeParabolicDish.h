@@ -68,6 +68,10 @@ public:
 
 	bool Intersect(const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -82,6 +86,7 @@ protected:
 	NormalVector GetNormal ( double u, double v ) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox( SoAction* action, SbBox3f& box, SbVec3f& center);
 	void generatePrimitives(SoAction *action);
 	virtual ~ShapeParabolicDish();
@@ -92,6 +97,13 @@ protected:
 private:
 	double m_lastMaxRadius;
 	double m_lastMinRadius;
+
+	double m_phiMax;
+	double m_minRadius;
+	double m_maxRadius;
+	double m_radiusRange;
+	double m_fourFocus;
+	double m_invTwoFocus;
 };
 
 #endif /*SHAPEPARABOLICDISH_H_*/
@@ -50,6 +50,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeParabolicRectangle.h"
 #include "Vector3D.h"
 
@@ -72,6 +73,8 @@ ShapeParabolicRectangle::ShapeParabolicRectangle()
 	SO_NODE_DEFINE_ENUM_VALUE( Side, OUTSIDE );
 	SO_NODE_SET_SF_ENUM_TYPE( activeSide, Side );
 	SO_NODE_ADD_FIELD( activeSide, (OUTSIDE) );
+
+	ComputeTraceParameters();
 }
 
 ShapeParabolicRectangle::~ShapeParabolicRectangle()
@@ -106,14 +109,32 @@ QString ShapeParabolicRectangle::GetIcon() const
 
 bool ShapeParabolicRectangle::Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg) const
 {
-	double focus = focusLength.getValue();
-	double wX = widthX.getValue();
-	double wZ = widthZ.getValue();
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
 
+    // Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) )	gf::SevereError( "Function ParabolicCyl::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+	// Update _tHit_ for quadric intersection
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeParabolicRectangle::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
 	// Compute quadratic coefficients
 	double A = objectRay.direction().x * objectRay.direction().x + objectRay.direction().z * objectRay.direction().z;
-	double B = 2.0 * ( objectRay.direction().x * objectRay.origin.x + objectRay.direction().z * objectRay.origin.z  - 2 * focus * objectRay.direction().y );
-	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.z * objectRay.origin.z - 4 * focus * objectRay.origin.y;
+	double B = 2.0 * ( objectRay.direction().x * objectRay.origin.x + objectRay.direction().z * objectRay.origin.z  - 0.5 * m_fourFocus * objectRay.direction().y );
+	double C = objectRay.origin.x * objectRay.origin.x + objectRay.origin.z * objectRay.origin.z - m_fourFocus * objectRay.origin.y;
 
 	// Solve quadratic equation for _t_ values
 	double t0, t1;
@@ -131,78 +152,134 @@ bool ShapeParabolicRectangle::Intersect(const Ray& objectRay, double *tHit, Diff
 	Point3D hitPoint = objectRay( thit );
 
 	// Test intersection against clipping parameters
-	if( (thit - objectRay.mint) < tol ||  hitPoint.x < ( - wX / 2 ) || hitPoint.x > ( wX / 2 ) ||
-			hitPoint.z < ( - wZ / 2 ) || hitPoint.z > ( wZ / 2 ) )
+	if( (thit - objectRay.mint) < tol ||  hitPoint.x < -m_halfWidthX || hitPoint.x > m_halfWidthX ||
+			hitPoint.z < -m_halfWidthZ || hitPoint.z > m_halfWidthZ )
 	{
 		if ( thit == t1 ) return false;
 		if ( t1 > objectRay.maxt ) return false;
 		thit = t1;
 
 		hitPoint = objectRay( thit );
-		if( (thit - objectRay.mint) < tol ||  hitPoint.x < ( - wX / 2 ) || hitPoint.x > ( wX / 2 ) ||
-					hitPoint.z < ( - wZ / 2 ) || hitPoint.z > ( wZ / 2 ) )	return false;
+		if( (thit - objectRay.mint) < tol ||  hitPoint.x < -m_halfWidthX || hitPoint.x > m_halfWidthX ||
+					hitPoint.z < -m_halfWidthZ || hitPoint.z > m_halfWidthZ )	return false;
 
 	}
 
-    // Now check if the function is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) )	gf::SevereError( "Function ParabolicCyl::Intersect(...) called with null pointers" );
-
-///////////////////////////////////////////////////////////////////////////////////////
+	// Find parametric representation of paraboloid hit
+	double u =  ( hitPoint.x  / m_widthX ) + 0.5;
+	double v =  ( hitPoint.z  / m_widthZ ) + 0.5;
 
-	// Compute possible parabola hit position
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( m_widthX, (-0.5 + u) * m_d2Pduu, 0 );
+	hit->dpdv = Vector3D( 0.0, ( -0.5 + v) * m_d2Pdvv, m_widthZ );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
 
-	// Find parametric representation of paraboloid hit
-	double u =  ( hitPoint.x  / wX ) + 0.5;
-	double v =  ( hitPoint.z  / wZ ) + 0.5;
+	*tHit = thit;
+	return true;
+}
 
-	Vector3D dpdu( wX, ( (-0.5 + u) * wX *  wX ) / ( 2 * focus ), 0 );
-	Vector3D dpdv( 0.0, (( -0.5 + v) * wZ *  wZ ) /( 2 * focus ), wZ );
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeParabolicRectangle::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
 
 	// Compute parabaloid \dndu and \dndv
-	Vector3D d2Pduu( 0.0,  (wX *  wX ) /( 2 * focus ), 0.0 );
+	Vector3D d2Pduu( 0.0, m_d2Pduu, 0.0 );
 	Vector3D d2Pduv( 0.0, 0.0, 0.0 );
-	Vector3D d2Pdvv( 0.0,  (wZ *  wZ ) /( 2 * focus ), 0.0 );
+	Vector3D d2Pdvv( 0.0, m_d2Pdvv, 0.0 );
 
 	// Compute coefficients for fundamental forms
 	double E = DotProduct(dpdu, dpdu);
 	double F = DotProduct(dpdu, dpdv);
 	double G = DotProduct(dpdv, dpdv);
 
-	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
 	double e = DotProduct(N, d2Pduu);
 	double f = DotProduct(N, d2Pduv);
 	double g = DotProduct(N, d2Pdvv);
 
 	// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 		(e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 		(f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry(hitPoint,
-							   dpdu,
-							   dpdv,
-							   dndu,
-							   dndv,
-							   u, v, this);
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
-
-
-///////////////////////////////////////////////////////////////////////////////////////
-
-	// Update _tHit_ for quadric intersection
-	*tHit = thit;
-	return true;
+/*!
+ * Computes the intersection of each ray in \a objectRays with the parabolic rectangle.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeParabolicRectangle::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double fourFocus = m_fourFocus;
+	const double halfWidthX = m_halfWidthX;
+	const double halfWidthZ = m_halfWidthZ;
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Compute quadratic coefficients
+		double A = dx[i] * dx[i] + dz[i] * dz[i];
+		double B = 2.0 * ( dx[i] * ox[i] + dz[i] * oz[i] - 0.5 * fourFocus * dy[i] );
+		double C = ox[i] * ox[i] + oz[i] * oz[i] - fourFocus * oy[i];
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+
+		// Test both intersections against clipping parameters
+		double x0 = ox[i] + dx[i] * tFirst;
+		double z0 = oz[i] + dz[i] * tFirst;
+		bool isFirstHit = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol ) &&
+				!( x0 < -halfWidthX || x0 > halfWidthX || z0 < -halfWidthZ || z0 > halfWidthZ );
+
+		double x1 = ox[i] + dx[i] * t1;
+		double z1 = oz[i] + dz[i] * t1;
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) && !( ( t1 - mint[i] ) < tol ) &&
+				!( x1 < -halfWidthX || x1 > halfWidthX || z1 < -halfWidthZ || z1 > halfWidthZ );
+
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeParabolicRectangle::IntersectP( const Ray& objectRay ) const
 {
-	return Intersect( objectRay, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( objectRay, &thit, &hit );
 }
 
 Point3D ShapeParabolicRectangle::Sample( double u, double v ) const
@@ -232,6 +309,21 @@ NormalVector ShapeParabolicRectangle::GetNormal( double u, double v ) const
 	Vector3D dpdv( 0.0, (( -0.5 + v) * widthZ.getValue() *  widthZ.getValue() ) /( 2 * focusLength.getValue() ), widthZ.getValue() );
 	return Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
 }
+/*!
+ * Updates the half widths and the focus terms used by the intersection functions.
+ */
+void ShapeParabolicRectangle::ComputeTraceParameters()
+{
+	double focus = focusLength.getValue();
+	m_widthX = widthX.getValue();
+	m_widthZ = widthZ.getValue();
+	m_halfWidthX = 0.5 * m_widthX;
+	m_halfWidthZ = 0.5 * m_widthZ;
+	m_fourFocus = 4 * focus;
+	m_d2Pduu = ( m_widthX * m_widthX ) / ( 2 * focus );
+	m_d2Pdvv = ( m_widthZ * m_widthZ ) / ( 2 * focus );
+}
+
 void ShapeParabolicRectangle::computeBBox( SoAction*, SbBox3f& box, SbVec3f& /*center*/ )
 {
 	BBox bBox = GetBBox();
@@ -66,6 +66,10 @@ public:
 
 	bool Intersect(const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	Point3D Sample( double u, double v ) const;
 
@@ -79,9 +83,19 @@ protected:
 	NormalVector GetNormal( double u, double v ) const;
 	bool OutOfRange( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	void generatePrimitives(SoAction *action);
    	~ShapeParabolicRectangle();
+
+private:
+	double m_widthX;
+	double m_widthZ;
+	double m_halfWidthX;
+	double m_halfWidthZ;
+	double m_fourFocus;
+	double m_d2Pduu;
+	double m_d2Pdvv;
 };
 
 #endif /*RECTANGULARPARABOLICFACET_H_*/
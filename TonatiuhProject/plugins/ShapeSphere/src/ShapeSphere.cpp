@@ -51,6 +51,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "DifferentialGeometry.h"
 #include "Ray.h"
+#include "RayBatch.h"
 #include "ShapeSphere.h"
 
 SO_NODE_SOURCE(ShapeSphere);
@@ -92,6 +93,8 @@ ShapeSphere::ShapeSphere( )
 	SoFieldSensor* m_phiMaxSensor = new SoFieldSensor(updatePhiMax, this);
 	m_phiMaxSensor->setPriority( 1 );
 	m_phiMaxSensor->attach( &phiMax );
+
+	ComputeTraceParameters();
 }
 
 ShapeSphere::~ShapeSphere()
@@ -160,13 +163,36 @@ Point3D ShapeSphere::Sample( double u1, double u2 ) const
 }
 
 bool ShapeSphere::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	// Now check if the fucntion is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeSphere::Intersect(...) called with null pointers" );
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+    // Update _tHit_ for quadric intersection
+    *tHit = thit;
+
+	return true;
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape and its parametric representation.
+ * The normal derivatives are not computed.
+ */
+bool ShapeSphere::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
 {
 
 	// Compute quadratic ShapeSphere coefficients
 	Vector3D vObjectRayOrigin = Vector3D( objectRay.origin );
 	double A = objectRay.direction().lengthSquared();
     double B = 2.0 * DotProduct( vObjectRayOrigin, objectRay.direction() );
-	double C = vObjectRayOrigin.lengthSquared() - radius.getValue() * radius.getValue();
+	double C = vObjectRayOrigin.lengthSquared() - m_radius2;
 
 	// Solve quadratic equation for _t_ values
 	double t0, t1;
@@ -186,7 +212,7 @@ bool ShapeSphere::Intersect( const Ray& objectRay, double* tHit, DifferentialGeo
 	if ( phi < 0. ) phi += gc::TwoPi;
 
 	// Test intersection against clipping parameters
-	if( (thit - objectRay.mint) < tol || hitPoint.y < yMin.getValue() || hitPoint.y > yMax.getValue() || phi > phiMax.getValue() )
+	if( (thit - objectRay.mint) < tol || hitPoint.y < m_yMin || hitPoint.y > m_yMax || phi > m_phiMax )
 	{
 		if ( thit == t1 ) return false;
 		if ( t1 > objectRay.maxt ) return false;
@@ -197,78 +223,164 @@ bool ShapeSphere::Intersect( const Ray& objectRay, double* tHit, DifferentialGeo
 		phi = atan2( hitPoint.x, hitPoint.z );
 	    if ( phi < 0. ) phi += gc::TwoPi;
 
-		if ( (thit - objectRay.mint) < tol || hitPoint.y < yMin.getValue() || hitPoint.y > yMax.getValue() || phi > phiMax.getValue() )	return false;
+		if ( (thit - objectRay.mint) < tol || hitPoint.y < m_yMin || hitPoint.y > m_yMax || phi > m_phiMax )	return false;
 	}
-	// Now check if the fucntion is being called from IntersectP,
-	// in which case the pointers tHit and dg are 0
-	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
-	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeSphere::Intersect(...) called with null pointers" );
 
 	// Find parametric representation of ShapeSphere hit
-	double theta = acos( hitPoint.y / radius.getValue() );
-	double thetaMin = acos( yMax.getValue() / radius.getValue() );
-	double thetaMax = acos( yMin.getValue()/radius.getValue() );
+	double theta = acos( hitPoint.y / m_radius );
+	double thetaMin = m_thetaMin;
+	double thetaMax = m_thetaMax;
 	double u = ( theta - thetaMin ) / ( thetaMax - thetaMin );
-	double v = phi / phiMax.getValue();
+	double v = phi / m_phiMax;
 
-	// Compute ShapeSphere \dpdu and \dpdv
-	Vector3D dpdu( radius.getValue() * ( -thetaMin + thetaMax ) * cos( ( -1 + u ) * thetaMin - u * thetaMax ) * sin( phiMax.getValue() * v ),
-					radius.getValue() * ( -thetaMin + thetaMax ) * sin( ( -1 + u ) * thetaMin - u * thetaMax ),
-					radius.getValue() * ( -thetaMin + thetaMax ) * cos( phiMax.getValue() * v ) * cos( ( -1 + u ) * thetaMin - u * thetaMax ) );
+	double sinTheta = sin( ( -1 + u ) * thetaMin - u * thetaMax );
+	double cosTheta = cos( ( -1 + u ) * thetaMin - u * thetaMax );
+	double sinPhi = sin( m_phiMax * v );
+	double cosPhi = cos( m_phiMax * v );
 
-	Vector3D dpdv( -phiMax.getValue() * radius.getValue() * cos( phiMax.getValue() * v ) * sin( ( -1 + u ) * thetaMin - u * thetaMax ),
+	// Compute ShapeSphere \dpdu and \dpdv
+	hit->u = u;
+	hit->v = v;
+	hit->dpdu = Vector3D( m_radius * ( -thetaMin + thetaMax ) * cosTheta * sinPhi,
+					m_radius * ( -thetaMin + thetaMax ) * sinTheta,
+					m_radius * ( -thetaMin + thetaMax ) * cosPhi * cosTheta );
+	hit->dpdv = Vector3D( -m_phiMax * m_radius * cosPhi * sinTheta,
 					0.0,
-					phiMax.getValue() * radius.getValue() * sin( phiMax.getValue() * v ) * sin( ( -1 + u ) * thetaMin - u * thetaMax ) );
+					m_phiMax * m_radius * sinPhi * sinTheta );
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
+
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ */
+void ShapeSphere::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int fields, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->shapeFrontSide = hit.shapeFrontSide;
+	if( fields == DifferentialGeometry::POINT_ONLY )	return;
+
+	const Vector3D& dpdu = hit.dpdu;
+	const Vector3D& dpdv = hit.dpdv;
+	NormalVector N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
+	dg->normal = N;
+	if( !( fields & DifferentialGeometry::NORMAL_DERIVATIVES ) )	return;
+
+	double thetaMin = m_thetaMin;
+	double thetaMax = m_thetaMax;
+	double sinTheta = sin( ( -1 + hit.u ) * thetaMin - hit.u * thetaMax );
+	double cosTheta = cos( ( -1 + hit.u ) * thetaMin - hit.u * thetaMax );
+	double sinPhi = sin( m_phiMax * hit.v );
+	double cosPhi = cos( m_phiMax * hit.v );
 
 	// Compute ShapeSphere \dndu and \dndv
-	Vector3D d2Pduu(  -radius.getValue() * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * sin( phiMax.getValue() * v ) * sin( (-1 + u) * thetaMin - u * thetaMax ),
-					radius.getValue() * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * cos( (-1 + u) * thetaMin - u * thetaMax ),
-					-radius.getValue() * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * cos( phiMax.getValue() * v ) * sin( (-1 + u) * thetaMin -u * thetaMax )  );
+	Vector3D d2Pduu(  -m_radius * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * sinPhi * sinTheta,
+					m_radius * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * cosTheta,
+					-m_radius * ( thetaMin - thetaMax ) * ( -thetaMin + thetaMax ) * cosPhi * sinTheta  );
 
-	Vector3D d2Pduv( phiMax.getValue() * radius.getValue() * ( -thetaMin + thetaMax ) * cos( phiMax.getValue() * v ) * cos( (-1 + u ) * thetaMin - u  * thetaMax ),
+	Vector3D d2Pduv( m_phiMax * m_radius * ( -thetaMin + thetaMax ) * cosPhi * cosTheta,
 					0.0,
-					-phiMax.getValue() * radius.getValue() * ( -thetaMin + thetaMax ) * cos( (-1 + u ) * thetaMin - u  * thetaMax ) * sin( phiMax.getValue() * v ) );
+					-m_phiMax * m_radius * ( -thetaMin + thetaMax ) * cosTheta * sinPhi );
 
-	Vector3D d2Pdvv( phiMax.getValue() * phiMax.getValue() * radius.getValue() * sin( phiMax.getValue() * v ) * sin( (-1 + u) * thetaMin - u * thetaMax ),
+	Vector3D d2Pdvv( m_phiMax * m_phiMax * m_radius * sinPhi * sinTheta,
 					0.0,
-					phiMax.getValue() * phiMax.getValue() *  radius.getValue() * cos( phiMax.getValue() * v ) * sin( (-1 + u) * thetaMin - u * thetaMax ) );
+					m_phiMax * m_phiMax *  m_radius * cosPhi * sinTheta );
 
 	// Compute coefficients for fundamental forms
 	double E = DotProduct( dpdu, dpdu );
 	double F = DotProduct( dpdu, dpdv );
 	double G = DotProduct( dpdv, dpdv );
 
-	Vector3D N = Normalize( NormalVector( CrossProduct( dpdu, dpdv ) ) );
-
 	double e = DotProduct( N, d2Pduu );
 	double f = DotProduct( N, d2Pduv );
 	double g = DotProduct( N, d2Pdvv );
 
 		// Compute \dndu and \dndv from fundamental form coefficients
 	double invEGF2 = 1.0 / (E*G - F*F);
-	Vector3D dndu = (f*F - e*G) * invEGF2 * dpdu +
+	dg->dndu = (f*F - e*G) * invEGF2 * dpdu +
 			        (e*F - f*E) * invEGF2 * dpdv;
-	Vector3D dndv = (g*F - f*G) * invEGF2 * dpdu +
+	dg->dndv = (g*F - f*G) * invEGF2 * dpdu +
 	                (f*F - g*E) * invEGF2 * dpdv;
+}
 
-	// Initialize _DifferentialGeometry_ from parametric information
-	*dg = DifferentialGeometry( hitPoint ,
-		                        dpdu,
-								dpdv,
-		                        dndu,
-								dndv,
-		                        u, v, this );
+/*!
+ * Computes the intersection of each ray in \a objectRays with the sphere.
+ *
+ * Uses the same tests as Intersect without branches so that the loop can be vectorized.
+ */
+void ShapeSphere::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	const int nRays = objectRays.Size();
+	if( nRays < 1 ) return;
+
+	const double* ox = &objectRays.originX[0];
+	const double* oy = &objectRays.originY[0];
+	const double* oz = &objectRays.originZ[0];
+	const double* dx = &objectRays.directionX[0];
+	const double* dy = &objectRays.directionY[0];
+	const double* dz = &objectRays.directionZ[0];
+	const double* mint = &objectRays.mint[0];
+	const double* maxt = &objectRays.maxt[0];
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	const double radius2 = m_radius2;
+	const double yMin = m_yMin;
+	const double yMax = m_yMax;
+	const double phiMax = m_phiMax;
+	const bool isPhiClipped = ( m_phiMax < gc::TwoPi );
+
+	for( int i = 0; i < nRays; ++i )
+	{
+		// Compute quadratic ShapeSphere coefficients
+		double A = dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i];
+		double B = 2.0 * ( ox[i] * dx[i] + oy[i] * dy[i] + oz[i] * dz[i] );
+		double C = ox[i] * ox[i] + oy[i] * oy[i] + oz[i] * oz[i] - radius2;
+
+		double t0, t1;
+		bool isValid = gf::QuadraticRoots( A, B, C, &t0, &t1 ) && !( t0 > maxt[i] || t1 < mint[i] );
+		double tFirst = ( t0 > mint[i] ) ? t0 : t1;
+
+		// Test both intersections against clipping parameters
+		double y0 = oy[i] + dy[i] * tFirst;
+		bool isFirstHit = isValid && !( tFirst > maxt[i] ) && !( ( tFirst - mint[i] ) < tol ) &&
+				!( y0 < yMin || y0 > yMax );
+
+		double y1 = oy[i] + dy[i] * t1;
+		bool isSecondHit = isValid && ( tFirst != t1 ) && !( t1 > maxt[i] ) && !( ( t1 - mint[i] ) < tol ) &&
+				!( y1 < yMin || y1 > yMax );
+
+		// The angle is only computed for sphere sectors
+		if( isPhiClipped )
+		{
+			double phi0 = atan2( ox[i] + dx[i] * tFirst, oz[i] + dz[i] * tFirst );
+			if( phi0 < 0. ) phi0 += gc::TwoPi;
+			double phi1 = atan2( ox[i] + dx[i] * t1, oz[i] + dz[i] * t1 );
+			if( phi1 < 0. ) phi1 += gc::TwoPi;
 
-	dg->shapeFrontSide = ( DotProduct( N, objectRay.direction() ) > 0 ) ? false : true;
-    // Update _tHit_ for quadric intersection
-    *tHit = thit;
+			isFirstHit = isFirstHit && !( phi0 > phiMax );
+			isSecondHit = isSecondHit && !( phi1 > phiMax );
+		}
 
-	return true;
+		isHit[i] = isFirstHit || isSecondHit;
+		tHit[i] = isFirstHit ? tFirst : t1;
+	}
 }
 
 bool ShapeSphere::IntersectP( const Ray& ray ) const
 {
-	return Intersect( ray, 0, 0 );
+	double thit = 0.0;
+	ShapeHit hit;
+	return IntersectHit( ray, &thit, &hit );
 }
 
 
@@ -382,6 +494,20 @@ bool ShapeSphere::OutOfRange( double u, double v ) const
 	return ( ( u < 0.0 ) || ( u > 1.0 ) || ( v < 0.0 ) || ( v > 1.0 ) );
 }
 
+/*!
+ * Updates the radius, the clipping values and the theta range used by the intersection functions.
+ */
+void ShapeSphere::ComputeTraceParameters()
+{
+	m_radius = radius.getValue();
+	m_radius2 = m_radius * m_radius;
+	m_yMin = yMin.getValue();
+	m_yMax = yMax.getValue();
+	m_phiMax = phiMax.getValue();
+	m_thetaMin = acos( m_yMax / m_radius );
+	m_thetaMax = acos( m_yMin / m_radius );
+}
+
 void ShapeSphere::computeBBox(SoAction*, SbBox3f& box, SbVec3f& /*center*/)
 {
 	BBox bBox = GetBBox();
@@ -71,6 +71,10 @@ public:
 
 	bool Intersect(const Ray &ray, double *tHit, DifferentialGeometry *dg ) const;
 	bool IntersectP( const Ray &ray ) const;
+	void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 
 	trt::TONATIUH_REAL radius;
 	trt::TONATIUH_REAL yMax;
@@ -88,6 +92,7 @@ protected:
 	Point3D GetPoint3D ( double u, double v ) const;
 	NormalVector GetNormal( double u, double v ) const;
 
+	void ComputeTraceParameters();
 	void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
 	void generatePrimitives(SoAction *action);
    	virtual ~ShapeSphere();
@@ -102,6 +107,14 @@ private:
 	SoFieldSensor* m_yMaxSensor;
 	SoFieldSensor* m_phiMaxSensor;
 
+	double m_radius;
+	double m_radius2;
+	double m_yMin;
+	double m_yMax;
+	double m_phiMax;
+	double m_thetaMin;
+	double m_thetaMax;
+
 };
 
 #endif /*SHAPESPHERE_H_*/
@@ -0,0 +1,490 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <map>
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <Inventor/SoPrimitiveVertex.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/elements/SoGLTextureCoordinateElement.h>
+#include <Inventor/sensors/SoFieldSensor.h>
+
+#include "gf.h"
+
+#include "BBox.h"
+#include "DifferentialGeometry.h"
+#include "NormalVector.h"
+#include "Ray.h"
+#include "ShapeTriangleMesh.h"
+#include "Vector3D.h"
+
+/*!
+ * Lexicographic order of points, used to merge the repeated vertices of STL files.
+ */
+struct PointLess
+{
+	bool operator()( const Point3D& a, const Point3D& b ) const
+	{
+		if( a.x != b.x ) return a.x < b.x;
+		if( a.y != b.y ) return a.y < b.y;
+		return a.z < b.z;
+	}
+};
+
+SO_NODE_SOURCE(ShapeTriangleMesh);
+
+/**
+ * Sets up initialization for data common to all instances of this class.
+ */
+void ShapeTriangleMesh::initClass()
+{
+	SO_NODE_INIT_CLASS(ShapeTriangleMesh, TShape, "TShape");
+}
+
+/**
+ * Default constructor, initializes node instance.
+ */
+ShapeTriangleMesh::ShapeTriangleMesh()
+{
+	SO_NODE_CONSTRUCTOR(ShapeTriangleMesh);
+	SO_NODE_ADD_FIELD( inputDataFile, ("") );
+
+	SoFieldSensor* fileSensor = new SoFieldSensor( updateInputDataFile, this );
+	fileSensor->setPriority( 1 );
+	fileSensor->attach( &inputDataFile );
+}
+
+/**
+ * Destructor.
+ */
+ShapeTriangleMesh::~ShapeTriangleMesh()
+{
+}
+
+double ShapeTriangleMesh::GetArea() const
+{
+	return m_mesh.GetArea();
+}
+
+/*!
+ * Return the shape bounding box.
+ */
+BBox ShapeTriangleMesh::GetBBox() const
+{
+	return m_mesh.GetBBox();
+}
+
+QString ShapeTriangleMesh::GetIcon() const
+{
+	return ":/icons/ShapeTriangleMesh.png";
+}
+
+bool ShapeTriangleMesh::Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const
+{
+	// Now check if the function is being called from IntersectP,
+	// in which case the pointers tHit and dg are 0 and any intersection is enough
+	if( ( tHit == 0 ) && ( dg == 0 ) ) return m_mesh.IntersectP( objectRay );
+	else if( ( tHit == 0 ) || ( dg == 0 ) ) gf::SevereError( "Function ShapeTriangleMesh::Intersect(...) called with null pointers" );
+
+	double thit = 0.0;
+	ShapeHit hit;
+	if( !IntersectHit( objectRay, &thit, &hit ) ) return false;
+
+	ComputeDifferentialGeometry( objectRay, thit, hit, DifferentialGeometry::ALL_FIELDS, dg );
+
+	*tHit = thit;
+	return true;
+}
+
+bool ShapeTriangleMesh::IntersectP( const Ray& objectRay ) const
+{
+	return m_mesh.IntersectP( objectRay );
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the mesh triangles. The parameters
+ * of the intersection are the barycentric coordinates of the second and third triangle vertices.
+ */
+bool ShapeTriangleMesh::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
+	double thit;
+	int triangle;
+	double b1;
+	double b2;
+	if( !m_mesh.Intersect( objectRay, &thit, &triangle, &b1, &b2 ) ) return false;
+
+	Point3D p0, p1, p2;
+	m_mesh.GetTriangle( triangle, &p0, &p1, &p2 );
+
+	hit->u = b1;
+	hit->v = b2;
+	hit->dpdu = p1 - p0;
+	hit->dpdv = p2 - p0;
+	hit->shapeFrontSide = ( DotProduct( CrossProduct( hit->dpdu, hit->dpdv ), objectRay.direction() ) > 0 ) ? false : true;
+
+	*tHit = thit;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the \a fields of the differential geometry for the intersection \a hit at \a tHit.
+ * The triangles are flat, so the normal derivatives are zero.
+ */
+void ShapeTriangleMesh::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+		int /*fields*/, DifferentialGeometry* dg ) const
+{
+	dg->point = objectRay( tHit );
+	dg->u = hit.u;
+	dg->v = hit.v;
+	dg->pShape = this;
+	dg->dpdu = hit.dpdu;
+	dg->dpdv = hit.dpdv;
+	dg->normal = Normalize( NormalVector( CrossProduct( hit.dpdu, hit.dpdv ) ) );
+	dg->dndu = Vector3D( 0.0, 0.0, 0.0 );
+	dg->dndv = Vector3D( 0.0, 0.0, 0.0 );
+	dg->shapeFrontSide = hit.shapeFrontSide;
+}
+
+Point3D ShapeTriangleMesh::Sample( double u, double v ) const
+{
+	return m_mesh.Sample( u, v );
+}
+
+/*!
+ * Reads the mesh from the new input file. If the file cannot be read, the last valid file is restored.
+ */
+void ShapeTriangleMesh::updateInputDataFile( void* data, SoSensor* )
+{
+	ShapeTriangleMesh* shape = (ShapeTriangleMesh*) data;
+
+	QString fileName( shape->inputDataFile.getValue().getString() );
+	if( fileName.isEmpty() )
+	{
+		shape->m_mesh.Clear();
+		shape->m_lastValidInputFile = fileName;
+		return;
+	}
+
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	QString errorMessage;
+	if( !ReadInputDataFile( fileName, &vertices, &indices, &errorMessage ) )
+	{
+		QMessageBox::warning( 0, QString( "Tonatiuh" ), errorMessage );
+		shape->inputDataFile.setValue( shape->m_lastValidInputFile.toStdString().c_str() );
+		return;
+	}
+
+	if( !shape->m_mesh.Create( vertices, indices ) )
+	{
+		QMessageBox::warning( 0, QString( "Tonatiuh" ), QString( "The file %1 does not define a valid triangle mesh." ).arg( fileName ) );
+		shape->m_lastValidInputFile = QString();
+		shape->inputDataFile.setValue( "" );
+		return;
+	}
+
+	shape->m_lastValidInputFile = fileName;
+}
+
+/*!
+ * Reads the vertices and triangles of the mesh in \a fileName. The file format is selected with the file extension.
+ *
+ * Returns false and sets \a errorMessage if the file cannot be read or does not define any triangle.
+ */
+bool ShapeTriangleMesh::ReadInputDataFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+		QString* errorMessage )
+{
+	QString suffix = QFileInfo( fileName ).suffix().toLower();
+	if( suffix == QLatin1String( "stl" ) ) return ReadSTLFile( fileName, vertices, indices, errorMessage );
+	if( suffix == QLatin1String( "obj" ) ) return ReadOBJFile( fileName, vertices, indices, errorMessage );
+
+	*errorMessage = QString( "The file %1 is not a STL or OBJ file." ).arg( fileName );
+	return false;
+}
+
+/*!
+ * Reads an ASCII or binary STL file. The vertices shared by several triangles are stored only once.
+ */
+bool ShapeTriangleMesh::ReadSTLFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+		QString* errorMessage )
+{
+	QFile inputFile( fileName );
+	if( !inputFile.open( QIODevice::ReadOnly ) )
+	{
+		*errorMessage = QString( "The file %1 cannot be opened." ).arg( fileName );
+		return false;
+	}
+
+	std::vector< Point3D > triangleVertices;
+
+	// A binary file has a 80 bytes header, the number of triangles and 50 bytes for each triangle
+	bool isBinary = false;
+	quint32 nTriangles = 0;
+	if( inputFile.size() >= 84 )
+	{
+		QDataStream in( &inputFile );
+		in.setByteOrder( QDataStream::LittleEndian );
+		in.skipRawData( 80 );
+		in >> nTriangles;
+		isBinary = ( inputFile.size() == 84 + 50 * qint64( nTriangles ) );
+	}
+
+	if( isBinary )
+	{
+		QDataStream in( &inputFile );
+		in.setByteOrder( QDataStream::LittleEndian );
+		in.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+		triangleVertices.reserve( 3 * nTriangles );
+		for( quint32 i = 0; i < nTriangles; ++i )
+		{
+			float normal[3];
+			in >> normal[0] >> normal[1] >> normal[2];
+			for( int j = 0; j < 3; ++j )
+			{
+				float x, y, z;
+				in >> x >> y >> z;
+				triangleVertices.push_back( Point3D( x, y, z ) );
+			}
+			quint16 attributeByteCount;
+			in >> attributeByteCount;
+		}
+		if( in.status() != QDataStream::Ok )
+		{
+			*errorMessage = QString( "The file %1 is not a valid binary STL file." ).arg( fileName );
+			return false;
+		}
+	}
+	else
+	{
+		inputFile.seek( 0 );
+		QTextStream in( &inputFile );
+		while( !in.atEnd() )
+		{
+			QStringList lineData = in.readLine().split( QRegExp( "\\s+" ), QString::SkipEmptyParts );
+			if( lineData.isEmpty() || lineData[0] != QLatin1String( "vertex" ) ) continue;
+
+			bool okX = false, okY = false, okZ = false;
+			if( lineData.size() == 4 )
+				triangleVertices.push_back( Point3D( lineData[1].toDouble( &okX ), lineData[2].toDouble( &okY ), lineData[3].toDouble( &okZ ) ) );
+			if( !okX || !okY || !okZ )
+			{
+				*errorMessage = QString( "The file %1 is not a valid ASCII STL file." ).arg( fileName );
+				return false;
+			}
+		}
+		if( triangleVertices.size() % 3 != 0 )
+		{
+			*errorMessage = QString( "The file %1 is not a valid ASCII STL file." ).arg( fileName );
+			return false;
+		}
+	}
+	inputFile.close();
+
+	if( triangleVertices.empty() )
+	{
+		*errorMessage = QString( "The file %1 does not define any triangle." ).arg( fileName );
+		return false;
+	}
+
+	vertices->clear();
+	indices->resize( triangleVertices.size() );
+
+	std::map< Point3D, int, PointLess > vertexIndex;
+	for( unsigned int i = 0; i < triangleVertices.size(); ++i )
+	{
+		std::map< Point3D, int, PointLess >::iterator it = vertexIndex.find( triangleVertices[i] );
+		if( it == vertexIndex.end() )
+		{
+			it = vertexIndex.insert( std::make_pair( triangleVertices[i], int( vertices->size() ) ) ).first;
+			vertices->push_back( triangleVertices[i] );
+		}
+		(*indices)[i] = it->second;
+	}
+
+	return true;
+}
+
+/*!
+ * Reads the vertices and faces of a Wavefront OBJ file. Faces with more than three vertices
+ * are split in triangles around their first vertex. Other elements are ignored.
+ */
+bool ShapeTriangleMesh::ReadOBJFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+		QString* errorMessage )
+{
+	QFile inputFile( fileName );
+	if( !inputFile.open( QIODevice::ReadOnly ) )
+	{
+		*errorMessage = QString( "The file %1 cannot be opened." ).arg( fileName );
+		return false;
+	}
+
+	vertices->clear();
+	indices->clear();
+
+	QTextStream in( &inputFile );
+	int lineNumber = 0;
+	while( !in.atEnd() )
+	{
+		++lineNumber;
+		QStringList lineData = in.readLine().split( QRegExp( "\\s+" ), QString::SkipEmptyParts );
+		if( lineData.isEmpty() ) continue;
+
+		if( lineData[0] == QLatin1String( "v" ) )
+		{
+			bool okX = false, okY = false, okZ = false;
+			if( lineData.size() >= 4 )
+				vertices->push_back( Point3D( lineData[1].toDouble( &okX ), lineData[2].toDouble( &okY ), lineData[3].toDouble( &okZ ) ) );
+			if( !okX || !okY || !okZ )
+			{
+				*errorMessage = QString( "Invalid vertex in line %1 of file %2." ).arg( QString::number( lineNumber ), fileName );
+				return false;
+			}
+		}
+		else if( lineData[0] == QLatin1String( "f" ) )
+		{
+			// Each face vertex is "v", "v/vt", "v//vn" or "v/vt/vn", negative indices are relative to the last vertex
+			std::vector< int > face;
+			for( int i = 1; i < lineData.size(); ++i )
+			{
+				bool ok = false;
+				int index = lineData[i].section( QLatin1Char( '/' ), 0, 0 ).toInt( &ok );
+				if( index < 0 ) index += int( vertices->size() );
+				else index -= 1;
+				if( !ok || index < 0 || index >= int( vertices->size() ) )
+				{
+					*errorMessage = QString( "Invalid face in line %1 of file %2." ).arg( QString::number( lineNumber ), fileName );
+					return false;
+				}
+				face.push_back( index );
+			}
+			if( face.size() < 3 )
+			{
+				*errorMessage = QString( "Invalid face in line %1 of file %2." ).arg( QString::number( lineNumber ), fileName );
+				return false;
+			}
+
+			for( unsigned int i = 2; i < face.size(); ++i )
+			{
+				indices->push_back( face[0] );
+				indices->push_back( face[i - 1] );
+				indices->push_back( face[i] );
+			}
+		}
+	}
+	inputFile.close();
+
+	if( indices->empty() )
+	{
+		*errorMessage = QString( "The file %1 does not define any triangle." ).arg( fileName );
+		return false;
+	}
+
+	return true;
+}
+
+void ShapeTriangleMesh::computeBBox( SoAction*, SbBox3f& box, SbVec3f& /*center*/ )
+{
+	if( m_mesh.NumberOfTriangles() < 1 )
+	{
+		box.makeEmpty();
+		return;
+	}
+
+	BBox bBox = GetBBox();
+	// These points define the min and max extents of the box.
+	SbVec3f min, max;
+
+	min.setValue( bBox.pMin.x, bBox.pMin.y, bBox.pMin.z );
+	max.setValue( bBox.pMax.x, bBox.pMax.y, bBox.pMax.z );
+
+	// Set the box to bound the two extreme points.
+	box.setBounds( min, max );
+}
+
+void ShapeTriangleMesh::generatePrimitives( SoAction* action )
+{
+	SoPrimitiveVertex pv;
+
+	// Access the state from the action.
+	SoState* state = action->getState();
+
+	// See if we have to use a texture coordinate function,
+	// rather than generating explicit texture coordinates.
+	SbBool useTexFunc = ( SoTextureCoordinateElement::getType( state ) ==
+			SoTextureCoordinateElement::FUNCTION );
+
+	// If we need to generate texture coordinates with a
+	// function, we'll need an SoGLTextureCoordinateElement.
+	// Otherwise, we'll set up the coordinates directly.
+	const SoTextureCoordinateElement* tce = 0;
+	if( useTexFunc ) tce = SoTextureCoordinateElement::getInstance( state );
+
+	const SbVec4f texCoords[3] = { SbVec4f( 0.0, 0.0, 0.0, 1.0 ), SbVec4f( 1.0, 0.0, 0.0, 1.0 ), SbVec4f( 0.0, 1.0, 0.0, 1.0 ) };
+
+	beginShape( action, TRIANGLES );
+	for( int triangle = 0; triangle < m_mesh.NumberOfTriangles(); ++triangle )
+	{
+		Point3D p[3];
+		m_mesh.GetTriangle( triangle, &p[0], &p[1], &p[2] );
+
+		SbVec3f points[3];
+		for( int j = 0; j < 3; ++j ) points[j].setValue( p[j].x, p[j].y, p[j].z );
+
+		SbVec3f normal = ( points[1] - points[0] ).cross( points[2] - points[0] );
+		normal.normalize();
+
+		for( int j = 0; j < 3; ++j )
+		{
+			SbVec4f texCoord = useTexFunc ? tce->get( points[j], normal ) : texCoords[j];
+			pv.setPoint( points[j] );
+			pv.setNormal( normal );
+			pv.setTextureCoords( texCoord );
+			shapeVertex( &pv );
+		}
+	}
+	endShape();
+}
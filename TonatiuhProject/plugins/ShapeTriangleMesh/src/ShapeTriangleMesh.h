@@ -0,0 +1,105 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef SHAPETRIANGLEMESH_H_
+#define SHAPETRIANGLEMESH_H_
+
+#include <vector>
+
+#include <QString>
+
+#include <Inventor/fields/SoSFString.h>
+
+#include "Point3D.h"
+#include "TShape.h"
+#include "TriangleMesh.h"
+
+class SoSensor;
+
+/*!
+ * Shape defined by a triangle mesh read from a STL (ASCII or binary) or Wavefront OBJ file.
+ *
+ * The whole mesh is a single shape in the scene. Its triangles are intersected through the
+ * bounding volume hierarchy of TriangleMesh, so meshes exported from CAD models do not
+ * need a scene node for each triangle.
+ */
+class ShapeTriangleMesh : public TShape
+{
+	SO_NODE_HEADER(ShapeTriangleMesh);
+
+public:
+	ShapeTriangleMesh();
+	static void initClass();
+
+	double GetArea() const;
+	double GetVolume() const { return 0.0; };
+	BBox GetBBox() const;
+	QString GetIcon() const;
+
+	bool Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const;
+	bool IntersectP( const Ray& objectRay ) const;
+	bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
+
+	Point3D Sample( double u, double v ) const;
+
+	static bool ReadInputDataFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+			QString* errorMessage );
+
+	SoSFString inputDataFile;
+
+protected:
+	static void updateInputDataFile( void* data, SoSensor* );
+
+	void computeBBox( SoAction* action, SbBox3f& box, SbVec3f& center );
+	void generatePrimitives( SoAction* action );
+	virtual ~ShapeTriangleMesh();
+
+private:
+	static bool ReadSTLFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+			QString* errorMessage );
+	static bool ReadOBJFile( QString fileName, std::vector< Point3D >* vertices, std::vector< int >* indices,
+			QString* errorMessage );
+
+	TriangleMesh m_mesh;
+	QString m_lastValidInputFile;
+};
+
+#endif /* SHAPETRIANGLEMESH_H_ */
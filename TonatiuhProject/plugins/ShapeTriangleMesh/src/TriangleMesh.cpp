@@ -0,0 +1,589 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "gc.h"
+#include "Ray.h"
+#include "TriangleMesh.h"
+#include "Vector3D.h"
+
+/*!
+ * Returns the surface area of \a bbox.
+ */
+static double SurfaceArea( const BBox& bbox )
+{
+	if( bbox.pMin.x > bbox.pMax.x ) return 0.0;
+	Vector3D d = bbox.pMax - bbox.pMin;
+	return 2.0 * ( d.x * d.y + d.x * d.z + d.y * d.z );
+}
+
+/*!
+ * Returns the bin, out of \a nBins equal bins over [ \a cMin, \a cMin + \a cExtent ], for the centroid coordinate \a c.
+ */
+static int CentroidBin( double c, double cMin, double cExtent, int nBins )
+{
+	int b = int( nBins * ( c - cMin ) / cExtent );
+	return ( b < nBins ) ? b : nBins - 1;
+}
+
+/*!
+ * Orders triangles by the \a axis coordinate of their centroids.
+ */
+struct CentroidLess
+{
+	CentroidLess( const std::vector< Point3D >& centroids, int axis )
+	:m_centroids( centroids ), m_axis( axis )
+	{
+	}
+
+	bool operator()( int a, int b ) const
+	{
+		return m_centroids[a][m_axis] < m_centroids[b][m_axis];
+	}
+
+	const std::vector< Point3D >& m_centroids;
+	int m_axis;
+};
+
+/*!
+ * Selects the triangles whose centroid falls in the bins up to \a split.
+ */
+struct BinPredicate
+{
+	BinPredicate( const std::vector< Point3D >& centroids, int axis, double cMin, double cExtent, int nBins, int split )
+	:m_centroids( centroids ), m_axis( axis ), m_cMin( cMin ), m_cExtent( cExtent ), m_nBins( nBins ), m_split( split )
+	{
+	}
+
+	bool operator()( int triangle ) const
+	{
+		return CentroidBin( m_centroids[triangle][m_axis], m_cMin, m_cExtent, m_nBins ) <= m_split;
+	}
+
+	const std::vector< Point3D >& m_centroids;
+	int m_axis;
+	double m_cMin;
+	double m_cExtent;
+	int m_nBins;
+	int m_split;
+};
+
+/*!
+ * Creates an empty mesh.
+ */
+TriangleMesh::TriangleMesh()
+:m_area( 0.0 )
+{
+
+}
+
+TriangleMesh::~TriangleMesh()
+{
+
+}
+
+/*!
+ * Removes all the triangles of the mesh.
+ */
+void TriangleMesh::Clear()
+{
+	m_vertices.clear();
+	m_indices.clear();
+	m_nodes.clear();
+	m_p0x.clear(); m_p0y.clear(); m_p0z.clear();
+	m_p1x.clear(); m_p1y.clear(); m_p1z.clear();
+	m_p2x.clear(); m_p2y.clear(); m_p2z.clear();
+	m_triangleIndex.clear();
+	m_areaCDF.clear();
+	m_area = 0.0;
+}
+
+/*!
+ * Defines the mesh with the \a vertices and the triangles in \a indices, three vertex
+ * indices for each triangle, and builds its bounding volume hierarchy.
+ *
+ * Returns false and leaves the mesh empty if \a indices does not define any triangle or
+ * refers to vertices that do not exist.
+ */
+bool TriangleMesh::Create( const std::vector< Point3D >& vertices, const std::vector< int >& indices )
+{
+	Clear();
+
+	if( indices.empty() || ( indices.size() % 3 ) != 0 ) return false;
+	const int nVertices = int( vertices.size() );
+	for( unsigned int i = 0; i < indices.size(); ++i )
+		if( indices[i] < 0 || indices[i] >= nVertices ) return false;
+
+	m_vertices = vertices;
+	m_indices = indices;
+
+	const int nTriangles = NumberOfTriangles();
+	std::vector< BBox > triangleBounds( nTriangles );
+	std::vector< Point3D > centroids( nTriangles );
+	std::vector< int > order( nTriangles );
+	m_areaCDF.resize( nTriangles );
+	for( int i = 0; i < nTriangles; ++i )
+	{
+		Point3D p0, p1, p2;
+		GetTriangle( i, &p0, &p1, &p2 );
+		triangleBounds[i] = Union( BBox( p0, p1 ), p2 );
+		centroids[i] = Point3D( ( p0.x + p1.x + p2.x ) / 3.0,
+				( p0.y + p1.y + p2.y ) / 3.0,
+				( p0.z + p1.z + p2.z ) / 3.0 );
+		order[i] = i;
+
+		m_area += 0.5 * CrossProduct( p1 - p0, p2 - p0 ).length();
+		m_areaCDF[i] = m_area;
+	}
+
+	m_nodes.reserve( 2 * nTriangles / m_maxTrianglesInLeaf + 1 );
+	BuildNode( 0, nTriangles, &order, triangleBounds, centroids, 0 );
+
+	m_p0x.resize( nTriangles ); m_p0y.resize( nTriangles ); m_p0z.resize( nTriangles );
+	m_p1x.resize( nTriangles ); m_p1y.resize( nTriangles ); m_p1z.resize( nTriangles );
+	m_p2x.resize( nTriangles ); m_p2y.resize( nTriangles ); m_p2z.resize( nTriangles );
+	m_triangleIndex = order;
+	for( int i = 0; i < nTriangles; ++i )
+	{
+		Point3D p0, p1, p2;
+		GetTriangle( order[i], &p0, &p1, &p2 );
+		m_p0x[i] = p0.x; m_p0y[i] = p0.y; m_p0z[i] = p0.z;
+		m_p1x[i] = p1.x; m_p1y[i] = p1.y; m_p1z[i] = p1.z;
+		m_p2x[i] = p2.x; m_p2y[i] = p2.y; m_p2z[i] = p2.z;
+	}
+
+	return true;
+}
+
+int TriangleMesh::NumberOfTriangles() const
+{
+	return int( m_indices.size() / 3 );
+}
+
+int TriangleMesh::NumberOfVertices() const
+{
+	return int( m_vertices.size() );
+}
+
+const std::vector< Point3D >& TriangleMesh::Vertices() const
+{
+	return m_vertices;
+}
+
+const std::vector< int >& TriangleMesh::Indices() const
+{
+	return m_indices;
+}
+
+double TriangleMesh::GetArea() const
+{
+	return m_area;
+}
+
+/*!
+ * Returns the bounding box of all the triangles. The box is empty if the mesh has no triangles.
+ */
+BBox TriangleMesh::GetBBox() const
+{
+	if( m_nodes.empty() ) return BBox();
+	const BVHNode& root = m_nodes[0];
+	return BBox( Point3D( root.bMin[0], root.bMin[1], root.bMin[2] ),
+			Point3D( root.bMax[0], root.bMax[1], root.bMax[2] ) );
+}
+
+/*!
+ * Returns in \a p0, \a p1 and \a p2 the vertices of the triangle with index \a triangle.
+ */
+void TriangleMesh::GetTriangle( int triangle, Point3D* p0, Point3D* p1, Point3D* p2 ) const
+{
+	*p0 = m_vertices[ m_indices[3 * triangle] ];
+	*p1 = m_vertices[ m_indices[3 * triangle + 1] ];
+	*p2 = m_vertices[ m_indices[3 * triangle + 2] ];
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the mesh.
+ *
+ * Returns the ray parameter in \a tHit, the index of the intersected triangle in \a triangle
+ * and the barycentric coordinates of the intersection point for the second and third
+ * triangle vertices in \a b1 and \a b2.
+ */
+bool TriangleMesh::Intersect( const Ray& objectRay, double* tHit, int* triangle, double* b1, double* b2 ) const
+{
+	int hitTriangle = Traverse( objectRay, false, tHit, b1, b2 );
+	if( hitTriangle < 0 ) return false;
+
+	*triangle = m_triangleIndex[hitTriangle];
+	return true;
+}
+
+/*!
+ * Returns true if \a objectRay intersects any triangle of the mesh.
+ *
+ * The traversal stops at the first intersected triangle.
+ */
+bool TriangleMesh::IntersectP( const Ray& objectRay ) const
+{
+	double tHit, b1, b2;
+	return ( Traverse( objectRay, true, &tHit, &b1, &b2 ) >= 0 );
+}
+
+/*!
+ * Traverses the hierarchy to find the closest intersection of \a objectRay with the triangles.
+ * If \a anyHit is true, the traversal stops at the first intersected triangle, that can be not the closest one.
+ *
+ * Returns the position of the intersected triangle in the hierarchy order or -1 if the ray does not
+ * intersect the mesh. The ray parameter and the barycentric coordinates of the intersection are
+ * returned in \a tHit, \a b1 and \a b2.
+ */
+int TriangleMesh::Traverse( const Ray& objectRay, bool anyHit, double* tHit, double* b1, double* b2 ) const
+{
+	if( m_nodes.empty() ) return -1;
+
+	// Permutation and shear that transform the ray direction into the +z axis
+	const Vector3D& d = objectRay.direction();
+	int k[3];
+	k[2] = 0;
+	if( fabs( d.y ) > fabs( d[k[2]] ) ) k[2] = 1;
+	if( fabs( d.z ) > fabs( d[k[2]] ) ) k[2] = 2;
+	k[0] = ( k[2] + 1 ) % 3;
+	k[1] = ( k[0] + 1 ) % 3;
+	if( d[k[2]] < 0.0 ) std::swap( k[0], k[1] );
+	double shear[3];
+	shear[0] = d[k[0]] / d[k[2]];
+	shear[1] = d[k[1]] / d[k[2]];
+	shear[2] = 1.0 / d[k[2]];
+
+	const Vector3D& invDirection = objectRay.invDirection();
+	const bool dirIsNeg[3] = { invDirection.x < 0.0, invDirection.y < 0.0, invDirection.z < 0.0 };
+
+	double tMax = objectRay.maxt;
+	int hitTriangle = -1;
+	double hitB1 = 0.0;
+	double hitB2 = 0.0;
+
+	int stack[m_maxTraversalDepth];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	while( true )
+	{
+		const BVHNode& node = m_nodes[nodeIndex];
+		if( IntersectNodeBox( node, objectRay, tMax ) )
+		{
+			if( node.nTriangles > 0 )
+			{
+				double t, u, v;
+				int leafTriangle = IntersectLeaf( node, objectRay, k, shear, tMax, &t, &u, &v );
+				if( leafTriangle >= 0 )
+				{
+					tMax = t;
+					hitTriangle = leafTriangle;
+					hitB1 = u;
+					hitB2 = v;
+					if( anyHit ) break;
+				}
+				if( stackSize == 0 ) break;
+				nodeIndex = stack[--stackSize];
+			}
+			else
+			{
+				// Visit first the child closest to the ray origin
+				if( dirIsNeg[node.axis] )
+				{
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					nodeIndex = nodeIndex + 1;
+				}
+			}
+		}
+		else
+		{
+			if( stackSize == 0 ) break;
+			nodeIndex = stack[--stackSize];
+		}
+	}
+
+	if( hitTriangle < 0 ) return -1;
+
+	*tHit = tMax;
+	*b1 = hitB1;
+	*b2 = hitB2;
+	return hitTriangle;
+}
+
+/*!
+ * Returns a point uniformly distributed over the mesh surface for the random numbers \a u and \a v.
+ */
+Point3D TriangleMesh::Sample( double u, double v ) const
+{
+	if( m_areaCDF.empty() ) return Point3D();
+
+	const double areaValue = u * m_area;
+	int triangle = int( std::lower_bound( m_areaCDF.begin(), m_areaCDF.end(), areaValue ) - m_areaCDF.begin() );
+	if( triangle >= NumberOfTriangles() ) triangle = NumberOfTriangles() - 1;
+
+	const double areaBefore = ( triangle > 0 ) ? m_areaCDF[triangle - 1] : 0.0;
+	const double triangleArea = m_areaCDF[triangle] - areaBefore;
+	const double w = ( triangleArea > 0.0 ) ? std::min( 1.0, ( areaValue - areaBefore ) / triangleArea ) : 0.0;
+
+	Point3D p0, p1, p2;
+	GetTriangle( triangle, &p0, &p1, &p2 );
+	const double su = sqrt( w );
+	return p0 + ( p1 - p0 ) * ( su * ( 1.0 - v ) ) + ( p2 - p0 ) * ( su * v );
+}
+
+/*!
+ * Builds the hierarchy node for the triangles \a order[ \a first ... \a last - 1 ] and its children.
+ * Returns the index of the node in m_nodes.
+ *
+ * The triangles are split with the surface area heuristic evaluated on bins along the
+ * widest axis of their centroids. Below \a depth 32 the split falls back to the median so
+ * that the hierarchy always fits in the traversal stack.
+ */
+int TriangleMesh::BuildNode( int first, int last, std::vector< int >* order,
+		const std::vector< BBox >& triangleBounds, const std::vector< Point3D >& centroids, int depth )
+{
+	const int nodeIndex = int( m_nodes.size() );
+	m_nodes.push_back( BVHNode() );
+
+	BBox bounds;
+	BBox centroidBounds;
+	for( int i = first; i < last; ++i )
+	{
+		bounds = Union( bounds, triangleBounds[ (*order)[i] ] );
+		centroidBounds = Union( centroidBounds, centroids[ (*order)[i] ] );
+	}
+	for( int j = 0; j < 3; ++j )
+	{
+		m_nodes[nodeIndex].bMin[j] = bounds.pMin[j];
+		m_nodes[nodeIndex].bMax[j] = bounds.pMax[j];
+	}
+
+	const int nTriangles = last - first;
+	if( nTriangles <= m_maxTrianglesInLeaf )
+	{
+		m_nodes[nodeIndex].offset = first;
+		m_nodes[nodeIndex].nTriangles = nTriangles;
+		m_nodes[nodeIndex].axis = 0;
+		return nodeIndex;
+	}
+
+	const int axis = centroidBounds.MaximumExtent();
+	const double cMin = centroidBounds.pMin[axis];
+	const double cExtent = centroidBounds.pMax[axis] - cMin;
+
+	int middle = first;
+	if( cExtent > 0.0 && depth < 32 )
+	{
+		int binCount[m_numberOfBins];
+		BBox binBounds[m_numberOfBins];
+		for( int b = 0; b < m_numberOfBins; ++b ) binCount[b] = 0;
+		for( int i = first; i < last; ++i )
+		{
+			int b = CentroidBin( centroids[ (*order)[i] ][axis], cMin, cExtent, m_numberOfBins );
+			binCount[b]++;
+			binBounds[b] = Union( binBounds[b], triangleBounds[ (*order)[i] ] );
+		}
+
+		// Cost of splitting after each bin, sweeping from the right
+		double rightCost[m_numberOfBins];
+		BBox rightBounds;
+		int rightCount = 0;
+		for( int b = m_numberOfBins - 1; b > 0; --b )
+		{
+			rightBounds = Union( rightBounds, binBounds[b] );
+			rightCount += binCount[b];
+			rightCost[b - 1] = rightCount * SurfaceArea( rightBounds );
+		}
+
+		int bestSplit = -1;
+		double bestCost = gc::Infinity;
+		BBox leftBounds;
+		int leftCount = 0;
+		for( int b = 0; b < m_numberOfBins - 1; ++b )
+		{
+			leftBounds = Union( leftBounds, binBounds[b] );
+			leftCount += binCount[b];
+			if( leftCount == 0 || leftCount == nTriangles ) continue;
+			double cost = leftCount * SurfaceArea( leftBounds ) + rightCost[b];
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+
+		if( bestSplit >= 0 )
+		{
+			std::vector< int >::iterator split = std::partition( order->begin() + first, order->begin() + last,
+					BinPredicate( centroids, axis, cMin, cExtent, m_numberOfBins, bestSplit ) );
+			middle = int( split - order->begin() );
+		}
+	}
+
+	if( middle <= first || middle >= last )
+	{
+		middle = ( first + last ) / 2;
+		std::nth_element( order->begin() + first, order->begin() + middle, order->begin() + last,
+				CentroidLess( centroids, axis ) );
+	}
+
+	BuildNode( first, middle, order, triangleBounds, centroids, depth + 1 );
+	const int secondChild = BuildNode( middle, last, order, triangleBounds, centroids, depth + 1 );
+
+	m_nodes[nodeIndex].offset = secondChild;
+	m_nodes[nodeIndex].nTriangles = 0;
+	m_nodes[nodeIndex].axis = axis;
+	return nodeIndex;
+}
+
+/*!
+ * Intersects \a objectRay with the triangles of the leaf \a node, using the ray axes
+ * permutation \a k and \a shear. Only the intersections before \a tMax are considered.
+ *
+ * Returns the position in BVH order of the closest intersected triangle, or -1 if there is
+ * none, and its parameter and barycentric coordinates in \a tHit, \a b1 and \a b2.
+ */
+int TriangleMesh::IntersectLeaf( const BVHNode& node, const Ray& objectRay, const int* k, const double* shear,
+		double tMax, double* tHit, double* b1, double* b2 ) const
+{
+	const double* p0[3] = { &m_p0x[0], &m_p0y[0], &m_p0z[0] };
+	const double* p1[3] = { &m_p1x[0], &m_p1y[0], &m_p1z[0] };
+	const double* p2[3] = { &m_p2x[0], &m_p2y[0], &m_p2z[0] };
+
+	const double* p0x = p0[k[0]] + node.offset;
+	const double* p0y = p0[k[1]] + node.offset;
+	const double* p0z = p0[k[2]] + node.offset;
+	const double* p1x = p1[k[0]] + node.offset;
+	const double* p1y = p1[k[1]] + node.offset;
+	const double* p1z = p1[k[2]] + node.offset;
+	const double* p2x = p2[k[0]] + node.offset;
+	const double* p2y = p2[k[1]] + node.offset;
+	const double* p2z = p2[k[2]] + node.offset;
+
+	const double ox = objectRay.origin[k[0]];
+	const double oy = objectRay.origin[k[1]];
+	const double oz = objectRay.origin[k[2]];
+	const double sx = shear[0];
+	const double sy = shear[1];
+	const double sz = shear[2];
+	const double mint = objectRay.mint;
+
+	//Evaluate Tolerance
+	const double tol = 0.00001;
+
+	double tValues[m_maxTrianglesInLeaf];
+	double b1Values[m_maxTrianglesInLeaf];
+	double b2Values[m_maxTrianglesInLeaf];
+	bool isHit[m_maxTrianglesInLeaf];
+
+	const int nTriangles = node.nTriangles;
+	for( int i = 0; i < nTriangles; ++i )
+	{
+		// Vertices relative to the ray origin in the sheared ray space
+		const double az = p0z[i] - oz;
+		const double bz = p1z[i] - oz;
+		const double cz = p2z[i] - oz;
+		const double ax = p0x[i] - ox - sx * az;
+		const double ay = p0y[i] - oy - sy * az;
+		const double bx = p1x[i] - ox - sx * bz;
+		const double by = p1y[i] - oy - sy * bz;
+		const double cx = p2x[i] - ox - sx * cz;
+		const double cy = p2y[i] - oy - sy * cz;
+
+		// Scaled barycentric coordinates
+		const double u = cx * by - cy * bx;
+		const double v = ax * cy - ay * cx;
+		const double w = bx * ay - by * ax;
+		const double det = u + v + w;
+		const double t = sz * ( u * az + v * bz + w * cz ) / det;
+
+		const bool inside = !( ( u < 0.0 || v < 0.0 || w < 0.0 ) && ( u > 0.0 || v > 0.0 || w > 0.0 ) );
+		isHit[i] = inside && ( det != 0.0 ) && !( t > tMax ) && !( ( t - mint ) < tol );
+		tValues[i] = t;
+		b1Values[i] = v / det;
+		b2Values[i] = w / det;
+	}
+
+	int closest = -1;
+	double tClosest = tMax;
+	for( int i = 0; i < nTriangles; ++i )
+	{
+		if( isHit[i] && !( tValues[i] > tClosest ) )
+		{
+			closest = i;
+			tClosest = tValues[i];
+		}
+	}
+	if( closest < 0 ) return -1;
+
+	*tHit = tValues[closest];
+	*b1 = b1Values[closest];
+	*b2 = b2Values[closest];
+	return node.offset + closest;
+}
+
+/*!
+ * Returns true if \a objectRay intersects the bounds of \a node between its minimum parameter and \a tMax.
+ */
+bool TriangleMesh::IntersectNodeBox( const BVHNode& node, const Ray& objectRay, double tMax ) const
+{
+	const Vector3D& invDirection = objectRay.invDirection();
+	double t0 = objectRay.mint;
+	double t1 = tMax;
+	for( int i = 0; i < 3; ++i )
+	{
+		double tNear = ( node.bMin[i] - objectRay.origin[i] ) * invDirection[i];
+		double tFar = ( node.bMax[i] - objectRay.origin[i] ) * invDirection[i];
+		if( tNear > tFar ) std::swap( tNear, tFar );
+
+		// Keep the rays that hit the box boundary despite rounding errors
+		tFar *= 1.0 + 1e-12;
+		t0 = tNear > t0 ? tNear : t0;
+		t1 = tFar < t1 ? tFar : t1;
+		if( t0 > t1 ) return false;
+	}
+	return true;
+}
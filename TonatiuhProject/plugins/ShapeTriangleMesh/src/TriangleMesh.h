@@ -0,0 +1,116 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef TRIANGLEMESH_H_
+#define TRIANGLEMESH_H_
+
+#include <vector>
+
+#include "BBox.h"
+#include "Point3D.h"
+
+class Ray;
+
+/*!
+ * Indexed triangle mesh with a bounding volume hierarchy for ray intersection.
+ *
+ * The vertices are stored once and each triangle is defined by three vertex indices.
+ * Create builds a binned surface area heuristic BVH over the triangles and copies the
+ * triangle vertices in BVH order as separate coordinate arrays, so that the triangles of
+ * a leaf are tested in a loop the compiler can vectorize. The ray/triangle test is the
+ * watertight algorithm of Woop, Benthin and Wald: rays through shared edges or vertices
+ * never pass between adjacent triangles.
+ */
+class TriangleMesh
+{
+public:
+	TriangleMesh();
+	~TriangleMesh();
+
+	void Clear();
+	bool Create( const std::vector< Point3D >& vertices, const std::vector< int >& indices );
+
+	int NumberOfTriangles() const;
+	int NumberOfVertices() const;
+	const std::vector< Point3D >& Vertices() const;
+	const std::vector< int >& Indices() const;
+
+	double GetArea() const;
+	BBox GetBBox() const;
+	void GetTriangle( int triangle, Point3D* p0, Point3D* p1, Point3D* p2 ) const;
+
+	bool Intersect( const Ray& objectRay, double* tHit, int* triangle, double* b1, double* b2 ) const;
+	bool IntersectP( const Ray& objectRay ) const;
+
+	Point3D Sample( double u, double v ) const;
+
+private:
+	struct BVHNode
+	{
+		double bMin[3];
+		double bMax[3];
+		int offset;		// First triangle for leaves, second child for interior nodes
+		int nTriangles;	// Zero for interior nodes
+		int axis;
+	};
+
+	enum { m_maxTrianglesInLeaf = 4, m_numberOfBins = 16, m_maxTraversalDepth = 64 };
+
+	int BuildNode( int first, int last, std::vector< int >* order,
+			const std::vector< BBox >& triangleBounds, const std::vector< Point3D >& centroids, int depth );
+	int IntersectLeaf( const BVHNode& node, const Ray& objectRay, const int* k, const double* shear,
+			double tMax, double* tHit, double* b1, double* b2 ) const;
+	bool IntersectNodeBox( const BVHNode& node, const Ray& objectRay, double tMax ) const;
+	int Traverse( const Ray& objectRay, bool anyHit, double* tHit, double* b1, double* b2 ) const;
+
+	std::vector< Point3D > m_vertices;
+	std::vector< int > m_indices;
+	std::vector< BVHNode > m_nodes;
+
+	// Triangle vertices in BVH order
+	std::vector< double > m_p0x, m_p0y, m_p0z;
+	std::vector< double > m_p1x, m_p1y, m_p1z;
+	std::vector< double > m_p2x, m_p2y, m_p2z;
+	std::vector< int > m_triangleIndex;
+
+	std::vector< double > m_areaCDF;
+	double m_area;
+};
+
+#endif /* TRIANGLEMESH_H_ */
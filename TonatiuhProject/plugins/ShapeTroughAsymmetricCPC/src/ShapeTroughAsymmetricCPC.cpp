@@ -63,6 +63,11 @@ double fPart( double alpha, double x, double r1, double theta, double r, double
 	return -r1 + sin( alpha - theta ) * ( r/ ( 1 - eccentricity * cos( alpha ) ) ) - x ;
 }
 
+/*!
+ * Number of uniform theta intervals used to tabulate each branch of the concentrator profile.
+ */
+const int profileSegments = 128;
+
 SO_NODE_SOURCE(ShapeTroughAsymmetricCPC);
 
 void ShapeTroughAsymmetricCPC::initClass()
@@ -446,7 +451,8 @@ Vector3D ShapeTroughAsymmetricCPC::GetD2PDUU( double u , double /* v */ ) const
 }
 
 /*!
- * Computes and sets \a m_phi, \a m_s, \a m_theta and \a m_eccentricity.
+ * Computes the profile limits for the current parameters, taking into account the truncation line,
+ * and tabulates the profile between them.
  */
 void ShapeTroughAsymmetricCPC::SetInternalValues()
 {
@@ -458,6 +464,7 @@ void ShapeTroughAsymmetricCPC::SetInternalValues()
 	m_thetaMin = -( 3*gc::Pi/2 - acceptanceAngleCCW.getValue() - m_tangentAngle );
 
 	// Truncation
+	BuildProfileTable();
 	double thetaMaxTruncated = m_thetaMax;
 	double thetaMinTruncated = m_thetaMin;
 
@@ -465,13 +472,18 @@ void ShapeTroughAsymmetricCPC::SetInternalValues()
 	Vector3D truncationDir = Vector3D( cos( truncationAngle.getValue() ) , sin( truncationAngle.getValue() ) , 0.0 );
 	Ray truncationLine = Ray( truncationOr , truncationDir );
 	std::vector<double> intersections = FindRoots( truncationLine );
-	if( intersections.size() > 0 )
+	for( unsigned int i = 0; i < intersections.size(); ++i )
 	{
-		if( intersections[ 0 ] > 0.0 ) thetaMaxTruncated = intersections[ 0 ];
-		if( intersections[ intersections.size() - 1 ] < 0.0 ) thetaMinTruncated = intersections[ intersections.size() - 1 ];
+		if( intersections[ i ] < 0.0 ) thetaMinTruncated = intersections[ i ];
+		else if( intersections[ i ] > 0.0 )
+		{
+			thetaMaxTruncated = intersections[ i ];
+			break;
+		}
 	}
 	m_thetaMax = std::min( m_thetaMax , thetaMaxTruncated );
 	m_thetaMin = std::max( m_thetaMin , thetaMinTruncated );
+	BuildProfileTable();
 
 }
 
@@ -539,126 +551,109 @@ double ShapeTroughAsymmetricCPC::ConcentratorProfileY( double theta ) const
 	return y;
 }
 
-std::vector<double> ShapeTroughAsymmetricCPC::FindRigthRoots( const Ray ray, double thetaStart , double thetaEnd , double acceptanceAngle ) const
+/*!
+ * Tabulates the concentrator profile at uniform theta values on each branch, from \a m_thetaMin
+ * to zero and from zero to \a m_thetaMax.
+ */
+void ShapeTroughAsymmetricCPC::BuildProfileTable()
 {
-	std::vector<double> roots;
-	//Set general algorithm parameters
-	double maxIterations = 500;
-	double tolerance = 0.00000001;
-
-	//Initialize starting and ending point
-	double theta0 = thetaStart;
-	double theta1 = thetaEnd;
-
-	//Set step for going through the space in case YDistance(start) * YDistance(end) > 0 (both positives or negatives)
-	double delta = fabs( theta1 - theta0 ) / 100;
-	// Define an auxiliar value with -Infinity. This variable will hold the closest theta value next to the not computed root in case there are two roots
-	double thetaAux = - gc::Infinity;
-
-	//Compute extreme points
-	double tDeviation0 = TDeviation( ray, theta0 , acceptanceAngle );
-	double tDeviation1 = TDeviation( ray, theta1 , acceptanceAngle );
-
-	//If YDistance(start) * YDistance(end) > 0 add the defined step to the starting point
-	// until YDistance(start) * YDistance(end) < 0 condition is satisfied.
-	while( ( ( tDeviation0 * tDeviation1 ) > 0.0 ) && ( theta0 < theta1 ) )
+	m_profileTheta.clear();
+	for( int i = 0; i < profileSegments; ++i )
+		m_profileTheta.push_back( m_thetaMin * ( profileSegments - i ) / profileSegments );
+	for( int i = 0; i <= profileSegments; ++i )
+		m_profileTheta.push_back( m_thetaMax * i / profileSegments );
+
+	m_profileX.resize( m_profileTheta.size() );
+	m_profileY.resize( m_profileTheta.size() );
+	for( unsigned int i = 0; i < m_profileTheta.size(); ++i )
 	{
-		//Set theta aux if while is entered.
-		thetaAux = theta0;
-		theta0 += delta;
-		tDeviation0 = TDeviation( ray, theta0 , acceptanceAngle );
+		m_profileX[i] = ConcentratorProfileX( m_profileTheta[i] );
+		m_profileY[i] = ConcentratorProfileY( m_profileTheta[i] );
 	}
-	// If YDistance(start) * YDistance(end) < 0 condition is NOT satisfied, there are no roots --> return.
-	if( ( ( tDeviation0 * tDeviation1 ) > 0.0 ) || ( theta0 > theta1 ) ) return roots;
-
-	// Once YDistance(start) * YDistance(end) < 0 iterate by the bisection method
-	int iterations = 0;
-	while( ( fabs( theta1 - theta0 ) > tolerance ) && ( iterations < maxIterations ) )
-	{
-		double thetaMiddle = ( theta0 + theta1 ) / 2.0 ;
-		double tDeviationMiddle = TDeviation( ray, thetaMiddle , acceptanceAngle );
+}
 
-		if( ( tDeviationMiddle > 0.0 ) && ( tDeviation1 > tDeviation0 ) ) theta1 = thetaMiddle;
-		else if( ( tDeviationMiddle > 0.0 ) && ( tDeviation1 < tDeviation0 ) ) theta0 = thetaMiddle;
-		else if( ( tDeviationMiddle < 0.0 ) && ( tDeviation1 > tDeviation0 ) ) theta0 = thetaMiddle;
-		else theta1 = thetaMiddle;
+/*!
+ * Computes the profile point for \a theta and its derivatives respect theta.
+ */
+void ShapeTroughAsymmetricCPC::ProfilePoint( double theta, double* x, double* y, double* dxdtheta, double* dydtheta ) const
+{
+	*x = ConcentratorProfileX( theta );
+	*y = ConcentratorProfileY( theta );
 
-		iterations++;
+	if( theta >= 0.0 )
+	{
+		Vector3D dpdtheta = GetDPDURight( acceptanceAngleCCW.getValue() , theta );
+		*dxdtheta = dpdtheta.x;
+		*dydtheta = dpdtheta.y;
 	}
-
-	//If max iterations has been reached --> return, else insert the root (mean) into the roots vector.
-	if( iterations >= maxIterations ) return roots;
-	roots.push_back( ( theta0 + theta1 ) / 2.0 );
-
-	// If thetaAux has been used (no more -Infinity value), this should be close to the non-computed root. Update theta0 and theta1 and repeat iteration.
-	if( thetaAux < thetaStart ) return roots;
-
-	theta0 = std::max( thetaStart , thetaAux - delta );
-	theta1 = std::min( thetaAux + delta , thetaEnd );
-
-	tDeviation0 = TDeviation( ray, theta0 , acceptanceAngle );
-	tDeviation1 = TDeviation( ray, theta1 , acceptanceAngle );
-
-	if( ( tDeviation0 * tDeviation1 ) > 0.0 ) return roots;
-
-	iterations = 0;
-	while( ( fabs( theta1 - theta0 ) > tolerance ) && ( iterations < maxIterations ) )
+	else
 	{
-		double thetaMiddle = ( theta0 + theta1 ) / 2.0 ;
-		double tDeviationMiddle = TDeviation( ray, thetaMiddle , acceptanceAngle );
-
-		if( ( tDeviationMiddle > 0.0 ) && ( tDeviation1 > tDeviation0 ) ) theta1 = thetaMiddle;
-		else if( ( tDeviationMiddle > 0.0 ) && ( tDeviation1 < tDeviation0 ) ) theta0 = thetaMiddle;
-		else if( ( tDeviationMiddle < 0.0 ) && ( tDeviation1 > tDeviation0 ) ) theta0 = thetaMiddle;
-		else theta1 = thetaMiddle;
-
-		iterations++;
+		Vector3D dpdtheta = GetDPDURight( acceptanceAngleCW.getValue() , - theta );
+		*dxdtheta = dpdtheta.x;
+		*dydtheta = - dpdtheta.y;
 	}
-
-
-	if( iterations >= maxIterations ) return roots;
-	roots.push_back( ( theta0 + theta1 ) / 2.0 );
-
-	return roots;
 }
 
+/*!
+ * Returns, in increasing order, the theta values where the profile crosses the projection of \a ray
+ * on the xy plane.
+ *
+ * The table built in BuildProfileTable gives the segments where the crossings are, and each
+ * one is refined with Newton steps kept inside its segment.
+ */
 std::vector<double> ShapeTroughAsymmetricCPC::FindRoots( const Ray ray ) const
 {
-	// Right branch roots
-	std::vector<double> roots = FindRigthRoots( ray, 0 , m_thetaMax , acceptanceAngleCCW.getValue() );
-
-	// Left branch hits calculated with the symmetric ray.
-	Point3D symmetricRayOrigin = Point3D( - ray.origin.x , ray.origin.y , ray.origin.z );
-	Vector3D symmetricRayDirection = Vector3D( - ray.direction().x , ray.direction().y , ray.direction().z );
-	Ray symmetricRay = Ray( symmetricRayOrigin , symmetricRayDirection );
-
-	std::vector<double> rootsLeft = FindRigthRoots( symmetricRay, 0 , - m_thetaMin , acceptanceAngleCW.getValue() );
-
-	// Change sign to roots thetaRoot --> -thetaRoot and append to roots
-	for ( unsigned int i = 0; i < rootsLeft.size(); i++)
-		roots.push_back( -1.0 * rootsLeft[i] );
-
-	return roots;
-}
-
+	std::vector<double> roots;
 
-double ShapeTroughAsymmetricCPC::TDeviation( const Ray ray, double theta, double acceptanceAngle ) const
-{
 	double dx = ray.direction().x;
-	double ox = ray.origin.x;
 	double dy = ray.direction().y;
+	double ox = ray.origin.x;
 	double oy = ray.origin.y;
 
-	double involuteLimit = gc::Pi/2 + acceptanceAngle - m_tangentAngle;
-	if( theta < involuteLimit )
-		return -dy * ox + dx * oy + rInt.getValue() * ( dx - dy * ( theta + m_tangentAngle - m_thetaZero ) ) * cos( theta + m_tangentAngle ) + rInt.getValue() * ( dy + dx * ( theta + m_tangentAngle - m_thetaZero ) ) * sin( theta + m_tangentAngle );
-	else
-		return ( ( -2 * dy * rInt.getValue() * cos( acceptanceAngle ) )
-			+ rInt.getValue() * ( -2 * dx + dy * ( 2 * acceptanceAngle + gc::Pi + 2 * ( theta + m_tangentAngle - 2 * m_thetaZero ) ) ) * cos( theta + m_tangentAngle )
-			+ 2 * ( dx * rInt.getValue() * sin( acceptanceAngle ) - ( dy * ox - dx * oy ) * ( -1 + sin( acceptanceAngle - theta - m_tangentAngle ) ) )
-			- rInt.getValue() * ( 2*dy + dx * ( 2 * acceptanceAngle + gc::Pi + 2 * ( theta + m_tangentAngle - 2 * m_thetaZero ) ) ) * sin( theta + m_tangentAngle ) ) /
-			( 2*( -1 + sin( acceptanceAngle - theta - m_tangentAngle ) ) );
+	double g0 = ( m_profileX[0] - ox ) * dy - ( m_profileY[0] - oy ) * dx;
+	for( unsigned int i = 0; i + 1 < m_profileTheta.size(); ++i )
+	{
+		double g1 = ( m_profileX[i + 1] - ox ) * dy - ( m_profileY[i + 1] - oy ) * dx;
+		if( ( g0 < 0.0 ) != ( g1 < 0.0 ) )
+		{
+			double theta0 = m_profileTheta[i];
+			double theta1 = m_profileTheta[i + 1];
+			double ga = g0;
+
+			double theta = theta0 - g0 * ( theta1 - theta0 ) / ( g1 - g0 );
+			int iterations = 0;
+			while( iterations < 100 )
+			{
+				double x;
+				double y;
+				double dxdtheta;
+				double dydtheta;
+				ProfilePoint( theta, &x, &y, &dxdtheta, &dydtheta );
+				double g = ( x - ox ) * dy - ( y - oy ) * dx;
+				if( g == 0.0 ) break;
+
+				if( ( g < 0.0 ) == ( ga < 0.0 ) )
+				{
+					theta0 = theta;
+					ga = g;
+				}
+				else theta1 = theta;
+
+				double dgdtheta = dxdtheta * dy - dydtheta * dx;
+				double next = ( dgdtheta != 0.0 ) ? theta - g / dgdtheta : theta0;
+				if( ( next <= theta0 ) || ( next >= theta1 ) ) next = 0.5 * ( theta0 + theta1 );
+
+				bool converged = ( fabs( next - theta ) < 0.00000001 );
+				theta = next;
+				if( converged ) break;
+				iterations++;
+			}
+			roots.push_back( theta );
+		}
+		g0 = g1;
+	}
 
+	return roots;
 }
 
 std::vector<double> ShapeTroughAsymmetricCPC::FindThits( const Ray ray, const std::vector<double> roots ) const
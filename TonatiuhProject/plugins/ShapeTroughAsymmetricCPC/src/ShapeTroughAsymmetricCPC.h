@@ -99,8 +99,8 @@ private:
 	double ConcentratorProfileX( double theta ) const;
 	double ConcentratorProfileY( double theta ) const;
 
-	double TDeviation( const Ray ray, double theta, double acceptanceAngle ) const;
-	std::vector<double> FindRigthRoots( const Ray ray, double thetaStart , double thetaEnd , double acceptanceAngle ) const;
+	void BuildProfileTable();
+	void ProfilePoint( double theta, double* x, double* y, double* dxdtheta, double* dydtheta ) const;
 	std::vector<double> FindRoots( const Ray ray ) const;
 	std::vector<double> FindThits( const Ray ray, const std::vector<double> roots ) const;
 
@@ -108,6 +108,9 @@ private:
 	double m_thetaZero;
 	double m_thetaMin;
 	double m_thetaMax;
+	std::vector<double> m_profileTheta;
+	std::vector<double> m_profileX;
+	std::vector<double> m_profileY;
 };
 
 #endif /*SHAPETROUGHASYMMETRICCPC_H_*/
@@ -59,11 +59,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "DifferentialGeometry.h"
 #include "ShapeTroughCHC.h"
 
-
-double fPart( double alpha, double x, double r1, double theta, double r, double eccentricity )
-{
-	return -r1 + sin( alpha - theta ) * ( r/ ( 1 - eccentricity * cos( alpha ) ) ) - x ;
-}
+/*!
+ * Number of uniform alpha intervals used to tabulate the profile x coordinate.
+ */
+const int profileSegments = 128;
 
 SO_NODE_SOURCE(ShapeTroughCHC);
 
@@ -198,8 +197,7 @@ bool ShapeTroughCHC::Intersect(const Ray& objectRay, double *tHit, DifferentialG
 	double inf = m_theta + m_phi;
 
 	double alpha;
-	bool isAlpha = findRoot( fPart, hitPoint.x,  m_eccentricity,  r1.getValue(), m_theta, inf, sup, 0.5*( sup-inf), 500, &alpha );
-	if( !isAlpha )return false;
+	if( !FindAlpha( hitPoint.x, &alpha ) ) return false;
 	double u = ( alpha - inf ) / ( sup - inf );
 
 	zmax = (lengthX1.getValue() / 2 ) + m* ( hitPoint.x - r1.getValue() );
@@ -462,54 +460,74 @@ Vector3D ShapeTroughCHC::GetDPDV( double u, double /* v */ ) const
    return Vector3D( x, y, z );
 }
 
-bool ShapeTroughCHC::findRoot( double (*funcion)( double, double, double, double, double, double ), double xCoord, double e, double r1, double theta, double a, double b, double y0, int max, double* alpha )
+/*!
+ * Computes in \a alpha the profile parameter whose x coordinate is \a xCoord.
+ * The segment that contains the solution is taken from the tabulated profile and
+ * the value is refined with Newton steps kept inside that segment.
+ * Returns false if \a xCoord is not within the profile.
+ */
+bool ShapeTroughCHC::FindAlpha( double xCoord, double* alpha ) const
 {
+	int nSegments = m_profileX.size() - 1;
+	int segment = 0;
+	while( ( segment < nSegments ) &&
+			( ( m_profileX[segment] - xCoord ) * ( m_profileX[segment + 1] - xCoord ) > 0.0 ) )
+		segment++;
+	if( segment >= nSegments ) return false;
 
-	double r  =  2 * r1 *( 1 - e * cos( theta + 0.5* gc::Pi ) );
-
-
-	double y1 = funcion( a, xCoord, r1, theta, r, e );
-	double y2 =funcion( b, xCoord, r1, theta, r, e );
-
-	double delta = fabs( a - b ) / 100;
-	while( ( ( y1 * y2 ) > 0.0 ) && ( a < b ) )
-	{
-		a += delta;
-		y1 = funcion(  a, xCoord, r1, theta, r, e );
-		//funcion( a, r, thetaI, ray  );
-	}
-
-	if( ( ( y1 * y2 ) > 0.0 ) || ( a > b ) ) return false;
+	double alphaMin = m_theta + m_phi;
+	double delta = ( m_theta + 0.5 * gc::Pi - alphaMin ) / nSegments;
+	double a = alphaMin + segment * delta;
+	double b = a + delta;
+	double fa = m_profileX[segment] - xCoord;
+	double fb = m_profileX[segment + 1] - xCoord;
 
+	double alphaHit = ( fb != fa ) ? a - fa * ( b - a ) / ( fb - fa ) : a;
 	int iterations = 0;
-	while( ( fabs( a - b ) > 0.000000000001 ) && ( iterations < max ) )
+	while( iterations < 100 )
 	{
-		double x = ( a + b ) / 2.0 ;
-		//double y = funcion( x, r, thetaI, ray );
-		double y = funcion( x, xCoord, r1, theta, r, e );
+		double x;
+		double dxdalpha;
+		ProfileX( alphaHit, &x, &dxdalpha );
+		double f = x - xCoord;
+		if( f == 0.0 ) break;
 
-		if( y == y0 )
+		if( ( f > 0.0 ) == ( fa > 0.0 ) )
 		{
-			*alpha = x;
-			return true;
+			a = alphaHit;
+			fa = f;
 		}
+		else b = alphaHit;
 
-		if( ( y > y0 ) && ( y2 > y1 ) ) 	b= x;
-		else if( ( y > y0 ) && ( y2 < y1 ) ) 		a = x;
-		else if( ( y < y0 ) && ( y2 > y1 ) ) 		a= x;
-		else	b = x;
-		iterations++;
+		double next = ( dxdalpha != 0.0 ) ? alphaHit - f / dxdalpha : a;
+		if( ( next <= a ) || ( next >= b ) ) next = 0.5 * ( a + b );
 
+		bool converged = ( fabs( next - alphaHit ) < 0.000000000001 );
+		alphaHit = next;
+		if( converged ) break;
+		iterations++;
 	}
 
-	if( iterations >= max ) return false;
-
-	*alpha  = ( a + b ) / 2 ;
+	*alpha = alphaHit;
 	return true;
 }
 
+/*!
+ * Computes the profile x coordinate for \a alpha and its derivative respect alpha.
+ */
+void ShapeTroughCHC::ProfileX( double alpha, double* x, double* dxdalpha ) const
+{
+	double r  =  2 * r1.getValue() *( 1 - m_eccentricity * cos( m_theta + 0.5* gc::Pi ) );
+	double denominator = 1 - m_eccentricity * cos( alpha );
+
+	*x = - r1.getValue() + sin( alpha - m_theta ) * r / denominator;
+	*dxdalpha = ( r * cos( alpha - m_theta ) / denominator )
+			- ( m_eccentricity * r * sin( alpha ) * sin( alpha - m_theta ) ) / ( denominator * denominator );
+}
+
 /*!
  * Computes and sets \a m_phi, \a m_s, \a m_theta and \a m_eccentricity.
+ * Tabulates the profile x coordinate used to find the parameter of the hit points.
  */
 void ShapeTroughCHC::SetInternalValues()
 {
@@ -524,4 +542,13 @@ void ShapeTroughCHC::SetInternalValues()
 								* ( 1 + sin( m_phi ) ) * ( 1 + sin( m_phi ) ) * sin( m_phi ) * sin( m_phi ) )
 	                  /( 2 * p1.getValue() * cos( m_phi ) * cos( m_phi ) - ( p1.getValue() - r1.getValue() ) * ( 1 + sin( m_phi ) ) );
 
+	double alphaMin = m_theta + m_phi;
+	double delta = ( m_theta + 0.5 * gc::Pi - alphaMin ) / profileSegments;
+	m_profileX.resize( profileSegments + 1 );
+	for( int i = 0; i <= profileSegments; ++i )
+	{
+		double dxdalpha;
+		ProfileX( alphaMin + i * delta, &m_profileX[i], &dxdalpha );
+	}
+
 }
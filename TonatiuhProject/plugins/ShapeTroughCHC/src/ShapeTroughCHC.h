@@ -39,6 +39,8 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef SHAPETROUGHCHC_H_
 #define SHAPETROUGHCHC_H_
 
+#include <vector>
+
 #include <QString>
 
 #include <Inventor/fields/SoSFDouble.h>
@@ -87,7 +89,8 @@ protected:
 private:
 	Vector3D GetDPDU( double u, double v ) const;
 	Vector3D GetDPDV( double u, double v ) const;
-	static bool findRoot( double (*funcion)( double, double, double, double, double, double ), double xCoord, double e, double r1, double theta, double a, double b, double y0, int max, double* alpha );
+	bool FindAlpha( double xCoord, double* alpha ) const;
+	void ProfileX( double alpha, double* x, double* dxdalpha ) const;
 
 	void SetInternalValues();
 
@@ -95,6 +98,7 @@ private:
 	double m_s;
 	double m_theta;
 	double m_eccentricity;
+	std::vector<double> m_profileX;
 };
 
 #endif /*SHAPETROUGHCHC_H_*/
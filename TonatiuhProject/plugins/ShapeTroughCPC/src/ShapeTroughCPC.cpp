@@ -40,7 +40,6 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <vector>
 
 #include <QIcon>
-#include <QMap>
 #include <QMessageBox>
 
 #include <Inventor/SoPrimitiveVertex.h>
@@ -57,21 +56,10 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "DifferentialGeometry.h"
 #include "ShapeTroughCPC.h"
 
-double fPart( double theta, double a, double thetaI, Ray ray )
-{
-
-	//Caso 1a: RIGHT, If= FALSE
-
-	double xrd = ray.direction().x;
-	double xro = ray.origin.x;
-	double yrd = ray.direction().y;
-	double yro = ray.origin.y;
-
-	return ( 1 /(-1 + cos( theta ))) * ( (a + xro ) * yrd - xrd * yro + (-xro * yrd + xrd * yro ) * cos(theta)
-					+ a * ( -yrd * ( cos(theta - 2 * thetaI ) + 2 * sin( theta - thetaI ))
-					+ 2 * xrd * cos( theta - thetaI ) * (1 + sin(thetaI) ) ) );
-
-}
+/*!
+ * Number of uniform theta intervals used to tabulate the concentrator profile.
+ */
+const int profileSegments = 128;
 
 SO_NODE_SOURCE(ShapeTroughCPC);
 
@@ -96,6 +84,7 @@ ShapeTroughCPC::ShapeTroughCPC()
 
 	m_thetaI = asin( 1 / cMax.getValue() );
 	m_thetaMin = 2 * m_thetaI;
+	BuildProfileTable();
 
 	m_aSensor = new SoFieldSensor(updateHeightValues, this);
 	m_aSensor->setPriority( 0 );
@@ -143,43 +132,21 @@ QString ShapeTroughCPC::GetIcon() const
 
 bool ShapeTroughCPC::Intersect(const Ray& objectRay, double *tHit, DifferentialGeometry *dg) const
 {
-	QMap< double, double > vectorTr;
+	double roots[2];
+	int nIntersections = FindRoots( objectRay, roots );
+	if ( nIntersections == 0 ) return false;
 
-	double inf = 2 * m_thetaI;
-	double sup = ( gc::Pi / 2 ) + m_thetaI;
-	double ts11;
-	bool isRoot1 = findRoot( fPart, objectRay, a.getValue(), m_thetaI, inf, sup, 0, 500, &ts11 );
-	if( isRoot1 )
+	double tHits[2];
+	for( int i = 0; i < nIntersections; ++i )
+		tHits[i] = findThit( objectRay, roots[i], true );
+	if( ( nIntersections == 2 ) && ( tHits[1] < tHits[0] ) )
 	{
-
-		double tr11 = findThit( objectRay, ts11, true );
-		vectorTr.insert( tr11, ts11 );
-		double ts12;
-		if ( findRoot( fPart, objectRay, a.getValue(), m_thetaI, inf, ts11 - 0.00001, 0, 500, &ts12 ) )
-		{
-			double tr12  = findThit( objectRay, ts12, true );
-			vectorTr.insert( tr12, ts12 );
-		}
-		else
-		{
-			if( findRoot( fPart, objectRay, a.getValue(), m_thetaI, ts11 + 0.00001, sup, 0, 500, &ts12 ) )
-			{
-				double tr12 = findThit( objectRay, ts12, true );
-				vectorTr.insert( tr12, ts12 );
-			}
-		}
-
+		std::swap( tHits[0], tHits[1] );
+		std::swap( roots[0], roots[1] );
 	}
 
-
-	int nIntersections =  vectorTr.size();
-	if ( nIntersections == 0 ) return false;
-	QList< double > keys = vectorTr.keys();
-	std::vector<double> array = QVector<double>::fromList( keys ).toStdVector() ;
-
-
- 	std::sort(array.begin(), array.end());
-	double thit = array[0];
+	double thit = tHits[0];
+	double theta = roots[0];
 	int intersection = 0;
 	bool valid = false;
 	Point3D hitPoint;
@@ -190,10 +157,11 @@ bool ShapeTroughCPC::Intersect(const Ray& objectRay, double *tHit, DifferentialG
 	double ymin = 0.0;
 	double ymax = ( 2 * a.getValue() * cos(m_thetaI)* (1 + sin(m_thetaI ) ) )/(1 - cos( 2 * m_thetaI ) );
 
-	while(  ( intersection < vectorTr.size() ) && !valid )
+	while(  ( intersection < nIntersections ) && !valid )
 	{
 
-		thit = array[intersection];
+		thit = tHits[intersection];
+		theta = roots[intersection];
 
 		if ( thit < 0 ) valid = false;
 		else
@@ -201,7 +169,6 @@ bool ShapeTroughCPC::Intersect(const Ray& objectRay, double *tHit, DifferentialG
 			// Compute intersection distance along ray
 				//Evaluate Tolerance
 			double tol = 0.0001;
-			double theta = vectorTr.value( thit );
 			if( ( fabs( thit ) < tol ) || ( theta > ( gc::Pi / 2 + m_thetaI )  ) ) valid = false;
 			else
 			{
@@ -227,8 +194,6 @@ bool ShapeTroughCPC::Intersect(const Ray& objectRay, double *tHit, DifferentialG
 	}
 	if( !valid ) return false;
 
-	double theta = vectorTr.value( thit );
-
 	// Now check if the fucntion is being called from IntersectP,
 	// in which case the pointers tHit and dg are 0
 	if( ( tHit == 0 ) && ( dg == 0 ) ) return true;
@@ -309,37 +274,15 @@ void ShapeTroughCPC::updateCMaxValues( void *data, SoSensor *)
 {
 	ShapeTroughCPC* shapeTroughCPC = (ShapeTroughCPC *) data;
 	shapeTroughCPC->m_thetaI = asin( 1 / shapeTroughCPC->cMax.getValue() );
+	shapeTroughCPC->BuildProfileTable();
 
-	double theta = 2 * shapeTroughCPC->m_thetaI;
-	double theta1 = gc::Pi/2 + shapeTroughCPC->m_thetaI;
-	double y1 = 0;
-	double theta2 = 2 * shapeTroughCPC->m_thetaI;
-	double y2 = ( 2 * shapeTroughCPC->a.getValue() * (1 + sin(shapeTroughCPC->m_thetaI) ) *cos( theta - shapeTroughCPC->m_thetaI ) )
-			/( 1 - cos(theta2) );
-
-
-	double y0 = shapeTroughCPC->height.getValue();
-
-	int iterations = 0;
-	while( ( fabs( theta1 - theta2 ) > 0.00001 ) && ( iterations < 100 ) )
-	{
-		double theta = ( theta1 + theta2 ) / 2 ;
-
-		double y = ( 2 * shapeTroughCPC->a.getValue() * (1 + sin(shapeTroughCPC->m_thetaI) ) *cos( theta - shapeTroughCPC->m_thetaI ) )
-				/( 1 - cos(theta) );
-
-		if( ( y >= y0 ) && ( y2 > y1 ) ) 	theta2 = theta;
-		else if( ( y >= y0 ) && ( y2 < y1 ) ) 		theta1 = theta;
-		else if( ( y < y0 ) && ( y2 > y1 ) ) 		theta1 = theta;
-		else	theta2 = theta;
-
-	}
-	shapeTroughCPC->m_thetaMin = ( theta1 + theta2 ) / 2;
+	shapeTroughCPC->m_thetaMin = shapeTroughCPC->ThetaAtHeight( shapeTroughCPC->height.getValue() );
 }
 
 void ShapeTroughCPC::updateHeightValues( void *data, SoSensor *)
 {
 	ShapeTroughCPC* shapeTroughCPC = (ShapeTroughCPC *) data;
+	shapeTroughCPC->BuildProfileTable();
 
 	double theta = 2 * shapeTroughCPC->m_thetaI;
 	double yMax = ( 2 * shapeTroughCPC->a.getValue() * (1 + sin(shapeTroughCPC->m_thetaI) ) *cos( theta- shapeTroughCPC->m_thetaI ) )
@@ -359,32 +302,7 @@ void ShapeTroughCPC::updateHeightValues( void *data, SoSensor *)
 			shapeTroughCPC->m_thetaMin = 2 * shapeTroughCPC->m_thetaI;
 	}
 	else
-	{
-		double theta1 = gc::Pi/2 + shapeTroughCPC->m_thetaI;
-		double y1 = 0;
-		double theta2 = 2 * shapeTroughCPC->m_thetaI;
-		double y2 = ( 2 * shapeTroughCPC->a.getValue() * (1 + sin(shapeTroughCPC->m_thetaI) ) *cos( theta - shapeTroughCPC->m_thetaI ) )
-				/( 1 - cos(theta2) );
-
-
-		double y0 = shapeTroughCPC->height.getValue();
-
-		int iterations = 0;
-		while( ( fabs( theta1 - theta2 ) > 0.00001 ) && ( iterations < 100 ) )
-		{
-			double theta = ( theta1 + theta2 ) / 2 ;
-
-			double y = ( 2 * shapeTroughCPC->a.getValue() * (1 + sin(shapeTroughCPC->m_thetaI) ) *cos( theta - shapeTroughCPC->m_thetaI ) )
-					/( 1 - cos(theta) );
-
-			if( ( y >= y0 ) && ( y2 > y1 ) ) 	theta2 = theta;
-			else if( ( y >= y0 ) && ( y2 < y1 ) ) 		theta1 = theta;
-			else if( ( y < y0 ) && ( y2 > y1 ) ) 		theta1 = theta;
-			else	theta2 = theta;
-
-		}
-		shapeTroughCPC->m_thetaMin = ( theta1 + theta2 ) / 2;
-	}
+		shapeTroughCPC->m_thetaMin = shapeTroughCPC->ThetaAtHeight( shapeTroughCPC->height.getValue() );
 }
 
 
@@ -565,43 +483,113 @@ double ShapeTroughCPC::findThit( Ray ray, double theta, bool right ) const
 	return tHit;
 }
 
-bool ShapeTroughCPC::findRoot( double (*funcion)( double, double, double, Ray ), Ray ray, double r, double thetaI, double a, double b, double y0, int max, double* theta )
+/*!
+ * Tabulates the concentrator profile at uniform theta values between 2 * \a m_thetaI and
+ * PI / 2 + \a m_thetaI. The table must be rebuilt each time \a a or \a cMax changes.
+ */
+void ShapeTroughCPC::BuildProfileTable()
 {
+	double thetaStart = 2 * m_thetaI;
+	double delta = ( gc::Pi / 2 + m_thetaI - thetaStart ) / profileSegments;
 
-	double y1 = funcion( a, r, thetaI, ray  );
-	double y2 = funcion( b, r, thetaI, ray );
-
-	double delta = fabs( a - b ) / 100;
-	while( ( ( y1 * y2 ) > 0.0 ) && ( a < b ) )
+	m_profileX.resize( profileSegments + 1 );
+	m_profileY.resize( profileSegments + 1 );
+	for( int i = 0; i <= profileSegments; ++i )
 	{
-		a += delta;
-		y1 = funcion( a, r, thetaI, ray  );
+		double dxdtheta;
+		double dydtheta;
+		ProfilePoint( thetaStart + i * delta, &m_profileX[i], &m_profileY[i], &dxdtheta, &dydtheta );
 	}
+}
 
-	if( ( ( y1 * y2 ) > 0.0 ) || ( a > b ) ) return false;
+/*!
+ * Computes the profile point for \a theta and its derivatives respect theta.
+ */
+void ShapeTroughCPC::ProfilePoint( double theta, double* x, double* y, double* dxdtheta, double* dydtheta ) const
+{
+	double k = 2 * a.getValue() * ( 1 + sin( m_thetaI ) );
+	double denominator = 1 - cos( theta );
+	double sinTheta = sin( theta - m_thetaI );
+	double cosTheta = cos( theta - m_thetaI );
+
+	*x = ( k * sinTheta / denominator ) - a.getValue();
+	*y = k * cosTheta / denominator;
+	*dxdtheta = k * ( cosTheta * denominator - sinTheta * sin( theta ) ) / ( denominator * denominator );
+	*dydtheta = - k * ( sinTheta * denominator + cosTheta * sin( theta ) ) / ( denominator * denominator );
+}
 
-	int iterations = 0;
-	while( ( fabs( a - b ) > 0.000000000001 ) && ( iterations < max ) )
-	{
-		double x = ( a + b ) / 2.0 ;
-		double y = funcion( x, r, thetaI, ray );
+/*!
+ * Computes in \a roots the theta values where the profile crosses the projection of \a ray
+ * on the xy plane and returns the number of roots found. \a roots must hold at least two values.
+ *
+ * The table built in BuildProfileTable gives the segments where the crossings are, and each
+ * one is refined with Newton steps kept inside its segment.
+ */
+int ShapeTroughCPC::FindRoots( const Ray& ray, double* roots ) const
+{
+	double dx = ray.direction().x;
+	double dy = ray.direction().y;
+	double ox = ray.origin.x;
+	double oy = ray.origin.y;
 
-		if( y == y0 )
-		{
-			*theta = x;
-			return true;
-		}
+	double thetaStart = 2 * m_thetaI;
+	double delta = ( gc::Pi / 2 + m_thetaI - thetaStart ) / profileSegments;
 
-		if( ( y > y0 ) && ( y2 > y1 ) ) 	b= x;
-		else if( ( y > y0 ) && ( y2 < y1 ) ) 		a = x;
-		else if( ( y < y0 ) && ( y2 > y1 ) ) 		a= x;
-		else	b = x;
-		iterations++;
+	int nRoots = 0;
+	double g0 = ( m_profileX[0] - ox ) * dy - ( m_profileY[0] - oy ) * dx;
+	for( int i = 0; ( i < profileSegments ) && ( nRoots < 2 ); ++i )
+	{
+		double g1 = ( m_profileX[i + 1] - ox ) * dy - ( m_profileY[i + 1] - oy ) * dx;
+		if( ( g0 < 0.0 ) != ( g1 < 0.0 ) )
+		{
+			double theta0 = thetaStart + i * delta;
+			double theta1 = theta0 + delta;
+			double ga = g0;
 
+			double theta = theta0 - g0 * delta / ( g1 - g0 );
+			int iterations = 0;
+			while( iterations < 100 )
+			{
+				double x;
+				double y;
+				double dxdtheta;
+				double dydtheta;
+				ProfilePoint( theta, &x, &y, &dxdtheta, &dydtheta );
+				double g = ( x - ox ) * dy - ( y - oy ) * dx;
+				if( g == 0.0 ) break;
+
+				if( ( g < 0.0 ) == ( ga < 0.0 ) )
+				{
+					theta0 = theta;
+					ga = g;
+				}
+				else theta1 = theta;
+
+				double dgdtheta = dxdtheta * dy - dydtheta * dx;
+				double next = ( dgdtheta != 0.0 ) ? theta - g / dgdtheta : theta0;
+				if( ( next <= theta0 ) || ( next >= theta1 ) ) next = 0.5 * ( theta0 + theta1 );
+
+				bool converged = ( fabs( next - theta ) < 0.000000000001 );
+				theta = next;
+				if( converged ) break;
+				iterations++;
+			}
+			roots[nRoots++] = theta;
+		}
+		g0 = g1;
 	}
 
-	if( iterations >= max ) return false;
+	return nRoots;
+}
 
-	*theta  = ( a + b ) / 2 ;
-	return true;
+/*!
+ * Returns the theta value of the profile point at height \a y0.
+ */
+double ShapeTroughCPC::ThetaAtHeight( double y0 ) const
+{
+	Ray heightLine( Point3D( 0.0, y0, 0.0 ), Vector3D( 1.0, 0.0, 0.0 ) );
+	double roots[2];
+	if( FindRoots( heightLine, roots ) > 0 ) return roots[0];
+
+	return ( y0 > 0.0 ) ? 2 * m_thetaI : gc::Pi / 2 + m_thetaI;
 }
@@ -39,6 +39,8 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef SHAPETROUGHCPC_H_
 #define SHAPETROUGHCPC_H_
 
+#include <vector>
+
 #include <QString>
 
 #include <Inventor/fields/SoSFDouble.h>
@@ -87,10 +89,15 @@ protected:
 
 private:
 	double findThit( Ray ray, double theta, bool right ) const;
-	static bool findRoot( double (*funcion)( double, double, double, Ray ), Ray ray, double r, double thetaI, double a, double b, double y0, int max, double* theta );
+	void BuildProfileTable();
+	void ProfilePoint( double theta, double* x, double* y, double* dxdtheta, double* dydtheta ) const;
+	int FindRoots( const Ray& ray, double* roots ) const;
+	double ThetaAtHeight( double y0 ) const;
 
 	double m_thetaI;
 	double m_thetaMin;
+	std::vector<double> m_profileX;
+	std::vector<double> m_profileY;
 
 	SoFieldSensor* m_aSensor;
 	SoFieldSensor* m_cMaxSensor;
@@ -12,6 +12,7 @@ INCLUDEPATH += . \
 HEADERS = src/*.h \   						
            	$$(TONATIUH_ROOT)/src/source/raytracing/DifferentialGeometry.h \
            	$$(TONATIUH_ROOT)/src/source/raytracing/Photon.h \
+           	$$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.h \
            	$$(TONATIUH_ROOT)/src/source/raytracing/TMaterial.h \
            	$$(TONATIUH_ROOT)/src/source/raytracing/TShape.h \ 
            	$$(TONATIUH_ROOT)/src/source/raytracing/TShapeKit.h
@@ -20,6 +21,7 @@ HEADERS = src/*.h \
 SOURCES = src/*.cpp  \           						
            	$$(TONATIUH_ROOT)/src/source/raytracing/DifferentialGeometry.cpp \
            	$$(TONATIUH_ROOT)/src/source/raytracing/Photon.cpp \
+           	$$(TONATIUH_ROOT)/src/source/raytracing/SpectralWeights.cpp \
            	$$(TONATIUH_ROOT)/src/source/raytracing/TMaterial.cpp \
            	$$(TONATIUH_ROOT)/src/source/raytracing/TShape.cpp \ 
            	$$(TONATIUH_ROOT)/src/source/raytracing/TShapeKit.cpp
@@ -36,6 +36,8 @@ Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <cmath>
+
 #include <Inventor/sensors/SoFieldSensor.h>
 
 #include "gc.h"
@@ -75,7 +77,6 @@ void SunshapeBuie::updateState( double csrValue )
 {
     m_thetaSD = 0.00465;
     m_thetaCS = 0.0436;
-    m_deltaThetaCSSD = m_thetaCS - m_thetaSD;
     m_integralA = 9.224724736098827/1000000.0;
 	m_chi = chiValue( csrValue );
 	m_k = kValue( m_chi );
@@ -83,9 +84,7 @@ void SunshapeBuie::updateState( double csrValue )
 	m_etokTimes1000toGamma = exp( m_k ) * pow( 1000, m_gamma );
     m_integralB = intregralB( m_k, m_gamma, m_thetaCS, m_thetaSD );
     m_alpha = 1.0/( m_integralA + m_integralB );
-    m_heightRectangle1 = 1.001 * pdfTheta( 0.0038915695846209047 );
-    m_heightRectangle2 = pdfTheta( m_thetaSD );
-    m_probabilityRectangle1 = probabilityRectangle1(  m_thetaSD, m_heightRectangle1, (m_thetaCS - m_thetaSD), m_heightRectangle2 );
+    BuildZenithAngleTables();
 }
 
 SunshapeBuie::~SunshapeBuie()
@@ -95,16 +94,25 @@ SunshapeBuie::~SunshapeBuie()
 //Light Interface
 void SunshapeBuie::GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const
 {
-	double phi = gc::TwoPi * rand.RandomDouble();
-    double theta = zenithAngle( rand );
-    double sinTheta = sin( theta );
-    double cosTheta = cos( theta );
-    double cosPhi = cos( phi );
-    double sinPhi = sin( phi );
+	GenerateRayDirections( &direction.x, &direction.y, &direction.z, 1, rand );
+}
 
-    direction.x = sinTheta*sinPhi;
-    direction.y = -cosTheta;
-    direction.z = sinTheta*cosPhi;
+/*!
+ * Generates \a numberOfDirections sun directions in \a directionX, \a directionY and \a directionZ.
+ * The random numbers are consumed in the same order as \a numberOfDirections calls to GenerateRayDirection.
+ */
+void SunshapeBuie::GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+		int numberOfDirections, RandomDeviate& rand ) const
+{
+	for( int i = 0; i < numberOfDirections; ++i )
+	{
+		directionX[i] = rand.RandomDouble();
+		directionZ[i] = rand.RandomDouble();
+	}
+	for( int i = 0; i < numberOfDirections; ++i )
+		directionZ[i] = SinZenithAngle2( directionZ[i] );
+
+	ComputeDirections( directionX, directionY, directionZ, numberOfDirections );
 }
 
 double SunshapeBuie::GetIrradiance( void ) const
@@ -132,13 +140,12 @@ SoNode* SunshapeBuie::copy( SbBool copyConnections ) const
 	newSunShape->m_etokTimes1000toGamma = m_etokTimes1000toGamma;
 	newSunShape->m_thetaSD = m_thetaSD;
 	newSunShape->m_thetaCS = m_thetaCS;
-	newSunShape->m_deltaThetaCSSD = m_deltaThetaCSSD;
 	newSunShape->m_integralA = m_integralA;
 	newSunShape->m_integralB = m_integralB;
 	newSunShape->m_alpha = m_alpha;
-	newSunShape->m_heightRectangle1 = m_heightRectangle1;
-	newSunShape->m_heightRectangle2 = m_heightRectangle2;
-	newSunShape->m_probabilityRectangle1 = m_probabilityRectangle1;
+	newSunShape->m_probabilitySolarDisk = m_probabilitySolarDisk;
+	newSunShape->m_solarDiskTable = m_solarDiskTable;
+	newSunShape->m_circumSolarTable = m_circumSolarTable;
 
 	return newSunShape;
 }
@@ -150,26 +157,89 @@ void SunshapeBuie::updateCSR(void *data, SoSensor *)
 	if( csrValue >= m_minCRSValue && csrValue <= m_maxCRSValue ) sunshape->updateState( csrValue );
 }
 
-double SunshapeBuie::zenithAngle( RandomDeviate& rand ) const
+/*!
+ * Integrates the zenith angle distribution between \a thetaMin and \a thetaMax with the
+ * trapezoidal rule and returns the inverse of the cumulative distribution at m_tableSize + 1
+ * equally spaced probabilities. The table stores sin^2( theta ), which grows linearly with the
+ * probability near the sun centre, so that the lookup interpolates it without bias.
+ */
+static void InvertCumulativeDistribution( const std::vector< double >& cdf, double thetaMin, double thetaMax,
+		int tableSize, std::vector< double >* table )
 {
-	double theta;
-	double value;
+	int numberOfSteps = cdf.size() - 1;
+	double step = ( thetaMax - thetaMin ) / numberOfSteps;
 
-	do
+	table->resize( tableSize + 1 );
+	int j = 0;
+	for( int k = 0; k <= tableSize; ++k )
 	{
-		if ( rand.RandomDouble() < m_probabilityRectangle1 )
-		{
-			theta = rand.RandomDouble() * m_thetaSD;
-			value = rand.RandomDouble() * m_heightRectangle1;
-		}
-		else
-		{
-			theta = m_thetaSD + rand.RandomDouble() * m_deltaThetaCSSD;
-			value = rand.RandomDouble() * m_heightRectangle2;
-		}
-	} while ( value > pdfTheta( theta ) );
+		double probability = cdf[numberOfSteps] * k / tableSize;
+		while( j < numberOfSteps - 1 && cdf[j + 1] < probability ) ++j;
+
+		double width = cdf[j + 1] - cdf[j];
+		double t = ( width > 0.0 ) ? ( probability - cdf[j] ) / width : 0.0;
+		if( t > 1.0 ) t = 1.0;
 
-	return theta;
+		double sinTheta = sin( thetaMin + ( j + t ) * step );
+		( *table )[k] = sinTheta * sinTheta;
+	}
+}
+
+/*!
+ * Builds the solar disk and circumsolar region tables for the current parameters.
+ * The two regions are integrated separately because the distribution jumps at m_thetaSD.
+ */
+void SunshapeBuie::BuildZenithAngleTables()
+{
+	std::vector< double > solarDiskCDF( m_integrationSteps + 1, 0.0 );
+	std::vector< double > circumSolarCDF( m_integrationSteps + 1, 0.0 );
+
+	double solarDiskStep = m_thetaSD / m_integrationSteps;
+	double circumSolarStep = ( m_thetaCS - m_thetaSD ) / m_integrationSteps;
+	double previousSolarDisk = 0.0;
+	double previousCircumSolar = m_alpha * phiCircumSolarRegion( m_thetaSD ) * sin( m_thetaSD );
+	for( int i = 1; i <= m_integrationSteps; ++i )
+	{
+		double theta = i * solarDiskStep;
+		double value = m_alpha * phiSolarDisk( theta ) * sin( theta );
+		solarDiskCDF[i] = solarDiskCDF[i - 1] + 0.5 * solarDiskStep * ( previousSolarDisk + value );
+		previousSolarDisk = value;
+
+		theta = m_thetaSD + i * circumSolarStep;
+		value = m_alpha * phiCircumSolarRegion( theta ) * sin( theta );
+		circumSolarCDF[i] = circumSolarCDF[i - 1] + 0.5 * circumSolarStep * ( previousCircumSolar + value );
+		previousCircumSolar = value;
+	}
+
+	double solarDiskProbability = solarDiskCDF[m_integrationSteps];
+	m_probabilitySolarDisk = solarDiskProbability / ( solarDiskProbability + circumSolarCDF[m_integrationSteps] );
+
+	InvertCumulativeDistribution( solarDiskCDF, 0.0, m_thetaSD, m_tableSize, &m_solarDiskTable );
+	InvertCumulativeDistribution( circumSolarCDF, m_thetaSD, m_thetaCS, m_tableSize, &m_circumSolarTable );
+}
+
+/*!
+ * Returns sin^2 of the zenith angle whose cumulative probability is \a u.
+ */
+double SunshapeBuie::SinZenithAngle2( double u ) const
+{
+	const std::vector< double >* table;
+	if( u < m_probabilitySolarDisk )
+	{
+		table = &m_solarDiskTable;
+		u = u / m_probabilitySolarDisk;
+	}
+	else
+	{
+		table = &m_circumSolarTable;
+		u = ( u - m_probabilitySolarDisk ) / ( 1.0 - m_probabilitySolarDisk );
+	}
+
+	double x = u * m_tableSize;
+	int i = int( x );
+	if( i >= m_tableSize ) i = m_tableSize - 1;
+	double t = x - i;
+	return ( *table )[i] + t * ( ( *table )[i + 1] - ( *table )[i] );
 }
 
 double SunshapeBuie::chiValue( double csr ) const
@@ -200,19 +270,6 @@ double SunshapeBuie::phiCircumSolarRegion( double theta ) const
 	return m_etokTimes1000toGamma * pow( theta, m_gamma );
 }
 
-double SunshapeBuie::phi( double theta ) const
-{
-	// The parameter theta is the zenith angle in radians
-	if ( theta < m_thetaSD ) return phiSolarDisk( theta );
-	else return phiCircumSolarRegion( theta );
-}
-
-double SunshapeBuie::pdfTheta( double theta ) const
-{
-	// The parameter theta is the zenith angle in radians
-	return m_alpha * phi( theta ) * sin( theta );
-}
-
 double SunshapeBuie::kValue( double chi ) const
 {
 	return 0.9 * log( 13.5 * chi ) * pow( chi, -0.3 );
@@ -229,9 +286,3 @@ double SunshapeBuie::intregralB( double k, double gamma, double thetaCS, double
 	return ( exp( k ) * pow( 1000, gamma ) / gammaPlusTwo ) * ( pow( thetaCS, gammaPlusTwo ) - pow( thetaSD, gammaPlusTwo ) );
 }
 
-double SunshapeBuie::probabilityRectangle1( double widthR1, double heightR1, double widthR2, double heightR2 ) const
-{
-	double areaR1 = widthR1 * heightR1;
-	double areaR2 = widthR2 * heightR2;
-	return areaR1 / ( areaR1 + areaR2 );
-}
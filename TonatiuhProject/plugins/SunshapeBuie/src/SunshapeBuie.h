@@ -40,11 +40,20 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef SUNSHAPEBUIE_H_
 #define SUNSHAPEBUIE_H_
 
+#include <vector>
+
 #include "TSunShape.h"
 #include "trt.h"
 
 class SoSensor;
 
+/*!
+ * Buie sunshape model.
+ *
+ * Every time the csr changes the zenith angle distribution is integrated and inverted
+ * into two tables, one for the solar disk and one for the circumsolar region. A direction
+ * is then sampled with a table lookup and a linear interpolation.
+ */
 class SunshapeBuie : public TSunShape
 {
 	SO_NODE_HEADER(SunshapeBuie);
@@ -56,6 +65,8 @@ public:
 
     //Sunshape Interface
     void GenerateRayDirection( Vector3D& direction, RandomDeviate& rand) const;
+    void GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+    		int numberOfDirections, RandomDeviate& rand ) const;
 	double GetIrradiance() const;
     double GetThetaMax() const;
 
@@ -69,13 +80,11 @@ private:
 	 double chiValue( double csr ) const;
 	 double phiSolarDisk( double theta ) const;
 	 double phiCircumSolarRegion( double theta ) const;
-	 double phi( double theta ) const;
-	 double pdfTheta( double theta ) const;
-	 double zenithAngle( RandomDeviate& rand ) const;
+	 void BuildZenithAngleTables();
+	 double SinZenithAngle2( double u ) const;
 	 double kValue( double chi ) const;
 	 double gammaValue( double chi ) const;
 	 double intregralB( double k, double gamma, double thetaCS, double thetaSD ) const;
-	 double probabilityRectangle1( double widthR1, double heightR1, double widthR2, double heightR2 ) const;
 	 void updateState( double csrValue );
 
 	 double m_chi;
@@ -84,13 +93,15 @@ private:
 	 double m_etokTimes1000toGamma;
 	 double m_thetaSD;
 	 double m_thetaCS;
-	 double m_deltaThetaCSSD;
 	 double m_integralA;
 	 double m_integralB;
 	 double m_alpha;
-	 double m_heightRectangle1;
-	 double m_heightRectangle2;
-	 double m_probabilityRectangle1;
+
+	 // Inverse cumulative distributions of the zenith angle, stored as sin^2( theta )
+	 enum { m_tableSize = 2048, m_integrationSteps = 8192 };
+	 double m_probabilitySolarDisk;
+	 std::vector< double > m_solarDiskTable;
+	 std::vector< double > m_circumSolarTable;
 	 static const double m_minCRSValue;// = 0.001;
 	 static const double m_maxCRSValue;// = 0.8;
 };
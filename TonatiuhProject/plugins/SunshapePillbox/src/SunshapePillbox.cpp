@@ -62,16 +62,26 @@ SunshapePillbox::~SunshapePillbox()
 //Light Interface
 void SunshapePillbox::GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const
 {
-	double phi = gc::TwoPi * rand.RandomDouble();
-    double theta = asin( sin( thetaMax.getValue() )*sqrt( rand.RandomDouble() ) );
-    double sinTheta = sin( theta );
-    double cosTheta = cos( theta );
-    double cosPhi = cos( phi );
-    double sinPhi = sin( phi );
-
-    direction.x = sinTheta*sinPhi;
-    direction.y = -cosTheta;
-    direction.z = sinTheta*cosPhi;
+	GenerateRayDirections( &direction.x, &direction.y, &direction.z, 1, rand );
+}
+
+/*!
+ * Generates \a numberOfDirections sun directions in \a directionX, \a directionY and \a directionZ.
+ * The sine of the zenith angle is the radius of a point uniformly distributed in the disk of radius
+ * sin( thetaMax ), so its square is proportional to a uniform random number.
+ */
+void SunshapePillbox::GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+		int numberOfDirections, RandomDeviate& rand ) const
+{
+	double sinThetaMax = sin( thetaMax.getValue() );
+	double sinThetaMax2 = sinThetaMax * sinThetaMax;
+	for( int i = 0; i < numberOfDirections; ++i )
+	{
+		directionX[i] = rand.RandomDouble();
+		directionZ[i] = sinThetaMax2 * rand.RandomDouble();
+	}
+
+	ComputeDirections( directionX, directionY, directionZ, numberOfDirections );
 }
 
 double SunshapePillbox::GetIrradiance( void ) const
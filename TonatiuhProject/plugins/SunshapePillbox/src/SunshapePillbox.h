@@ -57,6 +57,8 @@ public:
 
     //Sunshape Interface
     void GenerateRayDirection( Vector3D& direction, RandomDeviate& rand) const;
+    void GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+    		int numberOfDirections, RandomDeviate& rand ) const;
 	double GetIrradiance() const;
     double GetThetaMax() const;
 
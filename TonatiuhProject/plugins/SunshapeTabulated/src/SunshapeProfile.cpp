@@ -0,0 +1,211 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+
+#include "gc.h"
+
+#include "SunshapeProfile.h"
+
+SunshapeProfile::SunshapeProfile()
+:m_thetaMax( 0.0 )
+{
+	Clear();
+}
+
+SunshapeProfile::~SunshapeProfile()
+{
+}
+
+/*!
+ * Sets the default profile, a uniform disk of 4.65 milliradians.
+ */
+void SunshapeProfile::Clear()
+{
+	std::vector< double > angles( 2 );
+	angles[0] = 0.0;
+	angles[1] = 4.65;
+	std::vector< double > intensities( 2, 1.0 );
+	Create( angles, intensities );
+}
+
+/*!
+ * Builds the sampling tables for the intensities \a intensities measured at the angles \a angles, in milliradians.
+ *
+ * Returns false and leaves the profile unchanged if the vectors are empty or have different sizes,
+ * if any angle is negative or not smaller than pi/2, if any intensity is negative or if all of them are zero.
+ */
+bool SunshapeProfile::Create( const std::vector< double >& angles, const std::vector< double >& intensities )
+{
+	if( angles.empty() || ( angles.size() != intensities.size() ) ) return false;
+
+	std::vector< std::pair< double, double > > points;
+	bool positiveIntensity = false;
+	for( unsigned int i = 0; i < angles.size(); ++i )
+	{
+		double theta = angles[i] / 1000;
+		if( !( theta >= 0.0 && theta < gc::Pi / 2 ) ) return false;
+		if( !( intensities[i] >= 0.0 ) ) return false;
+		if( intensities[i] > 0.0 ) positiveIntensity = true;
+		points.push_back( std::make_pair( theta, intensities[i] ) );
+	}
+	if( !positiveIntensity ) return false;
+	std::sort( points.begin(), points.end() );
+
+	// The profile ends at the first zero after the last nonzero intensity
+	while( ( points.size() > 1 ) && ( points[points.size() - 2].second == 0.0 ) && ( points.back().second == 0.0 ) )
+		points.pop_back();
+	double thetaMax = points.back().first;
+	if( !( thetaMax > 0.0 ) ) return false;
+
+	std::vector< double > cdf( m_numberOfIntervals + 1 );
+	std::vector< double > sinTheta2( m_numberOfIntervals + 1 );
+	cdf[0] = 0.0;
+	sinTheta2[0] = 0.0;
+
+	double step = thetaMax / m_numberOfIntervals;
+	double previousValue = 0.0;
+	unsigned int next = 0;
+	for( int i = 1; i <= m_numberOfIntervals; ++i )
+	{
+		double theta = i * step;
+		while( ( next < points.size() ) && ( points[next].first <= theta ) ) ++next;
+
+		double intensity;
+		if( next == 0 ) intensity = points.front().second;
+		else if( next == points.size() ) intensity = points.back().second;
+		else
+		{
+			const std::pair< double, double >& p0 = points[next - 1];
+			const std::pair< double, double >& p1 = points[next];
+			intensity = p0.second + ( theta - p0.first ) / ( p1.first - p0.first ) * ( p1.second - p0.second );
+		}
+
+		double sinTheta = sin( theta );
+		double value = intensity * sinTheta;
+		cdf[i] = cdf[i - 1] + 0.5 * step * ( previousValue + value );
+		sinTheta2[i] = sinTheta * sinTheta;
+		previousValue = value;
+	}
+
+	double total = cdf[m_numberOfIntervals];
+	for( int i = 1; i < m_numberOfIntervals; ++i ) cdf[i] /= total;
+	cdf[m_numberOfIntervals] = 1.0;
+
+	// guide[k] is the last grid interval that starts at a probability not greater than k / m_numberOfIntervals
+	std::vector< int > guide( m_numberOfIntervals + 1 );
+	int j = 0;
+	for( int k = 0; k <= m_numberOfIntervals; ++k )
+	{
+		double probability = double( k ) / m_numberOfIntervals;
+		while( ( j < m_numberOfIntervals - 1 ) && ( cdf[j + 1] <= probability ) ) ++j;
+		guide[k] = j;
+	}
+
+	m_thetaMax = thetaMax;
+	m_cdf.swap( cdf );
+	m_sinTheta2.swap( sinTheta2 );
+	m_guide.swap( guide );
+	return true;
+}
+
+/*!
+ * Reads the angles and intensities in \a fileName and builds the profile with them.
+ * The values of each line can be separated by spaces, tabs, commas or semicolons.
+ *
+ * If the file cannot be read, \a errorMessage describes the error, the profile is not changed and false is returned.
+ */
+bool SunshapeProfile::Read( QString fileName, QString* errorMessage )
+{
+	QFile inputFile( fileName );
+	if( !inputFile.open( QIODevice::ReadOnly ) )
+	{
+		*errorMessage = QString( "The file %1 cannot be opened." ).arg( fileName );
+		return false;
+	}
+
+	std::vector< double > angles;
+	std::vector< double > intensities;
+
+	QTextStream in( &inputFile );
+	int lineNumber = 0;
+	while( !in.atEnd() )
+	{
+		++lineNumber;
+		QString line = in.readLine().trimmed();
+		if( line.isEmpty() || line.startsWith( QLatin1Char( '#' ) ) ) continue;
+
+		QStringList lineData = line.split( QRegExp( "[\\s,;]+" ), QString::SkipEmptyParts );
+		bool okAngle = false, okIntensity = false;
+		if( lineData.size() == 2 )
+		{
+			angles.push_back( lineData[0].toDouble( &okAngle ) );
+			intensities.push_back( lineData[1].toDouble( &okIntensity ) );
+		}
+		if( !okAngle || !okIntensity )
+		{
+			*errorMessage = QString( "Invalid values in line %1 of file %2." ).arg( QString::number( lineNumber ), fileName );
+			return false;
+		}
+	}
+	inputFile.close();
+
+	if( !Create( angles, intensities ) )
+	{
+		*errorMessage = QString( "The file %1 does not define a valid sunshape profile. The angles must be milliradians "
+				"between 0 and pi/2 and the intensities must not be negative, with at least one of them greater than zero." ).arg( fileName );
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Returns the largest angle of the profile, in radians.
+ */
+double SunshapeProfile::ThetaMax() const
+{
+	return m_thetaMax;
+}
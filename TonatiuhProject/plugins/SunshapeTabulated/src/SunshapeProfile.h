@@ -0,0 +1,95 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef SUNSHAPEPROFILE_H_
+#define SUNSHAPEPROFILE_H_
+
+#include <vector>
+
+#include <QString>
+
+/*!
+ * Radial intensity profile of the sun, read from a text file.
+ *
+ * Each line of the file has an angle from the sun centre, in milliradians, and the intensity
+ * per unit solid angle at that angle, in any units. Empty lines and lines that start with '#'
+ * are ignored. The angles do not need to be sorted or equally spaced. The intensity is linearly
+ * interpolated between the angles, and the profile ends at the last angle with nonzero intensity
+ * or at the first zero after it.
+ *
+ * Create integrates the zenith angle distribution, intensity times sin( theta ), on a fine grid
+ * and stores its cumulative distribution with a guide table, so SinTheta2 finds the grid interval
+ * of a probability with one lookup and usually no search. The default profile is a uniform disk
+ * with the angular radius of the sun, the same as the default pillbox sunshape.
+ */
+class SunshapeProfile
+{
+public:
+	SunshapeProfile();
+	~SunshapeProfile();
+
+	void Clear();
+	bool Create( const std::vector< double >& angles, const std::vector< double >& intensities );
+	bool Read( QString fileName, QString* errorMessage );
+
+	double ThetaMax() const;
+
+	/*!
+	 * Returns sin^2 of the zenith angle whose cumulative probability is \a u, between 0 and 1.
+	 */
+	double SinTheta2( double u ) const
+	{
+		int j = m_guide[int( u * m_numberOfIntervals )];
+		while( m_cdf[j + 1] < u ) ++j;
+
+		double width = m_cdf[j + 1] - m_cdf[j];
+		double f = ( width > 0.0 ) ? ( u - m_cdf[j] ) / width : 0.0;
+		return m_sinTheta2[j] + f * ( m_sinTheta2[j + 1] - m_sinTheta2[j] );
+	}
+
+private:
+	enum { m_numberOfIntervals = 8192 };
+
+	double m_thetaMax;
+	std::vector< double > m_cdf;
+	std::vector< double > m_sinTheta2;
+	std::vector< int > m_guide;
+};
+
+#endif /* SUNSHAPEPROFILE_H_ */
@@ -0,0 +1,143 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <QMessageBox>
+
+#include <Inventor/sensors/SoFieldSensor.h>
+
+#include "SunshapeTabulated.h"
+
+SO_NODE_SOURCE(SunshapeTabulated);
+
+void SunshapeTabulated::initClass()
+{
+	SO_NODE_INIT_CLASS(SunshapeTabulated, TSunShape, "TSunShape");
+}
+
+SunshapeTabulated::SunshapeTabulated( )
+{
+	SO_NODE_CONSTRUCTOR( SunshapeTabulated );
+	SO_NODE_ADD_FIELD( irradiance, ( 1000.0 ) );
+	SO_NODE_ADD_FIELD( profileFile, ( "" ) );
+
+	SoFieldSensor* profileFileSensor = new SoFieldSensor( updateProfileFile, this );
+	profileFileSensor->setPriority( 0 );
+	profileFileSensor->attach( &profileFile );
+}
+
+SunshapeTabulated::~SunshapeTabulated()
+{
+}
+
+//Light Interface
+void SunshapeTabulated::GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const
+{
+	GenerateRayDirections( &direction.x, &direction.y, &direction.z, 1, rand );
+}
+
+/*!
+ * Generates \a numberOfDirections sun directions in \a directionX, \a directionY and \a directionZ.
+ * The random numbers are consumed in the same order as \a numberOfDirections calls to GenerateRayDirection.
+ */
+void SunshapeTabulated::GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+		int numberOfDirections, RandomDeviate& rand ) const
+{
+	for( int i = 0; i < numberOfDirections; ++i )
+	{
+		directionX[i] = rand.RandomDouble();
+		directionZ[i] = rand.RandomDouble();
+	}
+	for( int i = 0; i < numberOfDirections; ++i )
+		directionZ[i] = m_profile.SinTheta2( directionZ[i] );
+
+	ComputeDirections( directionX, directionY, directionZ, numberOfDirections );
+}
+
+double SunshapeTabulated::GetIrradiance( void ) const
+{
+	return irradiance.getValue();
+}
+
+double SunshapeTabulated::GetThetaMax() const
+{
+	return m_profile.ThetaMax();
+}
+
+SoNode* SunshapeTabulated::copy( SbBool copyConnections ) const
+{
+	// Use the standard version of the copy method to create
+	// a copy of this instance, including its field data
+	SunshapeTabulated* newSunShape = dynamic_cast< SunshapeTabulated* >( SoNode::copy( copyConnections ) );
+
+	newSunShape->irradiance = irradiance;
+	newSunShape->profileFile = profileFile;
+
+	newSunShape->m_profile = m_profile;
+	newSunShape->m_lastValidProfileFile = m_lastValidProfileFile;
+
+	return newSunShape;
+}
+
+/*!
+ * Reads the profile from the new file. If the file cannot be read, a warning is shown and the last valid file is restored.
+ * The file is read again when the same name is set, so a file rewritten for each time step is reloaded.
+ */
+void SunshapeTabulated::updateProfileFile( void* data, SoSensor* )
+{
+	SunshapeTabulated* sunshape = static_cast< SunshapeTabulated* >( data );
+
+	QString fileName( sunshape->profileFile.getValue().getString() );
+	if( fileName.isEmpty() )
+	{
+		sunshape->m_profile.Clear();
+		sunshape->m_lastValidProfileFile = fileName;
+		return;
+	}
+
+	QString errorMessage;
+	if( !sunshape->m_profile.Read( fileName, &errorMessage ) )
+	{
+		QMessageBox::warning( 0, QString( "Tonatiuh" ), errorMessage );
+		if( fileName != sunshape->m_lastValidProfileFile )
+			sunshape->profileFile.setValue( sunshape->m_lastValidProfileFile.toStdString().c_str() );
+		return;
+	}
+
+	sunshape->m_lastValidProfileFile = fileName;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef SUNSHAPETABULATED_H_
+#define SUNSHAPETABULATED_H_
+
+#include <QString>
+
+#include <Inventor/fields/SoSFString.h>
+
+#include "SunshapeProfile.h"
+#include "TSunShape.h"
+#include "trt.h"
+
+class SoSensor;
+
+/*!
+ * Sunshape with a measured radial intensity profile.
+ *
+ * The profile is read from the file \a profileFile, as described in SunshapeProfile, and
+ * GetThetaMax is the largest angle of the profile. Without a file the sunshape is a uniform
+ * disk of 4.65 milliradians.
+ *
+ * Changing \a profileFile only reads the new file and rebuilds the sampling tables, so the
+ * profile can be changed for each time step of a simulation without changing the scene.
+ */
+class SunshapeTabulated : public TSunShape
+{
+	SO_NODE_HEADER(SunshapeTabulated);
+
+public:
+	SunshapeTabulated( );
+	static void initClass();
+	SoNode* copy( SbBool copyConnections ) const;
+
+	//Sunshape Interface
+	void GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const;
+	void GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+			int numberOfDirections, RandomDeviate& rand ) const;
+	double GetIrradiance() const;
+	double GetThetaMax() const;
+
+	trt::TONATIUH_REAL irradiance;
+	SoSFString profileFile;
+
+protected:
+	static void updateProfileFile( void* data, SoSensor* );
+	~SunshapeTabulated();
+
+private:
+	SunshapeProfile m_profile;
+	QString m_lastValidProfileFile;
+};
+
+#endif /* SUNSHAPETABULATED_H_ */
@@ -61,17 +61,11 @@ TransmissivityATMParameters::~TransmissivityATMParameters()
 
 }
 
-bool TransmissivityATMParameters::IsTransmitted( double distance, RandomDeviate& rand ) const
+double TransmissivityATMParameters::Transmittance( double distance ) const
 {
-
-
 	double dKM = ( distance / 1000 );
 
 	double attenuation = atm1.getValue() + atm2.getValue() * dKM + atm3.getValue()* dKM * dKM + atm4.getValue() * dKM * dKM * dKM;
 
-	double t = 1 - ( attenuation / 100 );
-
-	if( rand.RandomDouble() < t  )	return ( true );
-
-	return ( false );
+	return ( 1 - ( attenuation / 100 ) );
 }
@@ -51,7 +51,7 @@ public:
     static void initClass();
     TransmissivityATMParameters();
 
-	bool IsTransmitted( double distance, RandomDeviate& rand ) const;
+	double Transmittance( double distance ) const;
 
 	//trt::TONATIUH_BOOL ClearDay;
 	trt::TONATIUH_REAL atm1;
@@ -58,7 +58,7 @@ TransmissivityBallestrin::~TransmissivityBallestrin()
 
 }
 
-bool TransmissivityBallestrin::IsTransmitted( double distance, RandomDeviate& rand ) const
+double TransmissivityBallestrin::Transmittance( double distance ) const
 {
 	double t;
 	if( ClearDay.getValue() )
@@ -72,7 +72,5 @@ bool TransmissivityBallestrin::IsTransmitted( double distance, RandomDeviate& ra
 				-0.0153718 * ( distance / 1000 ) * ( distance / 1000 ) * ( distance / 1000 ) );
 	}
 
-	if( rand.RandomDouble() < t  )	return true;
-
-	return false;
+	return t;
 }
@@ -51,7 +51,7 @@ public:
     static void initClass();
     TransmissivityBallestrin();
 
-	bool IsTransmitted( double distance, RandomDeviate& rand ) const;
+	double Transmittance( double distance ) const;
 
 	trt::TONATIUH_BOOL ClearDay;
 
@@ -57,9 +57,7 @@ TransmissivityDefault::~TransmissivityDefault()
 
 }
 
-bool TransmissivityDefault::IsTransmitted( double distance, RandomDeviate& rand ) const
+double TransmissivityDefault::Transmittance( double distance ) const
 {
-	if( rand.RandomDouble() < exp( -constant.getValue() * distance  ) )	return true;
-
-	return false;
+	return exp( -constant.getValue() * distance  );
 }
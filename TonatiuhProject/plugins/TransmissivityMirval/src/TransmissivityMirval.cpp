@@ -57,7 +57,7 @@ TransmissivityMirval::~TransmissivityMirval()
 
 }
 
-bool TransmissivityMirval::IsTransmitted( double distance, RandomDeviate& rand ) const
+double TransmissivityMirval::Transmittance( double distance ) const
 {
 	double t;
 	if( distance <= 1.0 )
@@ -66,6 +66,5 @@ bool TransmissivityMirval::IsTransmitted( double distance, RandomDeviate& rand )
 		t= exp (-0.1106 * distance/1000);
 	}
 
-	if( rand.RandomDouble() < t  )	return true;
-	return false;
+	return t;
 }
@@ -64,10 +64,10 @@ TransmissivityVantHull::~TransmissivityVantHull()
 
 }
 
-bool TransmissivityVantHull::IsTransmitted( double distance, RandomDeviate& rand ) const
+double TransmissivityVantHull::Transmittance( double distance ) const
 {
 
-	if( distance == HUGE_VAL )	return false;
+	if( distance == HUGE_VAL )	return 0.0;
 
 	double R = distance/ 1000;
 	double beta = 3.912 / ( Visibility.getValue() / 1000 );
@@ -85,12 +85,6 @@ bool TransmissivityVantHull::IsTransmitted( double distance, RandomDeviate& rand
 	double C = C0 * pow( beta - 0.0037, S );
 
 	double e = C * exp( - A * ( Tower_Heigth.getValue() / 1000 ) );
-	if( pow( R, S ) == HUGE_VAL )	return true;
-	double t = exp( - e * pow( R, S ) );
-
-
-	if( rand.RandomDouble() <  t  )	return true;
-
-	return false;
-
+	if( pow( R, S ) == HUGE_VAL )	return 1.0;
+	return exp( - e * pow( R, S ) );
 }
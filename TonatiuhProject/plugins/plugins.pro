@@ -5,6 +5,7 @@ SUBDIRS =  ComponentHeliostatField \
 			MaterialBasicRefractive \
 			MaterialStandardSpecular \
             MaterialStandardRoughSpecular \
+            MaterialTabulatedSpecular \
             MaterialVirtual \
 			PhotonMapExportDB \
 			PhotonMapExportFile \
@@ -17,12 +18,14 @@ SUBDIRS =  ComponentHeliostatField \
 			ShapeFlatDisk \
 			ShapeFlatRectangle \
             ShapeFlatTriangle \
+            ShapeHeightField \
 			ShapeHyperboloid \
 			ShapeParabolicDish \
 			ShapeParabolicRectangle \
 			ShapeSphere \
 			ShapeSphericalPolygon \
             ShapeSphericalRectangle \
+            ShapeTriangleMesh \
             ShapeTroughAsymmetricCPC \
 			ShapeTroughCHC \
             ShapeTroughCPC \
@@ -31,6 +34,7 @@ SUBDIRS =  ComponentHeliostatField \
             ShapeTrumpet \
             SunshapeBuie \
 			SunshapePillbox \
+            SunshapeTabulated \
 			TrackerHeliostat \
             TrackerLinearFresnel \
 			TrackerOneAxis \
@@ -99,6 +99,7 @@ void TAnalyzerResultKit::PrepareCompute()
 {
 	analyzerResult = static_cast<TAnalyzerResult*> (getPart("result", false));
 	tshape = static_cast< TShape* >( getPart("shape", false) );
+	if( tshape )	tshape->PrepareForTrace();
 	analyzerResult->numRayIntersected=0;
 }
 
@@ -43,8 +43,12 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "BBox.h"
 #include "DifferentialGeometry.h"
+#include "InstanceBVH.h"
 #include "InstanceNode.h"
 #include "Ray.h"
+#include "RayBatch.h"
+#include "RayPacket.h"
+#include "SpectralWeights.h"
 #include "tgf.h"
 #include "TMaterial.h"
 #include "Transform.h"
@@ -58,11 +62,12 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 
 InstanceNode::InstanceNode( SoNode* node )
-: m_coinNode( node ), m_parent( 0 )
+: m_coinNode( node ), m_parent( 0 ), m_traceShape( 0 ), m_traceMaterial( 0 ), m_instanceBVH( 0 )
 {
 }
 
 InstanceNode::InstanceNode( const InstanceNode* node )
+: m_traceShape( 0 ), m_traceMaterial( 0 ), m_instanceBVH( 0 )
 {
    m_coinNode = node->m_coinNode;
    node->m_coinNode->ref();
@@ -78,6 +83,7 @@ InstanceNode::InstanceNode( const InstanceNode* node )
 InstanceNode::~InstanceNode()
 {
    qDeleteAll( children );
+   delete m_instanceBVH;
 }
 
 /**
@@ -123,79 +129,29 @@ void InstanceNode::InsertChild( int row, InstanceNode* instanceChild)
 
 
 //bool InstanceNode::Intersect( const Ray& ray, RandomDeviate& rand, InstanceNode** modelNode, Ray* outputRay )
-bool InstanceNode::Intersect( const Ray& ray, RandomDeviate& rand, bool* isShapeFront, InstanceNode** modelNode, Ray* outputRay )
+/*!
+ * Computes the closest intersection of the \a ray with the shapes under this node and the ray reflected by its material.
+ *
+ * If the ray intersects a shape, \a ray maxt is updated to the intersection distance, \a modelNode to the intersected
+ * shape node and \a isShapeFront to the intersected side. Returns true if the material of the intersected shape
+ * generates an output ray, that is stored in \a outputRay.
+ *
+ * The differential geometry and the output ray are computed only for the closest intersection.
+ *
+ * In spectral traces \a weights are the power of the ray in each band and are updated by the material, see
+ * TMaterial::OutputSpectralRay. The \a weights can be null for traces that are not spectral.
+ */
+bool InstanceNode::Intersect( const Ray& ray, RandomDeviate& rand, bool* isShapeFront, InstanceNode** modelNode, Ray* outputRay,
+		SpectralWeights* weights )
 {
+	InstanceNode* hitNode = 0;
+	ShapeHit hit;
+	if( !IntersectHit( ray, &hitNode, &hit ) ) return false;
 
-	//Check if the ray intersects with the BoundingBox
-   if( !m_bbox.IntersectP(ray) ) return false;
-   if( GetNode()->getTypeId().isDerivedFrom( TAnalyzerKit::getClassTypeId() ) ) return false;
-   if( !GetNode()->getTypeId().isDerivedFrom( TShapeKit::getClassTypeId() ) )
-   {
-
-      bool isOutputRay = false;
-      double t = ray.maxt;
-      for( int index = 0; index < children.size(); ++index )
-      {
-         InstanceNode* intersectedChild = 0;
-         Ray childOutputRay;
-         bool childShapreFront = true;
-         bool isChildOutputRay = children[index]->Intersect( ray, rand, &childShapreFront, &intersectedChild, &childOutputRay );
-
-         if( ray.maxt < t )
-         {
-            t = ray.maxt;
-            *modelNode = intersectedChild;
-            *isShapeFront = childShapreFront;
+	*modelNode = hitNode;
+	*isShapeFront = hit.shapeFrontSide;
 
-            *outputRay = childOutputRay;
-            isOutputRay = isChildOutputRay;
-
-         }
-      }
-
-      return isOutputRay;
-
-   }
-	else
-	{
-		Ray childCoordinatesRay( m_transformWTO( ray ) );
-
-		TShape* tshape = 0;
-		TMaterial* tmaterial = 0;
-		if( children[0]->GetNode()->getTypeId().isDerivedFrom( TShape::getClassTypeId() ) )
-		{
-			tshape = static_cast< TShape* >( children[0]->GetNode() );
-			if( children.size() > 1 )	tmaterial = static_cast< TMaterial* > ( children[1]->GetNode() );
-		}
-		else if(  children.count() > 1 )
-		{
-			tmaterial = static_cast< TMaterial* > ( children[0]->GetNode() );
-			tshape = static_cast< TShape* >( children[1]->GetNode() );
-		}
-
-		if( tshape )
-		{
-			 double thit = 0.0;
-			 DifferentialGeometry dg;
-			 if( !tshape->Intersect( childCoordinatesRay, &thit, &dg ) ) return false;
-
-			 ray.maxt = thit;
-			 *modelNode = this;
-
-			 *isShapeFront = dg.shapeFrontSide;
-
-			 if( tmaterial )
-			 {
-				 Ray surfaceOutputRay;
-				 if( tmaterial->OutputRay( childCoordinatesRay, &dg, rand, &surfaceOutputRay ) )
-				 {
-					 *outputRay = m_transformOTW( surfaceOutputRay );
-					 return true;
-				 }
-			}
-      }
-   }
-	return false;
+	return hitNode->OutputRay( ray, hit, rand, outputRay, weights );
 }
 
 void InstanceNode::Analyze(  std::vector<Ray> * raysWays, QMutex* mutex )
@@ -362,6 +318,34 @@ void InstanceNode::SetIntersectionTransform( Transform nodeTransform )
 	m_transformOTW = m_transformWTO.GetInverse();
 }
 
+/*!
+ * Sets the shape and the material used to compute the intersections of this shape node.
+ *
+ * They can be nodes of other instances equal to the shape and the material of this node, shared by all the
+ * instances during the ray tracing. trf::ComputeSceneTreeMap sets them before each ray tracing.
+ */
+void InstanceNode::SetTraceNodes( TShape* tshape, TMaterial* tmaterial )
+{
+	m_traceShape = tshape;
+	m_traceMaterial = tmaterial;
+}
+
+/*!
+ * Updates the bounding volume hierarchy over the shape instances under this node, used by the intersection
+ * functions instead of the node children.
+ *
+ * The instances bounding boxes and transforms must be computed. If the shape instances are the same of the
+ * previous update, the hierarchy is only refitted to the new bounding boxes.
+ */
+void InstanceNode::UpdateInstanceBVH()
+{
+	QVector< InstanceNode* > instances;
+	CollectShapeInstances( &instances );
+
+	if( !m_instanceBVH ) m_instanceBVH = new InstanceBVH;
+	m_instanceBVH->Update( instances );
+}
+
 QDataStream& operator<< ( QDataStream & s, const InstanceNode& node )
 {
 	s << node.GetNode();
@@ -441,3 +425,182 @@ template<class T,class Param1,class Param2> void InstanceNode::RecursivlyApplyWi
       }
 	}
 }
+
+/*!
+ * Finds for each ray of a packet the closest shape node under this node that the ray intersects.
+ *
+ * Only the \a numberOfActiveRays rays of \a rays whose indexes are in \a activeRays are tested. For each ray that
+ * intersects a shape closer than the ray maxt, maxt is updated to the intersection distance and \a hitNodes is
+ * updated to the intersected node. The bounding box of each node is tested once for all the rays and the shapes are
+ * intersected with TShape::IntersectBatch. The \a objectRays batch is used as working storage.
+ *
+ * The number of active rays must not be greater than RayPacket::m_maxPacketSize.
+ */
+void InstanceNode::IntersectPacket( const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays )
+{
+	if( m_instanceBVH )
+	{
+		m_instanceBVH->IntersectPacket( rays, activeRays, numberOfActiveRays, hitNodes, objectRays );
+		return;
+	}
+
+	if( GetNode()->getTypeId().isDerivedFrom( TAnalyzerKit::getClassTypeId() ) ) return;
+
+	//Select the rays that intersect with the BoundingBox
+	int boxRays[RayPacket::m_maxPacketSize];
+	int numberOfBoxRays = 0;
+	for( int r = 0; r < numberOfActiveRays; ++r )
+	{
+		if( m_bbox.IntersectP( rays[activeRays[r]] ) )
+		{
+			boxRays[numberOfBoxRays] = activeRays[r];
+			++numberOfBoxRays;
+		}
+	}
+	if( numberOfBoxRays < 1 ) return;
+
+	if( !GetNode()->getTypeId().isDerivedFrom( TShapeKit::getClassTypeId() ) )
+	{
+		for( int index = 0; index < children.size(); ++index )
+			children[index]->IntersectPacket( rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+		return;
+	}
+
+	TShape* tshape = 0;
+	TMaterial* tmaterial = 0;
+	GetShapeAndMaterial( &tshape, &tmaterial );
+	if( !tshape ) return;
+
+	objectRays->Resize( numberOfBoxRays );
+	for( int r = 0; r < numberOfBoxRays; ++r )
+		objectRays->SetRay( r, m_transformWTO( rays[boxRays[r]] ) );
+
+	double tHit[RayPacket::m_maxPacketSize];
+	bool isHit[RayPacket::m_maxPacketSize];
+	tshape->IntersectBatch( *objectRays, tHit, isHit );
+
+	for( int r = 0; r < numberOfBoxRays; ++r )
+	{
+		if( isHit[r] )
+		{
+			rays[boxRays[r]].maxt = tHit[r];
+			hitNodes[boxRays[r]] = this;
+		}
+	}
+}
+
+/*!
+ * Finds the closest intersection of the \a ray with the shapes under this node.
+ *
+ * The intersection is only computed for distances lower than \a ray maxt. If an intersection is found,
+ * ray maxt is updated to its distance, \a hitNode to the intersected shape node and \a hit to the intersection
+ * parameters. Otherwise, the arguments are not modified.
+ */
+bool InstanceNode::IntersectHit( const Ray& ray, InstanceNode** hitNode, ShapeHit* hit )
+{
+	if( m_instanceBVH ) return m_instanceBVH->IntersectHit( ray, hitNode, hit );
+
+	//Check if the ray intersects with the BoundingBox
+	if( !m_bbox.IntersectP(ray) ) return false;
+	if( GetNode()->getTypeId().isDerivedFrom( TAnalyzerKit::getClassTypeId() ) ) return false;
+	if( !GetNode()->getTypeId().isDerivedFrom( TShapeKit::getClassTypeId() ) )
+	{
+		bool isHit = false;
+		for( int index = 0; index < children.size(); ++index )
+		{
+			//Each child only finds intersections closer than the previous ones
+			if( children[index]->IntersectHit( ray, hitNode, hit ) ) isHit = true;
+		}
+		return isHit;
+	}
+
+	TShape* tshape = 0;
+	TMaterial* tmaterial = 0;
+	GetShapeAndMaterial( &tshape, &tmaterial );
+	if( !tshape ) return false;
+
+	Ray childCoordinatesRay( m_transformWTO( ray ) );
+
+	double thit = 0.0;
+	ShapeHit shapeHit;
+	if( !tshape->IntersectHit( childCoordinatesRay, &thit, &shapeHit ) ) return false;
+
+	ray.maxt = thit;
+	*hitNode = this;
+	*hit = shapeHit;
+	return true;
+}
+
+/*!
+ * Computes the ray that the material of this shape node generates for the \a ray intersection \a hit.
+ *
+ * The \a ray maxt must be the intersection distance. Only the differential geometry fields that the material needs are computed.
+ * Returns false if the node has not material or the material does not generate an output ray.
+ */
+bool InstanceNode::OutputRay( const Ray& ray, const ShapeHit& hit, RandomDeviate& rand, Ray* outputRay, SpectralWeights* weights ) const
+{
+	TShape* tshape = 0;
+	TMaterial* tmaterial = 0;
+	GetShapeAndMaterial( &tshape, &tmaterial );
+	if( !tshape || !tmaterial ) return false;
+
+	Ray childCoordinatesRay( m_transformWTO( ray ) );
+
+	DifferentialGeometry dg;
+	tshape->ComputeDifferentialGeometry( childCoordinatesRay, ray.maxt, hit, tmaterial->RequiredGeometry(), &dg );
+
+	Ray surfaceOutputRay;
+	if( weights && ( weights->nBands > 0 ) )
+	{
+		if( !tmaterial->OutputSpectralRay( childCoordinatesRay, &dg, rand, &surfaceOutputRay, weights ) ) return false;
+	}
+	else if( !tmaterial->OutputRay( childCoordinatesRay, &dg, rand, &surfaceOutputRay ) ) return false;
+
+	*outputRay = m_transformOTW( surfaceOutputRay );
+	return true;
+}
+
+/*!
+ * Appends to \a instances the shape nodes under this node that can be intersected. The nodes under analyzers and
+ * the shapes with an empty bounding box are not appended.
+ */
+void InstanceNode::CollectShapeInstances( QVector< InstanceNode* >* instances )
+{
+	if( GetNode()->getTypeId().isDerivedFrom( TAnalyzerKit::getClassTypeId() ) ) return;
+	if( GetNode()->getTypeId().isDerivedFrom( TShapeKit::getClassTypeId() ) )
+	{
+		if( m_traceShape && ( m_bbox.pMin.x <= m_bbox.pMax.x ) ) instances->push_back( this );
+		return;
+	}
+
+	for( int index = 0; index < children.size(); ++index )
+		children[index]->CollectShapeInstances( instances );
+}
+
+/*!
+ * Gets the shape and the material of a shape kit node. The pointers are not modified if the node has not them.
+ *
+ * If the trace nodes have been set, they are returned instead of the children nodes.
+ */
+void InstanceNode::GetShapeAndMaterial( TShape** tshape, TMaterial** tmaterial ) const
+{
+	if( m_traceShape )
+	{
+		*tshape = m_traceShape;
+		if( m_traceMaterial ) *tmaterial = m_traceMaterial;
+		return;
+	}
+
+	if( children.size() < 1 ) return;
+
+	if( children[0]->GetNode()->getTypeId().isDerivedFrom( TShape::getClassTypeId() ) )
+	{
+		*tshape = static_cast< TShape* >( children[0]->GetNode() );
+		if( children.size() > 1 )	*tmaterial = static_cast< TMaterial* > ( children[1]->GetNode() );
+	}
+	else if(  children.count() > 1 )
+	{
+		*tmaterial = static_cast< TMaterial* > ( children[0]->GetNode() );
+		*tshape = static_cast< TShape* >( children[1]->GetNode() );
+	}
+}
@@ -49,12 +49,18 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "BBox.h"
 #include "Transform.h"
 
+class InstanceBVH;
 class RandomDeviate;
 class Ray;
+class RayBatch;
 class SoNode;
 class TAnalyzerKit;
 class TLightKit;
 class SceneModel;
+struct ShapeHit;
+struct SpectralWeights;
+class TMaterial;
+class TShape;
 
 
 //!  InstanceNode class represents a instance of a node in the scene.
@@ -79,7 +85,10 @@ public:
     QString GetNodeURL() const;
     void Print( int level ) const;
 
-    bool Intersect( const Ray& ray, RandomDeviate& rand, bool* isShapeFront, InstanceNode** modelNode, Ray* outputRay );
+    bool Intersect( const Ray& ray, RandomDeviate& rand, bool* isShapeFront, InstanceNode** modelNode, Ray* outputRay,
+    		SpectralWeights* weights = 0 );
+    bool IntersectHit( const Ray& ray, InstanceNode** hitNode, ShapeHit* hit );
+    void IntersectPacket( const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays );
     void Analyze( std::vector<Ray>* raysWay, QMutex* mutex );
 	template<class T> void RecursivlyApply(void (T::*func)(void));
 	template<class T,class Param1> void RecursivlyApply(void (T::*func)(Param1),Param1 param1);
@@ -99,15 +108,24 @@ public:
     Transform GetIntersectionTransform();
     void SetIntersectionBBox( BBox nodeBBox );
     void SetIntersectionTransform( Transform nodeTransform );
+    void SetTraceNodes( TShape* tshape, TMaterial* tmaterial );
+    void UpdateInstanceBVH();
 
     QVector< InstanceNode* > children;
 
 private:
+    void CollectShapeInstances( QVector< InstanceNode* >* instances );
+    bool OutputRay( const Ray& ray, const ShapeHit& hit, RandomDeviate& rand, Ray* outputRay, SpectralWeights* weights ) const;
+    void GetShapeAndMaterial( TShape** tshape, TMaterial** tmaterial ) const;
+
     SoNode* m_coinNode;
     InstanceNode* m_parent;
     BBox m_bbox;
     Transform m_transformWTO;
     Transform m_transformOTW;
+    TShape* m_traceShape;
+    TMaterial* m_traceMaterial;
+    InstanceBVH* m_instanceBVH;
 };
 
 QDataStream & operator<< ( QDataStream & s, const InstanceNode& node );
@@ -120,6 +120,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "RayTracerNoTr.h"
 #include "SceneModel.h"
 #include "ScriptEditorDialog.h"
+#include "SpectralWeights.h"
 #include "SunPositionCalculatorDialog.h"
 #include "TComponentFactory.h"
 #include "TDefaultTracker.h"
@@ -181,6 +182,10 @@ m_selectedRandomDeviate( -1 ),
 m_bufferPhotons( 5000000 ),
 m_increasePhotonMap( false ),
 m_pExportModeSettings( 0 ),
+m_attenuationWeighting( false ),
+m_postTraceAttenuation( false ),
+m_packetSize( 1 ),
+m_sunBandFractions( "" ),
 m_pPhotonMap( 0 ),
 m_lastExportFileName( "" ),
 m_lastExportSurfaceUrl( "" ),
@@ -857,7 +862,8 @@ void MainWindow::ShowRayTracerOptionsDialog()
 			randomDeviateFactoryList, m_selectedRandomDeviate,
 			m_widthDivisions,m_heightDivisions,
 			m_drawRays, m_drawPhotons,
-			m_bufferPhotons, m_increasePhotonMap, this );
+			m_bufferPhotons, m_increasePhotonMap, m_attenuationWeighting, m_postTraceAttenuation, m_packetSize,
+			m_sunBandFractions, this );
 	options->exec();
 
 	SetRaysPerIteration( options->GetNumRays() );
@@ -866,6 +872,10 @@ void MainWindow::ShowRayTracerOptionsDialog()
 	SetRaysDrawingOptions( options->DrawRays(), options->DrawPhotons() );
 	SetPhotonMapBufferSize( options->GetPhotonMapBufferSize() );
 	SetIncreasePhotonMap( options->IncreasePhotonMap() );
+	SetAttenuationWeighting( options->AttenuationWeighting() );
+	SetPostTraceAttenuation( options->PostTraceAttenuation() );
+	SetPacketSize( options->GetPacketSize() );
+	SetSpectralBands( options->GetSunBandFractions() );
 
 }
 
@@ -1967,20 +1977,32 @@ void MainWindow::Run()
 		QMutex mutex;
 		QMutex mutexPhotonMap;
 		QFuture< void > photonMap;
+		std::vector< double > sunBandFractions = SpectralWeights::ReadBandFactors( m_sunBandFractions.toStdString().c_str() );
 		if( transmissivity )
-			 photonMap = QtConcurrent::map( raysPerThread, RayTracer(  rootSeparatorInstance,
+		{
+			RayTracer rayTracer( rootSeparatorInstance,
 							 lightInstance, raycastingSurface, sunShape, lightToWorld,
 							 transmissivity,
 							 *m_rand,
 							 &mutex, m_pPhotonMap, &mutexPhotonMap,
-							 exportSuraceList ) );
-
+							 exportSuraceList );
+			rayTracer.SetAttenuationWeighting( m_attenuationWeighting );
+			rayTracer.SetPostTraceAttenuation( m_postTraceAttenuation );
+			rayTracer.SetPacketSize( m_packetSize );
+			rayTracer.SetSpectralBands( sunBandFractions );
+			photonMap = QtConcurrent::map( raysPerThread, rayTracer );
+		}
 		else
-			photonMap = QtConcurrent::map( raysPerThread, RayTracerNoTr(  rootSeparatorInstance,
+		{
+			RayTracerNoTr rayTracer( rootSeparatorInstance,
 						lightInstance, raycastingSurface, sunShape, lightToWorld,
 						*m_rand,
 						&mutex, m_pPhotonMap, &mutexPhotonMap,
-						exportSuraceList ) );
+						exportSuraceList );
+			rayTracer.SetPacketSize( m_packetSize );
+			rayTracer.SetSpectralBands( sunBandFractions );
+			photonMap = QtConcurrent::map( raysPerThread, rayTracer );
+		}
 
 		futureWatcher.setFuture( photonMap );
 
@@ -2065,6 +2087,16 @@ void MainWindow::SetAimingPointRelative()
 	SetAimingPointRelativity( true );
 }
 
+/*!
+ * If \a attenuationAsWeight is true, the rays are not killed by the atmospheric attenuation. The power of each ray
+ * is multiplied by the transmitted fraction and the photons store it as the weight of the bands. Otherwise, the
+ * attenuated rays are killed.
+ */
+void MainWindow::SetAttenuationWeighting( bool attenuationAsWeight )
+{
+	m_attenuationWeighting = attenuationAsWeight;
+}
+
 /*!
  *Sets to export all surfaces photons.
  */
@@ -2180,6 +2212,15 @@ void MainWindow::SetNodeName( QString nodeName )
 	ChangeNodeName( m_selectionModel->currentIndex(), nodeName );
 }
 
+/*!
+ * Sets the number of primary rays that the ray tracer intersects together as a packet to \a packetSize.
+ * If \a packetSize is 1, each ray is traced alone.
+ */
+void MainWindow::SetPacketSize( int packetSize )
+{
+	m_packetSize = packetSize;
+}
+
 /*!
  *Sets the number of photons that the photon map can store to \a nPhotons.
  */
@@ -2188,6 +2229,16 @@ void MainWindow::SetPhotonMapBufferSize( unsigned int nPhotons )
 	m_bufferPhotons = nPhotons;
 }
 
+/*!
+ * If \a postTraceAttenuation is true, the rays are not attenuated by the atmosphere during the trace and the
+ * exported photons always store their path length, so that the attenuation is applied to them afterwards with
+ * trf::ComputeAttenuationFactors. Otherwise, the rays are attenuated while they are traced.
+ */
+void MainWindow::SetPostTraceAttenuation( bool postTraceAttenuation )
+{
+	m_postTraceAttenuation = postTraceAttenuation;
+}
+
 /*!
  *Sets the random number generator type, \a typeName, for ray tracing.
  */
@@ -2244,6 +2295,16 @@ void MainWindow::SetRaysPerIteration( unsigned int rays )
 	m_raysPerIteration = rays;
 }
 
+/*!
+ * Sets the fractions of the sun power in each wavelength band for spectral traces. The values of \a sunBandFractions
+ * are separated by spaces, commas or semicolons. The geometry is traced once for all the bands and the photons store
+ * the weight of each band. An empty \a sunBandFractions disables the spectral trace.
+ */
+void MainWindow::SetSpectralBands( QString sunBandFractions )
+{
+	m_sunBandFractions = sunBandFractions;
+}
+
 /*!
  *	Set selected sunshape, \a sunshapeType, to the sun.
  */
@@ -3002,6 +3063,9 @@ PhotonMapExport* MainWindow::CreatePhotonMapExport() const
         ++i;
     }
 
+    // The attenuation of the photons traced without it is computed afterwards from their path lengths
+    if( m_postTraceAttenuation )	pExportMode->SetSavePathLengthEnabled( true );
+
     pExportMode->SetSceneModel( *m_sceneModel );
 
 	return pExportMode;
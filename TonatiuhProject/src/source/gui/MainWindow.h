@@ -123,6 +123,7 @@ public slots:
     void SelectNode( QString nodeUrl );
 	void SetAimingPointAbsolute();
 	void SetAimingPointRelative();
+    void SetAttenuationWeighting( bool attenuationAsWeight );
 	void SetExportAllPhotonMap();
 	void SetExportCoordinates( bool enabled, bool global );
 	void SetExportIntesectionSurface( bool enabled );
@@ -132,11 +133,14 @@ public slots:
 	void SetExportTypeParameterValue( QString parameterName, QString parameterValue );
     void SetIncreasePhotonMap( bool increase );
     void SetNodeName( QString nodeName );
+    void SetPacketSize( int packetSize );
     void SetPhotonMapBufferSize( unsigned int nPhotons );
+    void SetPostTraceAttenuation( bool postTraceAttenuation );
     void SetRandomDeviateType( QString typeName );
     void SetRayCastingGrid( int widthDivisions, int heightDivisions );
     void SetRaysDrawingOptions( bool drawRays, bool drawPhotons );
     void SetRaysPerIteration( unsigned int rays );
+    void SetSpectralBands( QString sunBandFractions );
     void SetSunshape( QString sunshapeType );
     void SetSunshapeParameter( QString parameter, QString value );
     void SetTransmissivity( QString transmissivityType );
@@ -284,6 +288,10 @@ private:
     unsigned long m_bufferPhotons;
     bool m_increasePhotonMap;
     PhotonMapExportSettings* m_pExportModeSettings;
+    bool m_attenuationWeighting;
+    bool m_postTraceAttenuation;
+    int m_packetSize;
+    QString m_sunBandFractions;
     TPhotonMap* m_pPhotonMap;
 
     QString m_lastExportFileName;
@@ -50,13 +50,17 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
  */
 RayTraceDialog::RayTraceDialog( QWidget * parent, Qt::WindowFlags f )
 :QDialog ( parent, f ),
+ m_attenuationWeighting( false ),
  m_drawPhotons( false ),
  m_drawRays( false ),
  m_heightDivisions( 200 ),
  m_increasePhotonMap( false ),
  m_numRays( 0 ),
+ m_packetSize( 1 ),
  m_photonMapBufferSize( 1000000 ),
+ m_postTraceAttenuation( false ),
  m_selectedRandomFactory( -1 ),
+ m_sunBandFractions( QLatin1String( "" ) ),
  m_widthDivisions( 200 )
 {
 	setupUi( this );
@@ -68,21 +72,31 @@ RayTraceDialog::RayTraceDialog( QWidget * parent, Qt::WindowFlags f )
  * Creates a dialog to ray tracer options with the given \a parent and \a f flags.
  *
  * The variables take the values specified by \a numRats, \a faction, \a drawPhotons and \a increasePhotonMap.
+ * If \a attenuationWeighting is true, the atmospheric attenuation multiplies the power of the rays instead of killing them.
+ * If \a postTraceAttenuation is true, the atmospheric attenuation is applied to the exported photons after the trace.
+ * The primary rays are intersected in packets of \a packetSize rays.
+ * If \a sunBandFractions is not empty, the trace is spectral with the fractions of the sun power in each band.
  */
 RayTraceDialog::RayTraceDialog( int numRays,
 		QVector< RandomDeviateFactory* > randomFactoryList, int selectedRandomFactory,
 		int widthDivisions, int heightDivisions,
 		bool drawRays, bool drawPhotons,
 		int photonMapSize, bool increasePhotonMap,
+		bool attenuationWeighting, bool postTraceAttenuation, int packetSize,
+		QString sunBandFractions,
 		QWidget * parent, Qt::WindowFlags f )
 :QDialog ( parent, f ),
+ m_attenuationWeighting( attenuationWeighting ),
  m_drawPhotons( drawPhotons ),
  m_drawRays( drawRays ),
  m_heightDivisions( heightDivisions ),
  m_increasePhotonMap( increasePhotonMap ),
  m_numRays( numRays ),
+ m_packetSize( packetSize ),
  m_photonMapBufferSize( photonMapSize ),
+ m_postTraceAttenuation( postTraceAttenuation ),
  m_selectedRandomFactory( selectedRandomFactory ),
+ m_sunBandFractions( sunBandFractions ),
  m_widthDivisions( widthDivisions )
 {
 	setupUi( this );
@@ -108,6 +122,11 @@ RayTraceDialog::RayTraceDialog( int numRays,
 	else
 		newMapRadio->setChecked( true );
 
+	attenuationWeightingCheck->setChecked( m_attenuationWeighting );
+	postTraceAttenuationCheck->setChecked( m_postTraceAttenuation );
+	packetSizeSpinBox->setValue( m_packetSize );
+	sunBandFractionsLineEdit->setText( m_sunBandFractions );
+
 	connect( this, SIGNAL( accepted() ), this, SLOT( saveChanges() ) );
 	connect( buttonBox, SIGNAL( clicked( QAbstractButton* ) ), this, SLOT( applyChanges( QAbstractButton* ) ) );
 }
@@ -120,6 +139,14 @@ RayTraceDialog::~RayTraceDialog()
 
 }
 
+/*!
+ * Returns if the atmospheric attenuation multiplies the power of the rays instead of killing them.
+ */
+bool RayTraceDialog::AttenuationWeighting() const
+{
+	return m_attenuationWeighting;
+}
+
 /**
  * Returns if the photons are going to be represented.
  */
@@ -152,6 +179,14 @@ int RayTraceDialog::GetNumRays() const
 	return m_numRays;
 }
 
+/*!
+ * Returns the number of primary rays that are intersected together as a packet.
+ */
+int RayTraceDialog::GetPacketSize() const
+{
+	return m_packetSize;
+}
+
 /*!
  * Returns maximum number of photons that the photonmap buffer can save.
  */
@@ -168,6 +203,14 @@ int RayTraceDialog::GetRandomDeviateFactoryIndex() const
 	return m_selectedRandomFactory;
 }
 
+/*!
+ * Returns the fractions of the sun power in each band for spectral traces. It is empty if the trace is not spectral.
+ */
+QString RayTraceDialog::GetSunBandFractions() const
+{
+	return m_sunBandFractions;
+}
+
 /**
  * Returns the the width divisions applied to the sun shape.
  */
@@ -184,6 +227,14 @@ bool RayTraceDialog::IncreasePhotonMap() const
 	return m_increasePhotonMap;
 }
 
+/*!
+ * Returns if the atmospheric attenuation is applied to the exported photons after the trace instead of during the trace.
+ */
+bool RayTraceDialog::PostTraceAttenuation() const
+{
+	return m_postTraceAttenuation;
+}
+
 /**
  * If the applyChanges button is clicked the dialog values are saved.
  */
@@ -211,5 +262,10 @@ void RayTraceDialog::saveChanges()
 		m_increasePhotonMap = false;
 	else
 		m_increasePhotonMap = true;
+
+	m_attenuationWeighting = attenuationWeightingCheck->isChecked();
+	m_postTraceAttenuation = postTraceAttenuationCheck->isChecked();
+	m_packetSize = packetSizeSpinBox->value();
+	m_sunBandFractions = sunBandFractionsLineEdit->text();
 }
 
@@ -66,30 +66,40 @@ public:
 			int widthDivisions = 200,int heightDivisions = 200,
 			bool drawRays = true, bool drawPhotons = false,
 			int photonMapSize = 1000000, bool increasePhotonMap = false,
+			bool attenuationWeighting = false, bool postTraceAttenuation = false, int packetSize = 1,
+			QString sunBandFractions = QString(),
 				QWidget * parent = 0, Qt::WindowFlags f = 0 );
     ~RayTraceDialog();
 
+    bool AttenuationWeighting() const;
     bool DrawPhotons() const;
     bool DrawRays() const;
     int GetHeightDivisions() const;
     int GetNumRays() const;
+    int GetPacketSize() const;
     int GetPhotonMapBufferSize() const;
     int GetRandomDeviateFactoryIndex() const;
+    QString GetSunBandFractions() const;
     int GetWidthDivisions() const;
     bool IncreasePhotonMap() const;;
+    bool PostTraceAttenuation() const;
 
 public slots:
 	void applyChanges( QAbstractButton* button );
 	void saveChanges();
 
 private:
+	bool m_attenuationWeighting; /*!<This property holds whether the atmospheric attenuation is traced as a weight of the rays. */
 	bool m_drawPhotons;  /*!<This property holds whether photons are going to be drawn. */
 	bool m_drawRays;  /*!<This property holds whether rays are going to be drawn. */
 	int m_heightDivisions; /*!<number of height divisions in the sun*/
 	bool m_increasePhotonMap; /*!<This property holds whether traced phtons are going to added to the old photon map. */
 	int m_numRays; /*!< Number of rays to trace. */
+	int m_packetSize; /*!< Number of primary rays intersected together as a packet. */
     int m_photonMapBufferSize; /*!< Maximum number of photons int the PhotonMap. */
+	bool m_postTraceAttenuation; /*!<This property holds whether the atmospheric attenuation is applied after the trace. */
 	int m_selectedRandomFactory; /*!< The index of factory selected from TPhotonMapFactory list. */
+	QString m_sunBandFractions; /*!< Fractions of the sun power in each band for spectral traces. */
 	int m_widthDivisions; /*number of width divisions in the sun*/
 
 };
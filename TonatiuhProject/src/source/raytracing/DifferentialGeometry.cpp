@@ -39,8 +39,14 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "DifferentialGeometry.h"
 #include "TShape.h"
 
+ShapeHit::ShapeHit()
+: u(0.0), v(0.0), shapeFrontSide(true)
+{
+
+}
+
 DifferentialGeometry::DifferentialGeometry()
-: u(0.0), v(0.0), pShape(0)
+: u(0.0), v(0.0), pShape(0), shapeFrontSide(true)
 {
 
 }
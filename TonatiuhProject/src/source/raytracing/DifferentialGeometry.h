@@ -47,8 +47,38 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 class TShape;
 
+/*!
+ * Parametric information of a ray/shape intersection.
+ *
+ * Is the cheap part of the intersection computed by TShape::IntersectHit: the surface parameters,
+ * the tangents used to know the intersected side and the side. The complete DifferentialGeometry
+ * is computed later only for the closest hit.
+ */
+struct ShapeHit
+{
+    ShapeHit( );
+
+    double u;
+    double v;
+    Vector3D dpdu;
+    Vector3D dpdv;
+    bool shapeFrontSide;
+};
+
 struct DifferentialGeometry
 {
+	/*!
+	 * Groups of values that TShape::ComputeDifferentialGeometry computes.
+	 * The point, parameters, shape and side are always computed. SURFACE_TANGENTS
+	 * are dpdu, dpdv and the normal, NORMAL_DERIVATIVES are dndu and dndv.
+	 */
+	enum GeometryFields{
+		POINT_ONLY = 0x0,
+		SURFACE_TANGENTS = 0x1,
+		NORMAL_DERIVATIVES = 0x2,
+		ALL_FIELDS = 0x3
+	};
+
     DifferentialGeometry( );
 	DifferentialGeometry( const Point3D& P, const Vector3D& DPDU,
 			const Vector3D& DPDV, const Vector3D& DNDU,
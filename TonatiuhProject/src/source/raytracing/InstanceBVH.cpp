@@ -0,0 +1,452 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+
+#include "gc.h"
+#include "InstanceBVH.h"
+#include "InstanceNode.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Vector3D.h"
+
+/*!
+ * Returns the surface area of \a bbox.
+ */
+static double SurfaceArea( const BBox& bbox )
+{
+	if( bbox.pMin.x > bbox.pMax.x ) return 0.0;
+	Vector3D d = bbox.pMax - bbox.pMin;
+	return 2.0 * ( d.x * d.y + d.x * d.z + d.y * d.z );
+}
+
+/*!
+ * Returns the bin, out of \a nBins equal bins over [ \a cMin, \a cMin + \a cExtent ], for the centroid coordinate \a c.
+ */
+static int CentroidBin( double c, double cMin, double cExtent, int nBins )
+{
+	int b = int( nBins * ( c - cMin ) / cExtent );
+	return ( b < nBins ) ? b : nBins - 1;
+}
+
+/*!
+ * Orders instances by the \a axis coordinate of their bounding box centroids.
+ */
+struct InstanceCentroidLess
+{
+	InstanceCentroidLess( const std::vector< Point3D >& centroids, int axis )
+	:m_centroids( centroids ), m_axis( axis )
+	{
+	}
+
+	bool operator()( int a, int b ) const
+	{
+		return m_centroids[a][m_axis] < m_centroids[b][m_axis];
+	}
+
+	const std::vector< Point3D >& m_centroids;
+	int m_axis;
+};
+
+/*!
+ * Selects the instances whose centroid falls in the bins up to \a split.
+ */
+struct InstanceBinPredicate
+{
+	InstanceBinPredicate( const std::vector< Point3D >& centroids, int axis, double cMin, double cExtent, int nBins, int split )
+	:m_centroids( centroids ), m_axis( axis ), m_cMin( cMin ), m_cExtent( cExtent ), m_nBins( nBins ), m_split( split )
+	{
+	}
+
+	bool operator()( int instance ) const
+	{
+		return CentroidBin( m_centroids[instance][m_axis], m_cMin, m_cExtent, m_nBins ) <= m_split;
+	}
+
+	const std::vector< Point3D >& m_centroids;
+	int m_axis;
+	double m_cMin;
+	double m_cExtent;
+	int m_nBins;
+	int m_split;
+};
+
+/*!
+ * Creates an empty hierarchy.
+ */
+InstanceBVH::InstanceBVH()
+{
+
+}
+
+InstanceBVH::~InstanceBVH()
+{
+
+}
+
+/*!
+ * Removes all the instances of the hierarchy.
+ */
+void InstanceBVH::Clear()
+{
+	m_sceneInstances.clear();
+	m_instances.clear();
+	m_nodes.clear();
+}
+
+/*!
+ * Updates the hierarchy for the shape \a instances, whose bounding boxes and transforms must be computed.
+ *
+ * If the instances are the same of the previous update, the nodes are kept and only their bounding boxes are
+ * computed again. Otherwise, the hierarchy is built again.
+ */
+void InstanceBVH::Update( const QVector< InstanceNode* >& instances )
+{
+	if( !m_nodes.empty() && ( instances == m_sceneInstances ) )
+	{
+		Refit();
+		return;
+	}
+
+	m_sceneInstances = instances;
+	Build();
+}
+
+/*!
+ * Returns the number of instances of the hierarchy.
+ */
+int InstanceBVH::NumberOfInstances() const
+{
+	return int( m_instances.size() );
+}
+
+/*!
+ * Finds the closest intersection of the \a ray with the instances of the hierarchy.
+ *
+ * The intersection is only computed for distances lower than \a ray maxt. If an intersection is found,
+ * ray maxt is updated to its distance, \a hitNode to the intersected shape node and \a hit to the intersection
+ * parameters. Otherwise, the arguments are not modified.
+ */
+bool InstanceBVH::IntersectHit( const Ray& ray, InstanceNode** hitNode, ShapeHit* hit ) const
+{
+	if( m_nodes.empty() ) return false;
+
+	const Vector3D& invDirection = ray.invDirection();
+	const bool dirIsNeg[3] = { invDirection.x < 0.0, invDirection.y < 0.0, invDirection.z < 0.0 };
+
+	bool isHit = false;
+	int stack[m_maxTraversalDepth];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	while( true )
+	{
+		const BVHNode& node = m_nodes[nodeIndex];
+		if( IntersectNodeBox( node, ray ) )
+		{
+			if( node.nInstances > 0 )
+			{
+				//Each instance only finds intersections closer than the previous ones
+				for( int i = 0; i < node.nInstances; ++i )
+					if( m_instances[node.offset + i]->IntersectHit( ray, hitNode, hit ) ) isHit = true;
+
+				if( stackSize == 0 ) break;
+				nodeIndex = stack[--stackSize];
+			}
+			else
+			{
+				// Visit first the child closest to the ray origin
+				if( dirIsNeg[node.axis] )
+				{
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					nodeIndex = nodeIndex + 1;
+				}
+			}
+		}
+		else
+		{
+			if( stackSize == 0 ) break;
+			nodeIndex = stack[--stackSize];
+		}
+	}
+
+	return isHit;
+}
+
+/*!
+ * Finds for each ray of a packet the closest instance of the hierarchy that the ray intersects.
+ *
+ * The arguments are the same of InstanceNode::IntersectPacket. Each node bounding box is tested once for all
+ * the active rays and the instances of the leaves are intersected with InstanceNode::IntersectPacket.
+ */
+void InstanceBVH::IntersectPacket( const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays ) const
+{
+	if( m_nodes.empty() || numberOfActiveRays < 1 ) return;
+	IntersectPacketNode( 0, rays, activeRays, numberOfActiveRays, hitNodes, objectRays );
+}
+
+/*!
+ * Builds the hierarchy nodes for the scene instances.
+ */
+void InstanceBVH::Build()
+{
+	m_instances.clear();
+	m_nodes.clear();
+
+	const int nInstances = m_sceneInstances.size();
+	if( nInstances < 1 ) return;
+
+	std::vector< BBox > instanceBounds( nInstances );
+	std::vector< Point3D > centroids( nInstances );
+	std::vector< int > order( nInstances );
+	for( int i = 0; i < nInstances; ++i )
+	{
+		instanceBounds[i] = m_sceneInstances[i]->GetIntersectionBBox();
+		centroids[i] = instanceBounds[i].pMin + ( instanceBounds[i].pMax - instanceBounds[i].pMin ) * 0.5;
+		order[i] = i;
+	}
+
+	m_nodes.reserve( 2 * nInstances / m_maxInstancesInLeaf + 1 );
+	BuildNode( 0, nInstances, &order, instanceBounds, centroids, 0 );
+
+	m_instances.resize( nInstances );
+	for( int i = 0; i < nInstances; ++i )
+		m_instances[i] = m_sceneInstances[ order[i] ];
+}
+
+/*!
+ * Computes again the bounding boxes of the nodes from the current instances bounding boxes.
+ *
+ * The children of a node are stored after it, so the nodes are visited from the last one.
+ */
+void InstanceBVH::Refit()
+{
+	for( int nodeIndex = int( m_nodes.size() ) - 1; nodeIndex >= 0; --nodeIndex )
+	{
+		BVHNode& node = m_nodes[nodeIndex];
+		if( node.nInstances > 0 )
+		{
+			BBox bounds;
+			for( int i = 0; i < node.nInstances; ++i )
+				bounds = Union( bounds, m_instances[node.offset + i]->GetIntersectionBBox() );
+			for( int j = 0; j < 3; ++j )
+			{
+				node.bMin[j] = bounds.pMin[j];
+				node.bMax[j] = bounds.pMax[j];
+			}
+		}
+		else
+		{
+			const BVHNode& firstChild = m_nodes[nodeIndex + 1];
+			const BVHNode& secondChild = m_nodes[node.offset];
+			for( int j = 0; j < 3; ++j )
+			{
+				node.bMin[j] = std::min( firstChild.bMin[j], secondChild.bMin[j] );
+				node.bMax[j] = std::max( firstChild.bMax[j], secondChild.bMax[j] );
+			}
+		}
+	}
+}
+
+/*!
+ * Creates the node for the instances between \a first and \a last in \a order and, for interior nodes, its
+ * children. Returns the node index.
+ */
+int InstanceBVH::BuildNode( int first, int last, std::vector< int >* order,
+		const std::vector< BBox >& instanceBounds, const std::vector< Point3D >& centroids, int depth )
+{
+	const int nodeIndex = int( m_nodes.size() );
+	m_nodes.push_back( BVHNode() );
+
+	BBox bounds;
+	BBox centroidBounds;
+	for( int i = first; i < last; ++i )
+	{
+		bounds = Union( bounds, instanceBounds[ (*order)[i] ] );
+		centroidBounds = Union( centroidBounds, centroids[ (*order)[i] ] );
+	}
+	for( int j = 0; j < 3; ++j )
+	{
+		m_nodes[nodeIndex].bMin[j] = bounds.pMin[j];
+		m_nodes[nodeIndex].bMax[j] = bounds.pMax[j];
+	}
+
+	const int nInstances = last - first;
+	if( nInstances <= m_maxInstancesInLeaf )
+	{
+		m_nodes[nodeIndex].offset = first;
+		m_nodes[nodeIndex].nInstances = nInstances;
+		m_nodes[nodeIndex].axis = 0;
+		return nodeIndex;
+	}
+
+	const int axis = centroidBounds.MaximumExtent();
+	const double cMin = centroidBounds.pMin[axis];
+	const double cExtent = centroidBounds.pMax[axis] - cMin;
+
+	int middle = first;
+	if( cExtent > 0.0 && depth < 32 )
+	{
+		int binCount[m_numberOfBins];
+		BBox binBounds[m_numberOfBins];
+		for( int b = 0; b < m_numberOfBins; ++b ) binCount[b] = 0;
+		for( int i = first; i < last; ++i )
+		{
+			int b = CentroidBin( centroids[ (*order)[i] ][axis], cMin, cExtent, m_numberOfBins );
+			binCount[b]++;
+			binBounds[b] = Union( binBounds[b], instanceBounds[ (*order)[i] ] );
+		}
+
+		// Cost of splitting after each bin, sweeping from the right
+		double rightCost[m_numberOfBins];
+		BBox rightBounds;
+		int rightCount = 0;
+		for( int b = m_numberOfBins - 1; b > 0; --b )
+		{
+			rightBounds = Union( rightBounds, binBounds[b] );
+			rightCount += binCount[b];
+			rightCost[b - 1] = rightCount * SurfaceArea( rightBounds );
+		}
+
+		int bestSplit = -1;
+		double bestCost = gc::Infinity;
+		BBox leftBounds;
+		int leftCount = 0;
+		for( int b = 0; b < m_numberOfBins - 1; ++b )
+		{
+			leftBounds = Union( leftBounds, binBounds[b] );
+			leftCount += binCount[b];
+			if( leftCount == 0 || leftCount == nInstances ) continue;
+			double cost = leftCount * SurfaceArea( leftBounds ) + rightCost[b];
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+
+		if( bestSplit >= 0 )
+		{
+			std::vector< int >::iterator split = std::partition( order->begin() + first, order->begin() + last,
+					InstanceBinPredicate( centroids, axis, cMin, cExtent, m_numberOfBins, bestSplit ) );
+			middle = int( split - order->begin() );
+		}
+	}
+
+	if( middle <= first || middle >= last )
+	{
+		middle = ( first + last ) / 2;
+		std::nth_element( order->begin() + first, order->begin() + middle, order->begin() + last,
+				InstanceCentroidLess( centroids, axis ) );
+	}
+
+	BuildNode( first, middle, order, instanceBounds, centroids, depth + 1 );
+	const int secondChild = BuildNode( middle, last, order, instanceBounds, centroids, depth + 1 );
+
+	m_nodes[nodeIndex].offset = secondChild;
+	m_nodes[nodeIndex].nInstances = 0;
+	m_nodes[nodeIndex].axis = axis;
+	return nodeIndex;
+}
+
+/*!
+ * Intersects the active rays that hit the bounds of the node \a nodeIndex with the instances under the node.
+ */
+void InstanceBVH::IntersectPacketNode( int nodeIndex, const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays ) const
+{
+	const BVHNode& node = m_nodes[nodeIndex];
+
+	int boxRays[RayPacket::m_maxPacketSize];
+	int numberOfBoxRays = 0;
+	for( int r = 0; r < numberOfActiveRays; ++r )
+	{
+		if( IntersectNodeBox( node, rays[activeRays[r]] ) )
+		{
+			boxRays[numberOfBoxRays] = activeRays[r];
+			++numberOfBoxRays;
+		}
+	}
+	if( numberOfBoxRays < 1 ) return;
+
+	if( node.nInstances > 0 )
+	{
+		for( int i = 0; i < node.nInstances; ++i )
+			m_instances[node.offset + i]->IntersectPacket( rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+		return;
+	}
+
+	// The rays of a packet are coherent, the first one selects the child closest to the rays origin
+	if( rays[boxRays[0]].invDirection()[node.axis] < 0.0 )
+	{
+		IntersectPacketNode( node.offset, rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+		IntersectPacketNode( nodeIndex + 1, rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+	}
+	else
+	{
+		IntersectPacketNode( nodeIndex + 1, rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+		IntersectPacketNode( node.offset, rays, boxRays, numberOfBoxRays, hitNodes, objectRays );
+	}
+}
+
+/*!
+ * Returns true if \a ray intersects the bounds of \a node between its minimum and maximum parameters.
+ */
+bool InstanceBVH::IntersectNodeBox( const BVHNode& node, const Ray& ray ) const
+{
+	const Vector3D& invDirection = ray.invDirection();
+	double t0 = ray.mint;
+	double t1 = ray.maxt;
+	for( int i = 0; i < 3; ++i )
+	{
+		double tNear = ( node.bMin[i] - ray.origin[i] ) * invDirection[i];
+		double tFar = ( node.bMax[i] - ray.origin[i] ) * invDirection[i];
+		if( tNear > tFar ) std::swap( tNear, tFar );
+
+		// Keep the rays that hit the box boundary despite rounding errors
+		tFar *= 1.0 + 1e-12;
+		t0 = tNear > t0 ? tNear : t0;
+		t1 = tFar < t1 ? tFar : t1;
+		if( t0 > t1 ) return false;
+	}
+	return true;
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef INSTANCEBVH_H_
+#define INSTANCEBVH_H_
+
+#include <vector>
+
+#include <QVector>
+
+#include "BBox.h"
+
+class InstanceNode;
+class Ray;
+class RayBatch;
+struct ShapeHit;
+
+//!  InstanceBVH class is a bounding volume hierarchy over the shape instances of a scene.
+/*!
+ * The hierarchy is the top level of the scene intersection: its leaves are shape InstanceNode objects, that
+ * transform the rays to the shape coordinates and intersect them with the shape, so that each shape keeps its
+ * own acceleration structure. The hierarchy is built with the binned surface area heuristic over the instances
+ * world bounding boxes.
+ *
+ * When the scene only changes the instances transforms, as the trackers do when the sun moves, Update keeps the
+ * hierarchy nodes and only recomputes their bounding boxes.
+ */
+class InstanceBVH
+{
+public:
+	InstanceBVH();
+	~InstanceBVH();
+
+	void Clear();
+	void Update( const QVector< InstanceNode* >& instances );
+	int NumberOfInstances() const;
+
+	bool IntersectHit( const Ray& ray, InstanceNode** hitNode, ShapeHit* hit ) const;
+	void IntersectPacket( const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays ) const;
+
+private:
+	struct BVHNode
+	{
+		double bMin[3];
+		double bMax[3];
+		int offset;		// First instance for leaves, second child for interior nodes
+		int nInstances;	// Zero for interior nodes
+		int axis;
+	};
+
+	enum { m_maxInstancesInLeaf = 2, m_numberOfBins = 16, m_maxTraversalDepth = 64 };
+
+	void Build();
+	void Refit();
+	int BuildNode( int first, int last, std::vector< int >* order,
+			const std::vector< BBox >& instanceBounds, const std::vector< Point3D >& centroids, int depth );
+	void IntersectPacketNode( int nodeIndex, const Ray* rays, const int* activeRays, int numberOfActiveRays, InstanceNode** hitNodes, RayBatch* objectRays ) const;
+	bool IntersectNodeBox( const BVHNode& node, const Ray& ray ) const;
+
+	QVector< InstanceNode* > m_sceneInstances;
+	std::vector< InstanceNode* > m_instances;	// Instances in BVH order
+	std::vector< BVHNode > m_nodes;
+};
+
+#endif /* INSTANCEBVH_H_ */
@@ -43,18 +43,18 @@ Photon::Photon( )
 
 }
 
-Photon::Photon( const Photon& photon )
-:id( photon.id ), pos( photon.pos ), side( photon.side ), intersectedSurface( photon.intersectedSurface )
+/*!
+ * Creates a photon at \a pos. The \a pathLength is the length of the ray segment that arrives to the photon through the
+ * atmosphere, 0 for the segments that are not attenuated, so that the atmospheric attenuation can be computed after the trace.
+ */
+Photon::Photon( const Point3D& pos, int side, int id, InstanceNode* intersectedSurface, double pathLength )
+:intersectedSurface( intersectedSurface ),
+ x( float( pos.x ) ),
+ y( float( pos.y ) ),
+ z( float( pos.z ) ),
+ pathLength( float( pathLength ) ),
+ id( static_cast< unsigned short >( id ) ),
+ side( static_cast< unsigned char >( side ) )
 {
 
 }
-
-Photon::Photon( Point3D pos, int side, double id, InstanceNode* intersectedSurface  )
-:id(id), pos(pos), side( side ), intersectedSurface( intersectedSurface )
-{
-
-}
-
-Photon::~Photon()
-{
-}
@@ -42,17 +42,28 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "InstanceNode.h"
 #include "Point3D.h"
 
+/*!
+ * Photon record of the photon map.
+ *
+ * The record is trivially copyable, so the buffers of photons are copied as plain memory. The position is stored
+ * in world coordinates with single precision and \a id is the depth of the photon in its ray, 0 for the photons
+ * of the light. The band weights of the spectral traces are stored apart by PhotonArena.
+ */
 struct Photon
 {
 	Photon( );
-	Photon( const Photon& photon );
-	Photon( Point3D pos, int side, double id = 0, InstanceNode* intersectedSurface = 0 );
-	~Photon();
+	Photon( const Point3D& pos, int side, int id = 0, InstanceNode* intersectedSurface = 0, double pathLength = 0.0 );
+
+	//! Returns the position of the photon in world coordinates.
+	Point3D Position() const { return Point3D( x, y, z ); }
 
-	double id;
-	Point3D pos;
-	int side;
 	InstanceNode* intersectedSurface;
+	float x;
+	float y;
+	float z;
+	float pathLength;
+	unsigned short id;
+	unsigned char side;
 };
 
 #endif /*PHOTON_H_*/
@@ -0,0 +1,135 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+
+#include "PhotonArena.h"
+
+/*!
+ * Creates an empty arena.
+ */
+PhotonArena::PhotonArena()
+:m_size( 0 )
+{
+
+}
+
+/*!
+ * Destroys the arena and releases the memory of all the chunks.
+ */
+PhotonArena::~PhotonArena()
+{
+	for( unsigned int c = 0; c < m_chunks.size(); ++c )
+	{
+		delete[] m_chunks[c];
+		delete[] m_weightChunks[c];
+	}
+}
+
+/*!
+ * Adds the \a photon at the end of the arena. The \a bandWeights are only stored if they have bands.
+ */
+void PhotonArena::Add( const Photon& photon, const SpectralWeights& bandWeights )
+{
+	AppendRange( &photon, ( bandWeights.nBands > 0 ) ? &bandWeights : 0, 1 );
+}
+
+/*!
+ * Copies the \a photons at the end of the arena. The photons have no band weights.
+ */
+void PhotonArena::Append( const std::vector< Photon >& photons )
+{
+	if( !photons.empty() )	AppendRange( &photons[0], 0, photons.size() );
+}
+
+/*!
+ * Copies the photons of the arena \a photons, with their band weights, at the end of this arena.
+ */
+void PhotonArena::Append( const PhotonArena& photons )
+{
+	for( unsigned int c = 0; c < photons.m_chunks.size(); ++c )
+	{
+		unsigned long chunkStart = c * (unsigned long) m_chunkSize;
+		if( chunkStart >= photons.m_size )	break;
+
+		unsigned long n = std::min< unsigned long >( m_chunkSize, photons.m_size - chunkStart );
+		AppendRange( photons.m_chunks[c], photons.m_weightChunks[c], n );
+	}
+}
+
+/*!
+ * Copies \a numberOfPhotons \a photons and their \a bandWeights at the end of the arena. If \a bandWeights is null, the photons
+ * have no weights.
+ *
+ * New chunks are only allocated when the chunks of previous buffers are full.
+ */
+void PhotonArena::AppendRange( const Photon* photons, const SpectralWeights* bandWeights, unsigned long numberOfPhotons )
+{
+	unsigned long copied = 0;
+	while( copied < numberOfPhotons )
+	{
+		unsigned long chunk = m_size >> m_chunkShift;
+		if( chunk == m_chunks.size() )
+		{
+			m_chunks.push_back( new Photon[m_chunkSize] );
+			m_weightChunks.push_back( 0 );
+		}
+
+		unsigned long offset = m_size & ( m_chunkSize - 1 );
+		unsigned long n = std::min< unsigned long >( m_chunkSize - offset, numberOfPhotons - copied );
+		std::copy( photons + copied, photons + copied + n, m_chunks[chunk] + offset );
+
+		if( bandWeights && !m_weightChunks[chunk] )	m_weightChunks[chunk] = new SpectralWeights[m_chunkSize];
+		if( bandWeights )
+			std::copy( bandWeights + copied, bandWeights + copied + n, m_weightChunks[chunk] + offset );
+		else if( m_weightChunks[chunk] )
+			std::fill( m_weightChunks[chunk] + offset, m_weightChunks[chunk] + offset + n, m_noBandWeights );
+
+		copied += n;
+		m_size += n;
+	}
+}
+
+/*!
+ * Removes all the photons. The chunks are kept to store the next photons.
+ */
+void PhotonArena::Clear()
+{
+	m_size = 0;
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef PHOTONARENA_H_
+#define PHOTONARENA_H_
+
+#include <vector>
+
+#include "Photon.h"
+#include "SpectralWeights.h"
+
+/*!
+ * Stores photons contiguously in chunks of m_chunkSize photons.
+ *
+ * The chunks are kept when the arena is cleared, so that the photon map reuses the same memory for each buffer
+ * of photons. The export modes receive the arena as a read-only view of the photons.
+ *
+ * The band weights of the spectral traces are stored in parallel chunks, that are only allocated for the chunks
+ * with photons that have weights.
+ */
+class PhotonArena
+{
+public:
+	PhotonArena();
+	~PhotonArena();
+
+	void Add( const Photon& photon, const SpectralWeights& bandWeights );
+	void Append( const std::vector< Photon >& photons );
+	void Append( const PhotonArena& photons );
+	void Clear();
+
+	//! Returns the band weights of the photon at position \a index. The photons without weights have no bands.
+	const SpectralWeights& BandWeights( unsigned long index ) const
+	{
+		const SpectralWeights* weightsChunk = m_weightChunks[index >> m_chunkShift];
+		if( !weightsChunk )	return m_noBandWeights;
+		return weightsChunk[index & ( m_chunkSize - 1 )];
+	}
+
+	//! Returns true if the arena has no photons.
+	bool empty() const { return ( m_size == 0 ); }
+
+	//! Returns the number of photons in the arena.
+	unsigned long size() const { return m_size; }
+
+	//! Returns the photon at position \a index. The \a index must be lower than size().
+	const Photon* operator[]( unsigned long index ) const
+	{
+		return ( m_chunks[index >> m_chunkShift] + ( index & ( m_chunkSize - 1 ) ) );
+	}
+
+	enum { m_chunkShift = 16, m_chunkSize = 1 << m_chunkShift };
+
+private:
+	PhotonArena( const PhotonArena& );
+	PhotonArena& operator=( const PhotonArena& );
+
+	void AppendRange( const Photon* photons, const SpectralWeights* bandWeights, unsigned long numberOfPhotons );
+
+	std::vector< Photon* > m_chunks;
+	std::vector< SpectralWeights* > m_weightChunks;
+	SpectralWeights m_noBandWeights;
+	unsigned long m_size;
+};
+
+#endif /* PHOTONARENA_H_ */
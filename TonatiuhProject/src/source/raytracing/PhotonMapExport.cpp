@@ -47,6 +47,7 @@ PhotonMapExport::PhotonMapExport()
  m_saveAllPhotonsData( true ),
  m_saveCoordinates( false ),
  m_saveCoordinatesInGlobal( true ),
+ m_savePathLength( false ),
  m_savePowerPerPhoton( false ),
  m_savePrevNexID( false ),
  m_saveSide( false )
@@ -96,6 +97,15 @@ void PhotonMapExport::SetSaveCoordinatesInGlobalSystemEnabled( bool enabled )
 	m_saveCoordinatesInGlobal = enabled;
 }
 
+/*!
+ * Sets enabled to save the length of the ray segment that arrives to each photon through the atmosphere.
+ * The attenuation of several atmosphere models can be applied to the exported photons after the trace.
+ */
+void PhotonMapExport::SetSavePathLengthEnabled( bool enabled )
+{
+	m_savePathLength = enabled;
+}
+
 /*!
  *If \a enabled is true, the identifier of the previous and next photons will be exported.
  */
@@ -44,6 +44,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <QStringList>
 
 #include "Photon.h"
+#include "PhotonArena.h"
 
 class SceneModel;
 
@@ -55,7 +56,7 @@ public:
 	virtual ~PhotonMapExport();
 
 	virtual void EndExport() = 0;
-	virtual void SavePhotonMap( std::vector < Photon* > raysLists ) = 0;
+	virtual void SavePhotonMap( const PhotonArena& raysLists ) = 0;
 	void SetConcentratorToWorld( Transform concentratorToWorld );
 	virtual void SetPowerPerPhoton( double wPhoton ) = 0;
 
@@ -63,6 +64,7 @@ public:
 	void SetSaveCoordinatesEnabled( bool enabled );
 	void SetSaveCoordinatesInGlobalSystemEnabled( bool enabled );
 	virtual void SetSaveParameterValue( QString parameterName, QString parameterValue ) = 0;
+	void SetSavePathLengthEnabled( bool enabled );
 	void SetSavePreviousNextPhotonsID( bool enabled );
 	void SetSaveSideEnabled( bool enabled );
 	void SetSaveSurfacesIDEnabled( bool enabled );
@@ -76,6 +78,7 @@ protected:
 	bool m_saveAllPhotonsData;
 	bool m_saveCoordinates;
 	bool m_saveCoordinatesInGlobal;
+	bool m_savePathLength;
 	bool m_savePowerPerPhoton;
 	bool m_savePrevNexID;
 	bool m_saveSide;
@@ -0,0 +1,141 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <QMutexLocker>
+
+#include "PhotonArena.h"
+#include "PhotonMapExport.h"
+#include "PhotonMapExportThread.h"
+
+/*!
+ * Creates a thread that saves the photons with \a exportMode using \a numberOfBuffers buffers. The thread must be
+ * started before any buffer is saved.
+ */
+PhotonMapExportThread::PhotonMapExportThread( PhotonMapExport* exportMode, int numberOfBuffers )
+:m_pExportMode( exportMode ),
+ m_saving( false ),
+ m_stop( false )
+{
+	for( int b = 0; b < numberOfBuffers; ++b )
+		m_buffers.push_back( new PhotonArena );
+	m_freeBuffers = m_buffers;
+}
+
+/*!
+ * Saves the queued buffers, stops the thread and releases the buffers. The buffers taken from the thread
+ * can not be used after it is destroyed.
+ */
+PhotonMapExportThread::~PhotonMapExportThread()
+{
+	Stop();
+	qDeleteAll( m_buffers );
+}
+
+/*!
+ * Waits until all the buffers given to the thread are saved.
+ */
+void PhotonMapExportThread::Flush()
+{
+	QMutexLocker locker( &m_mutex );
+	while( !m_queuedBuffers.isEmpty() || m_saving )
+		m_bufferSaved.wait( &m_mutex );
+}
+
+/*!
+ * Queues \a buffer to be saved with the export mode. The \a buffer must have been taken from this thread and
+ * can not be used until it is taken again.
+ */
+void PhotonMapExportThread::SaveBuffer( PhotonArena* buffer )
+{
+	QMutexLocker locker( &m_mutex );
+	m_queuedBuffers.enqueue( buffer );
+	m_bufferQueued.wakeOne();
+}
+
+/*!
+ * Saves the queued buffers and finishes the thread.
+ */
+void PhotonMapExportThread::Stop()
+{
+	m_mutex.lock();
+	m_stop = true;
+	m_bufferQueued.wakeOne();
+	m_mutex.unlock();
+
+	wait();
+}
+
+/*!
+ * Returns an empty buffer. If all the buffers are queued to be saved, waits until one of them is saved.
+ */
+PhotonArena* PhotonMapExportThread::TakeBuffer()
+{
+	QMutexLocker locker( &m_mutex );
+	while( m_freeBuffers.isEmpty() )
+		m_bufferSaved.wait( &m_mutex );
+
+	return m_freeBuffers.takeFirst();
+}
+
+/*!
+ * Saves the queued buffers in order until the thread is stopped.
+ */
+void PhotonMapExportThread::run()
+{
+	m_mutex.lock();
+	while( true )
+	{
+		while( m_queuedBuffers.isEmpty() && !m_stop )
+			m_bufferQueued.wait( &m_mutex );
+		if( m_queuedBuffers.isEmpty() )	break;
+
+		PhotonArena* buffer = m_queuedBuffers.dequeue();
+		m_saving = true;
+		m_mutex.unlock();
+
+		if( m_pExportMode )	m_pExportMode->SavePhotonMap( *buffer );
+		buffer->Clear();
+
+		m_mutex.lock();
+		m_saving = false;
+		m_freeBuffers.push_back( buffer );
+		m_bufferSaved.wakeAll();
+	}
+	m_mutex.unlock();
+}
@@ -0,0 +1,87 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef PHOTONMAPEXPORTTHREAD_H_
+#define PHOTONMAPEXPORTTHREAD_H_
+
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+class PhotonArena;
+class PhotonMapExport;
+
+/*!
+ * Saves the buffers of the photon map with an export mode in its own thread.
+ *
+ * The thread owns a fixed number of buffers. The photon map takes an empty buffer, fills it and gives it back
+ * with SaveBuffer while it fills the next one. When all the buffers are waiting to be saved, TakeBuffer blocks
+ * until the export mode has saved one of them, so the tracing never gets ahead of the export by more than the
+ * buffers of the thread.
+ */
+class PhotonMapExportThread : public QThread
+{
+public:
+	PhotonMapExportThread( PhotonMapExport* exportMode, int numberOfBuffers );
+	~PhotonMapExportThread();
+
+	void Flush();
+	void SaveBuffer( PhotonArena* buffer );
+	void Stop();
+	PhotonArena* TakeBuffer();
+
+protected:
+	void run();
+
+private:
+	PhotonMapExport* m_pExportMode;
+	QList< PhotonArena* > m_buffers;
+	QList< PhotonArena* > m_freeBuffers;
+	QQueue< PhotonArena* > m_queuedBuffers;
+	bool m_saving;
+	bool m_stop;
+
+	QMutex m_mutex;
+	QWaitCondition m_bufferQueued;
+	QWaitCondition m_bufferSaved;
+};
+
+#endif /* PHOTONMAPEXPORTTHREAD_H_ */
@@ -0,0 +1,147 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include "gf.h"
+#include "InstanceNode.h"
+#include "RayPacket.h"
+
+/*!
+ * Creates an empty packet for up to \a packetSize rays. The size is limited to m_maxPacketSize rays.
+ */
+RayPacket::RayPacket( int packetSize )
+:m_packetSize( packetSize ),
+ m_numberOfRays( 0 ),
+ m_nextRay( 0 )
+{
+	if( m_packetSize < 1 )	m_packetSize = 1;
+	if( m_packetSize > m_maxPacketSize )	m_packetSize = m_maxPacketSize;
+
+	m_objectRays.Resize( m_packetSize );
+	for( int r = 0; r < m_maxPacketSize; ++r )
+	{
+		m_raysMaxt[r] = 0.0;
+		m_hitNodes[r] = 0;
+	}
+}
+
+RayPacket::~RayPacket()
+{
+
+}
+
+/*!
+ * Returns the maximum number of rays of the packet.
+ */
+int RayPacket::Capacity() const
+{
+	return m_packetSize;
+}
+
+/*!
+ * Returns the number of rays stored in the packet.
+ */
+int RayPacket::Size() const
+{
+	return m_numberOfRays;
+}
+
+/*!
+ * Returns true if all the packet rays have been taken with NextRay.
+ */
+bool RayPacket::IsEmpty() const
+{
+	return ( m_nextRay >= m_numberOfRays );
+}
+
+/*!
+ * Removes all the rays from the packet.
+ */
+void RayPacket::Clear()
+{
+	m_numberOfRays = 0;
+	m_nextRay = 0;
+}
+
+/*!
+ * Adds the \a ray to the packet.
+ */
+void RayPacket::AddRay( const Ray& ray )
+{
+	if( m_numberOfRays >= m_packetSize )	gf::SevereError( "RayPacket::AddRay called with a full packet" );
+
+	m_rays[m_numberOfRays] = ray;
+	m_hitNodes[m_numberOfRays] = 0;
+	++m_numberOfRays;
+}
+
+/*!
+ * Finds for each ray of the packet the closest shape node under \a rootNode that the ray intersects.
+ */
+void RayPacket::Intersect( InstanceNode* rootNode )
+{
+	int activeRays[m_maxPacketSize];
+	for( int r = 0; r < m_numberOfRays; ++r )
+	{
+		activeRays[r] = r;
+		m_hitNodes[r] = 0;
+		m_raysMaxt[r] = m_rays[r].maxt;
+	}
+
+	rootNode->IntersectPacket( m_rays, activeRays, m_numberOfRays, m_hitNodes, &m_objectRays );
+
+	//Restore the rays extent to compute again the intersection with the hit node
+	for( int r = 0; r < m_numberOfRays; ++r )
+		m_rays[r].maxt = m_raysMaxt[r];
+}
+
+/*!
+ * Takes the next ray of the packet. The \a hitNode is the closest node found by Intersect for the ray or null
+ * if the ray does not intersect any shape.
+ *
+ * Returns false if all the rays have been taken.
+ */
+bool RayPacket::NextRay( Ray* ray, InstanceNode** hitNode )
+{
+	if( IsEmpty() )	return false;
+
+	*ray = m_rays[m_nextRay];
+	*hitNode = m_hitNodes[m_nextRay];
+	++m_nextRay;
+	return true;
+}
@@ -40,8 +40,11 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "DifferentialGeometry.h"
 #include "ParallelRandomDeviate.h"
+#include "PhotonArena.h"
 #include "Ray.h"
+#include "RayPacket.h"
 #include "RayTracer.h"
+#include "SunDirectionBank.h"
 #include "TPhotonMap.h"
 #include "TLightShape.h"
 #include "TSunShape.h"
@@ -68,13 +71,17 @@ m_pRand( &rand ),
 m_mutex( mutex ),
 m_photonMap( photonMap ),
 m_pPhotonMapMutex( mutexPhotonMap ),
-m_transmissivity( transmissivity )
+m_transmissivity( transmissivity ),
+m_packetSize( 1 ),
+m_attenuationAsWeight( false ),
+m_postTraceAttenuation( false )
 {
 	m_validAreasVector = m_lightShape->GetValidAreasCoord();
+	if( m_transmissivity )	m_transmissivity->PrepareForTrace();
 }
 
 //generating the ray
-bool RayTracer::NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand )
+bool RayTracer::NewPrimitiveRay( Ray* ray, SunDirectionBank* sunDirections, ParallelRandomDeviate& rand )
 {
 	int area = int ( rand.RandomDouble() * m_validAreasVector.size() );
 	QPair< int, int > areaIndex = m_validAreasVector[area] ;
@@ -83,14 +90,150 @@ bool RayTracer::NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand )
 	Point3D origin = m_lightShape->Sample( rand.RandomDouble(), rand.RandomDouble(), areaIndex.first, areaIndex.second );
 
 	//generating the ray direction
-	Vector3D direction;
-	m_lightSunShape->GenerateRayDirection( direction, rand );
+	Vector3D direction = sunDirections->NextDirection( rand );
 	//generatin the ray
 	*ray =  m_lightToWorld( Ray( origin, direction ) );
 
 	return true;
 }
 
+/*!
+ * Sets the number of primary rays that are intersected together as a packet to \a packetSize.
+ *
+ * The rays of a packet start from the same light cell, so they traverse the scene close to each other.
+ * Values lower than 2 trace each ray alone. The maximum size is RayPacket::m_maxPacketSize.
+ */
+void RayTracer::SetPacketSize( int packetSize )
+{
+	m_packetSize = packetSize;
+	if( m_packetSize < 1 )	m_packetSize = 1;
+	if( m_packetSize > RayPacket::m_maxPacketSize )	m_packetSize = RayPacket::m_maxPacketSize;
+}
+
+/*!
+ * Enables the spectral trace with a band for each value of \a sunBandFractions, the fraction of the sun power in
+ * the band. The photons store the power of each band as a fraction of the photon power. Only the first
+ * SpectralWeights::m_maxBands bands are traced. An empty \a sunBandFractions disables the spectral trace.
+ */
+void RayTracer::SetSpectralBands( const std::vector< double >& sunBandFractions )
+{
+	m_sunBandFractions = sunBandFractions;
+	UpdateSourceWeights();
+}
+
+/*!
+ * If \a attenuationAsWeight is true, the rays are not killed by the atmospheric attenuation. The power of the ray is multiplied
+ * by the transmitted fraction and the photons store it as the weight of the bands. If no spectral bands are defined, a single band
+ * with all the sun power is traced. By default, the attenuated rays are killed.
+ */
+void RayTracer::SetAttenuationWeighting( bool attenuationAsWeight )
+{
+	m_attenuationAsWeight = attenuationAsWeight;
+	UpdateSourceWeights();
+}
+
+/*!
+ * If \a postTraceAttenuation is true, the atmospheric attenuation is not computed during the trace. The photons store the
+ * length of the path through the atmosphere, so that the attenuation of any transmissivity model can be applied afterwards
+ * with trf::ComputeAttenuationFactors.
+ */
+void RayTracer::SetPostTraceAttenuation( bool postTraceAttenuation )
+{
+	m_postTraceAttenuation = postTraceAttenuation;
+	UpdateSourceWeights();
+}
+
+/*!
+ * Returns false if the ray is killed by the atmospheric attenuation along \a distance.
+ *
+ * When the attenuation is traced as a weight, the ray is always transmitted and \a weights and \a incidentWeights
+ * are multiplied by the transmitted fraction. The rays that do not intersect any surface are not attenuated.
+ */
+bool RayTracer::IsTransmitted( double distance, RandomDeviate& rand, SpectralWeights* weights, SpectralWeights* incidentWeights ) const
+{
+	if( !m_transmissivity || m_postTraceAttenuation )	return true;
+	if( !m_attenuationAsWeight )	return m_transmissivity->IsTransmitted( distance, rand );
+
+	if( distance < HUGE_VAL )
+	{
+		double factor = m_transmissivity->AttenuationFactor( distance );
+		weights->Scale( factor );
+		incidentWeights->Scale( factor );
+	}
+	return true;
+}
+
+/*!
+ * Computes the weights of the primary rays from the sun band fractions and the attenuation mode.
+ */
+void RayTracer::UpdateSourceWeights()
+{
+	if( !m_sunBandFractions.empty() )
+		m_sourceWeights = SpectralWeights( int( m_sunBandFractions.size() ), &m_sunBandFractions[0] );
+	else if( m_attenuationAsWeight && m_transmissivity && !m_postTraceAttenuation )
+	{
+		double sunFraction = 1.0;
+		m_sourceWeights = SpectralWeights( 1, &sunFraction );
+	}
+	else
+		m_sourceWeights = SpectralWeights();
+}
+
+/*!
+ * Takes from the \a packet the next primary ray and the closest node that it intersects.
+ *
+ * When the packet is empty, it is filled with up to \a maximumRays new rays from a light cell and intersected with the scene.
+ * If the packet size is lower than 2, a single ray is generated and \a packetHitNode is not modified.
+ */
+bool RayTracer::NewPrimitiveRay( Ray* ray, InstanceNode** packetHitNode, RayPacket* packet, SunDirectionBank* sunDirections,
+		double maximumRays, ParallelRandomDeviate& rand )
+{
+	if( m_packetSize < 2 )	return NewPrimitiveRay( ray, sunDirections, rand );
+
+	if( packet->IsEmpty() )
+	{
+		packet->Clear();
+
+		int area = int ( rand.RandomDouble() * m_validAreasVector.size() );
+		QPair< int, int > areaIndex = m_validAreasVector[area] ;
+
+		int packetRays = packet->Capacity();
+		if( maximumRays < packetRays )	packetRays = int( maximumRays );
+		for( int r = 0; r < packetRays; ++r )
+		{
+			Point3D origin = m_lightShape->Sample( rand.RandomDouble(), rand.RandomDouble(), areaIndex.first, areaIndex.second );
+
+			Vector3D direction = sunDirections->NextDirection( rand );
+			packet->AddRay( m_lightToWorld( Ray( origin, direction ) ) );
+		}
+
+		packet->Intersect( m_rootNode );
+	}
+
+	return packet->NextRay( ray, packetHitNode );
+}
+
+/*!
+ * Computes the first intersection of the primary \a ray. The \a packetHitNode is the node found by the packet intersection.
+ *
+ * The packet traverses the whole scene, so a ray without \a packetHitNode does not intersect any shape and it is not
+ * traced again. Only the intersection with the \a packetHitNode is computed again. If it is not confirmed, the ray is
+ * traced from the root node, so the packet tests never lose an intersection.
+ */
+bool RayTracer::IntersectPrimitiveRay( const Ray& ray, InstanceNode* packetHitNode, RandomDeviate& rand, bool* isFront, InstanceNode** intersectedSurface,
+		Ray* reflectedRay, SpectralWeights* weights )
+{
+	if( m_packetSize > 1 )
+	{
+		if( !packetHitNode )	return false;
+
+		bool isReflectedRay = packetHitNode->Intersect( ray, rand, isFront, intersectedSurface, reflectedRay, weights );
+		if( *intersectedSurface == packetHitNode )	return isReflectedRay;
+	}
+
+	return m_rootNode->Intersect( ray, rand, isFront, intersectedSurface, reflectedRay, weights );
+}
+
 void RayTracer::operator()( double numberOfRays )
 {
 	if( m_exportSuraceList.size() < 1 )
@@ -108,20 +251,26 @@ void RayTracer::operator()( double numberOfRays )
 void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 {
 
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
-			photonsVector.push_back( Photon( ray.origin, 1, 0, m_lightNode ) );
+			photons.Add( Photon( ray.origin, 1, 0, m_lightNode ), m_sourceWeights );
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 
 			//Trace the ray
 			bool isReflectedRay = true;
@@ -130,13 +279,18 @@ void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if( rayLength > 0 )
 				{
 					currentRaysWay.push_back( ray );
 
-					if( m_transmissivity && !m_transmissivity->IsTransmitted( ray.maxt, rand ) )
+					if( !IsTransmitted( ray.maxt, rand, &weights, &incidentWeights ) )
 					{
 						++rayLength;
 						isReflectedRay = false;
@@ -147,7 +301,7 @@ void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 				}
 				if( isReflectedRay )
 				{
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -162,10 +316,10 @@ void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -178,10 +332,9 @@ void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 
 	}
 
-	photonsVector.resize( photonsVector.size() );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 }
@@ -192,20 +345,26 @@ void RayTracer::RayTracerCreatingAllPhotons( double numberOfRays  )
 void RayTracer::RayTracerCreatingLightPhotons(  double numberOfRays  )
 {
 
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
-			photonsVector.push_back( Photon( ray.origin, 1, 0, m_lightNode ) );
+			photons.Add( Photon( ray.origin, 1, 0, m_lightNode ), m_sourceWeights );
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 
 			//Trace the ray
 			bool isReflectedRay = true;
@@ -214,13 +373,18 @@ void RayTracer::RayTracerCreatingLightPhotons(  double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if( rayLength > 0 )
 				{
 					currentRaysWay.push_back( ray );
 
-					if( m_transmissivity && !m_transmissivity->IsTransmitted( ray.maxt, rand ) )
+					if( !IsTransmitted( ray.maxt, rand, &weights, &incidentWeights ) )
 					{
 						++rayLength;
 						isReflectedRay = false;
@@ -233,7 +397,7 @@ void RayTracer::RayTracerCreatingLightPhotons(  double numberOfRays  )
 				{
 					++rayLength;
 					if( m_exportSuraceList.contains( intersectedSurface ) )
-						photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, rayLength, intersectedSurface) );
+						photons.Add( Photon( (ray)( ray.maxt ), isFront, rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -246,10 +410,10 @@ void RayTracer::RayTracerCreatingLightPhotons(  double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -261,10 +425,9 @@ void RayTracer::RayTracerCreatingLightPhotons(  double numberOfRays  )
 		}
 
 	}
-	photonsVector.resize( photonsVector.size() );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 }
@@ -277,19 +440,25 @@ void RayTracer::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 {
 	// std::cout<<"RayTracer::RayTracerNotCreatingLightPhotons"<<std::endl;
 
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 
 			//Trace the ray
 			bool isReflectedRay = true;
@@ -298,12 +467,17 @@ void RayTracer::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if( rayLength > 0 )
 				{
 					currentRaysWay.push_back( ray );
-					if( m_transmissivity && !m_transmissivity->IsTransmitted( ray.maxt, rand ) )
+					if( !IsTransmitted( ray.maxt, rand, &weights, &incidentWeights ) )
 					{
 						++rayLength;
 						isReflectedRay = false;
@@ -317,7 +491,7 @@ void RayTracer::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 				{
 					++rayLength;
 					if( m_exportSuraceList.contains( intersectedSurface ) )
-						photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, rayLength, intersectedSurface) );
+						photons.Add( Photon( (ray)( ray.maxt ), isFront, rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -330,10 +504,10 @@ void RayTracer::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -345,10 +519,9 @@ void RayTracer::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 		}
 
 	}
-	photonsVector.resize( photonsVector.size() );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 }
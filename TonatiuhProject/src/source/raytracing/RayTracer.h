@@ -47,15 +47,18 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <QObject>
 #include <QVector>
 
+#include "SpectralWeights.h"
 #include "Transform.h"
 
 class InstanceNode;
 class ParallelRandomDeviate;
 struct Photon;
 class RandomDeviate;
+class RayPacket;
 struct RayTracerPhoton;
 class QMutex;
 class QPoint;
+class SunDirectionBank;
 class TPhotonMap;
 class TLightShape;
 class TSunShape;
@@ -80,9 +83,19 @@ public:
 	typedef void result_type;
 	void operator()( double numberOfRays );
 
+	void SetPacketSize( int packetSize );
+	void SetSpectralBands( const std::vector< double >& sunBandFractions );
+	void SetAttenuationWeighting( bool attenuationAsWeight );
+	void SetPostTraceAttenuation( bool postTraceAttenuation );
 
 private:
-	bool NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand );
+	bool NewPrimitiveRay( Ray* ray, SunDirectionBank* sunDirections, ParallelRandomDeviate& rand );
+	bool NewPrimitiveRay( Ray* ray, InstanceNode** packetHitNode, RayPacket* packet, SunDirectionBank* sunDirections,
+			double maximumRays, ParallelRandomDeviate& rand );
+	bool IntersectPrimitiveRay( const Ray& ray, InstanceNode* packetHitNode, RandomDeviate& rand, bool* isFront, InstanceNode** intersectedSurface,
+			Ray* reflectedRay, SpectralWeights* weights );
+	bool IsTransmitted( double distance, RandomDeviate& rand, SpectralWeights* weights, SpectralWeights* incidentWeights ) const;
+	void UpdateSourceWeights();
 	void RayTracerCreatingAllPhotons(  double numberOfRays  );
 	void RayTracerCreatingLightPhotons(  double numberOfRays  );
 	void RayTracerNotCreatingLightPhotons(  double numberOfRays  );
@@ -100,6 +113,11 @@ private:
     QMutex* m_pPhotonMapMutex;
 	TTransmissivity * m_transmissivity;
 	std::vector< QPair< int, int > >  m_validAreasVector;
+	int m_packetSize;
+	SpectralWeights m_sourceWeights;
+	std::vector< double > m_sunBandFractions;
+	bool m_attenuationAsWeight;
+	bool m_postTraceAttenuation;
 
 
 };
@@ -40,8 +40,11 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 
 #include "DifferentialGeometry.h"
 #include "ParallelRandomDeviate.h"
+#include "PhotonArena.h"
 #include "Ray.h"
+#include "RayPacket.h"
 #include "RayTracerNoTr.h"
+#include "SunDirectionBank.h"
 #include "TPhotonMap.h"
 #include "TLightShape.h"
 #include "TSunShape.h"
@@ -64,13 +67,14 @@ m_lightToWorld( lightToWorld ),
 m_pRand( &rand ),
 m_mutex( mutex ),
 m_photonMap( photonMap ),
-m_pPhotonMapMutex( mutexPhotonMap )
+m_pPhotonMapMutex( mutexPhotonMap ),
+m_packetSize( 1 )
 {
 	m_validAreasVector = m_lightShape->GetValidAreasCoord();
 }
 
 //generating the ray
-bool RayTracerNoTr::NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand )
+bool RayTracerNoTr::NewPrimitiveRay( Ray* ray, SunDirectionBank* sunDirections, ParallelRandomDeviate& rand )
 {
 	int area = int ( rand.RandomDouble() * m_validAreasVector.size() );
 	QPair< int, int > areaIndex = m_validAreasVector[area] ;
@@ -78,8 +82,7 @@ bool RayTracerNoTr::NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand )
 	//generating the photon
 	Point3D origin = m_lightShape->Sample( rand.RandomDouble(), rand.RandomDouble(), areaIndex.first, areaIndex.second );
 	//generating the ray direction
-	Vector3D direction;
-	m_lightSunShape->GenerateRayDirection( direction, rand );
+	Vector3D direction = sunDirections->NextDirection( rand );
 	//generatin the ray
 	*ray =  m_lightToWorld( Ray( origin, direction ) );
 
@@ -87,7 +90,86 @@ bool RayTracerNoTr::NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand )
 }
 
 /*!
- * Traces \a numberOfRays rays.
+ * Sets the number of primary rays that are intersected together as a packet to \a packetSize.
+ *
+ * The rays of a packet start from the same light cell, so they traverse the scene close to each other.
+ * Values lower than 2 trace each ray alone. The maximum size is RayPacket::m_maxPacketSize.
+ */
+void RayTracerNoTr::SetPacketSize( int packetSize )
+{
+	m_packetSize = packetSize;
+	if( m_packetSize < 1 )	m_packetSize = 1;
+	if( m_packetSize > RayPacket::m_maxPacketSize )	m_packetSize = RayPacket::m_maxPacketSize;
+}
+
+/*!
+ * Enables the spectral trace with a band for each value of \a sunBandFractions, the fraction of the sun power in
+ * the band. The photons store the power of each band as a fraction of the photon power. Only the first
+ * SpectralWeights::m_maxBands bands are traced. An empty \a sunBandFractions disables the spectral trace.
+ */
+void RayTracerNoTr::SetSpectralBands( const std::vector< double >& sunBandFractions )
+{
+	if( sunBandFractions.empty() )	m_sourceWeights = SpectralWeights();
+	else m_sourceWeights = SpectralWeights( int( sunBandFractions.size() ), &sunBandFractions[0] );
+}
+
+/*!
+ * Takes from the \a packet the next primary ray and the closest node that it intersects.
+ *
+ * When the packet is empty, it is filled with up to \a maximumRays new rays from a light cell and intersected with the scene.
+ * If the packet size is lower than 2, a single ray is generated and \a packetHitNode is not modified.
+ */
+bool RayTracerNoTr::NewPrimitiveRay( Ray* ray, InstanceNode** packetHitNode, RayPacket* packet, SunDirectionBank* sunDirections,
+		double maximumRays, ParallelRandomDeviate& rand )
+{
+	if( m_packetSize < 2 )	return NewPrimitiveRay( ray, sunDirections, rand );
+
+	if( packet->IsEmpty() )
+	{
+		packet->Clear();
+
+		int area = int ( rand.RandomDouble() * m_validAreasVector.size() );
+		QPair< int, int > areaIndex = m_validAreasVector[area] ;
+
+		int packetRays = packet->Capacity();
+		if( maximumRays < packetRays )	packetRays = int( maximumRays );
+		for( int r = 0; r < packetRays; ++r )
+		{
+			Point3D origin = m_lightShape->Sample( rand.RandomDouble(), rand.RandomDouble(), areaIndex.first, areaIndex.second );
+
+			Vector3D direction = sunDirections->NextDirection( rand );
+			packet->AddRay( m_lightToWorld( Ray( origin, direction ) ) );
+		}
+
+		packet->Intersect( m_rootNode );
+	}
+
+	return packet->NextRay( ray, packetHitNode );
+}
+
+/*!
+ * Computes the first intersection of the primary \a ray. The \a packetHitNode is the node found by the packet intersection.
+ *
+ * The packet traverses the whole scene, so a ray without \a packetHitNode does not intersect any shape and it is not
+ * traced again. Only the intersection with the \a packetHitNode is computed again. If it is not confirmed, the ray is
+ * traced from the root node, so the packet tests never lose an intersection.
+ */
+bool RayTracerNoTr::IntersectPrimitiveRay( const Ray& ray, InstanceNode* packetHitNode, RandomDeviate& rand, bool* isFront, InstanceNode** intersectedSurface,
+		Ray* reflectedRay, SpectralWeights* weights )
+{
+	if( m_packetSize > 1 )
+	{
+		if( !packetHitNode )	return false;
+
+		bool isReflectedRay = packetHitNode->Intersect( ray, rand, isFront, intersectedSurface, reflectedRay, weights );
+		if( *intersectedSurface == packetHitNode )	return isReflectedRay;
+	}
+
+	return m_rootNode->Intersect( ray, rand, isFront, intersectedSurface, reflectedRay, weights );
+}
+
+/*!
+ * Traces \a numberOfRays rays.
  */
 void RayTracerNoTr::operator()( double numberOfRays )
 {
@@ -100,24 +182,30 @@ void RayTracerNoTr::operator()( double numberOfRays )
 }
 
 /*!
- * Traces \a numberOfRays rays and creates photons for all intersections.
+ * Traces \a numberOfRays rays and creates photons for all intersections.
  */
 void RayTracerNoTr::RayTracerCreatingAllPhotons(  double numberOfRays  )
 {
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
-			photonsVector.push_back( Photon( ray.origin, 1, 0, m_lightNode ) );
+			photons.Add( Photon( ray.origin, 1, 0, m_lightNode ), m_sourceWeights );
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 			bool isDirectSun = true;
 
 			//Trace the ray
@@ -127,12 +215,17 @@ void RayTracerNoTr::RayTracerCreatingAllPhotons(  double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if (!isDirectSun) currentRaysWay.push_back(ray);
 				if( isReflectedRay )
 				{
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -146,10 +239,10 @@ void RayTracerNoTr::RayTracerCreatingAllPhotons(  double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -162,11 +255,10 @@ void RayTracerNoTr::RayTracerCreatingAllPhotons(  double numberOfRays  )
 
 	}
 
-	photonsVector.resize( photonsVector.size() );
 	//return QPair< TPhotonMap*, std::vector< Photon > >( m_photonMap, photonsVector );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 
@@ -177,20 +269,26 @@ void RayTracerNoTr::RayTracerCreatingAllPhotons(  double numberOfRays  )
  */
 void RayTracerNoTr::RayTracerCreatingLightPhotons(  double numberOfRays  )
 {
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
-			photonsVector.push_back( Photon( ray.origin, 1, 0, m_lightNode ) );
+			photons.Add( Photon( ray.origin, 1, 0, m_lightNode ), m_sourceWeights );
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 			bool isDirectSun = true;
 
 			//Trace the ray
@@ -200,13 +298,18 @@ void RayTracerNoTr::RayTracerCreatingLightPhotons(  double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if (!isDirectSun) currentRaysWay.push_back(ray);
 				if( isReflectedRay )
 				{
 					if( m_exportSuraceList.contains( intersectedSurface ) )
-						photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+						photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -220,10 +323,10 @@ void RayTracerNoTr::RayTracerCreatingLightPhotons(  double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -235,10 +338,9 @@ void RayTracerNoTr::RayTracerCreatingLightPhotons(  double numberOfRays  )
 		}
 
 	}
-	photonsVector.resize( photonsVector.size() );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 }
@@ -249,19 +351,25 @@ void RayTracerNoTr::RayTracerCreatingLightPhotons(  double numberOfRays  )
  */
 void RayTracerNoTr::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 {
-	std::vector< Photon > photonsVector;
+	PhotonArena photons;
 	ParallelRandomDeviate rand( m_pRand, m_mutex );
+	RayPacket packet( m_packetSize );
+	SunDirectionBank sunDirections( m_lightSunShape, SunDirectionBank::BankSizeForRays( numberOfRays ) );
 
 	for(  unsigned long  i = 0; i < numberOfRays; ++i )
 	{
 		std::vector<Ray> currentRaysWay;
 		Ray ray;
-		if( NewPrimitiveRay( &ray, rand ) )
+		InstanceNode* packetHitNode = 0;
+		if( NewPrimitiveRay( &ray, &packetHitNode, &packet, &sunDirections, numberOfRays - i, rand ) )
 		{
 			int rayLength = 0;
+			SpectralWeights weights( m_sourceWeights );
+			SpectralWeights incidentWeights( weights );
 
 			InstanceNode* intersectedSurface = 0;
 			bool isFront = false;
+			double pathLength = 0.0;
 			bool isDirectSun = true;
 
 			//Trace the ray
@@ -271,13 +379,18 @@ void RayTracerNoTr::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 				intersectedSurface = 0;
 				isFront = 0;
 				Ray reflectedRay;
-				isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay );
+				incidentWeights = weights;
+				if( rayLength == 0 )
+					isReflectedRay = IntersectPrimitiveRay( ray, packetHitNode, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				else
+					isReflectedRay = m_rootNode->Intersect( ray, rand, &isFront, &intersectedSurface, &reflectedRay, &weights );
+				pathLength = ( rayLength > 0 ) ? ray.maxt : 0.0;
 
 				if (!isDirectSun) currentRaysWay.push_back(ray);
 				if( isReflectedRay )
 				{
 					if( m_exportSuraceList.contains( intersectedSurface ) )
-						photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+						photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 
 					//Prepare node and ray for next iteration
 					ray = reflectedRay;
@@ -291,10 +404,10 @@ void RayTracerNoTr::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 				if( ray.maxt == HUGE_VAL  )
 				{
 					ray.maxt = 0.1;
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), 0, ++rayLength, intersectedSurface ), incidentWeights );
 				}
 				else
-					photonsVector.push_back( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface) );
+					photons.Add( Photon( (ray)( ray.maxt ), isFront, ++rayLength, intersectedSurface, pathLength ), incidentWeights );
 			}
 			if (currentRaysWay.size()>0)
 			{
@@ -306,11 +419,10 @@ void RayTracerNoTr::RayTracerNotCreatingLightPhotons(  double numberOfRays  )
 		}
 
 	}
-	photonsVector.resize( photonsVector.size() );
 	//return QPair< TPhotonMap*, std::vector< Photon > >( m_photonMap, photonsVector );
 
 	m_pPhotonMapMutex->lock();
-	m_photonMap->StoreRays( photonsVector );
+	m_photonMap->StoreRays( photons );
 	m_pPhotonMapMutex->unlock();
 
 }
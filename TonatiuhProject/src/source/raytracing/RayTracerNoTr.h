@@ -47,6 +47,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <QObject>
 #include <QVector>
 
+#include "SpectralWeights.h"
 #include "Transform.h"
 
 
@@ -54,9 +55,11 @@ class InstanceNode;
 class ParallelRandomDeviate;
 struct Photon;
 class RandomDeviate;
+class RayPacket;
 struct RayTracerPhoton;
 class QMutex;
 class QPoint;
+class SunDirectionBank;
 class TPhotonMap;
 class TLightShape;
 class TSunShape;
@@ -79,6 +82,8 @@ public:
 	typedef void result_type;
 	void operator()( double numberOfRays );
 
+	void SetPacketSize( int packetSize );
+	void SetSpectralBands( const std::vector< double >& sunBandFractions );
 
 private:
 	void RayTracerCreatingAllPhotons(  double numberOfRays  );
@@ -96,8 +101,14 @@ private:
 	TPhotonMap* m_photonMap;
     QMutex* m_pPhotonMapMutex;
 	std::vector< QPair< int, int > >  m_validAreasVector;
-
-	bool NewPrimitiveRay( Ray* ray, ParallelRandomDeviate& rand );
+	int m_packetSize;
+	SpectralWeights m_sourceWeights;
+
+	bool NewPrimitiveRay( Ray* ray, SunDirectionBank* sunDirections, ParallelRandomDeviate& rand );
+	bool NewPrimitiveRay( Ray* ray, InstanceNode** packetHitNode, RayPacket* packet, SunDirectionBank* sunDirections,
+			double maximumRays, ParallelRandomDeviate& rand );
+	bool IntersectPrimitiveRay( const Ray& ray, InstanceNode* packetHitNode, RandomDeviate& rand, bool* isFront, InstanceNode** intersectedSurface,
+			Ray* reflectedRay, SpectralWeights* weights );
 };
 
 
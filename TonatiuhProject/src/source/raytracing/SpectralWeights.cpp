@@ -0,0 +1,174 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "RandomDeviate.h"
+#include "SpectralWeights.h"
+
+/*!
+ * Creates weights without bands.
+ */
+SpectralWeights::SpectralWeights()
+:nBands( 0 )
+{
+	for( int b = 0; b < m_maxBands; ++b )	weight[b] = 0.0f;
+}
+
+/*!
+ * Creates weights for \a numberOfBands bands with the values \a bandFractions. Only the first m_maxBands bands are stored.
+ */
+SpectralWeights::SpectralWeights( int numberOfBands, const double* bandFractions )
+:nBands( 0 )
+{
+	if( numberOfBands > 0 )	nBands = ( numberOfBands < m_maxBands ) ? numberOfBands : m_maxBands;
+	for( int b = 0; b < m_maxBands; ++b )
+		weight[b] = ( b < nBands ) ? float( bandFractions[b] ) : 0.0f;
+}
+
+/*!
+ * Applies to the weights the fraction of power \a bandFactors that an interaction keeps in each band.
+ * If \a numberOfFactors is lower than the number of bands, the last factor is used for the remaining bands.
+ *
+ * The ray survives with the probability of the largest factor and the weights of the surviving ray are divided by
+ * that probability, so the expected power of each band is the same as applying its factor. Returns false if the
+ * ray does not survive, in which case the weights are not changed. Weights without bands survive with the
+ * probability of the first factor.
+ */
+bool SpectralWeights::Attenuate( const double* bandFactors, int numberOfFactors, RandomDeviate& rand )
+{
+	if( numberOfFactors < 1 )	return true;
+	if( nBands < 1 )	return ( rand.RandomDouble() < bandFactors[0] );
+
+	double factors[m_maxBands];
+	double survivalProbability = 0.0;
+	for( int b = 0; b < nBands; ++b )
+	{
+		factors[b] = ( b < numberOfFactors ) ? bandFactors[b] : bandFactors[numberOfFactors - 1];
+		if( factors[b] > survivalProbability )	survivalProbability = factors[b];
+	}
+
+	if( rand.RandomDouble() >= survivalProbability )	return false;
+
+	for( int b = 0; b < nBands; ++b )
+		weight[b] = float( weight[b] * factors[b] / survivalProbability );
+	return true;
+}
+
+/*!
+ * Selects one of the \a numberOfInteractions interactions that a ray can have with a surface, as the reflection and
+ * the transmission, or the absorption of the ray. \a interactionFactors has for each interaction the fraction of power
+ * that goes to that interaction in each band, with a value for each band of the weights.
+ *
+ * Each interaction is selected with the probability of its fraction of the ray power and the weights are updated
+ * to keep the expected power of each band, so the selected ray keeps the total weight. Returns the index of the
+ * selected interaction or -1 if the ray is absorbed, in which case the weights are not changed.
+ */
+int SpectralWeights::SelectInteraction( const double* const* interactionFactors, int numberOfInteractions, RandomDeviate& rand )
+{
+	double total = Total();
+	if( !( total > 0.0 ) )	return -1;
+
+	double randomNumber = rand.RandomDouble();
+	double accumulatedProbability = 0.0;
+	for( int i = 0; i < numberOfInteractions; ++i )
+	{
+		double interactionPower = 0.0;
+		for( int b = 0; b < nBands; ++b )	interactionPower += weight[b] * interactionFactors[i][b];
+		double probability = interactionPower / total;
+
+		accumulatedProbability += probability;
+		if( ( probability > 0.0 ) && ( randomNumber < accumulatedProbability ) )
+		{
+			for( int b = 0; b < nBands; ++b )
+				weight[b] = float( weight[b] * interactionFactors[i][b] / probability );
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*!
+ * Multiplies the weights of all the bands by \a factor, the fraction of power that an interaction keeps in all the bands.
+ */
+void SpectralWeights::Scale( double factor )
+{
+	for( int b = 0; b < nBands; ++b )	weight[b] = float( weight[b] * factor );
+}
+
+/*!
+ * Returns the sum of the weights of all the bands.
+ */
+double SpectralWeights::Total() const
+{
+	double total = 0.0;
+	for( int b = 0; b < nBands; ++b )	total += weight[b];
+	return total;
+}
+
+/*!
+ * Returns the factors per band written in \a bandValues, separated by spaces, tabs, commas or semicolons.
+ * The values that are not numbers are read as zero and the factors are limited to the [0, 1] range.
+ */
+std::vector< double > SpectralWeights::ReadBandFactors( const char* bandValues )
+{
+	std::vector< double > factors;
+	if( !bandValues )	return factors;
+
+	const char* separators = " \t\r\n,;";
+	const char* position = bandValues + strspn( bandValues, separators );
+	while( *position )
+	{
+		size_t length = strcspn( position, separators );
+		std::string token( position, length );
+
+		char* end = 0;
+		double value = strtod( token.c_str(), &end );
+		if( *end != '\0' )	value = 0.0;
+		if( value < 0.0 )	value = 0.0;
+		if( value > 1.0 )	value = 1.0;
+		factors.push_back( value );
+
+		position += length;
+		position += strspn( position, separators );
+	}
+	return factors;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include "RandomDeviate.h"
+#include "SunDirectionBank.h"
+#include "TSunShape.h"
+
+/*!
+ * Creates an empty bank of \a bankSize directions of the \a sunShape. The first call to NextDirection fills it.
+ */
+SunDirectionBank::SunDirectionBank( const TSunShape* sunShape, int bankSize )
+:m_sunShape( sunShape ),
+ m_bankSize( bankSize ),
+ m_nextDirection( 0 )
+{
+	if( m_bankSize < 1 )	m_bankSize = 1;
+	m_nextDirection = m_bankSize;
+
+	m_directionX.resize( m_bankSize );
+	m_directionY.resize( m_bankSize );
+	m_directionZ.resize( m_bankSize );
+}
+
+SunDirectionBank::~SunDirectionBank()
+{
+}
+
+/*!
+ * Returns the number of directions generated together.
+ */
+int SunDirectionBank::BankSize() const
+{
+	return m_bankSize;
+}
+
+/*!
+ * Returns the bank size for a tracing loop of \a numberOfRays rays. It is the default size, or the number of rays if
+ * it is lower, so that a short loop does not generate directions that are not used.
+ */
+int SunDirectionBank::BankSizeForRays( double numberOfRays )
+{
+	if( numberOfRays < m_defaultBankSize )	return ( numberOfRays < 1.0 ) ? 1 : int( numberOfRays );
+	return m_defaultBankSize;
+}
+
+/*!
+ * Generates a new bank of directions with the random numbers of \a rand.
+ */
+void SunDirectionBank::Fill( RandomDeviate& rand )
+{
+	m_sunShape->GenerateRayDirections( &m_directionX[0], &m_directionY[0], &m_directionZ[0], m_bankSize, rand );
+	m_nextDirection = 0;
+}
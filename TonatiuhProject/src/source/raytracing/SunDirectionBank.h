@@ -0,0 +1,87 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef SUNDIRECTIONBANK_H_
+#define SUNDIRECTIONBANK_H_
+
+#include <vector>
+
+#include "Vector3D.h"
+
+class RandomDeviate;
+class TSunShape;
+
+//!  SunDirectionBank class stores a bank of sun directions that are generated together.
+/*!
+ * The directions are generated with TSunShape::GenerateRayDirections a bank at a time and NextDirection
+ * returns them one by one, so the sunshape is called once for each bank instead of once for each ray.
+ * A bank is not shared between threads, each tracing loop has its own bank.
+*/
+
+class SunDirectionBank
+{
+public:
+	explicit SunDirectionBank( const TSunShape* sunShape, int bankSize = m_defaultBankSize );
+	~SunDirectionBank();
+
+	int BankSize() const;
+	static int BankSizeForRays( double numberOfRays );
+
+	Vector3D NextDirection( RandomDeviate& rand )
+	{
+		if( m_nextDirection >= m_bankSize )	Fill( rand );
+
+		int i = m_nextDirection++;
+		return Vector3D( m_directionX[i], m_directionY[i], m_directionZ[i] );
+	}
+
+	enum { m_defaultBankSize = 256 };
+
+private:
+	void Fill( RandomDeviate& rand );
+
+	const TSunShape* m_sunShape;
+	int m_bankSize;
+	int m_nextDirection;
+	std::vector< double > m_directionX;
+	std::vector< double > m_directionY;
+	std::vector< double > m_directionZ;
+};
+
+#endif /* SUNDIRECTIONBANK_H_ */
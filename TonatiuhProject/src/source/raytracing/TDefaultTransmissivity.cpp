@@ -57,7 +57,7 @@ TDefaultTransmissivity::~TDefaultTransmissivity()
 
 }
 
-bool TDefaultTransmissivity::IsTransmitted( double /*distance*/, RandomDeviate& /*rand*/ ) const
+double TDefaultTransmissivity::Transmittance( double /*distance*/ ) const
 {
-	return true;
+	return 1.0;
 }
@@ -36,6 +36,9 @@ Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimen
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <Inventor/sensors/SoNodeSensor.h>
+
+#include "DifferentialGeometry.h"
 #include "TMaterial.h"
 
 
@@ -48,11 +51,73 @@ void TMaterial::initClass()
 }
 
 TMaterial::TMaterial()
+:m_traceParametersSensor( 0 ),
+ m_traceParametersOutdated( true )
 {
 	//SO_NODE_CONSTRUCTOR( TMaterial );
 
+	m_traceParametersSensor = new SoNodeSensor( updateTraceParameters, this );
+	m_traceParametersSensor->setPriority( 0 );
+	m_traceParametersSensor->attach( this );
 }
 
 TMaterial::~TMaterial()
 {
+	delete m_traceParametersSensor;
+}
+
+/*!
+ * Returns the combination of DifferentialGeometry::GeometryFields values that OutputRay reads from the
+ * differential geometry.
+ *
+ * The default implementation returns all the fields. Materials that do not need the surface derivatives
+ * can redefine it to avoid its computation.
+ */
+int TMaterial::RequiredGeometry() const
+{
+	return DifferentialGeometry::ALL_FIELDS;
+}
+
+/*!
+ * Computes the output ray of a spectral trace. The \a weights are the power of the \a incident ray in each band and are
+ * updated with the power that the output ray keeps. The weights are not changed if no output ray is generated.
+ *
+ * The default implementation calls OutputRay, that is, the material has the same behaviour in all the bands and the
+ * weights are not changed. Materials with values per band can redefine it and use SpectralWeights::Attenuate.
+ */
+bool TMaterial::OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+		SpectralWeights* /*weights*/ ) const
+{
+	return OutputRay( incident, dg, rand, outputRay );
+}
+
+/*!
+ * Updates the material values used by OutputRay if any field has changed since the last call.
+ *
+ * This function must be called before start to compute output rays with the material.
+ */
+void TMaterial::PrepareForTrace()
+{
+	if( !m_traceParametersOutdated )	return;
+
+	ComputeTraceParameters();
+	m_traceParametersOutdated = false;
+}
+
+/*!
+ * Computes from the material fields the values used by OutputRay.
+ * Materials that read its fields in OutputRay do not need to redefine it.
+ */
+void TMaterial::ComputeTraceParameters()
+{
+
+}
+
+/*!
+ * Marks the material values used by OutputRay as outdated.
+ */
+void TMaterial::updateTraceParameters( void* data, SoSensor* )
+{
+	TMaterial* material = static_cast< TMaterial* >( data );
+	material->m_traceParametersOutdated = true;
 }
@@ -45,6 +45,9 @@ struct DifferentialGeometry;
 class RandomDeviate;
 class Ray;
 class QString;
+class SoNodeSensor;
+class SoSensor;
+struct SpectralWeights;
 
 class TMaterial : public SoMaterial
 {
@@ -55,10 +58,22 @@ public:
 
 	virtual QString getIcon() = 0;
 	virtual bool OutputRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay  ) const = 0;
+	virtual bool OutputSpectralRay( const Ray& incident, DifferentialGeometry* dg, RandomDeviate& rand, Ray* outputRay,
+			SpectralWeights* weights ) const;
+	virtual int RequiredGeometry() const;
+
+	void PrepareForTrace();
 
 protected:
+	virtual void ComputeTraceParameters();
+	static void updateTraceParameters( void* data, SoSensor* );
+
 	TMaterial();
     virtual ~TMaterial();
+
+private:
+	SoNodeSensor* m_traceParametersSensor;
+	bool m_traceParametersOutdated;
 };
 
 #endif /*TMATERIAL_H_*/
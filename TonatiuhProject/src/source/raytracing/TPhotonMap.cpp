@@ -1,5 +1,6 @@
 
 #include "PhotonMapExport.h"
+#include "PhotonMapExportThread.h"
 #include "TPhotonMap.h"
 
 /*!
@@ -8,8 +9,10 @@
 TPhotonMap::TPhotonMap()
 :m_bufferSize( 0 ),
  m_pExportPhotonMap( 0 ),
+ m_pExportThread( 0 ),
  m_storedPhotonsInBuffer( 0 ),
- m_storedAllPhotons( 0 )
+ m_storedAllPhotons( 0 ),
+ m_pPhotonsInMemory( &m_photonsWithoutExport )
 {
 
 }
@@ -19,39 +22,18 @@ TPhotonMap::TPhotonMap()
  */
 TPhotonMap::~TPhotonMap()
 {
-	unsigned int photonListSize = m_photonsInMemory.size();
-	for( unsigned int i = 0; i < photonListSize ;++i )
-	{
-		delete m_photonsInMemory[i];
-		m_photonsInMemory[i] = 0;
-	}
-
-	m_photonsInMemory.clear();
-	std::vector< Photon* >( m_photonsInMemory ).swap( m_photonsInMemory );
+	delete m_pExportThread;
 	m_storedPhotonsInBuffer = 0;
 }
 
 /*!
- * Checks where the photon map has to be saved and saves them.
+ * Saves the photons of the buffer and waits until the export mode has saved all the buffers before ending the export.
  */
 void TPhotonMap::EndStore( double wPhoton )
 {
-	if( m_storedPhotonsInBuffer  > 0 )
-	{
-		if( m_pExportPhotonMap ) m_pExportPhotonMap->SavePhotonMap( m_photonsInMemory );
-
-		unsigned int photonListSize = m_photonsInMemory.size();
-		for( unsigned int i = 0; i < photonListSize ;++i )
-		{
-			delete m_photonsInMemory[i];
-			m_photonsInMemory[i] = 0;
-		}
+	if( m_storedPhotonsInBuffer  > 0 )	SaveBuffer();
+	if( m_pExportThread )	m_pExportThread->Flush();
 
-		m_photonsInMemory.clear();
-    	std::vector< Photon* >( m_photonsInMemory ).swap( m_photonsInMemory );
-		m_storedPhotonsInBuffer = 0;
-
-	}
 	m_pExportPhotonMap->SetPowerPerPhoton( wPhoton );
 
 
@@ -59,11 +41,11 @@ void TPhotonMap::EndStore( double wPhoton )
 }
 
 /*!
- *
+ * Returns the photons stored since the last time that the buffer was saved.
  */
-std::vector< Photon* > TPhotonMap::GetAllPhotons() const
+const PhotonArena& TPhotonMap::GetAllPhotons() const
 {
-	return ( m_photonsInMemory );
+	return ( *m_pPhotonsInMemory );
 }
 
 /*!
@@ -75,6 +57,31 @@ PhotonMapExport* TPhotonMap::GetExportMode( ) const
 	return ( m_pExportPhotonMap );
 }
 
+/*!
+ * Returns the number of photons stored in the photon map since it was created.
+ */
+unsigned long TPhotonMap::GetNumberOfStoredPhotons() const
+{
+	return m_storedAllPhotons;
+}
+
+/*!
+ * Gives the buffer to the export thread and continues storing the photons in an empty buffer. While the export thread
+ * has no empty buffer, waits for the export mode to save one. Without export mode the photons are discarded.
+ */
+void TPhotonMap::SaveBuffer()
+{
+	if( m_pExportThread )
+	{
+		m_pExportThread->SaveBuffer( m_pPhotonsInMemory );
+		m_pPhotonsInMemory = m_pExportThread->TakeBuffer();
+	}
+	else
+		m_pPhotonsInMemory->Clear();
+
+	m_storedPhotonsInBuffer = 0;
+}
+
 /*!
  * Sets the size of the buffer to \a nPhotons.
  */
@@ -94,6 +101,9 @@ void TPhotonMap::SetConcentratorToWorld( Transform concentratorToWorld )
 
 /*!
  *Sets the photonmap export mode.
+ *
+ * The buffers are saved with the export mode in an export thread, so that the tracing fills the next buffer
+ * while the previous ones are saved.
  */
 bool TPhotonMap::SetExportMode( PhotonMapExport* pExportPhotonMap )
 {
@@ -103,29 +113,44 @@ bool TPhotonMap::SetExportMode( PhotonMapExport* pExportPhotonMap )
 
 	if( !m_pExportPhotonMap->StartExport() ) return 0;
 
+	PhotonArena* photonsInMemory = m_pPhotonsInMemory;
+	PhotonMapExportThread* previousExportThread = m_pExportThread;
+
+	m_pExportThread = new PhotonMapExportThread( m_pExportPhotonMap, m_numberOfExportBuffers );
+	m_pExportThread->start();
+	m_pPhotonsInMemory = m_pExportThread->TakeBuffer();
+	m_pPhotonsInMemory->Append( *photonsInMemory );
+
+	delete previousExportThread;
+	m_photonsWithoutExport.Clear();
+
 	return 1;
 }
 
+/*!
+ * Copies the photons of \a raysList to the buffer. If the buffer is full, the stored photons are given to the export thread first.
+ */
 void TPhotonMap::StoreRays( std::vector< Photon >& raysList )
 {
 	unsigned int raysListSize = raysList.size();
-	if( ( m_storedPhotonsInBuffer > 0 ) && ( ( m_storedPhotonsInBuffer + raysListSize )  > m_bufferSize ) )
-	{
-		if( m_pExportPhotonMap ) m_pExportPhotonMap->SavePhotonMap( m_photonsInMemory );
-
-		unsigned int photonListSize = m_photonsInMemory.size();
-		for( unsigned int i = 0; i < photonListSize ;++i )
-		{
-			delete m_photonsInMemory[i];
-			m_photonsInMemory[i] = 0;
-		}
-		m_photonsInMemory.clear();
-    	std::vector< Photon* >( m_photonsInMemory ).swap( m_photonsInMemory );
-		m_storedPhotonsInBuffer = 0;
-	}
+	if( ( m_storedPhotonsInBuffer > 0 ) && ( ( m_storedPhotonsInBuffer + raysListSize )  > m_bufferSize ) )	SaveBuffer();
+
+	m_pPhotonsInMemory->Append( raysList );
+
+	m_storedPhotonsInBuffer += raysListSize;
+	m_storedAllPhotons += raysListSize;
+}
+
+/*!
+ * Copies the photons of \a raysList, with their band weights, to the buffer. If the buffer is full, the stored photons
+ * are given to the export thread first.
+ */
+void TPhotonMap::StoreRays( const PhotonArena& raysList )
+{
+	unsigned long raysListSize = raysList.size();
+	if( ( m_storedPhotonsInBuffer > 0 ) && ( ( m_storedPhotonsInBuffer + raysListSize )  > m_bufferSize ) )	SaveBuffer();
 
-	for( unsigned int photon = 0; photon < raysListSize; photon++ )
-		m_photonsInMemory.push_back( new Photon( raysList[photon] ) );
+	m_pPhotonsInMemory->Append( raysList );
 
 	m_storedPhotonsInBuffer += raysListSize;
 	m_storedAllPhotons += raysListSize;
@@ -2,8 +2,10 @@
 #define TPHOTONMAP_H_
 
 #include "Photon.h"
+#include "PhotonArena.h"
 
 class PhotonMapExport;
+class PhotonMapExportThread;
 
 class TPhotonMap
 {
@@ -12,22 +14,30 @@ public:
 	~TPhotonMap();
 
     void EndStore( double wPhoton );
-	std::vector< Photon* > GetAllPhotons() const;
+	const PhotonArena& GetAllPhotons() const;
 	PhotonMapExport* GetExportMode( ) const;
+	unsigned long GetNumberOfStoredPhotons() const;
 	void SetBufferSize( unsigned long nPhotons );
 	void SetConcentratorToWorld( Transform concentratorToWorld );
 	bool SetExportMode( PhotonMapExport* pExportPhotonMap );
 	void StoreRays( std::vector< Photon >& ray );
+	void StoreRays( const PhotonArena& raysList );
 
 
 private:
+	void SaveBuffer();
+
+    enum { m_numberOfExportBuffers = 3 };
+
     unsigned long m_bufferSize;
     Transform m_concentratorToWorld;
     PhotonMapExport* m_pExportPhotonMap;
+    PhotonMapExportThread* m_pExportThread;
 	const SceneModel* m_pSceneModel;
     unsigned long m_storedPhotonsInBuffer;
     unsigned long m_storedAllPhotons;
-    std::vector< Photon* > m_photonsInMemory;
+    PhotonArena* m_pPhotonsInMemory;
+    PhotonArena m_photonsWithoutExport;
 
 
 };
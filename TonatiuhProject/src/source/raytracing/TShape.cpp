@@ -36,6 +36,11 @@ Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimen
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <Inventor/sensors/SoNodeSensor.h>
+
+#include "DifferentialGeometry.h"
+#include "Ray.h"
+#include "RayBatch.h"
 #include "TShape.h"
 
 SO_NODE_ABSTRACT_SOURCE(TShape);
@@ -46,11 +51,105 @@ void TShape::initClass()
 }
 
 TShape::TShape()
+:m_traceParametersSensor( 0 ),
+ m_traceParametersOutdated( true )
 {
-
+	m_traceParametersSensor = new SoNodeSensor( updateTraceParameters, this );
+	m_traceParametersSensor->setPriority( 0 );
+	m_traceParametersSensor->attach( this );
 }
 
 TShape::~TShape()
 {
+	delete m_traceParametersSensor;
+}
+
+/*!
+ * Computes the intersection of each ray in \a objectRays with the shape.
+ *
+ * On return \a isHit[i] is true if the ray i intersects the shape and \a tHit[i] is the distance to the intersection.
+ * For the rays that do not intersect the shape \a tHit value is undefined. Both arrays must have objectRays.Size() elements.
+ *
+ * The default implementation calls IntersectHit for each ray. Shapes can redefine it with a vectorizable version.
+ */
+void TShape::IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const
+{
+	for( int i = 0; i < objectRays.Size(); ++i )
+	{
+		Ray objectRay = objectRays.GetRay( i );
+		ShapeHit hit;
+		double thit = 0.0;
+		isHit[i] = IntersectHit( objectRay, &thit, &hit );
+		tHit[i] = thit;
+	}
+}
+
+/*!
+ * Computes the closest intersection of \a objectRay with the shape without computing the surface derivatives.
+ *
+ * Returns true if the ray intersects the shape. In this case \a tHit is the distance to the intersection and
+ * \a hit stores the parameters needed to compute later the complete geometry with ComputeDifferentialGeometry.
+ *
+ * The default implementation calls Intersect. Shapes can redefine it to skip the derivatives computation.
+ */
+bool TShape::IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const
+{
+	DifferentialGeometry dg;
+	if( !Intersect( objectRay, tHit, &dg ) )	return false;
+
+	hit->u = dg.u;
+	hit->v = dg.v;
+	hit->dpdu = dg.dpdu;
+	hit->dpdv = dg.dpdv;
+	hit->shapeFrontSide = dg.shapeFrontSide;
+	return true;
+}
+
+/*!
+ * Computes in \a dg the geometry of the intersection \a hit found by IntersectHit at distance \a tHit of the \a objectRay origin.
+ *
+ * The \a fields is a combination of DifferentialGeometry::GeometryFields values with the values to compute. The
+ * values not included could be not computed.
+ *
+ * The default implementation repeats the intersection with Intersect limiting the ray to \a tHit.
+ */
+void TShape::ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& /*hit*/,
+		int /*fields*/, DifferentialGeometry* dg ) const
+{
+	Ray hitRay( objectRay );
+	hitRay.maxt = tHit;
 
+	double thit = 0.0;
+	Intersect( hitRay, &thit, dg );
+}
+
+/*!
+ * Updates the shape values used by the intersection functions if any field has changed since the last call.
+ *
+ * This function must be called before start to compute intersections with the shape.
+ */
+void TShape::PrepareForTrace()
+{
+	if( !m_traceParametersOutdated )	return;
+
+	ComputeTraceParameters();
+	m_traceParametersOutdated = false;
+}
+
+/*!
+ * Computes from the shape fields the values used by the intersection functions.
+ * Shapes that read its fields in the intersection functions do not need to redefine it.
+ */
+void TShape::ComputeTraceParameters()
+{
+
+}
+
+/*!
+ * Marks the shape values used by the intersection functions as outdated.
+ */
+void TShape::updateTraceParameters( void* data, SoSensor* )
+{
+	TShape* shape = static_cast< TShape* >( data );
+	shape->m_traceParametersOutdated = true;
 }
@@ -47,6 +47,10 @@ struct NormalVector;
 struct Point3D;
 class QString;
 class Ray;
+class RayBatch;
+struct ShapeHit;
+class SoNodeSensor;
+class SoSensor;
 
 class TShape : public SoShape
 {
@@ -57,18 +61,31 @@ public:
 
 	virtual bool IntersectP( const Ray& objectRay ) const = 0;
 	virtual bool Intersect( const Ray& objectRay, double* tHit, DifferentialGeometry* dg ) const = 0;
+	virtual void IntersectBatch( const RayBatch& objectRays, double* tHit, bool* isHit ) const;
+	virtual bool IntersectHit( const Ray& objectRay, double* tHit, ShapeHit* hit ) const;
+	virtual void ComputeDifferentialGeometry( const Ray& objectRay, double tHit, const ShapeHit& hit,
+			int fields, DifferentialGeometry* dg ) const;
 	virtual double GetArea() const = 0;
 	virtual double GetVolume() const = 0;
 	virtual BBox GetBBox() const = 0;
 	virtual QString GetIcon() const = 0;
 	virtual Point3D Sample( double u, double v ) const = 0;
 
+	void PrepareForTrace();
+
 protected:
+	virtual void ComputeTraceParameters();
+	static void updateTraceParameters( void* data, SoSensor* );
+
 	virtual void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center) = 0;
 	virtual void generatePrimitives(SoAction *action) = 0;
 
     TShape();
     ~TShape();
+
+private:
+	SoNodeSensor* m_traceParametersSensor;
+	bool m_traceParametersOutdated;
 };
 
 #endif /*TSHAPE_H_*/
@@ -36,6 +36,10 @@ Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimen
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <cmath>
+
+#include "gc.h"
+
 #include "TSunShape.h"
 
 SO_NODE_ABSTRACT_SOURCE(TSunShape);
@@ -52,3 +56,40 @@ TSunShape::TSunShape()
 TSunShape::~TSunShape()
 {
 }
+
+/*!
+ * Generates \a numberOfDirections ray directions. The components of the i-th direction are stored
+ * in \a directionX[i], \a directionY[i] and \a directionZ[i].
+ */
+void TSunShape::GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+		int numberOfDirections, RandomDeviate& rand ) const
+{
+	Vector3D direction;
+	for( int i = 0; i < numberOfDirections; ++i )
+	{
+		GenerateRayDirection( direction, rand );
+		directionX[i] = direction.x;
+		directionY[i] = direction.y;
+		directionZ[i] = direction.z;
+	}
+}
+
+/*!
+ * Builds \a numberOfDirections directions from their azimuths and zenith angles.
+ *
+ * On input \a directionX has the azimuth of each direction divided by 2 pi and \a directionZ
+ * has the squared sine of its zenith angle. On output the arrays have the direction components.
+ */
+void TSunShape::ComputeDirections( double* directionX, double* directionY, double* directionZ, int numberOfDirections )
+{
+	for( int i = 0; i < numberOfDirections; ++i )
+	{
+		double sinTheta2 = directionZ[i];
+		double sinTheta = sqrt( sinTheta2 );
+		double phi = gc::TwoPi * directionX[i];
+
+		directionX[i] = sinTheta * sin( phi );
+		directionY[i] = -sqrt( 1.0 - sinTheta2 );
+		directionZ[i] = sinTheta * cos( phi );
+	}
+}
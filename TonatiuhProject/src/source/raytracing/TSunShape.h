@@ -46,6 +46,14 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "Vector3D.h"
 #include "RandomDeviate.h"
 
+/*!
+ * Base class of the sunshape nodes, that give the direction of the sun rays in the light coordinates.
+ *
+ * GenerateRayDirections fills a batch of directions in structure of arrays form. The default
+ * implementation calls GenerateRayDirection for each direction. A sunshape that overrides it can
+ * sample the azimuths and the zenith angles of the batch first and then build all the directions
+ * with ComputeDirections, in loops the compiler can vectorize.
+ */
 class TSunShape : public SoNode
 {
 	  typedef SoNode inherited;
@@ -56,12 +64,16 @@ public:
     static void initClass();
 
 	virtual void GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const = 0;
+	virtual void GenerateRayDirections( double* directionX, double* directionY, double* directionZ,
+			int numberOfDirections, RandomDeviate& rand ) const;
 	virtual double GetIrradiance() const = 0;
     virtual double GetThetaMax() const = 0;
 
 protected:
     TSunShape();
     virtual ~TSunShape();
+
+    static void ComputeDirections( double* directionX, double* directionY, double* directionZ, int numberOfDirections );
 };
 
 #endif /*TSUNSHAPE_H_*/
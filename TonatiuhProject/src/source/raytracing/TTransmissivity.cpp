@@ -36,19 +36,75 @@ Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimen
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
 
+#include <Inventor/sensors/SoNodeSensor.h>
+
 #include "TTransmissivity.h"
 
 SO_NODE_ABSTRACT_SOURCE(TTransmissivity);
 
+const double TTransmissivity::m_tableStep = 1.0;
+
 void TTransmissivity::initClass()
 {
 	SO_NODE_INIT_ABSTRACT_CLASS(TTransmissivity, SoNode, "Node");
 }
 
 TTransmissivity::TTransmissivity()
+:m_traceParametersSensor( 0 ),
+ m_traceParametersOutdated( true ),
+ m_inverseTableStep( 1.0 / m_tableStep )
 {
+	m_traceParametersSensor = new SoNodeSensor( updateTraceParameters, this );
+	m_traceParametersSensor->setPriority( 0 );
+	m_traceParametersSensor->attach( this );
 }
 
 TTransmissivity::~TTransmissivity()
 {
+	delete m_traceParametersSensor;
+}
+
+/*!
+ * Returns true if the ray is transmitted along \a distance. The ray is transmitted with probability AttenuationFactor( distance ).
+ */
+bool TTransmissivity::IsTransmitted( double distance, RandomDeviate& rand ) const
+{
+	return ( rand.RandomDouble() < AttenuationFactor( distance ) );
+}
+
+/*!
+ * Builds the transmittance table if any field has changed since the last call.
+ *
+ * This function must be called before start to compute the attenuation of the rays.
+ */
+void TTransmissivity::PrepareForTrace()
+{
+	if( !m_traceParametersOutdated && !m_table.empty() )	return;
+
+	std::vector< double > table( m_tableSize + 1 );
+	for( int i = 0; i <= m_tableSize; ++i )
+		table[i] = ClampedTransmittance( i * m_tableStep );
+
+	m_table.swap( table );
+	m_traceParametersOutdated = false;
+}
+
+/*!
+ * Marks the transmittance table as outdated.
+ */
+void TTransmissivity::updateTraceParameters( void* data, SoSensor* )
+{
+	TTransmissivity* transmissivity = static_cast< TTransmissivity* >( data );
+	transmissivity->m_traceParametersOutdated = true;
+}
+
+/*!
+ * Returns Transmittance( \a distance ) limited to the interval [0, 1].
+ */
+double TTransmissivity::ClampedTransmittance( double distance ) const
+{
+	double t = Transmittance( distance );
+	if( t < 0.0 )	return 0.0;
+	if( t > 1.0 )	return 1.0;
+	return t;
 }
@@ -39,11 +39,27 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #ifndef TTRANSMISSIVITY_H_
 #define TTRANSMISSIVITY_H_
 
+#include <vector>
+
 #include <Inventor/nodes/SoNode.h>
 #include <Inventor/nodes/SoSubNode.h>
 
 #include "RandomDeviate.h"
 
+class SoNodeSensor;
+class SoSensor;
+
+/*!
+ * Base class of the atmospheric attenuation models.
+ *
+ * Transmittance returns the fraction of the power that is transmitted along a given distance.
+ * PrepareForTrace tabulates it for the distances up to m_tableSize * m_tableStep, so that
+ * AttenuationFactor only needs a linear interpolation. The table is built again when any field
+ * of the node changes.
+ *
+ * The ray tracer can kill the ray with the probability of being attenuated, with IsTransmitted,
+ * or multiply the ray power by AttenuationFactor.
+ */
 class TTransmissivity : public SoNode
 {
 	  typedef SoNode inherited;
@@ -53,11 +69,41 @@ class TTransmissivity : public SoNode
 public:
     static void initClass();
 
-	virtual bool IsTransmitted( double distance, RandomDeviate& rand ) const = 0;
+	virtual bool IsTransmitted( double distance, RandomDeviate& rand ) const;
+	virtual double Transmittance( double distance ) const = 0;
+
+	void PrepareForTrace();
+
+	/*!
+	 * Returns the fraction of the power transmitted along \a distance, between 0 and 1.
+	 * The distances out of the table are computed with Transmittance.
+	 */
+	double AttenuationFactor( double distance ) const
+	{
+		double x = distance * m_inverseTableStep;
+		if( !( x < m_tableSize ) || x < 0.0 || m_table.empty() )	return ClampedTransmittance( distance );
+
+		int i = int( x );
+		double f = x - i;
+		return m_table[i] + f * ( m_table[i + 1] - m_table[i] );
+	}
+
+	enum { m_tableSize = 8192 };
+	static const double m_tableStep;
 
 protected:
 	TTransmissivity();
     virtual ~TTransmissivity();
+
+	static void updateTraceParameters( void* data, SoSensor* );
+
+private:
+	double ClampedTransmittance( double distance ) const;
+
+	SoNodeSensor* m_traceParametersSensor;
+	bool m_traceParametersOutdated;
+	double m_inverseTableStep;
+	std::vector< double > m_table;
 };
 
 #endif /* TTRANSMISSIVITY_H_ */
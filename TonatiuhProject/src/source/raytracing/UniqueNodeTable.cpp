@@ -0,0 +1,220 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <Inventor/SbName.h>
+#include <Inventor/SbString.h>
+#include <Inventor/fields/SoField.h>
+#include <Inventor/lists/SoFieldList.h>
+#include <Inventor/nodes/SoNode.h>
+
+#include "TMaterial.h"
+#include "TShape.h"
+#include "UniqueNodeTable.h"
+
+
+UniqueNodeTable::UniqueNodeTable()
+:m_numberOfMaterials( 0 )
+{
+
+}
+
+UniqueNodeTable::~UniqueNodeTable()
+{
+
+}
+
+/*!
+ * Removes all the nodes from the table.
+ *
+ * The field values of the nodes compared since the previous call are kept for the next use of the table. The values
+ * of the other nodes are removed.
+ */
+void UniqueNodeTable::Clear()
+{
+	m_uniqueNodes.clear();
+	m_nodesByValues.clear();
+	m_shapeBBoxes.clear();
+	m_numberOfMaterials = 0;
+
+	QHash< SoNode*, NodeFieldValues >::iterator it = m_fieldValues.begin();
+	while( it != m_fieldValues.end() )
+	{
+		if( it->isUsed )
+		{
+			it->isUsed = false;
+			++it;
+		}
+		else it = m_fieldValues.erase( it );
+	}
+}
+
+/*!
+ * Returns the shape of the table equal to \a shape. If the table has not an equal shape, \a shape is added to
+ * the table, it is prepared for the ray tracing and its bounding box is stored.
+ */
+TShape* UniqueNodeTable::AddShape( TShape* shape )
+{
+	if( !shape ) return 0;
+
+	bool isNew = false;
+	TShape* uniqueShape = static_cast< TShape* >( UniqueNode( shape, &isNew ) );
+	if( isNew )
+	{
+		uniqueShape->PrepareForTrace();
+		m_shapeBBoxes.insert( uniqueShape, uniqueShape->GetBBox() );
+	}
+	return uniqueShape;
+}
+
+/*!
+ * Returns the material of the table equal to \a material. If the table has not an equal material,
+ * \a material is added to the table and it is prepared for the ray tracing.
+ */
+TMaterial* UniqueNodeTable::AddMaterial( TMaterial* material )
+{
+	if( !material ) return 0;
+
+	bool isNew = false;
+	TMaterial* uniqueMaterial = static_cast< TMaterial* >( UniqueNode( material, &isNew ) );
+	if( isNew )
+	{
+		uniqueMaterial->PrepareForTrace();
+		++m_numberOfMaterials;
+	}
+	return uniqueMaterial;
+}
+
+/*!
+ * Returns the object space bounding box of \a uniqueShape. The shape must be a shape returned by AddShape.
+ */
+BBox UniqueNodeTable::ShapeBBox( TShape* uniqueShape ) const
+{
+	return m_shapeBBoxes.value( uniqueShape );
+}
+
+/*!
+ * Returns the number of different shapes in the table.
+ */
+int UniqueNodeTable::NumberOfShapes() const
+{
+	return m_shapeBBoxes.count();
+}
+
+/*!
+ * Returns the number of different materials in the table.
+ */
+int UniqueNodeTable::NumberOfMaterials() const
+{
+	return m_numberOfMaterials;
+}
+
+/*!
+ * Returns the node of the table equal to \a node and sets \a isNew to false. If there is not an equal node,
+ * \a node is added to the table and \a isNew is set to true.
+ *
+ * The nodes are first looked up by their address, because the instances of a scene share their Coin nodes. Only
+ * the nodes not found are grouped by the text of their field values and the nodes of a group are compared with
+ * SoFieldContainer::fieldsAreEqual, so that values that have the same text but are not equal are not merged.
+ */
+SoNode* UniqueNodeTable::UniqueNode( SoNode* node, bool* isNew )
+{
+	*isNew = false;
+	SoNode* uniqueNode = m_uniqueNodes.value( node, 0 );
+	if( uniqueNode ) return uniqueNode;
+
+	QString values = FieldValues( node );
+	QMultiHash< QString, SoNode* >::const_iterator it = m_nodesByValues.constFind( values );
+	while( it != m_nodesByValues.constEnd() && it.key() == values )
+	{
+		SoNode* candidate = it.value();
+		if( ( candidate->getTypeId() == node->getTypeId() ) && node->fieldsAreEqual( candidate ) )
+		{
+			m_uniqueNodes.insert( node, candidate );
+			return candidate;
+		}
+		++it;
+	}
+
+	m_nodesByValues.insert( values, node );
+	m_uniqueNodes.insert( node, node );
+	*isNew = true;
+	return node;
+}
+
+/*!
+ * Returns a text with the type name of \a node and the names and values of all its fields.
+ *
+ * The text is stored with the node id, that Coin changes each time the node is modified, and it is only
+ * computed again if the node has changed.
+ */
+QString UniqueNodeTable::FieldValues( SoNode* node )
+{
+	QHash< SoNode*, NodeFieldValues >::iterator cached = m_fieldValues.find( node );
+	if( ( cached != m_fieldValues.end() ) && ( cached->nodeId == node->getNodeId() ) )
+	{
+		cached->isUsed = true;
+		return cached->values;
+	}
+
+	QString values( node->getTypeId().getName().getString() );
+
+	SoFieldList fields;
+	int numberOfFields = node->getFields( fields );
+	for( int index = 0; index < numberOfFields; ++index )
+	{
+		SoField* field = fields[index];
+		SbName fieldName;
+		node->getFieldName( field, fieldName );
+
+		SbString fieldValue;
+		field->get( fieldValue );
+
+		values.append( QLatin1String( "\n" ) );
+		values.append( QLatin1String( fieldName.getString() ) );
+		values.append( QLatin1String( " " ) );
+		values.append( QLatin1String( fieldValue.getString() ) );
+	}
+
+	NodeFieldValues nodeValues;
+	nodeValues.nodeId = node->getNodeId();
+	nodeValues.values = values;
+	nodeValues.isUsed = true;
+	m_fieldValues.insert( node, nodeValues );
+	return values;
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef UNIQUENODETABLE_H_
+#define UNIQUENODETABLE_H_
+
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+
+#include <Inventor/SbBasic.h>
+
+#include "BBox.h"
+
+class SoNode;
+class TMaterial;
+class TShape;
+
+//!  UniqueNodeTable class finds the shapes and materials of a scene that are equal.
+/*!
+ * Two nodes are equal if they are the same node or if they have the same type and all their fields have
+ * the same values. The table returns for each node the first equal node added to it, so that all the
+ * instances of a shape share one shape prepared for the ray tracing and one object space bounding box.
+ *
+ * The nodes are not referenced by the table. They must exist while the table is used. The text of the field values
+ * of the nodes is kept when the table is cleared, so that a table used for each ray tracing only computes the text
+ * of the nodes that have changed since the previous ray tracing.
+ */
+class UniqueNodeTable
+{
+public:
+	UniqueNodeTable();
+	~UniqueNodeTable();
+
+	void Clear();
+	TShape* AddShape( TShape* shape );
+	TMaterial* AddMaterial( TMaterial* material );
+	BBox ShapeBBox( TShape* uniqueShape ) const;
+
+	int NumberOfShapes() const;
+	int NumberOfMaterials() const;
+
+private:
+	SoNode* UniqueNode( SoNode* node, bool* isNew );
+	QString FieldValues( SoNode* node );
+
+	struct NodeFieldValues
+	{
+		SbUniqueId nodeId;
+		QString values;
+		bool isUsed;
+	};
+
+	QHash< SoNode*, SoNode* > m_uniqueNodes;
+	QHash< SoNode*, NodeFieldValues > m_fieldValues;
+	QMultiHash< QString, SoNode* > m_nodesByValues;
+	QHash< TShape*, BBox > m_shapeBBoxes;
+	int m_numberOfMaterials;
+};
+
+#endif /* UNIQUENODETABLE_H_ */
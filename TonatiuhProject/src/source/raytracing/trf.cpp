@@ -35,6 +35,7 @@ Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Marti
 Contributors: Javier Garcia-Barberena, I�aki Perez, Inigo Pagola,  Gilda Jimenez,
 Juana Amieva, Azael Mancillas, Cesar Cantu.
 ***************************************************************************/
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -59,6 +60,7 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "TLightKit.h"
 #include "trf.h"
 #include "TShapeKit.h"
+#include "TTransmissivity.h"
 
 
 SoSeparator* trf::DrawPhotonMapPoints( const TPhotonMap& map )
@@ -66,12 +68,12 @@ SoSeparator* trf::DrawPhotonMapPoints( const TPhotonMap& map )
 
 	SoSeparator* drawpoints = new SoSeparator;
 	SoCoordinate3* points = new SoCoordinate3;
-	std::vector< Photon* > photonsList = map.GetAllPhotons();
+	const PhotonArena& photonsList = map.GetAllPhotons();
     unsigned int numRays=0;
 
 	for( unsigned int i = 0; i < photonsList.size(); i++)
 	{
-		Point3D photon = photonsList[i]->pos;
+		Point3D photon = photonsList[i]->Position();
 		points->point.set1Value( numRays, photon.x, photon.y, photon.z );
 		numRays++;
 	}
@@ -92,6 +94,35 @@ SoSeparator* trf::DrawPhotonMapPoints( const TPhotonMap& map )
 
 }
 
+/*!
+ * Computes for each photon of \a photons the fraction of its power that is transmitted through the atmosphere with
+ * the \a transmissivity model. The factors are stored in \a attenuationFactors in the same order as the photons.
+ *
+ * The factor of a photon is the product of the transmittance of the path length of the photon and of the previous
+ * photons of the same ray. This allows to compare several attenuation models with the photons of a single trace
+ * without atmospheric attenuation. The previous segments are only known if the photons of all the surfaces are stored.
+ */
+void trf::ComputeAttenuationFactors( const PhotonArena& photons, TTransmissivity* transmissivity, std::vector< double >* attenuationFactors )
+{
+	attenuationFactors->resize( photons.size() );
+	if( !transmissivity )
+	{
+		std::fill( attenuationFactors->begin(), attenuationFactors->end(), 1.0 );
+		return;
+	}
+	transmissivity->PrepareForTrace();
+
+	double rayFactor = 1.0;
+	for( unsigned long p = 0; p < photons.size(); ++p )
+	{
+		const Photon* photon = photons[p];
+		if( p == 0 || photons[p - 1]->id != ( photon->id - 1 ) )	rayFactor = 1.0;
+		if( photon->pathLength > 0.0 )	rayFactor *= transmissivity->AttenuationFactor( photon->pathLength );
+
+		(*attenuationFactors)[p] = rayFactor;
+	}
+}
+
 SoSeparator* trf::DrawPhotonMapRays( const TPhotonMap& map, unsigned long /*numberOfRays*/ )
 {
 
@@ -99,7 +130,7 @@ SoSeparator* trf::DrawPhotonMapRays( const TPhotonMap& map, unsigned long /*numb
 	SoCoordinate3* points = new SoCoordinate3;
 
 	QVector< int >	rayLengths;
-	std::vector< Photon* > allRaysLists = map.GetAllPhotons();
+	const PhotonArena& allRaysLists = map.GetAllPhotons();
 
 
 	int nRay = 0;
@@ -109,8 +140,8 @@ SoSeparator* trf::DrawPhotonMapRays( const TPhotonMap& map, unsigned long /*numb
 		unsigned long rayLength = 0;
 		do
 		{
-			Photon* photon = allRaysLists[photonIndex];
-			Point3D photonPosistion = photon->pos;
+			const Photon* photon = allRaysLists[photonIndex];
+			Point3D photonPosistion = photon->Position();
 			points->point.set1Value( photonIndex, photonPosistion.x, photonPosistion.y, photonPosistion.z );
 			photonIndex++;
 			rayLength++;
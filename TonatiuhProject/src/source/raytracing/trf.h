@@ -52,22 +52,27 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include "TPhotonMap.h"
 #include "Ray.h"
 #include "tgf.h"
+#include "TMaterial.h"
 #include "TShape.h"
 #include "TSunShape.h"
 #include "Transform.h"
 #include "TSeparatorKit.h"
 #include "TAnalyzerKit.h"
 #include "TShapeKit.h"
+#include "UniqueNodeTable.h"
 
 
 
 class InstanceNode;
 class RandomDeviate;
 class TPhotonMap;
+class TTransmissivity;
 
 namespace trf
 {
+	void ComputeAttenuationFactors( const PhotonArena& photons, TTransmissivity* transmissivity, std::vector< double >* attenuationFactors );
 	void ComputeSceneTreeMap( InstanceNode* instanceNode, Transform parentWTO, bool insertInSurfaceList );
+	void ComputeSceneTreeMap( InstanceNode* instanceNode, Transform parentWTO, bool insertInSurfaceList, UniqueNodeTable* uniqueNodes );
 	void ComputeFistStageSurfaceList( InstanceNode* instanceNode, QStringList disabledNodesURL, QVector< QPair< TShapeKit*, Transform > >* surfacesList);
 	void CreatePhotonMap( TPhotonMap*& photonMap, QPair< TPhotonMap* ,  std::vector < Photon  > > photonsList );
 
@@ -80,8 +85,31 @@ namespace trf
  * Compute a map with the InstanceNodes of sub-tree with top node \a instanceNode.
  *
  *The map stores for each InstanceNode its BBox and its transform in global coordinates.
+ *
+ * The bounding volume hierarchy of \a instanceNode over its shape instances is updated. If only the transforms
+ * have changed since the previous call, as when the trackers follow the sun, the hierarchy is refitted.
+ *
+ * The table of equal nodes is kept between calls so that the field values of the nodes that have not changed
+ * are not converted to text again. The function must be called from one thread.
  **/
 inline void trf::ComputeSceneTreeMap( InstanceNode* instanceNode, Transform parentWTO, bool insertInSurfaceList )
+{
+	if( !instanceNode ) return;
+
+	static UniqueNodeTable uniqueNodes;
+	uniqueNodes.Clear();
+	ComputeSceneTreeMap( instanceNode, parentWTO, insertInSurfaceList, &uniqueNodes );
+	instanceNode->UpdateInstanceBVH();
+}
+
+/**
+ * Compute a map with the InstanceNodes of sub-tree with top node \a instanceNode.
+ *
+ * Equal shapes and materials are found with the \a uniqueNodes table. Each shape InstanceNode uses the shape and the
+ * material of the table for the intersections, so that the shapes are prepared for the ray tracing and their bounding
+ * box is computed once for all their instances.
+ **/
+inline void trf::ComputeSceneTreeMap( InstanceNode* instanceNode, Transform parentWTO, bool insertInSurfaceList, UniqueNodeTable* uniqueNodes )
 {
 
 	if( !instanceNode ) return;
@@ -106,7 +134,7 @@ inline void trf::ComputeSceneTreeMap( InstanceNode* instanceNode, Transform pare
 		for( int index = 0; index < instanceNode->children.count() ; ++index )
 		{
 			InstanceNode* childInstance = instanceNode->children[index];
-			ComputeSceneTreeMap(childInstance, nodeWTO, insertChildInSurfaceList );
+			ComputeSceneTreeMap(childInstance, nodeWTO, insertChildInSurfaceList, uniqueNodes );
 
 			nodeBB = Union( nodeBB, childInstance->GetIntersectionBBox() );
 		}
@@ -134,18 +162,32 @@ inline void trf::ComputeSceneTreeMap( InstanceNode* instanceNode, Transform pare
 
 
 		BBox shapeBB;
+		instanceNode->SetTraceNodes( 0, 0 );
 
 		if(  instanceNode->children.count() > 0 )
 		{
 			InstanceNode* shapeInstance = 0;
+			InstanceNode* materialInstance = 0;
 			if( instanceNode->children[0]->GetNode()->getTypeId().isDerivedFrom( TShape::getClassTypeId() ) )
+			{
 				shapeInstance =  instanceNode->children[0];
-			else if(  instanceNode->children.count() > 1 )	shapeInstance =  instanceNode->children[1];
+				if(  instanceNode->children.count() > 1 )	materialInstance =  instanceNode->children[1];
+			}
+			else if(  instanceNode->children.count() > 1 )
+			{
+				materialInstance =  instanceNode->children[0];
+				shapeInstance =  instanceNode->children[1];
+			}
 
 			if( shapeInstance )
 			{
-				TShape* shapeNode = static_cast< TShape* > ( shapeInstance->GetNode() );
-				shapeBB = shapeToWorld( shapeNode->GetBBox() );
+				TShape* shapeNode = uniqueNodes->AddShape( static_cast< TShape* > ( shapeInstance->GetNode() ) );
+				TMaterial* materialNode = 0;
+				if( materialInstance )
+					materialNode = uniqueNodes->AddMaterial( static_cast< TMaterial* > ( materialInstance->GetNode() ) );
+				instanceNode->SetTraceNodes( shapeNode, materialNode );
+
+				shapeBB = shapeToWorld( uniqueNodes->ShapeBBox( shapeNode ) );
 
 				instanceNode->SetIntersectionTransform( shapeTransform );
 				instanceNode->SetIntersectionBBox( shapeBB );
@@ -0,0 +1,207 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+
+#include "ErrorDistribution.h"
+#include "RandomDeviate.h"
+
+/*!
+ * Ziggurat tables for the standard normal distribution, with the 128 layers of Marsaglia and Tsang and the
+ * double precision variant of Doornik. The table is built when the library is loaded.
+ */
+struct NormalZiggurat
+{
+	enum { m_layers = 128 };
+
+	NormalZiggurat()
+	{
+		double f = exp( -0.5 * m_r * m_r );
+		x[0] = m_v / f;
+		x[1] = m_r;
+		x[m_layers] = 0.0;
+		for( int i = 2; i < m_layers; ++i )
+		{
+			x[i] = sqrt( -2.0 * log( m_v / x[i - 1] + f ) );
+			f = exp( -0.5 * x[i] * x[i] );
+		}
+		for( int i = 0; i < m_layers; ++i )
+			ratio[i] = x[i + 1] / x[i];
+	}
+
+	static const double m_r;	// Start of the tail
+	static const double m_v;	// Area of each layer
+
+	double x[m_layers + 1];
+	double ratio[m_layers];
+};
+
+const double NormalZiggurat::m_r = 3.442619855899;
+const double NormalZiggurat::m_v = 9.91256303526217e-3;
+
+static const NormalZiggurat normalZiggurat;
+
+/*!
+ * Returns a sample of the standard normal distribution tail beyond \a r, with the sign of \a isNegative.
+ */
+static double NormalTail( double r, bool isNegative, RandomDeviate& rand )
+{
+	double x, y;
+	do
+	{
+		x = log( 1.0 - rand.RandomDouble() ) / r;
+		y = log( 1.0 - rand.RandomDouble() );
+	}
+	while( -2.0 * y < x * x );
+
+	return isNegative ? x - r : r - x;
+}
+
+/*!
+ * Creates a pillbox distribution without error.
+ */
+ErrorDistribution::ErrorDistribution()
+:m_type( PILLBOX ),
+ m_sigma( 0.0 )
+{
+
+}
+
+/*!
+ * Creates a distribution of the \a type with the error \a sigma, in radians.
+ */
+ErrorDistribution::ErrorDistribution( int type, double sigma )
+:m_type( type ),
+ m_sigma( sigma )
+{
+
+}
+
+ErrorDistribution::~ErrorDistribution()
+{
+
+}
+
+/*!
+ * Returns the distribution type.
+ */
+int ErrorDistribution::GetType() const
+{
+	return m_type;
+}
+
+/*!
+ * Returns the distribution error in radians.
+ */
+double ErrorDistribution::GetSigma() const
+{
+	return m_sigma;
+}
+
+/*!
+ * Returns an error vector in the local frame of the ideal direction, that is the y axis.
+ */
+Vector3D ErrorDistribution::Sample( RandomDeviate& rand ) const
+{
+	if( m_type == NORMAL )
+		return Vector3D( m_sigma * StandardNormal( rand ), 1.0, m_sigma * StandardNormal( rand ) );
+
+	return SamplePillbox( rand );
+}
+
+/*!
+ * Returns a sample of the normal distribution with zero mean and unit standard deviation.
+ */
+double ErrorDistribution::StandardNormal( RandomDeviate& rand )
+{
+	while( true )
+	{
+		int i = int( NormalZiggurat::m_layers * rand.RandomDouble() );
+		double u = 2.0 * rand.RandomDouble() - 1.0;
+
+		// Inside the rectangle of the layer
+		if( fabs( u ) < normalZiggurat.ratio[i] ) return u * normalZiggurat.x[i];
+
+		if( i == 0 ) return NormalTail( NormalZiggurat::m_r, u < 0.0, rand );
+
+		// Inside the wedge of the layer under the density
+		double x = u * normalZiggurat.x[i];
+		double f0 = exp( -0.5 * ( normalZiggurat.x[i] * normalZiggurat.x[i] - x * x ) );
+		double f1 = exp( -0.5 * ( normalZiggurat.x[i + 1] * normalZiggurat.x[i + 1] - x * x ) );
+		if( f1 + rand.RandomDouble() * ( f0 - f1 ) < 1.0 ) return x;
+	}
+}
+
+/*!
+ * Returns a unit vector whose angle with the y axis is uniform between zero and sigma and whose azimuth is
+ * uniform.
+ *
+ * For a point uniformly distributed in the unit disk, its squared distance to the center is uniform and
+ * independent of its azimuth. It gives the angle and the point direction gives the azimuth sine and cosine.
+ */
+Vector3D ErrorDistribution::SamplePillbox( RandomDeviate& rand ) const
+{
+	double px, pz, s;
+	do
+	{
+		px = 2.0 * rand.RandomDouble() - 1.0;
+		pz = 2.0 * rand.RandomDouble() - 1.0;
+		s = px * px + pz * pz;
+	}
+	while( s >= 1.0 || s == 0.0 );
+
+	double theta = m_sigma * s;
+	double sinTheta;
+	double cosTheta;
+	if( theta < 0.1 )
+	{
+		// Taylor series, exact to double precision for small angles
+		double theta2 = theta * theta;
+		sinTheta = theta * ( 1.0 - theta2 / 6.0 * ( 1.0 - theta2 / 20.0 * ( 1.0 - theta2 / 42.0 ) ) );
+		cosTheta = 1.0 - theta2 / 2.0 * ( 1.0 - theta2 / 12.0 * ( 1.0 - theta2 / 30.0 * ( 1.0 - theta2 / 56.0 ) ) );
+	}
+	else
+	{
+		sinTheta = sin( theta );
+		cosTheta = cos( theta );
+	}
+
+	double scale = sinTheta / sqrt( s );
+	return Vector3D( scale * px, cosTheta, scale * pz );
+}
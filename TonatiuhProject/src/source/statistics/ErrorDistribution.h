@@ -0,0 +1,85 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#ifndef ERRORDISTRIBUTION_H_
+#define ERRORDISTRIBUTION_H_
+
+#include "Vector3D.h"
+
+class RandomDeviate;
+
+//!  ErrorDistribution class samples the angular errors of the material surfaces.
+/*!
+ * The errors are sampled as vectors in a local frame whose y axis is the ideal direction, the normal or the
+ * reflected direction. The PILLBOX distribution gives a unit vector whose angle with the y axis is uniform
+ * between zero and sigma. The NORMAL distribution gives the vector ( sigma * n1, 1, sigma * n2 ), where n1
+ * and n2 are standard normal deviates.
+ *
+ * The normal deviates are sampled with the ziggurat method of Marsaglia and Tsang, that only needs a table
+ * look up and a multiplication for most samples. The pillbox angles are taken from a point uniformly
+ * distributed in the unit disk, so that no trigonometric function is evaluated for small errors. The samples
+ * only use the random generator passed to Sample, so an ErrorDistribution can be shared by several threads.
+ */
+class ErrorDistribution
+{
+public:
+	enum Type {
+		PILLBOX = 0,
+		NORMAL = 1
+	};
+
+	ErrorDistribution();
+	ErrorDistribution( int type, double sigma );
+	~ErrorDistribution();
+
+	int GetType() const;
+	double GetSigma() const;
+
+	Vector3D Sample( RandomDeviate& rand ) const;
+
+	static double StandardNormal( RandomDeviate& rand );
+
+private:
+	Vector3D SamplePillbox( RandomDeviate& rand ) const;
+
+	int m_type;
+	double m_sigma;
+};
+
+#endif /* ERRORDISTRIBUTION_H_ */
@@ -23,6 +23,14 @@ TEST(DiferencialGeometryTests, DesfaultConstructor)
 
 }
 
+TEST(DiferencialGeometryTests, ShapeHitDefaultConstructor)
+{
+	ShapeHit hit;
+	EXPECT_DOUBLE_EQ( hit.u,0.0 );
+	EXPECT_DOUBLE_EQ( hit.v,0.0 );
+	EXPECT_TRUE( hit.shapeFrontSide );
+}
+
 TEST(DiferencialGeometryTests, Constructor)
 {
 	srand ( time(NULL) );
@@ -0,0 +1,147 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "ErrorDistribution.h"
+#include "gc.h"
+#include "RandomDeviate.h"
+#include "Vector3D.h"
+
+//! Linear congruential generator with a fixed seed, so that the tests are repeatable.
+class TestRandomDeviate : public RandomDeviate
+{
+public:
+	TestRandomDeviate() : RandomDeviate( 1000 ), m_state( 12345 ) {}
+
+	void FillArray( double* array, const unsigned long arraySize )
+	{
+		for( unsigned long i = 0; i < arraySize; ++i )
+		{
+			m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			array[i] = ( m_state >> 11 ) * ( 1.0 / 9007199254740992.0 );
+		}
+	}
+
+private:
+	unsigned long long m_state;
+};
+
+TEST( ErrorDistributionTests, ConstructorDefault )
+{
+	ErrorDistribution distribution;
+	EXPECT_EQ( ErrorDistribution::PILLBOX, distribution.GetType() );
+	EXPECT_DOUBLE_EQ( 0.0, distribution.GetSigma() );
+
+	TestRandomDeviate rand;
+	Vector3D error = distribution.Sample( rand );
+	EXPECT_DOUBLE_EQ( 0.0, error.x );
+	EXPECT_DOUBLE_EQ( 1.0, error.y );
+	EXPECT_DOUBLE_EQ( 0.0, error.z );
+}
+
+TEST( ErrorDistributionTests, StandardNormalMoments )
+{
+	TestRandomDeviate rand;
+	const int numberOfSamples = 1000000;
+	double sum = 0.0;
+	double sum2 = 0.0;
+	double sum4 = 0.0;
+	int tail = 0;
+	for( int i = 0; i < numberOfSamples; ++i )
+	{
+		double x = ErrorDistribution::StandardNormal( rand );
+		sum += x;
+		sum2 += x * x;
+		sum4 += x * x * x * x;
+		if( fabs( x ) > 3.0 ) ++tail;
+	}
+
+	EXPECT_NEAR( 0.0, sum / numberOfSamples, 0.005 );
+	EXPECT_NEAR( 1.0, sum2 / numberOfSamples, 0.01 );
+	EXPECT_NEAR( 3.0, sum4 / numberOfSamples, 0.05 );
+	EXPECT_NEAR( 0.0027, double( tail ) / numberOfSamples, 0.0003 );
+}
+
+TEST( ErrorDistributionTests, NormalSample )
+{
+	TestRandomDeviate rand;
+	ErrorDistribution distribution( ErrorDistribution::NORMAL, 0.002 );
+
+	const int numberOfSamples = 200000;
+	double sum2 = 0.0;
+	for( int i = 0; i < numberOfSamples; ++i )
+	{
+		Vector3D error = distribution.Sample( rand );
+		EXPECT_DOUBLE_EQ( 1.0, error.y );
+		sum2 += error.x * error.x + error.z * error.z;
+	}
+	EXPECT_NEAR( 2.0 * 0.002 * 0.002, sum2 / numberOfSamples, 0.03 * 2.0 * 0.002 * 0.002 );
+}
+
+TEST( ErrorDistributionTests, PillboxSample )
+{
+	TestRandomDeviate rand;
+	double sigmas[2] = { 0.004, 0.5 };
+	for( int j = 0; j < 2; ++j )
+	{
+		ErrorDistribution distribution( ErrorDistribution::PILLBOX, sigmas[j] );
+
+		const int numberOfSamples = 200000;
+		double sumTheta = 0.0;
+		double sumX = 0.0;
+		double sumZ = 0.0;
+		for( int i = 0; i < numberOfSamples; ++i )
+		{
+			Vector3D error = distribution.Sample( rand );
+			EXPECT_NEAR( 1.0, error.length(), 1e-12 );
+
+			double theta = atan2( sqrt( error.x * error.x + error.z * error.z ), error.y );
+			EXPECT_LE( theta, sigmas[j] * ( 1.0 + 1e-12 ) );
+			sumTheta += theta;
+			sumX += error.x;
+			sumZ += error.z;
+		}
+		EXPECT_NEAR( 0.5 * sigmas[j], sumTheta / numberOfSamples, 0.01 * sigmas[j] );
+		EXPECT_NEAR( 0.0, sumX / numberOfSamples, 0.01 * sigmas[j] );
+		EXPECT_NEAR( 0.0, sumZ / numberOfSamples, 0.01 * sigmas[j] );
+	}
+}
@@ -0,0 +1,312 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>
+
+#include <QDir>
+#include <QFile>
+#include <QString>
+
+#include <gtest/gtest.h>
+
+#include "BBox.h"
+#include "gc.h"
+#include "gf.h"
+#include "HeightFieldData.h"
+#include "Point3D.h"
+#include "Ptr.h"
+#include "Ray.h"
+#include "TestsAuxiliaryFunctions.h"
+#include "Vector3D.h"
+
+const int gridColumns = 9;
+const int gridRows = 7;
+const double gridXMin = -1.0;
+const double gridXMax = 1.0;
+const double gridYMin = -0.5;
+const double gridYMax = 1.0;
+
+//! Returns the height of the test surface at \a x, \a y.
+static double SurfaceHeight( double x, double y )
+{
+	return 0.1 * sin( 3.0 * x ) + 0.2 * y * y - 0.05 * x * y;
+}
+
+//! Returns the x coordinate of the grid column \a column, computed as HeightFieldData does.
+static double GridX( int column )
+{
+	return gridXMin + column * ( ( gridXMax - gridXMin ) / ( gridColumns - 1 ) );
+}
+
+//! Returns the y coordinate of the grid row \a row, computed as HeightFieldData does.
+static double GridY( int row )
+{
+	return gridYMin + row * ( ( gridYMax - gridYMin ) / ( gridRows - 1 ) );
+}
+
+/*!
+ * Writes a height field file \a name in the temporary directory with the test surface and returns the file path.
+ */
+static QString WriteHeightFieldFile( QString name )
+{
+	QString fileName = QDir::temp().absoluteFilePath( name );
+	QFile file( fileName );
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )	return fileName;
+
+	qint32 size[3] = { gridColumns, gridRows, 0 };
+	double limits[4] = { gridXMin, gridXMax, gridYMin, gridYMax };
+	file.write( "THF1", 4 );
+	file.write( reinterpret_cast< const char* >( size ), sizeof( size ) );
+	file.write( reinterpret_cast< const char* >( limits ), sizeof( limits ) );
+
+	for( int row = 0; row < gridRows; ++row )
+	{
+		for( int column = 0; column < gridColumns; ++column )
+		{
+			float values[4] = { float( SurfaceHeight( GridX( column ), GridY( row ) ) ), 0.0f, 0.0f, 1.0f };
+			file.write( reinterpret_cast< const char* >( values ), sizeof( values ) );
+		}
+	}
+	file.close();
+	return fileName;
+}
+
+/*!
+ * Computes the closest intersection of \a ray with the bilinear surfaces of all the \a data cells tested one by one.
+ */
+static bool BruteForceIntersect( const HeightFieldData& data, const Ray& ray, double* tHit, double* u, double* v )
+{
+	const double tol = 0.00001;
+	const double cellTolerance = 0.000000001;
+	double cellWidth = ( gridXMax - gridXMin ) / ( gridColumns - 1 );
+	double cellLength = ( gridYMax - gridYMin ) / ( gridRows - 1 );
+
+	bool isHit = false;
+	for( int row = 0; row < gridRows - 1; ++row )
+	{
+		for( int column = 0; column < gridColumns - 1; ++column )
+		{
+			double h00 = data.Height( column, row );
+			double h10 = data.Height( column + 1, row );
+			double h01 = data.Height( column, row + 1 );
+			double h11 = data.Height( column + 1, row + 1 );
+
+			double s0 = ( ray.origin.x - GridX( column ) ) / cellWidth;
+			double ds = ray.direction().x / cellWidth;
+			double r0 = ( ray.origin.y - GridY( row ) ) / cellLength;
+			double dr = ray.direction().y / cellLength;
+
+			// Height of the surface over the ray minus the ray height
+			double c = h00 - h10 - h01 + h11;
+			double A = c * ds * dr;
+			double B = ( h10 - h00 ) * ds + ( h01 - h00 ) * dr + c * ( s0 * dr + r0 * ds ) - ray.direction().z;
+			double C = h00 + ( h10 - h00 ) * s0 + ( h01 - h00 ) * r0 + c * s0 * r0 - ray.origin.z;
+
+			double roots[2];
+			int nRoots = 0;
+			if( A != 0.0 )
+			{
+				if( gf::Quadratic( A, B, C, &roots[0], &roots[1] ) ) nRoots = 2;
+			}
+			else if( B != 0.0 )
+			{
+				roots[0] = -C / B;
+				nRoots = 1;
+			}
+
+			for( int i = 0; i < nRoots; ++i )
+			{
+				double t = roots[i];
+				if( ( t - ray.mint ) < tol || t > ray.maxt ) continue;
+				if( isHit && !( t < *tHit ) ) continue;
+
+				double s = s0 + ds * t;
+				double r = r0 + dr * t;
+				if( ( s < -cellTolerance ) || ( s > 1.0 + cellTolerance ) || ( r < -cellTolerance ) || ( r > 1.0 + cellTolerance ) ) continue;
+
+				isHit = true;
+				*tHit = t;
+				*u = ( column + std::min( std::max( s, 0.0 ), 1.0 ) ) / ( gridColumns - 1 );
+				*v = ( row + std::min( std::max( r, 0.0 ), 1.0 ) ) / ( gridRows - 1 );
+			}
+		}
+	}
+	return isHit;
+}
+
+/*!
+ * Checks that HeightFieldData::Intersect finds the same intersection than the brute force test of all the cells.
+ * Returns true if the ray intersects the surface.
+ */
+static bool ExpectIntersectMatchesBruteForce( const HeightFieldData& data, const Ray& ray )
+{
+	double bruteForceTHit = 0.0, bruteForceU = 0.0, bruteForceV = 0.0;
+	bool isBruteForceHit = BruteForceIntersect( data, ray, &bruteForceTHit, &bruteForceU, &bruteForceV );
+
+	double tHit = 0.0, u = 0.0, v = 0.0;
+	bool isHit = data.Intersect( ray, &tHit, &u, &v );
+
+	EXPECT_EQ( isBruteForceHit, isHit ) << "origin " << ray.origin << " direction " << ray.direction();
+	if( !isHit || !isBruteForceHit ) return false;
+
+	EXPECT_NEAR( bruteForceTHit, tHit, 1.0e-9 );
+	EXPECT_NEAR( bruteForceU, u, 1.0e-9 );
+	EXPECT_NEAR( bruteForceV, v, 1.0e-9 );
+	return true;
+}
+
+TEST( HeightFieldDataTests, Load )
+{
+	QString fileName = WriteHeightFieldFile( QLatin1String( "HeightFieldDataTests_load.thf" ) );
+	QString errorMessage;
+	Ptr< HeightFieldData > data = HeightFieldData::Load( fileName, &errorMessage );
+	ASSERT_TRUE( data );
+	EXPECT_EQ( gridColumns, data->NumberOfColumns() );
+	EXPECT_EQ( gridRows, data->NumberOfRows() );
+	EXPECT_FLOAT_EQ( float( SurfaceHeight( GridX( 3 ), GridY( 2 ) ) ), float( data->Height( 3, 2 ) ) );
+
+	BBox bbox = data->GetBBox();
+	EXPECT_DOUBLE_EQ( gridXMin, bbox.pMin.x );
+	EXPECT_DOUBLE_EQ( gridXMax, bbox.pMax.x );
+	EXPECT_DOUBLE_EQ( gridYMin, bbox.pMin.y );
+	EXPECT_DOUBLE_EQ( gridYMax, bbox.pMax.y );
+
+	// The same file is loaded only once
+	Ptr< HeightFieldData > sameData = HeightFieldData::Load( fileName, &errorMessage );
+	EXPECT_TRUE( &( *sameData ) == &( *data ) );
+
+	EXPECT_FALSE( HeightFieldData::Load( QDir::temp().absoluteFilePath( QLatin1String( "HeightFieldDataTests_missing.thf" ) ), &errorMessage ) );
+	EXPECT_FALSE( errorMessage.isEmpty() );
+}
+
+TEST( HeightFieldDataTests, IntersectMatchesBruteForce )
+{
+	QString errorMessage;
+	Ptr< HeightFieldData > data = HeightFieldData::Load( WriteHeightFieldFile( QLatin1String( "HeightFieldDataTests_random.thf" ) ), &errorMessage );
+	ASSERT_TRUE( data );
+
+	srand( 7 );
+	int numberOfHits = 0;
+	for( int r = 0; r < 2000; ++r )
+	{
+		Point3D origin( taf::randomNumber( -1.5, 1.5 ), taf::randomNumber( -1.0, 1.5 ), taf::randomNumber( -0.3, 1.0 ) );
+		Vector3D direction = Normalize( Vector3D( taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 0.3 ) ) );
+		double maxt = ( r % 4 == 0 ) ? taf::randomNumber( 0.2, 2.0 ) : gc::Infinity;
+		if( ExpectIntersectMatchesBruteForce( *data, Ray( origin, direction, gc::Epsilon, maxt ) ) ) ++numberOfHits;
+	}
+	EXPECT_GT( numberOfHits, 0 );
+}
+
+/*!
+ * Rays inside the vertical planes of the grid lines, through the grid points and parallel to the grid axes.
+ */
+TEST( HeightFieldDataTests, IntersectAlongCellEdges )
+{
+	QString errorMessage;
+	Ptr< HeightFieldData > data = HeightFieldData::Load( WriteHeightFieldFile( QLatin1String( "HeightFieldDataTests_edges.thf" ) ), &errorMessage );
+	ASSERT_TRUE( data );
+
+	int numberOfHits = 0;
+	for( int column = 0; column < gridColumns; ++column )
+	{
+		Ray alongY( Point3D( GridX( column ), -0.8, 0.6 ), Normalize( Vector3D( 0.0, 1.0, -0.5 ) ) );
+		if( ExpectIntersectMatchesBruteForce( *data, alongY ) ) ++numberOfHits;
+
+		Ray vertical( Point3D( GridX( column ), GridY( column % gridRows ), 1.0 ), Vector3D( 0.0, 0.0, -1.0 ) );
+		EXPECT_TRUE( ExpectIntersectMatchesBruteForce( *data, vertical ) );
+	}
+
+	for( int row = 0; row < gridRows; ++row )
+	{
+		Ray alongX( Point3D( 1.3, GridY( row ), 0.5 ), Normalize( Vector3D( -1.0, 0.0, -0.4 ) ) );
+		if( ExpectIntersectMatchesBruteForce( *data, alongX ) ) ++numberOfHits;
+
+		// Horizontal ray over the grid line at a height that crosses the surface
+		Ray horizontal( Point3D( gridXMin - 0.5, GridY( row ), SurfaceHeight( 0.1, GridY( row ) ) ), Vector3D( 1.0, 0.0, 0.0 ) );
+		ExpectIntersectMatchesBruteForce( *data, horizontal );
+	}
+
+	// Diagonal through the grid points
+	Ray diagonal( Point3D( GridX( 0 ), GridY( 0 ), 0.8 ),
+			Normalize( Vector3D( GridX( gridRows - 1 ) - GridX( 0 ), GridY( gridRows - 1 ) - GridY( 0 ), -1.0 ) ) );
+	if( ExpectIntersectMatchesBruteForce( *data, diagonal ) ) ++numberOfHits;
+
+	EXPECT_GT( numberOfHits, 0 );
+}
+
+/*!
+ * Rays that leave the grid before reaching the surface, start outside the grid or pass under it.
+ */
+TEST( HeightFieldDataTests, IntersectRaysLeavingGrid )
+{
+	QString errorMessage;
+	Ptr< HeightFieldData > data = HeightFieldData::Load( WriteHeightFieldFile( QLatin1String( "HeightFieldDataTests_leaving.thf" ) ), &errorMessage );
+	ASSERT_TRUE( data );
+
+	double tHit = 0.0, u = 0.0, v = 0.0;
+
+	// Over the surface and leaving the grid through each side
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 0.5, 0.2, 0.6 ), Normalize( Vector3D( 1.0, 0.0, -0.05 ) ) ), &tHit, &u, &v ) );
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( -0.5, 0.2, 0.6 ), Normalize( Vector3D( -1.0, 0.0, -0.05 ) ) ), &tHit, &u, &v ) );
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 0.0, 0.8, 0.6 ), Normalize( Vector3D( 0.0, 1.0, -0.05 ) ) ), &tHit, &u, &v ) );
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 0.0, -0.3, 0.6 ), Normalize( Vector3D( 0.0, -1.0, -0.05 ) ) ), &tHit, &u, &v ) );
+
+	// Outside the grid and away from it
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 2.0, 0.0, 0.0 ), Vector3D( 0.0, 0.0, -1.0 ) ), &tHit, &u, &v ) );
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 2.0, 0.0, 0.0 ), Vector3D( 1.0, 0.0, 0.0 ) ), &tHit, &u, &v ) );
+
+	// Under the surface and going down
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 0.0, 0.0, -0.5 ), Normalize( Vector3D( 0.3, 0.2, -1.0 ) ) ), &tHit, &u, &v ) );
+
+	// Clipped before reaching the surface
+	EXPECT_FALSE( data->Intersect( Ray( Point3D( 0.0, 0.0, 1.0 ), Vector3D( 0.0, 0.0, -1.0 ), gc::Epsilon, 0.5 ), &tHit, &u, &v ) );
+
+	// Outside the grid and entering it
+	Ray entering( Point3D( -1.4, 0.3, 0.5 ), Normalize( Vector3D( 1.0, 0.1, -0.5 ) ) );
+	EXPECT_TRUE( ExpectIntersectMatchesBruteForce( *data, entering ) );
+
+	for( int r = 0; r < 200; ++r )
+	{
+		Point3D origin( taf::randomNumber( -0.9, 0.9 ), taf::randomNumber( -0.4, 0.9 ), 0.6 );
+		Vector3D direction = Normalize( Vector3D( taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -0.1, 0.0 ) ) );
+		ExpectIntersectMatchesBruteForce( *data, Ray( origin, direction ) );
+	}
+}
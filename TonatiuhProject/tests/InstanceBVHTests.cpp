@@ -0,0 +1,131 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+#include <QVector>
+
+#include "DifferentialGeometry.h"
+#include "InstanceBVH.h"
+#include "InstanceNode.h"
+#include "Point3D.h"
+#include "Ray.h"
+#include "ShapeFlatRectangle.h"
+#include "TestsAuxiliaryFunctions.h"
+#include "Transform.h"
+#include "TSeparatorKit.h"
+#include "Vector3D.h"
+
+/*!
+ * Places the \a instance of the \a shape in the world with the \a objectToWorld transform.
+ */
+static void PlaceInstance( InstanceNode* instance, TShape* shape, const Transform& objectToWorld )
+{
+	instance->SetIntersectionTransform( objectToWorld.GetInverse() );
+	instance->SetIntersectionBBox( objectToWorld( shape->GetBBox() ) );
+}
+
+/*!
+ * Checks that the closest intersection found with the \a bvh is the closest intersection of the \a instances
+ * tested one by one.
+ */
+static void ExpectBVHMatchesBruteForce( const InstanceBVH& bvh, const QVector< InstanceNode* >& instances )
+{
+	srand( 17 );
+	int numberOfHits = 0;
+	for( int r = 0; r < 500; ++r )
+	{
+		Point3D origin( taf::randomNumber( -2.0, 12.0 ), 5.0, taf::randomNumber( -2.0, 2.0 ) );
+		Vector3D direction = Normalize( Vector3D( taf::randomNumber( -0.3, 0.3 ), -1.0, taf::randomNumber( -0.3, 0.3 ) ) );
+
+		Ray bruteForceRay( origin, direction );
+		InstanceNode* bruteForceNode = 0;
+		ShapeHit bruteForceHit;
+		for( int i = 0; i < instances.size(); ++i )
+			instances[i]->IntersectHit( bruteForceRay, &bruteForceNode, &bruteForceHit );
+
+		Ray bvhRay( origin, direction );
+		InstanceNode* bvhNode = 0;
+		ShapeHit bvhHit;
+		bool isHit = bvh.IntersectHit( bvhRay, &bvhNode, &bvhHit );
+
+		EXPECT_EQ( bruteForceNode != 0, isHit );
+		EXPECT_TRUE( bvhNode == bruteForceNode );
+		if( isHit )
+		{
+			EXPECT_DOUBLE_EQ( bruteForceRay.maxt, bvhRay.maxt );
+			++numberOfHits;
+		}
+	}
+
+	EXPECT_GT( numberOfHits, 0 );
+}
+
+TEST( InstanceBVHTests, UpdateMatchesBruteForce )
+{
+	ShapeFlatRectangle* rectangle = new ShapeFlatRectangle;
+	InstanceNode* rootInstance = new InstanceNode( new TSeparatorKit );
+	QVector< InstanceNode* > instances;
+
+	//Disjoint rectangles
+	for( int i = 0; i < 6; ++i )
+		instances.push_back( taf::addShapeInstance( rootInstance, rectangle, 0, Translate( 2.0 * i, 0.0, 0.0 ) ) );
+
+	//Rectangles that overlap the disjoint ones and each other
+	for( int i = 0; i < 5; ++i )
+		instances.push_back( taf::addShapeInstance( rootInstance, rectangle, 0,
+				Translate( 2.0 * i + 0.7, 0.5 + 0.2 * i, 0.2 ) * RotateZ( 0.35 ) ) );
+
+	InstanceBVH bvh;
+	bvh.Update( instances );
+	EXPECT_EQ( instances.size(), bvh.NumberOfInstances() );
+	ExpectBVHMatchesBruteForce( bvh, instances );
+
+	//Move the instances as the trackers do and refit the hierarchy
+	for( int i = 0; i < instances.size(); ++i )
+		PlaceInstance( instances[i], rectangle, Translate( 10.0 - 1.5 * i, 0.3 * ( i % 3 ), 0.1 * i ) * RotateX( 0.15 * i ) );
+
+	bvh.Update( instances );
+	EXPECT_EQ( instances.size(), bvh.NumberOfInstances() );
+	ExpectBVHMatchesBruteForce( bvh, instances );
+
+	delete rootInstance;
+}
@@ -0,0 +1,199 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+
+#include <Inventor/SoDB.h>
+#include <Inventor/sensors/SoSensorManager.h>
+
+#include <gtest/gtest.h>
+
+#include "DifferentialGeometry.h"
+#include "gc.h"
+#include "MaterialTabulatedSpecular.h"
+#include "NormalVector.h"
+#include "Point3D.h"
+#include "RandomDeviate.h"
+#include "Ray.h"
+#include "SpectralWeights.h"
+#include "Vector3D.h"
+
+//! Random deviate that always returns the same number, to test the reflectance threshold.
+class ConstantRandomDeviate : public RandomDeviate
+{
+public:
+	ConstantRandomDeviate( double value ) : RandomDeviate( 16 ), m_value( value ) {}
+
+	void FillArray( double* array, const unsigned long arraySize )
+	{
+		for( unsigned long i = 0; i < arraySize; ++i )	array[i] = m_value;
+	}
+
+private:
+	double m_value;
+};
+
+/*!
+ * Returns true if \a material reflects the ray that reaches a horizontal surface with incidence \a angle, in degrees,
+ * when the random number is \a randomNumber.
+ */
+static bool IsReflected( const MaterialTabulatedSpecular& material, double angle, double randomNumber, Ray* outputRay )
+{
+	DifferentialGeometry dg;
+	dg.point = Point3D( 0.0, 0.0, 0.0 );
+	dg.normal = NormalVector( 0.0, 0.0, 1.0 );
+	dg.dpdu = Vector3D( 1.0, 0.0, 0.0 );
+	dg.dpdv = Vector3D( 0.0, 1.0, 0.0 );
+
+	Vector3D direction( sin( angle * gc::Degree ), 0.0, -cos( angle * gc::Degree ) );
+	Ray incident( Point3D( 0.0, 0.0, 0.0 ) - 2.0 * direction, direction );
+
+	ConstantRandomDeviate rand( randomNumber );
+	return material.OutputRay( incident, &dg, rand, outputRay );
+}
+
+/*!
+ * The material reflects the rays with the table reflectance of its incidence angle scaled by the reflectivity.
+ */
+TEST( MaterialTabulatedSpecularTests, OutputRayUsesReflectanceOfIncidenceAngle )
+{
+	QString fileName = QDir::temp().absoluteFilePath( QLatin1String( "MaterialTabulatedSpecularTests.txt" ) );
+	QFile file( fileName );
+	ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) );
+	QTextStream out( &file );
+	out << "10.0 0.9\n40.0 0.8\n70.0 0.5\n";
+	file.close();
+
+	MaterialTabulatedSpecular* material = new MaterialTabulatedSpecular;
+	material->ref();
+	material->sigmaSlope.setValue( 0.0 );
+	material->sigmaSpecularity.setValue( 0.0 );
+	material->reflectivity.setValue( 0.8 );
+	material->reflectanceFile.setValue( fileName.toStdString().c_str() );
+	SoDB::getSensorManager()->processDelayQueue( FALSE );
+	material->PrepareForTrace();
+
+	// Below, between and above the table angles
+	const double angles[] = { 5.0, 10.0, 25.0, 40.0, 55.0, 70.0, 85.0 };
+	const double reflectances[] = { 0.9, 0.9, 0.85, 0.8, 0.65, 0.5, 0.5 };
+	for( int i = 0; i < 7; ++i )
+	{
+		double reflectance = 0.8 * reflectances[i];
+		Ray outputRay;
+		EXPECT_TRUE( IsReflected( *material, angles[i], reflectance - 0.005, &outputRay ) ) << "angle " << angles[i];
+		EXPECT_FALSE( IsReflected( *material, angles[i], reflectance + 0.005, &outputRay ) ) << "angle " << angles[i];
+
+		ASSERT_TRUE( IsReflected( *material, angles[i], 0.0, &outputRay ) );
+		Vector3D expectedDirection( sin( angles[i] * gc::Degree ), 0.0, cos( angles[i] * gc::Degree ) );
+		EXPECT_NEAR( expectedDirection.x, outputRay.direction().x, 1.0e-12 );
+		EXPECT_NEAR( expectedDirection.y, outputRay.direction().y, 1.0e-12 );
+		EXPECT_NEAR( expectedDirection.z, outputRay.direction().z, 1.0e-12 );
+	}
+
+	// Without table the reflectance is the reflectivity for all the angles
+	material->reflectanceFile.setValue( "" );
+	SoDB::getSensorManager()->processDelayQueue( FALSE );
+	material->PrepareForTrace();
+	for( int i = 0; i < 7; ++i )
+	{
+		Ray outputRay;
+		EXPECT_TRUE( IsReflected( *material, angles[i], 0.795, &outputRay ) ) << "angle " << angles[i];
+		EXPECT_FALSE( IsReflected( *material, angles[i], 0.805, &outputRay ) ) << "angle " << angles[i];
+	}
+
+	material->unref();
+}
+
+/*!
+ * In spectral traces the band reflectivities multiply the reflectance of the incidence angle.
+ */
+TEST( MaterialTabulatedSpecularTests, OutputSpectralRayUsesBandReflectivity )
+{
+	QString fileName = QDir::temp().absoluteFilePath( QLatin1String( "MaterialTabulatedSpecularTests_bands.txt" ) );
+	QFile file( fileName );
+	ASSERT_TRUE( file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) );
+	QTextStream out( &file );
+	out << "10.0 0.9\n70.0 0.5\n";
+	file.close();
+
+	MaterialTabulatedSpecular* material = new MaterialTabulatedSpecular;
+	material->ref();
+	material->sigmaSlope.setValue( 0.0 );
+	material->sigmaSpecularity.setValue( 0.0 );
+	material->bandReflectivity.setValue( "0.9 0.3" );
+	material->reflectanceFile.setValue( fileName.toStdString().c_str() );
+	SoDB::getSensorManager()->processDelayQueue( FALSE );
+	material->PrepareForTrace();
+
+	DifferentialGeometry dg;
+	dg.point = Point3D( 0.0, 0.0, 0.0 );
+	dg.normal = NormalVector( 0.0, 0.0, 1.0 );
+	dg.dpdu = Vector3D( 1.0, 0.0, 0.0 );
+	dg.dpdv = Vector3D( 0.0, 1.0, 0.0 );
+	Vector3D direction( sin( 5.0 * gc::Degree ), 0.0, -cos( 5.0 * gc::Degree ) );
+	Ray incident( Point3D( 0.0, 0.0, 1.0 ), direction );
+
+	// The largest band factor is 0.9 * 0.9, the survival probability of the ray
+	double fractions[3] = { 0.5, 0.3, 0.2 };
+	SpectralWeights weights( 3, fractions );
+	Ray outputRay;
+	ConstantRandomDeviate reflectedRand( 0.8 );
+	ASSERT_TRUE( material->OutputSpectralRay( incident, &dg, reflectedRand, &outputRay, &weights ) );
+	EXPECT_NEAR( 0.5, weights.weight[0], 1.0e-6 );
+	EXPECT_NEAR( 0.3 / 3.0, weights.weight[1], 1.0e-6 );
+	EXPECT_NEAR( 0.2 / 3.0, weights.weight[2], 1.0e-6 );
+	EXPECT_NEAR( cos( 5.0 * gc::Degree ), outputRay.direction().z, 1.0e-12 );
+
+	SpectralWeights absorbedWeights( 3, fractions );
+	ConstantRandomDeviate absorbedRand( 0.82 );
+	EXPECT_FALSE( material->OutputSpectralRay( incident, &dg, absorbedRand, &outputRay, &absorbedWeights ) );
+	EXPECT_FLOAT_EQ( 0.3f, absorbedWeights.weight[1] );
+
+	// Without bands the reflectivity field is used
+	SpectralWeights noBands;
+	ConstantRandomDeviate rand( 0.85 );
+	EXPECT_TRUE( material->OutputSpectralRay( incident, &dg, rand, &outputRay, &noBands ) );
+
+	material->unref();
+}
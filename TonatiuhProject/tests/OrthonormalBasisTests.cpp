@@ -0,0 +1,119 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "OrthonormalBasis.h"
+#include "Vector3D.h"
+
+static void ExpectOrthonormal( const OrthonormalBasis& basis )
+{
+	EXPECT_NEAR( 1.0, basis.xAxis.length(), 1e-12 );
+	EXPECT_NEAR( 1.0, basis.yAxis.length(), 1e-12 );
+	EXPECT_NEAR( 1.0, basis.zAxis.length(), 1e-12 );
+	EXPECT_NEAR( 0.0, DotProduct( basis.xAxis, basis.yAxis ), 1e-12 );
+	EXPECT_NEAR( 0.0, DotProduct( basis.xAxis, basis.zAxis ), 1e-12 );
+	EXPECT_NEAR( 0.0, DotProduct( basis.yAxis, basis.zAxis ), 1e-12 );
+
+	Vector3D z = CrossProduct( basis.xAxis, basis.yAxis );
+	EXPECT_NEAR( basis.zAxis.x, z.x, 1e-12 );
+	EXPECT_NEAR( basis.zAxis.y, z.y, 1e-12 );
+	EXPECT_NEAR( basis.zAxis.z, z.z, 1e-12 );
+}
+
+TEST( OrthonormalBasisTests, ConstructorDefault )
+{
+	OrthonormalBasis basis;
+	EXPECT_DOUBLE_EQ( 1.0, basis.xAxis.x );
+	EXPECT_DOUBLE_EQ( 1.0, basis.yAxis.y );
+	EXPECT_DOUBLE_EQ( 1.0, basis.zAxis.z );
+	ExpectOrthonormal( basis );
+}
+
+TEST( OrthonormalBasisTests, ConstructorDirection )
+{
+	Vector3D directions[6] = { Vector3D( 0.0, 0.0, 1.0 ), Vector3D( 0.0, 0.0, -1.0 ), Vector3D( 0.0, 1.0, 0.0 ),
+							Vector3D( 3.0, -4.0, 12.0 ), Vector3D( -0.2, 0.5, -7.0 ), Vector3D( 1e-9, -1.0, 0.0 ) };
+
+	for( int i = 0; i < 6; ++i )
+	{
+		OrthonormalBasis basis( directions[i] );
+		ExpectOrthonormal( basis );
+
+		Vector3D y = Normalize( directions[i] );
+		EXPECT_NEAR( y.x, basis.yAxis.x, 1e-12 );
+		EXPECT_NEAR( y.y, basis.yAxis.y, 1e-12 );
+		EXPECT_NEAR( y.z, basis.yAxis.z, 1e-12 );
+	}
+}
+
+TEST( OrthonormalBasisTests, ConstructorDirectionTangent )
+{
+	Vector3D normal( 0.0, 0.0, 2.0 );
+	Vector3D tangent( 1.0, 1.0, 5.0 );
+	OrthonormalBasis basis( normal, tangent );
+	ExpectOrthonormal( basis );
+
+	EXPECT_NEAR( 1.0 / sqrt( 2.0 ), basis.xAxis.x, 1e-12 );
+	EXPECT_NEAR( 1.0 / sqrt( 2.0 ), basis.xAxis.y, 1e-12 );
+	EXPECT_NEAR( 0.0, basis.xAxis.z, 1e-12 );
+	EXPECT_NEAR( 1.0, basis.yAxis.z, 1e-12 );
+
+	OrthonormalBasis parallel( normal, Vector3D( 0.0, 0.0, -3.0 ) );
+	ExpectOrthonormal( parallel );
+}
+
+TEST( OrthonormalBasisTests, ToWorldToLocal )
+{
+	OrthonormalBasis basis( Vector3D( 0.3, -0.4, 0.8 ), Vector3D( 1.0, 2.0, 0.0 ) );
+
+	EXPECT_NEAR( basis.yAxis.x, basis.ToWorld( Vector3D( 0.0, 1.0, 0.0 ) ).x, 1e-12 );
+	EXPECT_NEAR( basis.zAxis.y, basis.ToWorld( Vector3D( 0.0, 0.0, 1.0 ) ).y, 1e-12 );
+
+	Vector3D local( 0.25, -1.5, 3.0 );
+	Vector3D world = basis.ToWorld( local );
+	EXPECT_NEAR( local.length(), world.length(), 1e-12 );
+
+	Vector3D back = basis.ToLocal( world );
+	EXPECT_NEAR( local.x, back.x, 1e-12 );
+	EXPECT_NEAR( local.y, back.y, 1e-12 );
+	EXPECT_NEAR( local.z, back.z, 1e-12 );
+}
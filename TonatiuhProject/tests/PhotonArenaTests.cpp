@@ -0,0 +1,114 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Photon.h"
+#include "PhotonArena.h"
+
+//! Returns \a n photons whose x coordinates are consecutive starting at \a firstX.
+static std::vector< Photon > ConsecutivePhotons( unsigned long n, double firstX )
+{
+	std::vector< Photon > photons;
+	for( unsigned long p = 0; p < n; ++p )
+		photons.push_back( Photon( Point3D( firstX + p, 0.0, 0.0 ), 1, int( p % 4 ) ) );
+	return photons;
+}
+
+TEST( PhotonArenaTests, Empty )
+{
+	PhotonArena arena;
+	EXPECT_TRUE( arena.empty() );
+	EXPECT_EQ( 0UL, arena.size() );
+}
+
+TEST( PhotonArenaTests, AppendAcrossChunks )
+{
+	PhotonArena arena;
+	unsigned long firstSize = PhotonArena::m_chunkSize - 3;
+	arena.Append( ConsecutivePhotons( firstSize, 0.0 ) );
+	arena.Append( ConsecutivePhotons( PhotonArena::m_chunkSize + 10, double( firstSize ) ) );
+
+	ASSERT_EQ( firstSize + PhotonArena::m_chunkSize + 10, arena.size() );
+	for( unsigned long p = 0; p < arena.size(); ++p )
+		ASSERT_DOUBLE_EQ( double( p ), arena[p]->Position().x );
+	EXPECT_EQ( 2, arena[firstSize + 2]->id );
+}
+
+TEST( PhotonArenaTests, ClearKeepsStoring )
+{
+	PhotonArena arena;
+	arena.Append( ConsecutivePhotons( 100, 0.0 ) );
+	const Photon* firstPhoton = arena[0];
+
+	arena.Clear();
+	EXPECT_TRUE( arena.empty() );
+
+	arena.Append( ConsecutivePhotons( 5, 50.0 ) );
+	ASSERT_EQ( 5UL, arena.size() );
+	EXPECT_EQ( firstPhoton, arena[0] );
+	EXPECT_DOUBLE_EQ( 54.0, arena[4]->Position().x );
+}
+
+TEST( PhotonArenaTests, BandWeights )
+{
+	double bandFractions[3] = { 0.25, 0.5, 0.25 };
+	SpectralWeights weights( 3, bandFractions );
+
+	PhotonArena arena;
+	arena.Add( Photon( Point3D( 0.0, 0.0, 0.0 ), 1 ), SpectralWeights() );
+	arena.Add( Photon( Point3D( 1.0, 0.0, 0.0 ), 1, 1 ), weights );
+	EXPECT_EQ( 0, arena.BandWeights( 0 ).nBands );
+	ASSERT_EQ( 3, arena.BandWeights( 1 ).nBands );
+	EXPECT_DOUBLE_EQ( 0.5, arena.BandWeights( 1 ).weight[1] );
+
+	PhotonArena copy;
+	copy.Append( ConsecutivePhotons( 2, 10.0 ) );
+	copy.Append( arena );
+	ASSERT_EQ( 4UL, copy.size() );
+	EXPECT_EQ( 0, copy.BandWeights( 0 ).nBands );
+	EXPECT_DOUBLE_EQ( 0.5, copy.BandWeights( 3 ).weight[1] );
+	EXPECT_DOUBLE_EQ( 1.0, copy[3]->Position().x );
+
+	copy.Clear();
+	copy.Append( ConsecutivePhotons( 1, 0.0 ) );
+	EXPECT_EQ( 0, copy.BandWeights( 0 ).nBands );
+}
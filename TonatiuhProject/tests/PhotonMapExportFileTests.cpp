@@ -0,0 +1,117 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <gtest/gtest.h>
+
+#include "Photon.h"
+#include "PhotonArena.h"
+#include "PhotonMapExportFile.h"
+
+//! Returns the photons of a ray with \a n photons whose path lengths are consecutive starting at 0.5.
+static std::vector< Photon > PathLengthPhotons( int n )
+{
+	std::vector< Photon > photons;
+	for( int p = 0; p < n; ++p )
+		photons.push_back( Photon( Point3D( p, 0.0, 0.0 ), 1, p, 0, 0.5 + p ) );
+	return photons;
+}
+
+//! Returns the lines of the text file \a filename.
+static QStringList FileLines( QString filename )
+{
+	QFile file( filename );
+	if( !file.open( QIODevice::ReadOnly ) )	return QStringList();
+	QTextStream in( &file );
+	QStringList lines;
+	while( !in.atEnd() )
+		lines<<in.readLine();
+	return lines;
+}
+
+TEST( PhotonMapExportFileTests, ExportsPathLength )
+{
+	QDir exportDirectory = QDir::temp();
+	QString exportName = QLatin1String( "PhotonMapExportFileTests_pathLength" );
+
+	PhotonMapExportFile exportMode;
+	exportMode.SetSaveSurfacesIDEnabled( false );
+	exportMode.SetSaveParameterValue( QLatin1String( "ExportDirectory" ), exportDirectory.absolutePath() );
+	exportMode.SetSaveParameterValue( QLatin1String( "ExportFile" ), exportName );
+	exportMode.SetSaveParameterValue( QLatin1String( "FileSize" ), QLatin1String( "-1" ) );
+	exportMode.SetSaveParameterValue( QLatin1String( "SavePathLength" ), QLatin1String( "true" ) );
+
+	PhotonArena photons;
+	photons.Append( PathLengthPhotons( 4 ) );
+
+	ASSERT_TRUE( exportMode.StartExport() );
+	exportMode.SavePhotonMap( photons );
+	exportMode.EndExport();
+
+	QStringList parameters = FileLines( exportDirectory.absoluteFilePath( exportName + QLatin1String( "_parameters.txt" ) ) );
+	ASSERT_LE( 4, parameters.count() );
+	EXPECT_EQ( QString( QLatin1String( "START PARAMETERS" ) ), parameters[0] );
+	EXPECT_EQ( QString( QLatin1String( "id" ) ), parameters[1] );
+	EXPECT_EQ( QString( QLatin1String( "path length" ) ), parameters[2] );
+	EXPECT_EQ( QString( QLatin1String( "END PARAMETERS" ) ), parameters[3] );
+
+	QFile photonsFile( exportDirectory.absoluteFilePath( exportName + QLatin1String( ".dat" ) ) );
+	ASSERT_TRUE( photonsFile.open( QIODevice::ReadOnly ) );
+	QDataStream in( &photonsFile );
+	for( int p = 0; p < 4; ++p )
+	{
+		double id = 0.0;
+		double pathLength = 0.0;
+		in>>id>>pathLength;
+		EXPECT_DOUBLE_EQ( p + 1, id );
+		EXPECT_DOUBLE_EQ( 0.5 + p, pathLength );
+	}
+	EXPECT_TRUE( in.atEnd() );
+	photonsFile.close();
+
+	photonsFile.remove();
+	QFile::remove( exportDirectory.absoluteFilePath( exportName + QLatin1String( "_parameters.txt" ) ) );
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Photon.h"
+#include "PhotonArena.h"
+#include "PhotonMapExport.h"
+#include "PhotonMapExportThread.h"
+
+//! Export mode that keeps the number of photons and the first x coordinate of each saved buffer.
+class RecordingExport : public PhotonMapExport
+{
+public:
+	void EndExport() { }
+	void SavePhotonMap( const PhotonArena& raysLists )
+	{
+		savedSizes.push_back( raysLists.size() );
+		savedFirstX.push_back( raysLists.empty() ? -1.0 : raysLists[0]->Position().x );
+	}
+	void SetPowerPerPhoton( double /*wPhoton*/ ) { }
+	void SetSaveParameterValue( QString /*parameterName*/, QString /*parameterValue*/ ) { }
+	bool StartExport() { return true; }
+
+	std::vector< unsigned long > savedSizes;
+	std::vector< double > savedFirstX;
+};
+
+//! Fills \a buffer with \a n photons whose first x coordinate is \a firstX.
+static void FillBuffer( PhotonArena* buffer, unsigned long n, double firstX )
+{
+	std::vector< Photon > photons;
+	for( unsigned long p = 0; p < n; ++p )
+		photons.push_back( Photon( Point3D( firstX + p, 0.0, 0.0 ), 1 ) );
+	buffer->Append( photons );
+}
+
+TEST( PhotonMapExportThreadTests, SavesBuffersInOrder )
+{
+	RecordingExport exportMode;
+	PhotonMapExportThread exportThread( &exportMode, 2 );
+	exportThread.start();
+
+	// More buffers than the thread has, so that TakeBuffer has to wait for the saved ones.
+	PhotonArena* buffer = exportThread.TakeBuffer();
+	for( unsigned long b = 0; b < 10; ++b )
+	{
+		FillBuffer( buffer, b + 1, 100.0 * b );
+		exportThread.SaveBuffer( buffer );
+		buffer = exportThread.TakeBuffer();
+		EXPECT_TRUE( buffer->empty() );
+	}
+	exportThread.Flush();
+
+	ASSERT_EQ( 10U, exportMode.savedSizes.size() );
+	for( unsigned long b = 0; b < 10; ++b )
+	{
+		EXPECT_EQ( b + 1, exportMode.savedSizes[b] );
+		EXPECT_DOUBLE_EQ( 100.0 * b, exportMode.savedFirstX[b] );
+	}
+}
+
+TEST( PhotonMapExportThreadTests, StopSavesQueuedBuffers )
+{
+	RecordingExport exportMode;
+	PhotonMapExportThread exportThread( &exportMode, 3 );
+	exportThread.start();
+
+	for( int b = 0; b < 3; ++b )
+	{
+		PhotonArena* buffer = exportThread.TakeBuffer();
+		FillBuffer( buffer, 5, 0.0 );
+		exportThread.SaveBuffer( buffer );
+	}
+	exportThread.Stop();
+
+	EXPECT_EQ( 3U, exportMode.savedSizes.size() );
+}
@@ -0,0 +1,151 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cstring>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QtEndian>
+
+#include <gtest/gtest.h>
+
+#include "PhotonMapRawFile.h"
+
+//! Returns the little-endian double stored at \a offset of \a data.
+static double LoadDouble( const QByteArray& data, int offset )
+{
+	quint64 bits = qFromLittleEndian< quint64 >( reinterpret_cast< const uchar* >( data.constData() + offset ) );
+	double value;
+	std::memcpy( &value, &bits, sizeof( double ) );
+	return value;
+}
+
+//! Returns the little-endian unsigned integer of type T stored at \a offset of \a data.
+template< class T >
+static T LoadUnsigned( const QByteArray& data, int offset )
+{
+	return qFromLittleEndian< T >( reinterpret_cast< const uchar* >( data.constData() + offset ) );
+}
+
+//! Returns the contents of the file \a filename.
+static QByteArray FileContents( QString filename )
+{
+	QFile file( filename );
+	if( !file.open( QIODevice::ReadOnly ) )	return QByteArray();
+	return file.readAll();
+}
+
+TEST( PhotonMapRawFileTests, RoundTrip )
+{
+	QString filename = QDir::temp().absoluteFilePath( QLatin1String( "PhotonMapRawFileTests_roundTrip.bin" ) );
+	QFile::remove( filename );
+
+	QStringList columnNames;
+	columnNames<<QLatin1String( "id" )<<QLatin1String( "x" )<<QLatin1String( "path length" );
+	const int nColumns = 3;
+	const int nRows = 5;
+
+	{
+		PhotonMapRawFile rawFile;
+		ASSERT_TRUE( rawFile.Open( filename, columnNames ) );
+		for( int r = 0; r < nRows; ++r )
+		{
+			double row[nColumns] = { r + 1.0, -0.25 * r, 1000.5 + r };
+			EXPECT_TRUE( rawFile.WriteRow( row ) );
+		}
+		EXPECT_EQ( (unsigned long) nRows, rawFile.NumberOfRows() );
+		EXPECT_TRUE( rawFile.Close( 2.5 ) );
+		EXPECT_FALSE( rawFile.IsOpen() );
+	}
+
+	QByteArray data = FileContents( filename );
+	ASSERT_EQ( PhotonMapRawFile::m_headerSize + nRows * nColumns * int( sizeof( double ) ), data.size() );
+
+	EXPECT_EQ( QByteArray( "TNHPHMAP" ), data.left( 8 ) );
+	EXPECT_EQ( 1U, LoadUnsigned< quint32 >( data, 8 ) );
+	EXPECT_EQ( quint32( PhotonMapRawFile::m_headerSize ), LoadUnsigned< quint32 >( data, 12 ) );
+	EXPECT_EQ( quint32( nColumns ), LoadUnsigned< quint32 >( data, 16 ) );
+	EXPECT_EQ( 0U, LoadUnsigned< quint32 >( data, 20 ) );
+	EXPECT_DOUBLE_EQ( 2.5, LoadDouble( data, 24 ) );
+	EXPECT_EQ( quint64( nRows ), LoadUnsigned< quint64 >( data, 32 ) );
+
+	for( int c = 0; c < nColumns; ++c )
+	{
+		QByteArray name = data.mid( 40 + c * PhotonMapRawFile::m_columnNameSize, PhotonMapRawFile::m_columnNameSize );
+		EXPECT_EQ( columnNames[c], QString::fromLatin1( name.constData() ) );
+		EXPECT_EQ( '\0', name.at( PhotonMapRawFile::m_columnNameSize - 1 ) );
+	}
+
+	for( int r = 0; r < nRows; ++r )
+	{
+		int rowOffset = PhotonMapRawFile::m_headerSize + r * nColumns * int( sizeof( double ) );
+		EXPECT_DOUBLE_EQ( r + 1.0, LoadDouble( data, rowOffset ) );
+		EXPECT_DOUBLE_EQ( -0.25 * r, LoadDouble( data, rowOffset + 8 ) );
+		EXPECT_DOUBLE_EQ( 1000.5 + r, LoadDouble( data, rowOffset + 16 ) );
+	}
+
+	// A new writer with the same columns adds its rows at the end of the file.
+	{
+		PhotonMapRawFile rawFile;
+		ASSERT_TRUE( rawFile.Open( filename, columnNames ) );
+		EXPECT_EQ( (unsigned long) nRows, rawFile.NumberOfRows() );
+		double row[nColumns] = { 6.0, 7.0, 8.0 };
+		EXPECT_TRUE( rawFile.WriteRow( row ) );
+		EXPECT_TRUE( rawFile.Close( 2.5 ) );
+	}
+
+	data = FileContents( filename );
+	ASSERT_EQ( PhotonMapRawFile::m_headerSize + ( nRows + 1 ) * nColumns * int( sizeof( double ) ), data.size() );
+	EXPECT_EQ( quint64( nRows + 1 ), LoadUnsigned< quint64 >( data, 32 ) );
+	EXPECT_DOUBLE_EQ( 8.0, LoadDouble( data, data.size() - 8 ) );
+
+	QFile::remove( filename );
+}
+
+TEST( PhotonMapRawFileTests, OpenFails )
+{
+	PhotonMapRawFile rawFile;
+	QStringList columnNames;
+	columnNames<<QLatin1String( "id" );
+	EXPECT_FALSE( rawFile.Open( QDir::temp().absoluteFilePath( QLatin1String( "PhotonMapRawFileTests_missing/photons.bin" ) ), columnNames ) );
+	EXPECT_FALSE( rawFile.IsOpen() );
+	EXPECT_TRUE( rawFile.Close( 1.0 ) );
+}
@@ -24,13 +24,13 @@ TEST(PhotonTests, DefaultConstructor){
 	for( unsigned long int i = 0; i < maximumNumberOfTests; i++ ){
 
 		Point3D point=taf::randomPoint(a,b);
-		int side=int(taf::randomNumber(a,b));
+		int side = int( i % 2 );
 		Photon ph( point, side, 0, 0 );
-		EXPECT_DOUBLE_EQ( ph.id,0 );
-		EXPECT_DOUBLE_EQ( ph.pos.x,point.x );
-		EXPECT_DOUBLE_EQ( ph.pos.y,point.y );
-		EXPECT_DOUBLE_EQ( ph.pos.z,point.z );
-		EXPECT_DOUBLE_EQ( ph.side,side );
+		EXPECT_EQ( ph.id,0 );
+		EXPECT_FLOAT_EQ( ph.Position().x,float( point.x ) );
+		EXPECT_FLOAT_EQ( ph.Position().y,float( point.y ) );
+		EXPECT_FLOAT_EQ( ph.Position().z,float( point.z ) );
+		EXPECT_EQ( ph.side,side );
 		//EXPECT_TRUE(Photon* ==0);
 	}
 
@@ -45,15 +45,48 @@ TEST(PhotonTests, ConstructorFromPhoton){
 
 	for( unsigned long int i = 0; i < maximumNumberOfTests; i++ ){
 		Point3D point=taf::randomPoint(a,b);
-		double side=taf::randomNumber(a,b);
-		Photon ph( point, side, 0, 0 );
+		int side = int( i % 2 );
+		Photon ph( point, side, 3, 0, 2.5 );
 		Photon result(ph);
-		EXPECT_DOUBLE_EQ( ph.id,result.id );
-		EXPECT_DOUBLE_EQ( ph.pos.x,result.pos.x );
-		EXPECT_DOUBLE_EQ( ph.pos.y,result.pos.y );
-		EXPECT_DOUBLE_EQ( ph.pos.z,result.pos.z );
-		EXPECT_DOUBLE_EQ( double(-1),double(result.side) );
+		EXPECT_EQ( ph.id,result.id );
+		EXPECT_DOUBLE_EQ( ph.Position().x,result.Position().x );
+		EXPECT_DOUBLE_EQ( ph.Position().y,result.Position().y );
+		EXPECT_DOUBLE_EQ( ph.Position().z,result.Position().z );
+		EXPECT_EQ( ph.side,result.side );
+		EXPECT_FLOAT_EQ( 2.5f,result.pathLength );
 	}
 }
 
+TEST(PhotonTests, CompactRecord){
+	// The photon map stores millions of photons, keep the record within half a cache line.
+	EXPECT_LE( sizeof( Photon ), 32u );
+}
+
+TEST(PhotonTests, SideAndIdPacking){
+	// The depth is stored in 16 bits and the side in 8 bits, next to each other.
+	const int ids[] = { 0, 1, 2, 255, 256, 1000, 32767, 32768, 65535 };
+	for( int i = 0; i < 9; i++ ){
+		for( int side = 0; side < 2; side++ ){
+			Photon ph( Point3D( 1.0, 2.0, 3.0 ), side, ids[i], 0, 10.0 );
+			EXPECT_EQ( ids[i], int( ph.id ) );
+			EXPECT_EQ( side, int( ph.side ) );
+			EXPECT_FLOAT_EQ( 10.0f, ph.pathLength );
+			EXPECT_TRUE( ph.intersectedSurface == 0 );
+		}
+	}
+}
 
+TEST(PhotonTests, PathLengthPrecision){
+	srand ( time(NULL) );
+
+	// The path length is stored in single precision.
+	for( unsigned long int i = 0; i < maximumNumberOfTests; i++ ){
+		double pathLength = taf::randomNumber( 0.0, maximumCoordinate );
+		Photon ph( Point3D( 0.0, 0.0, 0.0 ), 1, 1, 0, pathLength );
+		EXPECT_FLOAT_EQ( float( pathLength ), ph.pathLength );
+		EXPECT_NEAR( pathLength, ph.pathLength, 1.0e-7 * pathLength );
+	}
+
+	Photon lightPhoton( Point3D( 0.0, 0.0, 0.0 ), 1 );
+	EXPECT_EQ( 0.0f, lightPhoton.pathLength );
+}
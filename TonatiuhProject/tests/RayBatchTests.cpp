@@ -0,0 +1,101 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "gc.h"
+#include "gf.h"
+#include "Point3D.h"
+#include "Ray.h"
+#include "RayBatch.h"
+#include "Vector3D.h"
+
+TEST( RayBatchTests, ConstructorDefault )
+{
+	RayBatch rays;
+	EXPECT_EQ( 0, rays.Size() );
+}
+
+TEST( RayBatchTests, Resize )
+{
+	RayBatch rays( 16 );
+	EXPECT_EQ( 16, rays.Size() );
+
+	rays.Resize( 5 );
+	EXPECT_EQ( 5, rays.Size() );
+	EXPECT_EQ( 5, int( rays.originX.size() ) );
+	EXPECT_EQ( 5, int( rays.directionZ.size() ) );
+	EXPECT_EQ( 5, int( rays.mint.size() ) );
+}
+
+TEST( RayBatchTests, SetGetRay )
+{
+	RayBatch rays( 3 );
+	Ray first( Point3D( 1.0, -2.5, 3.0 ), Vector3D( 0.0, -1.0, 0.0 ) );
+	Ray second( Point3D( -10.0, 20.0, 0.25 ), Vector3D( 0.6, 0.0, -0.8 ), 0.5, 125.0 );
+	rays.SetRay( 0, first );
+	rays.SetRay( 2, second );
+
+	EXPECT_TRUE( rays.GetRay( 0 ) == first );
+	EXPECT_TRUE( rays.GetRay( 2 ) == second );
+	EXPECT_DOUBLE_EQ( -10.0, rays.originX[2] );
+	EXPECT_DOUBLE_EQ( -0.8, rays.directionZ[2] );
+	EXPECT_DOUBLE_EQ( 0.5, rays.mint[2] );
+	EXPECT_DOUBLE_EQ( 125.0, rays.maxt[2] );
+}
+
+TEST( RayBatchTests, QuadraticRoots )
+{
+	double coefficients[6][3] = { { 1.0, -3.0, 2.0 }, { 2.0, 4.0, -6.0 }, { 1.0, 2.0, 1.0 },
+								{ 1.0, 0.0, 1.0 }, { -0.5, 3.25, 8.0 }, { 1e-3, 2e3, -1.0 } };
+
+	for( int i = 0; i < 6; ++i )
+	{
+		double t0, t1;
+		bool isReal = gf::Quadratic( coefficients[i][0], coefficients[i][1], coefficients[i][2], &t0, &t1 );
+
+		double r0, r1;
+		EXPECT_EQ( isReal, gf::QuadraticRoots( coefficients[i][0], coefficients[i][1], coefficients[i][2], &r0, &r1 ) );
+		if( isReal )
+		{
+			EXPECT_DOUBLE_EQ( t0, r0 );
+			EXPECT_DOUBLE_EQ( t1, r1 );
+		}
+	}
+}
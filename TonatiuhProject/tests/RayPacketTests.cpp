@@ -0,0 +1,148 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "InstanceNode.h"
+#include "Point3D.h"
+#include "RandomDeviate.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "ShapeFlatRectangle.h"
+#include "TestsAuxiliaryFunctions.h"
+#include "Transform.h"
+#include "TSeparatorKit.h"
+#include "Vector3D.h"
+
+class RayPacketTestsRandom : public RandomDeviate
+{
+public:
+	RayPacketTestsRandom() : RandomDeviate( 100 ) {}
+	void FillArray( double* array, const unsigned long arraySize )
+	{
+		for( unsigned long i = 0; i < arraySize; ++i ) array[i] = 0.5;
+	}
+};
+
+/*!
+ * Checks that the node found by the packet for each ray is the node that InstanceNode::Intersect finds for the ray.
+ */
+static void ExpectPacketMatchesSingleRays( InstanceNode* rootInstance )
+{
+	RayPacket packet( RayPacket::m_maxPacketSize );
+	Vector3D direction = Normalize( Vector3D( 0.05, -1.0, 0.02 ) );
+	for( int r = 0; r < packet.Capacity(); ++r )
+		packet.AddRay( Ray( Point3D( -1.2 + 0.35 * r, 5.0, 0.3 ), direction ) );
+	packet.Intersect( rootInstance );
+
+	RayPacketTestsRandom rand;
+	int numberOfHits = 0;
+	Ray ray;
+	InstanceNode* packetHitNode = 0;
+	while( packet.NextRay( &ray, &packetHitNode ) )
+	{
+		EXPECT_DOUBLE_EQ( gc::Infinity, ray.maxt );
+
+		bool isFront = false;
+		InstanceNode* intersectedSurface = 0;
+		Ray outputRay;
+		rootInstance->Intersect( ray, rand, &isFront, &intersectedSurface, &outputRay );
+		EXPECT_TRUE( packetHitNode == intersectedSurface );
+		if( intersectedSurface ) ++numberOfHits;
+	}
+
+	EXPECT_GT( numberOfHits, 0 );
+	EXPECT_LT( numberOfHits, packet.Capacity() );
+}
+
+TEST( RayPacketTests, Capacity )
+{
+	RayPacket packet( 8 );
+	EXPECT_EQ( 8, packet.Capacity() );
+	EXPECT_EQ( 0, packet.Size() );
+	EXPECT_TRUE( packet.IsEmpty() );
+
+	RayPacket largePacket( 1000 );
+	EXPECT_EQ( int( RayPacket::m_maxPacketSize ), largePacket.Capacity() );
+
+	RayPacket invalidPacket( 0 );
+	EXPECT_EQ( 1, invalidPacket.Capacity() );
+}
+
+TEST( RayPacketTests, AddNextRay )
+{
+	RayPacket packet( 4 );
+	Ray first( Point3D( 1.0, 2.0, 3.0 ), Vector3D( 0.0, -1.0, 0.0 ) );
+	Ray second( Point3D( -1.0, 5.0, 0.5 ), Vector3D( 0.6, -0.8, 0.0 ) );
+	packet.AddRay( first );
+	packet.AddRay( second );
+	EXPECT_EQ( 2, packet.Size() );
+	EXPECT_FALSE( packet.IsEmpty() );
+
+	Ray ray;
+	InstanceNode* hitNode = 0;
+	EXPECT_TRUE( packet.NextRay( &ray, &hitNode ) );
+	EXPECT_TRUE( ray == first );
+	EXPECT_TRUE( hitNode == 0 );
+
+	EXPECT_TRUE( packet.NextRay( &ray, &hitNode ) );
+	EXPECT_TRUE( ray == second );
+	EXPECT_TRUE( packet.IsEmpty() );
+	EXPECT_FALSE( packet.NextRay( &ray, &hitNode ) );
+
+	packet.Clear();
+	EXPECT_EQ( 0, packet.Size() );
+	EXPECT_TRUE( packet.IsEmpty() );
+}
+
+TEST( RayPacketTests, IntersectMatchesSingleRays )
+{
+	ShapeFlatRectangle* rectangle = new ShapeFlatRectangle;
+	InstanceNode* rootInstance = new InstanceNode( new TSeparatorKit );
+	taf::addShapeInstance( rootInstance, rectangle, 0, Translate( 0.0, 0.0, 0.0 ) );
+	taf::addShapeInstance( rootInstance, rectangle, 0, Translate( 0.2, 1.0, 0.0 ) );
+	taf::addShapeInstance( rootInstance, rectangle, 0, Translate( 2.5, 0.5, 0.0 ) * RotateZ( 0.3 ) );
+
+	ExpectPacketMatchesSingleRays( rootInstance );
+
+	rootInstance->UpdateInstanceBVH();
+	ExpectPacketMatchesSingleRays( rootInstance );
+
+	delete rootInstance;
+}
@@ -0,0 +1,224 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <gtest/gtest.h>
+
+#include "gc.h"
+#include "ReflectanceTable.h"
+
+//! Incidence angles, in degrees, and reflectances of the test table.
+const double tableAngles[] = { 40.0, 10.0, 70.0 };
+const double tableReflectances[] = { 0.8, 0.9, 0.5 };
+
+//! Returns the reflectance of the test table at \a angle, in degrees, interpolated linearly in angle.
+static double ExpectedReflectance( double angle )
+{
+	if( angle <= 10.0 ) return 0.9;
+	if( angle <= 40.0 ) return 0.9 + ( angle - 10.0 ) / 30.0 * ( 0.8 - 0.9 );
+	if( angle <= 70.0 ) return 0.8 + ( angle - 40.0 ) / 30.0 * ( 0.5 - 0.8 );
+	return 0.5;
+}
+
+static ReflectanceTable CreateTestTable()
+{
+	ReflectanceTable table;
+	table.Create( std::vector< double >( tableAngles, tableAngles + 3 ),
+			std::vector< double >( tableReflectances, tableReflectances + 3 ) );
+	return table;
+}
+
+//! Writes \a content to the file \a name in the temporary directory and returns the file path.
+static QString WriteTableFile( QString name, QString content )
+{
+	QString fileName = QDir::temp().absoluteFilePath( name );
+	QFile file( fileName );
+	if( file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+	{
+		QTextStream out( &file );
+		out << content;
+	}
+	return fileName;
+}
+
+TEST( ReflectanceTableTests, EmptyTable )
+{
+	ReflectanceTable table;
+	EXPECT_TRUE( table.IsEmpty() );
+	EXPECT_DOUBLE_EQ( 1.0, table.Value( 0.0 ) );
+	EXPECT_DOUBLE_EQ( 1.0, table.Value( 0.5 ) );
+	EXPECT_DOUBLE_EQ( 1.0, table.Value( 1.0 ) );
+
+	table = CreateTestTable();
+	EXPECT_FALSE( table.IsEmpty() );
+	table.Clear();
+	EXPECT_TRUE( table.IsEmpty() );
+	EXPECT_DOUBLE_EQ( 1.0, table.Value( 0.5 ) );
+}
+
+TEST( ReflectanceTableTests, CreateInvalid )
+{
+	ReflectanceTable table = CreateTestTable();
+	double value = table.Value( 0.5 );
+
+	std::vector< double > angles( 2, 30.0 );
+	std::vector< double > reflectances( 2, 0.5 );
+	EXPECT_FALSE( table.Create( std::vector< double >(), std::vector< double >() ) );
+	EXPECT_FALSE( table.Create( angles, std::vector< double >( 3, 0.5 ) ) );
+
+	angles[1] = 95.0;
+	EXPECT_FALSE( table.Create( angles, reflectances ) );
+	angles[1] = -5.0;
+	EXPECT_FALSE( table.Create( angles, reflectances ) );
+	angles[1] = 60.0;
+	reflectances[0] = 1.2;
+	EXPECT_FALSE( table.Create( angles, reflectances ) );
+	reflectances[0] = -0.1;
+	EXPECT_FALSE( table.Create( angles, reflectances ) );
+
+	// The table is not changed
+	EXPECT_DOUBLE_EQ( value, table.Value( 0.5 ) );
+}
+
+/*!
+ * At the cosine grid points the value is the interpolation in angle of the table points.
+ */
+TEST( ReflectanceTableTests, ValueAtGridPoints )
+{
+	ReflectanceTable table = CreateTestTable();
+	for( int k = 0; k <= 1024; ++k )
+	{
+		double cosTheta = k / 1024.0;
+		EXPECT_NEAR( ExpectedReflectance( acos( cosTheta ) / gc::Degree ), table.Value( cosTheta ), 1.0e-12 ) << "cosTheta " << cosTheta;
+	}
+}
+
+TEST( ReflectanceTableTests, ValueBetweenTablePoints )
+{
+	ReflectanceTable table = CreateTestTable();
+
+	EXPECT_NEAR( 0.9, table.Value( cos( 10.0 * gc::Degree ) ), 1.0e-3 );
+	EXPECT_NEAR( 0.8, table.Value( cos( 40.0 * gc::Degree ) ), 1.0e-3 );
+	EXPECT_NEAR( 0.5, table.Value( cos( 70.0 * gc::Degree ) ), 1.0e-3 );
+
+	for( double angle = 10.0; angle <= 70.0; angle += 0.37 )
+		EXPECT_NEAR( ExpectedReflectance( angle ), table.Value( cos( angle * gc::Degree ) ), 1.0e-3 ) << "angle " << angle;
+}
+
+/*!
+ * Outside the measured angles the reflectance is the one of the closest measured angle.
+ */
+TEST( ReflectanceTableTests, ValueOutsideTableRange )
+{
+	ReflectanceTable table = CreateTestTable();
+
+	EXPECT_DOUBLE_EQ( 0.9, table.Value( 1.0 ) );
+	EXPECT_DOUBLE_EQ( 0.9, table.Value( cos( 5.0 * gc::Degree ) ) );
+	EXPECT_DOUBLE_EQ( 0.5, table.Value( cos( 80.0 * gc::Degree ) ) );
+	EXPECT_DOUBLE_EQ( 0.5, table.Value( 0.0 ) );
+
+	// Cosines outside [0, 1]
+	EXPECT_DOUBLE_EQ( 0.9, table.Value( 1.5 ) );
+	EXPECT_DOUBLE_EQ( 0.5, table.Value( -0.2 ) );
+
+	ReflectanceTable singlePoint;
+	ASSERT_TRUE( singlePoint.Create( std::vector< double >( 1, 45.0 ), std::vector< double >( 1, 0.7 ) ) );
+	EXPECT_DOUBLE_EQ( 0.7, singlePoint.Value( 0.0 ) );
+	EXPECT_DOUBLE_EQ( 0.7, singlePoint.Value( 0.3 ) );
+	EXPECT_DOUBLE_EQ( 0.7, singlePoint.Value( 1.0 ) );
+}
+
+TEST( ReflectanceTableTests, Read )
+{
+	QString fileName = WriteTableFile( QLatin1String( "ReflectanceTableTests_valid.txt" ),
+			QLatin1String( "# Angle Reflectance\n"
+					"\n"
+					"40.0 0.8\n"
+					"  10.0,0.9  \n"
+					"# Grazing angles\n"
+					"70.0;\t0.5\n" ) );
+
+	ReflectanceTable table;
+	QString errorMessage;
+	ASSERT_TRUE( table.Read( fileName, &errorMessage ) );
+
+	ReflectanceTable expectedTable = CreateTestTable();
+	for( int k = 0; k <= 20; ++k )
+	{
+		double cosTheta = k / 20.0;
+		EXPECT_DOUBLE_EQ( expectedTable.Value( cosTheta ), table.Value( cosTheta ) );
+	}
+}
+
+TEST( ReflectanceTableTests, ReadInvalid )
+{
+	ReflectanceTable table = CreateTestTable();
+	double value = table.Value( 0.5 );
+
+	QStringList invalidContents;
+	invalidContents << QLatin1String( "10.0 0.9\n40.0 0.8 0.7\n" )
+			<< QLatin1String( "10.0 0.9\n40.0\n" )
+			<< QLatin1String( "10.0 0.9\nforty 0.8\n" )
+			<< QLatin1String( "10.0 0.9\n95.0 0.8\n" )
+			<< QLatin1String( "10.0 1.5\n" )
+			<< QLatin1String( "# Only comments\n" );
+
+	for( int i = 0; i < invalidContents.size(); ++i )
+	{
+		QString fileName = WriteTableFile( QString( "ReflectanceTableTests_invalid%1.txt" ).arg( i ), invalidContents[i] );
+		QString errorMessage;
+		EXPECT_FALSE( table.Read( fileName, &errorMessage ) ) << invalidContents[i].toStdString();
+		EXPECT_FALSE( errorMessage.isEmpty() );
+	}
+
+	QString errorMessage;
+	EXPECT_FALSE( table.Read( QDir::temp().absoluteFilePath( QLatin1String( "ReflectanceTableTests_missing.txt" ) ), &errorMessage ) );
+	EXPECT_FALSE( errorMessage.isEmpty() );
+
+	// The table is not changed
+	EXPECT_DOUBLE_EQ( value, table.Value( 0.5 ) );
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+#include "DifferentialGeometry.h"
+#include "gc.h"
+#include "Point3D.h"
+#include "Ray.h"
+#include "RayBatch.h"
+#include "ShapeParabolicRectangle.h"
+#include "TestsAuxiliaryFunctions.h"
+#include "Vector3D.h"
+
+/*!
+ * Checks that ShapeParabolicRectangle::IntersectBatch finds the same hits and distances as ShapeParabolicRectangle::Intersect for random
+ * rays. The side of each batch hit is checked with the scalar intersection of the ray clipped at the batch distance.
+ */
+TEST( ShapeParabolicRectangleTests, IntersectBatchMatchesIntersect )
+{
+	ShapeParabolicRectangle* shape = new ShapeParabolicRectangle;
+	shape->ref();
+	shape->PrepareForTrace();
+
+	srand( 31 );
+	const int numberOfRays = 2000;
+	RayBatch objectRays( numberOfRays );
+	for( int r = 0; r < numberOfRays; ++r )
+	{
+		Point3D origin( taf::randomNumber( -0.8, 0.8 ), taf::randomNumber( -0.5, 1.5 ), taf::randomNumber( -0.8, 0.8 ) );
+		Vector3D direction = Normalize( Vector3D( taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ) ) );
+		double maxt = ( r % 4 == 0 ) ? taf::randomNumber( 0.1, 2.0 ) : gc::Infinity;
+		objectRays.SetRay( r, Ray( origin, direction, ( r % 3 == 0 ) ? 0.01 : gc::Epsilon, maxt ) );
+	}
+
+	double tHit[numberOfRays];
+	bool isHit[numberOfRays];
+	shape->IntersectBatch( objectRays, tHit, isHit );
+
+	int numberOfHits = 0;
+	for( int r = 0; r < numberOfRays; ++r )
+	{
+		Ray ray = objectRays.GetRay( r );
+		double thit = 0.0;
+		DifferentialGeometry dg;
+		bool isScalarHit = shape->Intersect( ray, &thit, &dg );
+
+		EXPECT_EQ( isScalarHit, isHit[r] );
+		if( !isScalarHit || !isHit[r] ) continue;
+		++numberOfHits;
+
+		EXPECT_NEAR( thit, tHit[r], 1.0e-9 );
+
+		Ray clippedRay( ray.origin, ray.direction(), ray.mint, tHit[r] + 1.0e-9 );
+		double clippedTHit = 0.0;
+		ShapeHit clippedHit;
+		EXPECT_TRUE( shape->IntersectHit( clippedRay, &clippedTHit, &clippedHit ) );
+		EXPECT_EQ( dg.shapeFrontSide, clippedHit.shapeFrontSide );
+	}
+	EXPECT_GT( numberOfHits, 0 );
+
+	shape->unref();
+}
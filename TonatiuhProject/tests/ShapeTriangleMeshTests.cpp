@@ -0,0 +1,246 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#include <gtest/gtest.h>
+
+#include "Point3D.h"
+#include "ShapeTriangleMesh.h"
+
+//! Writes \a contents to the file \a name in the temporary directory and returns the file path.
+static QString WriteTextFile( QString name, QString contents )
+{
+	QString fileName = QDir::temp().absoluteFilePath( name );
+	QFile file( fileName );
+	if( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )	file.write( contents.toLatin1() );
+	return fileName;
+}
+
+/*!
+ * Writes a binary STL file \a name in the temporary directory with the triangles of \a triangleVertices
+ * and returns the file path. If \a truncate is true, the last triangle is not complete.
+ */
+static QString WriteBinarySTLFile( QString name, const std::vector< Point3D >& triangleVertices, bool truncate )
+{
+	QString fileName = QDir::temp().absoluteFilePath( name );
+	QFile file( fileName );
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )	return fileName;
+
+	QDataStream out( &file );
+	out.setByteOrder( QDataStream::LittleEndian );
+	out.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+	out.writeRawData( QByteArray( 80, ' ' ).constData(), 80 );
+	quint32 nTriangles = quint32( triangleVertices.size() / 3 );
+	out << nTriangles;
+	for( quint32 t = 0; t < nTriangles; ++t )
+	{
+		out << 0.0f << 1.0f << 0.0f;
+		for( int v = 0; v < 3; ++v )
+		{
+			const Point3D& p = triangleVertices[3 * t + v];
+			out << float( p.x ) << float( p.y ) << float( p.z );
+		}
+		out << quint16( 0 );
+	}
+	file.close();
+
+	if( truncate )	file.resize( file.size() - 10 );
+	return fileName;
+}
+
+//! Returns the vertices of two triangles that define the square [0,1]x[0,1] in the xz plane.
+static std::vector< Point3D > SquareTriangles()
+{
+	std::vector< Point3D > triangleVertices;
+	triangleVertices.push_back( Point3D( 0.0, 0.0, 0.0 ) );
+	triangleVertices.push_back( Point3D( 1.0, 0.0, 0.0 ) );
+	triangleVertices.push_back( Point3D( 1.0, 0.0, 1.0 ) );
+	triangleVertices.push_back( Point3D( 0.0, 0.0, 0.0 ) );
+	triangleVertices.push_back( Point3D( 1.0, 0.0, 1.0 ) );
+	triangleVertices.push_back( Point3D( 0.0, 0.0, 1.0 ) );
+	return triangleVertices;
+}
+
+/*!
+ * Checks that \a vertices and \a indices define the triangles of \a triangleVertices.
+ */
+static void ExpectTriangles( const std::vector< Point3D >& triangleVertices, const std::vector< Point3D >& vertices,
+		const std::vector< int >& indices )
+{
+	ASSERT_EQ( triangleVertices.size(), indices.size() );
+	for( unsigned int i = 0; i < indices.size(); ++i )
+	{
+		ASSERT_GE( indices[i], 0 );
+		ASSERT_LT( indices[i], int( vertices.size() ) );
+		EXPECT_TRUE( vertices[ indices[i] ] == triangleVertices[i] );
+	}
+}
+
+TEST( ShapeTriangleMeshTests, ReadASCIISTL )
+{
+	QString fileName = WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_ascii.stl" ),
+			QLatin1String( "solid square\n"
+			"  facet normal 0 1 0\n"
+			"    outer loop\n"
+			"      vertex 0 0 0\n"
+			"      vertex 1 0 0\n"
+			"      vertex 1 0 1\n"
+			"    endloop\n"
+			"  endfacet\n"
+			"  facet normal 0 1 0\n"
+			"    outer loop\n"
+			"      vertex 0.0 0.0 0.0\n"
+			"      vertex 1.0e0 0.0 1.0\n"
+			"      vertex 0 0 1\n"
+			"    endloop\n"
+			"  endfacet\n"
+			"endsolid square\n" ) );
+
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	QString errorMessage;
+	ASSERT_TRUE( ShapeTriangleMesh::ReadInputDataFile( fileName, &vertices, &indices, &errorMessage ) );
+
+	// The vertices shared by both triangles are stored once
+	EXPECT_EQ( 4, int( vertices.size() ) );
+	ExpectTriangles( SquareTriangles(), vertices, indices );
+	QFile::remove( fileName );
+}
+
+TEST( ShapeTriangleMeshTests, ReadBinarySTL )
+{
+	QString fileName = WriteBinarySTLFile( QLatin1String( "ShapeTriangleMeshTests_binary.stl" ), SquareTriangles(), false );
+
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	QString errorMessage;
+	ASSERT_TRUE( ShapeTriangleMesh::ReadInputDataFile( fileName, &vertices, &indices, &errorMessage ) );
+
+	EXPECT_EQ( 4, int( vertices.size() ) );
+	ExpectTriangles( SquareTriangles(), vertices, indices );
+	QFile::remove( fileName );
+}
+
+TEST( ShapeTriangleMeshTests, ReadOBJ )
+{
+	QString fileName = WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_square.obj" ),
+			QLatin1String( "# Square defined with a quad\n"
+			"o square\n"
+			"v 0 0 0\n"
+			"v 1 0 0\n"
+			"v 1 0 1\n"
+			"v 0 0 1\n"
+			"vt 0 0\n"
+			"vn 0 1 0\n"
+			"f 1/1/1 2//1 3 -1\n" ) );
+
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	QString errorMessage;
+	ASSERT_TRUE( ShapeTriangleMesh::ReadInputDataFile( fileName, &vertices, &indices, &errorMessage ) );
+
+	// The quad is split around its first vertex
+	EXPECT_EQ( 4, int( vertices.size() ) );
+	ExpectTriangles( SquareTriangles(), vertices, indices );
+	QFile::remove( fileName );
+}
+
+TEST( ShapeTriangleMeshTests, ReadMalformedFiles )
+{
+	QStringList fileNames;
+
+	// Vertex with a coordinate that is not a number
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_badVertex.stl" ),
+			QLatin1String( "solid bad\n facet normal 0 1 0\n  outer loop\n"
+			"   vertex 0 0 0\n   vertex 1 x 0\n   vertex 1 0 1\n  endloop\n endfacet\nendsolid bad\n" ) );
+
+	// Incomplete triangle
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_incomplete.stl" ),
+			QLatin1String( "solid bad\n facet normal 0 1 0\n  outer loop\n"
+			"   vertex 0 0 0\n   vertex 1 0 0\n  endloop\n endfacet\nendsolid bad\n" ) );
+
+	// Binary file shorter than its number of triangles
+	fileNames<<WriteBinarySTLFile( QLatin1String( "ShapeTriangleMeshTests_truncated.stl" ), SquareTriangles(), true );
+
+	// Face with an index of a vertex that does not exist
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_badIndex.obj" ),
+			QLatin1String( "v 0 0 0\nv 1 0 0\nv 1 0 1\nf 1 2 5\n" ) );
+
+	// Face with two vertices
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_shortFace.obj" ),
+			QLatin1String( "v 0 0 0\nv 1 0 0\nv 1 0 1\nf 1 2\n" ) );
+
+	// Vertex with two coordinates
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_badVertex.obj" ),
+			QLatin1String( "v 0 0\nv 1 0 0\nv 1 0 1\nf 1 2 3\n" ) );
+
+	// Vertices without faces
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_noFaces.obj" ),
+			QLatin1String( "v 0 0 0\nv 1 0 0\nv 1 0 1\n" ) );
+
+	// Unknown file format
+	fileNames<<WriteTextFile( QLatin1String( "ShapeTriangleMeshTests_square.txt" ),
+			QLatin1String( "v 0 0 0\nv 1 0 0\nv 1 0 1\nf 1 2 3\n" ) );
+
+	for( int f = 0; f < fileNames.size(); ++f )
+	{
+		std::vector< Point3D > vertices;
+		std::vector< int > indices;
+		QString errorMessage;
+		EXPECT_FALSE( ShapeTriangleMesh::ReadInputDataFile( fileNames[f], &vertices, &indices, &errorMessage ) ) << fileNames[f].toStdString();
+		EXPECT_FALSE( errorMessage.isEmpty() );
+		QFile::remove( fileNames[f] );
+	}
+
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	QString errorMessage;
+	EXPECT_FALSE( ShapeTriangleMesh::ReadInputDataFile( QDir::temp().absoluteFilePath( QLatin1String( "ShapeTriangleMeshTests_missing.stl" ) ),
+			&vertices, &indices, &errorMessage ) );
+	EXPECT_FALSE( errorMessage.isEmpty() );
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "DifferentialGeometry.h"
+#include "Point3D.h"
+#include "Ray.h"
+#include "ShapeTroughCHC.h"
+#include "Vector3D.h"
+
+/*!
+ * A vertical ray crosses the default CHC profile at x = 0.3, in the middle of the profile. The profile parameter
+ * search used before the fix compared the profile function against 0.5 * ( sup - inf ) instead of zero and returned
+ * u = 0, the top edge of the profile at ( 0.5, 1.0 ). The hit parameters must give back the hit point.
+ */
+TEST( ShapeTroughCHCTests, IntersectFindsProfileParameterOfHit )
+{
+	ShapeTroughCHC* shape = new ShapeTroughCHC;
+	shape->ref();
+
+	Ray ray( Point3D( 0.3, 2.0, 0.1 ), Vector3D( 0.0, -1.0, 0.0 ) );
+	double tHit = 0.0;
+	DifferentialGeometry dg;
+	ASSERT_TRUE( shape->Intersect( ray, &tHit, &dg ) );
+
+	EXPECT_NEAR( 1.7653417620710035, tHit, 1.0e-9 );
+	EXPECT_NEAR( 0.3, dg.point.x, 1.0e-12 );
+	EXPECT_NEAR( 0.23465823792899654, dg.point.y, 1.0e-9 );
+
+	// Root returned before the fix and the point it represents
+	const double oldU = 0.0;
+	Point3D oldPoint = shape->Sample( oldU, dg.v );
+	EXPECT_NEAR( 0.5, oldPoint.x, 1.0e-9 );
+	EXPECT_NEAR( 1.0, oldPoint.y, 1.0e-9 );
+
+	// Root of the profile that the ray intersects
+	EXPECT_NEAR( 0.5429492415469614, dg.u, 1.0e-6 );
+	EXPECT_NEAR( 0.6, dg.v, 1.0e-9 );
+	Point3D point = shape->Sample( dg.u, dg.v );
+	EXPECT_NEAR( dg.point.x, point.x, 1.0e-9 );
+	EXPECT_NEAR( dg.point.y, point.y, 1.0e-6 );
+	EXPECT_NEAR( dg.point.z, point.z, 1.0e-9 );
+
+	shape->unref();
+}
@@ -0,0 +1,196 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "RandomDeviate.h"
+#include "SpectralWeights.h"
+
+//! Linear congruential generator with a fixed seed, so that the tests are repeatable.
+class BandsRandomDeviate : public RandomDeviate
+{
+public:
+	BandsRandomDeviate() : RandomDeviate( 1000 ), m_state( 54321 ) {}
+
+	void FillArray( double* array, const unsigned long arraySize )
+	{
+		for( unsigned long i = 0; i < arraySize; ++i )
+		{
+			m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			array[i] = ( m_state >> 11 ) * ( 1.0 / 9007199254740992.0 );
+		}
+	}
+
+private:
+	unsigned long long m_state;
+};
+
+TEST( SpectralWeightsTests, ConstructorDefault )
+{
+	SpectralWeights weights;
+	EXPECT_EQ( 0, weights.nBands );
+	EXPECT_DOUBLE_EQ( 0.0, weights.Total() );
+}
+
+TEST( SpectralWeightsTests, ConstructorBands )
+{
+	double fractions[3] = { 0.5, 0.3, 0.2 };
+	SpectralWeights weights( 3, fractions );
+	EXPECT_EQ( 3, weights.nBands );
+	EXPECT_FLOAT_EQ( 0.3f, weights.weight[1] );
+	EXPECT_NEAR( 1.0, weights.Total(), 1.0e-6 );
+
+	double manyFractions[SpectralWeights::m_maxBands + 2];
+	for( int b = 0; b < SpectralWeights::m_maxBands + 2; ++b )	manyFractions[b] = 0.1;
+	SpectralWeights limitedWeights( SpectralWeights::m_maxBands + 2, manyFractions );
+	EXPECT_EQ( int( SpectralWeights::m_maxBands ), limitedWeights.nBands );
+}
+
+TEST( SpectralWeightsTests, AttenuateExpectedPower )
+{
+	double fractions[3] = { 0.5, 0.3, 0.2 };
+	SpectralWeights sourceWeights( 3, fractions );
+
+	// The last factor is used for the third band
+	double reflectivity[2] = { 0.9, 0.45 };
+
+	BandsRandomDeviate rand;
+	const int numberOfRays = 200000;
+	double power[3] = { 0.0, 0.0, 0.0 };
+	for( int i = 0; i < numberOfRays; ++i )
+	{
+		SpectralWeights weights( sourceWeights );
+		if( !weights.Attenuate( reflectivity, 2, rand ) )
+		{
+			EXPECT_FLOAT_EQ( sourceWeights.weight[0], weights.weight[0] );
+			continue;
+		}
+		for( int b = 0; b < 3; ++b )	power[b] += weights.weight[b];
+	}
+
+	EXPECT_NEAR( 0.5 * 0.9, power[0] / numberOfRays, 0.005 );
+	EXPECT_NEAR( 0.3 * 0.45, power[1] / numberOfRays, 0.005 );
+	EXPECT_NEAR( 0.2 * 0.45, power[2] / numberOfRays, 0.005 );
+}
+
+TEST( SpectralWeightsTests, Scale )
+{
+	double fractions[2] = { 0.6, 0.4 };
+	SpectralWeights weights( 2, fractions );
+	weights.Scale( 0.5 );
+	EXPECT_FLOAT_EQ( 0.3f, weights.weight[0] );
+	EXPECT_FLOAT_EQ( 0.2f, weights.weight[1] );
+	EXPECT_NEAR( 0.5, weights.Total(), 1.0e-6 );
+
+	SpectralWeights emptyWeights;
+	emptyWeights.Scale( 0.5 );
+	EXPECT_EQ( 0, emptyWeights.nBands );
+}
+
+TEST( SpectralWeightsTests, SelectInteractionExpectedPower )
+{
+	double fractions[3] = { 0.5, 0.3, 0.2 };
+	SpectralWeights sourceWeights( 3, fractions );
+
+	double reflectivity[3] = { 0.1, 0.4, 0.05 };
+	double transmissivity[3] = { 0.85, 0.5, 0.2 };
+	const double* interactionFactors[2] = { reflectivity, transmissivity };
+
+	BandsRandomDeviate rand;
+	const int numberOfRays = 200000;
+	double reflectedPower[3] = { 0.0, 0.0, 0.0 };
+	double transmittedPower[3] = { 0.0, 0.0, 0.0 };
+	for( int i = 0; i < numberOfRays; ++i )
+	{
+		SpectralWeights weights( sourceWeights );
+		int interaction = weights.SelectInteraction( interactionFactors, 2, rand );
+		if( interaction < 0 )
+		{
+			EXPECT_FLOAT_EQ( sourceWeights.weight[0], weights.weight[0] );
+			continue;
+		}
+
+		// The selected ray keeps the total weight
+		EXPECT_NEAR( sourceWeights.Total(), weights.Total(), 1.0e-6 );
+		for( int b = 0; b < 3; ++b )
+		{
+			if( interaction == 0 )	reflectedPower[b] += weights.weight[b];
+			else	transmittedPower[b] += weights.weight[b];
+		}
+	}
+
+	for( int b = 0; b < 3; ++b )
+	{
+		EXPECT_NEAR( fractions[b] * reflectivity[b], reflectedPower[b] / numberOfRays, 0.005 );
+		EXPECT_NEAR( fractions[b] * transmissivity[b], transmittedPower[b] / numberOfRays, 0.005 );
+	}
+}
+
+TEST( SpectralWeightsTests, SelectInteractionWithoutPower )
+{
+	double reflectivity[2] = { 0.0, 0.0 };
+	const double* interactionFactors[1] = { reflectivity };
+
+	BandsRandomDeviate rand;
+	double fractions[2] = { 0.6, 0.4 };
+	SpectralWeights weights( 2, fractions );
+	EXPECT_EQ( -1, weights.SelectInteraction( interactionFactors, 1, rand ) );
+	EXPECT_FLOAT_EQ( 0.6f, weights.weight[0] );
+
+	SpectralWeights emptyWeights;
+	EXPECT_EQ( -1, emptyWeights.SelectInteraction( interactionFactors, 1, rand ) );
+}
+
+TEST( SpectralWeightsTests, ReadBandFactors )
+{
+	std::vector< double > factors = SpectralWeights::ReadBandFactors( " 0.9, 0.5;0.25\t1.5 -0.2 abc " );
+	ASSERT_EQ( 6u, factors.size() );
+	EXPECT_DOUBLE_EQ( 0.9, factors[0] );
+	EXPECT_DOUBLE_EQ( 0.5, factors[1] );
+	EXPECT_DOUBLE_EQ( 0.25, factors[2] );
+	EXPECT_DOUBLE_EQ( 1.0, factors[3] );
+	EXPECT_DOUBLE_EQ( 0.0, factors[4] );
+	EXPECT_DOUBLE_EQ( 0.0, factors[5] );
+
+	EXPECT_TRUE( SpectralWeights::ReadBandFactors( "" ).empty() );
+	EXPECT_TRUE( SpectralWeights::ReadBandFactors( " ,; " ).empty() );
+	EXPECT_TRUE( SpectralWeights::ReadBandFactors( 0 ).empty() );
+}
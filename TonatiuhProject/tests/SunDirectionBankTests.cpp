@@ -0,0 +1,154 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "RandomDeviate.h"
+#include "SunDirectionBank.h"
+#include "TSunShape.h"
+#include "Vector3D.h"
+
+//! Linear congruential generator with a fixed seed, so that the tests are repeatable.
+class BankRandomDeviate : public RandomDeviate
+{
+public:
+	BankRandomDeviate() : RandomDeviate( 10 ), m_state( 2718 ) {}
+
+	void FillArray( double* array, const unsigned long arraySize )
+	{
+		for( unsigned long i = 0; i < arraySize; ++i )
+		{
+			m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			array[i] = ( m_state >> 11 ) * ( 1.0 / 9007199254740992.0 );
+		}
+	}
+
+private:
+	unsigned long long m_state;
+};
+
+//! Sunshape that returns the random numbers as the direction components, with the default batch generation.
+class BankSunShape : public TSunShape
+{
+public:
+	BankSunShape() {}
+
+	void GenerateRayDirection( Vector3D& direction, RandomDeviate& rand ) const
+	{
+		direction.x = rand.RandomDouble();
+		direction.y = -1.0;
+		direction.z = rand.RandomDouble();
+	}
+	double GetIrradiance() const { return 1000.0; }
+	double GetThetaMax() const { return 0.00465; }
+
+	static void Directions( double* directionX, double* directionY, double* directionZ, int numberOfDirections )
+	{
+		ComputeDirections( directionX, directionY, directionZ, numberOfDirections );
+	}
+
+protected:
+	~BankSunShape() {}
+};
+
+TEST( SunDirectionBankTests, BankSize )
+{
+	BankSunShape* sunShape = new BankSunShape;
+	sunShape->ref();
+
+	SunDirectionBank bank( sunShape );
+	EXPECT_EQ( int( SunDirectionBank::m_defaultBankSize ), bank.BankSize() );
+
+	SunDirectionBank invalidBank( sunShape, 0 );
+	EXPECT_EQ( 1, invalidBank.BankSize() );
+
+	EXPECT_EQ( int( SunDirectionBank::m_defaultBankSize ), SunDirectionBank::BankSizeForRays( 1.0e6 ) );
+	EXPECT_EQ( 100, SunDirectionBank::BankSizeForRays( 100.0 ) );
+	EXPECT_EQ( 1, SunDirectionBank::BankSizeForRays( 0.0 ) );
+
+	sunShape->unref();
+}
+
+TEST( SunDirectionBankTests, SameDirectionsAsSunShape )
+{
+	BankSunShape* sunShape = new BankSunShape;
+	sunShape->ref();
+
+	BankRandomDeviate bankRand;
+	SunDirectionBank bank( sunShape, 3 );
+
+	BankRandomDeviate rand;
+	for( int i = 0; i < 7; ++i )
+	{
+		Vector3D expected;
+		sunShape->GenerateRayDirection( expected, rand );
+
+		Vector3D direction = bank.NextDirection( bankRand );
+		EXPECT_DOUBLE_EQ( expected.x, direction.x );
+		EXPECT_DOUBLE_EQ( expected.y, direction.y );
+		EXPECT_DOUBLE_EQ( expected.z, direction.z );
+	}
+
+	sunShape->unref();
+}
+
+TEST( SunDirectionBankTests, ComputeDirections )
+{
+	double directionX[3] = { 0.3, 0.25, 0.5 };
+	double directionY[3] = { 0.0, 0.0, 0.0 };
+	double directionZ[3] = { 0.0, 1.0e-5, 0.25 };
+	BankSunShape::Directions( directionX, directionY, directionZ, 3 );
+
+	EXPECT_DOUBLE_EQ( 0.0, directionX[0] );
+	EXPECT_DOUBLE_EQ( -1.0, directionY[0] );
+	EXPECT_DOUBLE_EQ( 0.0, directionZ[0] );
+
+	EXPECT_NEAR( sqrt( 1.0e-5 ), directionX[1], 1e-15 );
+	EXPECT_NEAR( 0.0, directionZ[1], 1e-15 );
+
+	EXPECT_NEAR( 0.0, directionX[2], 1e-15 );
+	EXPECT_NEAR( -0.5, directionZ[2], 1e-15 );
+	for( int i = 0; i < 3; ++i )
+	{
+		double length = directionX[i] * directionX[i] + directionY[i] * directionY[i] + directionZ[i] * directionZ[i];
+		EXPECT_NEAR( 1.0, length, 1e-15 );
+	}
+}
@@ -0,0 +1,220 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <gtest/gtest.h>
+
+#include "SunshapeProfile.h"
+
+//! Returns sin^2 of the zenith angle with cumulative probability \a u in a uniform disk of angular radius \a thetaMax.
+static double UniformDiskSinTheta2( double u, double thetaMax )
+{
+	double cosTheta = 1.0 - u * ( 1.0 - cos( thetaMax ) );
+	return 1.0 - cosTheta * cosTheta;
+}
+
+//! Writes \a content to the file \a name in the temporary directory and returns the file path.
+static QString WriteProfileFile( QString name, QString content )
+{
+	QString fileName = QDir::temp().absoluteFilePath( name );
+	QFile file( fileName );
+	if( file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+	{
+		QTextStream out( &file );
+		out << content;
+	}
+	return fileName;
+}
+
+/*!
+ * The default profile is the uniform disk of the default pillbox sunshape.
+ */
+TEST( SunshapeProfileTests, DefaultProfile )
+{
+	SunshapeProfile profile;
+	EXPECT_DOUBLE_EQ( 0.00465, profile.ThetaMax() );
+
+	double sinThetaMax2 = UniformDiskSinTheta2( 1.0, 0.00465 );
+	EXPECT_DOUBLE_EQ( 0.0, profile.SinTheta2( 0.0 ) );
+	EXPECT_NEAR( sinThetaMax2, profile.SinTheta2( 1.0 ), 1.0e-15 );
+	for( int k = 0; k <= 1000; ++k )
+	{
+		double u = k / 1000.0;
+		EXPECT_NEAR( UniformDiskSinTheta2( u, 0.00465 ), profile.SinTheta2( u ), 1.0e-6 * sinThetaMax2 ) << "u " << u;
+	}
+}
+
+TEST( SunshapeProfileTests, SinTheta2IsMonotonic )
+{
+	double anglesArray[] = { 0.0, 2.0, 4.0, 4.65, 10.0, 30.0 };
+	double intensitiesArray[] = { 1.0, 0.9, 0.6, 0.02, 0.001, 0.0 };
+	SunshapeProfile profile;
+	ASSERT_TRUE( profile.Create( std::vector< double >( anglesArray, anglesArray + 6 ),
+			std::vector< double >( intensitiesArray, intensitiesArray + 6 ) ) );
+	EXPECT_DOUBLE_EQ( 0.03, profile.ThetaMax() );
+
+	double previous = profile.SinTheta2( 0.0 );
+	for( int k = 1; k <= 100000; ++k )
+	{
+		double value = profile.SinTheta2( k / 100000.0 );
+		ASSERT_GE( value, previous ) << "u " << k / 100000.0;
+		previous = value;
+	}
+	EXPECT_NEAR( sin( 0.03 ) * sin( 0.03 ), previous, 1.0e-15 );
+}
+
+/*!
+ * The profile ends at the first zero after the last nonzero intensity, whatever the order of the angles.
+ */
+TEST( SunshapeProfileTests, ProfileEnd )
+{
+	double anglesArray[] = { 8.0, 0.0, 6.0, 5.0, 10.0 };
+	double intensitiesArray[] = { 0.0, 1.0, 0.0, 1.0, 0.0 };
+	SunshapeProfile profile;
+	ASSERT_TRUE( profile.Create( std::vector< double >( anglesArray, anglesArray + 5 ),
+			std::vector< double >( intensitiesArray, intensitiesArray + 5 ) ) );
+	EXPECT_DOUBLE_EQ( 0.006, profile.ThetaMax() );
+
+	// A profile that ends with a nonzero intensity ends at its last angle
+	std::vector< double > angles( 2 );
+	angles[0] = 0.0;
+	angles[1] = 4.65;
+	std::vector< double > intensities( 2, 1.0 );
+	ASSERT_TRUE( profile.Create( angles, intensities ) );
+	EXPECT_DOUBLE_EQ( 0.00465, profile.ThetaMax() );
+	SunshapeProfile defaultProfile;
+	for( int k = 0; k <= 100; ++k )
+		EXPECT_DOUBLE_EQ( defaultProfile.SinTheta2( k / 100.0 ), profile.SinTheta2( k / 100.0 ) );
+}
+
+TEST( SunshapeProfileTests, CreateInvalid )
+{
+	SunshapeProfile profile;
+	double value = profile.SinTheta2( 0.5 );
+
+	std::vector< double > angles( 2 );
+	angles[0] = 0.0;
+	angles[1] = 5.0;
+	std::vector< double > intensities( 2, 1.0 );
+	EXPECT_FALSE( profile.Create( std::vector< double >(), std::vector< double >() ) );
+	EXPECT_FALSE( profile.Create( angles, std::vector< double >( 3, 1.0 ) ) );
+
+	angles[1] = -1.0;
+	EXPECT_FALSE( profile.Create( angles, intensities ) );
+	angles[1] = 1600.0;
+	EXPECT_FALSE( profile.Create( angles, intensities ) );
+	angles[1] = 5.0;
+	intensities[0] = -0.5;
+	EXPECT_FALSE( profile.Create( angles, intensities ) );
+	intensities[0] = 0.0;
+	intensities[1] = 0.0;
+	EXPECT_FALSE( profile.Create( angles, intensities ) );
+
+	// A single angle at the sun centre has no width
+	EXPECT_FALSE( profile.Create( std::vector< double >( 1, 0.0 ), std::vector< double >( 1, 1.0 ) ) );
+
+	// The profile is not changed
+	EXPECT_DOUBLE_EQ( 0.00465, profile.ThetaMax() );
+	EXPECT_DOUBLE_EQ( value, profile.SinTheta2( 0.5 ) );
+}
+
+TEST( SunshapeProfileTests, Read )
+{
+	QString fileName = WriteProfileFile( QLatin1String( "SunshapeProfileTests_valid.txt" ),
+			QLatin1String( "# Angle (mrad) Intensity\n"
+					"\n"
+					"4.0 0.6\n"
+					"  0.0,1.0  \n"
+					"# Circumsolar region\n"
+					"10.0;\t0.0\n"
+					"4.65 0.02\n" ) );
+
+	SunshapeProfile profile;
+	QString errorMessage;
+	ASSERT_TRUE( profile.Read( fileName, &errorMessage ) );
+
+	double anglesArray[] = { 0.0, 4.0, 4.65, 10.0 };
+	double intensitiesArray[] = { 1.0, 0.6, 0.02, 0.0 };
+	SunshapeProfile expectedProfile;
+	ASSERT_TRUE( expectedProfile.Create( std::vector< double >( anglesArray, anglesArray + 4 ),
+			std::vector< double >( intensitiesArray, intensitiesArray + 4 ) ) );
+
+	EXPECT_DOUBLE_EQ( expectedProfile.ThetaMax(), profile.ThetaMax() );
+	for( int k = 0; k <= 20; ++k )
+		EXPECT_DOUBLE_EQ( expectedProfile.SinTheta2( k / 20.0 ), profile.SinTheta2( k / 20.0 ) );
+}
+
+TEST( SunshapeProfileTests, ReadInvalid )
+{
+	SunshapeProfile profile;
+	double value = profile.SinTheta2( 0.5 );
+
+	QStringList invalidContents;
+	invalidContents << QLatin1String( "0.0 1.0\n4.0 0.6 0.5\n" )
+			<< QLatin1String( "0.0 1.0\n4.0\n" )
+			<< QLatin1String( "0.0 1.0\nfour 0.6\n" )
+			<< QLatin1String( "0.0 1.0\n4.0 -0.6\n" )
+			<< QLatin1String( "0.0 1.0\n2000.0 0.6\n" )
+			<< QLatin1String( "0.0 0.0\n4.0 0.0\n" )
+			<< QLatin1String( "# Only comments\n" );
+
+	for( int i = 0; i < int( invalidContents.size() ); ++i )
+	{
+		QString fileName = WriteProfileFile( QString( "SunshapeProfileTests_invalid%1.txt" ).arg( i ), invalidContents[i] );
+		QString errorMessage;
+		EXPECT_FALSE( profile.Read( fileName, &errorMessage ) ) << invalidContents[i].toStdString();
+		EXPECT_FALSE( errorMessage.isEmpty() );
+	}
+
+	QString errorMessage;
+	EXPECT_FALSE( profile.Read( QDir::temp().absoluteFilePath( QLatin1String( "SunshapeProfileTests_missing.txt" ) ), &errorMessage ) );
+	EXPECT_FALSE( errorMessage.isEmpty() );
+
+	// The profile is not changed
+	EXPECT_DOUBLE_EQ( 0.00465, profile.ThetaMax() );
+	EXPECT_DOUBLE_EQ( value, profile.SinTheta2( 0.5 ) );
+}
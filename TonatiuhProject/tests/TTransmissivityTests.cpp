@@ -0,0 +1,201 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Photon.h"
+#include "PhotonArena.h"
+#include "trf.h"
+#include "TTransmissivity.h"
+
+//! Beer-Lambert attenuation with an extinction coefficient of 1/km.
+class ExponentialTransmissivity : public TTransmissivity
+{
+public:
+	ExponentialTransmissivity() {}
+
+	double Transmittance( double distance ) const { return exp( -0.001 * distance ); }
+};
+
+//! Linear model that is greater than 1 near the receiver and negative far away from it.
+class UnclampedTransmissivity : public TTransmissivity
+{
+public:
+	UnclampedTransmissivity() {}
+
+	double Transmittance( double distance ) const { return 1.2 - 0.0002 * distance; }
+};
+
+/*!
+ * At the nodes of the table the attenuation factor is the transmittance.
+ */
+TEST( TTransmissivityTests, AttenuationFactorAtTableNodes )
+{
+	ExponentialTransmissivity* transmissivity = new ExponentialTransmissivity;
+	transmissivity->ref();
+	transmissivity->PrepareForTrace();
+
+	for( int i = 0; i <= TTransmissivity::m_tableSize; ++i )
+	{
+		double distance = i * TTransmissivity::m_tableStep;
+		ASSERT_DOUBLE_EQ( transmissivity->Transmittance( distance ), transmissivity->AttenuationFactor( distance ) ) << "distance " << distance;
+	}
+
+	transmissivity->unref();
+}
+
+/*!
+ * Between the nodes the error of the linear interpolation is below step^2 / 8 * max| Transmittance'' |.
+ */
+TEST( TTransmissivityTests, AttenuationFactorMatchesTransmittance )
+{
+	ExponentialTransmissivity* transmissivity = new ExponentialTransmissivity;
+	transmissivity->ref();
+	transmissivity->PrepareForTrace();
+
+	double step = TTransmissivity::m_tableStep;
+	double maxError = step * step / 8 * 1.0e-6;
+	double tableEnd = TTransmissivity::m_tableSize * step;
+	for( double distance = 0.0; distance < tableEnd; distance += 0.37 )
+	{
+		ASSERT_NEAR( transmissivity->Transmittance( distance ), transmissivity->AttenuationFactor( distance ), maxError ) << "distance " << distance;
+	}
+
+	// Beyond the end of the table the transmittance is computed
+	for( double distance = tableEnd; distance < 2.0 * tableEnd; distance += 13.7 )
+		ASSERT_DOUBLE_EQ( transmissivity->Transmittance( distance ), transmissivity->AttenuationFactor( distance ) );
+
+	transmissivity->unref();
+}
+
+/*!
+ * Without table, the attenuation factor is the transmittance.
+ */
+TEST( TTransmissivityTests, AttenuationFactorWithoutTable )
+{
+	ExponentialTransmissivity* transmissivity = new ExponentialTransmissivity;
+	transmissivity->ref();
+
+	for( double distance = 0.0; distance < 10000.0; distance += 123.45 )
+		EXPECT_DOUBLE_EQ( transmissivity->Transmittance( distance ), transmissivity->AttenuationFactor( distance ) );
+
+	transmissivity->unref();
+}
+
+/*!
+ * The attenuation factor is limited to [0, 1] in the table and out of it.
+ */
+TEST( TTransmissivityTests, AttenuationFactorIsClamped )
+{
+	UnclampedTransmissivity* transmissivity = new UnclampedTransmissivity;
+	transmissivity->ref();
+	transmissivity->PrepareForTrace();
+
+	EXPECT_DOUBLE_EQ( 1.0, transmissivity->AttenuationFactor( 0.0 ) );
+	EXPECT_DOUBLE_EQ( 1.0, transmissivity->AttenuationFactor( 1000.0 ) );
+	EXPECT_NEAR( 0.8, transmissivity->AttenuationFactor( 2000.0 ), 1.0e-12 );
+	EXPECT_NEAR( 0.2, transmissivity->AttenuationFactor( 5000.0 ), 1.0e-12 );
+	EXPECT_DOUBLE_EQ( 0.0, transmissivity->AttenuationFactor( 6000.0 ) );
+	EXPECT_DOUBLE_EQ( 0.0, transmissivity->AttenuationFactor( 8191.5 ) );
+	EXPECT_DOUBLE_EQ( 0.0, transmissivity->AttenuationFactor( 10000.0 ) );
+	EXPECT_DOUBLE_EQ( 1.0, transmissivity->AttenuationFactor( -10.0 ) );
+
+	for( double distance = 0.0; distance < 10000.0; distance += 0.73 )
+	{
+		double factor = transmissivity->AttenuationFactor( distance );
+		ASSERT_GE( factor, 0.0 ) << "distance " << distance;
+		ASSERT_LE( factor, 1.0 ) << "distance " << distance;
+	}
+
+	transmissivity->unref();
+}
+
+TEST( TTransmissivityTests, AttenuationFactor )
+{
+	ExponentialTransmissivity* transmissivity = new ExponentialTransmissivity;
+	transmissivity->ref();
+	transmissivity->PrepareForTrace();
+
+	double distances[5] = { 0.0, 0.25, 120.5, 1234.75, 8191.9 };
+	for( int d = 0; d < 5; ++d )
+		EXPECT_NEAR( exp( -0.001 * distances[d] ), transmissivity->AttenuationFactor( distances[d] ), 1.0e-6 );
+
+	// Out of the table
+	EXPECT_DOUBLE_EQ( exp( -20.0 ), transmissivity->AttenuationFactor( 20000.0 ) );
+	EXPECT_DOUBLE_EQ( 0.0, transmissivity->AttenuationFactor( HUGE_VAL ) );
+
+	transmissivity->unref();
+}
+
+TEST( TTransmissivityTests, ComputeAttenuationFactors )
+{
+	ExponentialTransmissivity* transmissivity = new ExponentialTransmissivity;
+	transmissivity->ref();
+
+	// A ray with the light photon and two reflections and a ray without the light photon
+	std::vector< Photon > rays;
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 0 ) );
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 1 ) );
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 2, 0, 500.0 ) );
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 3, 0, 100.0 ) );
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 1 ) );
+	rays.push_back( Photon( Point3D( 0.0, 0.0, 0.0 ), 1, 2, 0, 1000.0 ) );
+
+	PhotonArena photons;
+	photons.Append( rays );
+
+	std::vector< double > factors;
+	trf::ComputeAttenuationFactors( photons, transmissivity, &factors );
+	ASSERT_EQ( photons.size(), factors.size() );
+	EXPECT_DOUBLE_EQ( 1.0, factors[0] );
+	EXPECT_DOUBLE_EQ( 1.0, factors[1] );
+	EXPECT_NEAR( exp( -0.5 ), factors[2], 1.0e-6 );
+	EXPECT_NEAR( exp( -0.6 ), factors[3], 1.0e-6 );
+	EXPECT_DOUBLE_EQ( 1.0, factors[4] );
+	EXPECT_NEAR( exp( -1.0 ), factors[5], 1.0e-6 );
+
+	trf::ComputeAttenuationFactors( photons, 0, &factors );
+	for( unsigned int p = 0; p < factors.size(); ++p )
+		EXPECT_DOUBLE_EQ( 1.0, factors[p] );
+
+	transmissivity->unref();
+}
@@ -41,7 +41,11 @@ Juana Amieva, Azael Mancillas, Cesar Cantu.
 #include <time.h>
 
 #include "BBox.h"
+#include "InstanceNode.h"
 #include "Ray.h"
+#include "Transform.h"
+#include "TShape.h"
+#include "TShapeKit.h"
 
 #include "TestsAuxiliaryFunctions.h"
 
@@ -85,3 +89,22 @@ Ray taf::randomRay( double a, double b )
 {
 	return Ray( randomPoint(a, b), randomDirection() );
 }
+
+/*!
+ * Appends to \a parent the instance of a shape kit with the \a shape and the \a material placed in the world with the
+ * \a objectToWorld transform. The \a parent bounding box is extended to contain the shape.
+ */
+InstanceNode* taf::addShapeInstance( InstanceNode* parent, TShape* shape, TMaterial* material, const Transform& objectToWorld )
+{
+	shape->PrepareForTrace();
+
+	InstanceNode* shapeInstance = new InstanceNode( new TShapeKit );
+	BBox shapeBBox = objectToWorld( shape->GetBBox() );
+	shapeInstance->SetIntersectionTransform( objectToWorld.GetInverse() );
+	shapeInstance->SetIntersectionBBox( shapeBBox );
+	shapeInstance->SetTraceNodes( shape, material );
+
+	parent->AddChild( shapeInstance );
+	parent->SetIntersectionBBox( Union( parent->GetIntersectionBBox(), shapeBBox ) );
+	return shapeInstance;
+}
@@ -43,6 +43,10 @@ class Point3D;
 class Vector3D;
 class Ray;
 class BBox;
+class InstanceNode;
+class TMaterial;
+class TShape;
+class Transform;
 
 namespace taf
 {
@@ -52,6 +56,7 @@ namespace taf
    BBox randomBox( double a, double b );
    Vector3D randomDirection( );
    Ray randomRay( double a, double b );
+   InstanceNode* addShapeInstance( InstanceNode* parent, TShape* shape, TMaterial* material, const Transform& objectToWorld );
 }
 
 #endif /* TESTSAUXILIARYFUNCTIONS_H_ */
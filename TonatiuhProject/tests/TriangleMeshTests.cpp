@@ -0,0 +1,200 @@
+/***************************************************************************
+Copyright (C) 2008 by the Tonatiuh Software Development Team.
+
+This file is part of Tonatiuh.
+
+Tonatiuh program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+Acknowledgments:
+
+The development of Tonatiuh was started on 2004 by Dr. Manuel Blanco,
+at the time Chair of the Department of Engineering of the University of Texas
+at Brownsville. From May 2004 to August 2008 Tonatiuh's development was
+supported by the Department of Energy (DOE) and the National Renewable
+Energy Laboratory (NREL) under the Minority Research Associate (MURA)
+Program Subcontract ACQ-4-33623-06. During 2007, NREL also contributed to
+the validation of Tonatiuh under the framework of the Memorandum of
+Understanding signed with the Spanish National Renewable Energy Centre (CENER)
+on February, 20, 2007 (MOU#NREL-07-117). Since June 2006, the development of
+Tonatiuh is being led by CENER, under the direction of Dr. Blanco, now
+Manager of the Solar Thermal Energy Department of CENER.
+
+Developers: Manuel J. Blanco (mblanco@cener.com), Amaia Mutuberria, Victor Martin.
+
+Contributors: Javier Garcia-Barberena, Inaki Perez, Inigo Pagola,  Gilda Jimenez,
+Juana Amieva, Azael Mancillas, Cesar Cantu.
+***************************************************************************/
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gc.h"
+#include "Point3D.h"
+#include "Ray.h"
+#include "TestsAuxiliaryFunctions.h"
+#include "TriangleMesh.h"
+#include "Vector3D.h"
+
+/*!
+ * Defines in \a vertices and \a indices a height field grid of \a n x \a n cells with two triangles each
+ * and a set of random triangles that cross the grid, so that the hierarchy nodes overlap.
+ */
+static void CreateTestMesh( int n, int nRandomTriangles, std::vector< Point3D >* vertices, std::vector< int >* indices )
+{
+	for( int i = 0; i <= n; ++i )
+	{
+		for( int j = 0; j <= n; ++j )
+		{
+			double x = -1.0 + 2.0 * i / n;
+			double z = -1.0 + 2.0 * j / n;
+			vertices->push_back( Point3D( x, 0.2 * x * x - 0.1 * z + 0.05 * x * z, z ) );
+		}
+	}
+
+	for( int i = 0; i < n; ++i )
+	{
+		for( int j = 0; j < n; ++j )
+		{
+			int v00 = i * ( n + 1 ) + j;
+			int v10 = v00 + n + 1;
+			indices->push_back( v00 );
+			indices->push_back( v10 );
+			indices->push_back( v10 + 1 );
+			indices->push_back( v00 );
+			indices->push_back( v10 + 1 );
+			indices->push_back( v00 + 1 );
+		}
+	}
+
+	for( int t = 0; t < nRandomTriangles; ++t )
+	{
+		for( int k = 0; k < 3; ++k )
+		{
+			indices->push_back( int( vertices->size() ) );
+			vertices->push_back( Point3D( taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -0.5, 0.5 ), taf::randomNumber( -1.0, 1.0 ) ) );
+		}
+	}
+}
+
+TEST( TriangleMeshTests, CreateInvalid )
+{
+	std::vector< Point3D > vertices;
+	vertices.push_back( Point3D( 0.0, 0.0, 0.0 ) );
+	vertices.push_back( Point3D( 1.0, 0.0, 0.0 ) );
+	vertices.push_back( Point3D( 0.0, 0.0, 1.0 ) );
+
+	TriangleMesh mesh;
+	std::vector< int > indices;
+	EXPECT_FALSE( mesh.Create( vertices, indices ) );
+
+	indices.push_back( 0 );
+	indices.push_back( 1 );
+	EXPECT_FALSE( mesh.Create( vertices, indices ) );
+
+	indices.push_back( 3 );
+	EXPECT_FALSE( mesh.Create( vertices, indices ) );
+	EXPECT_EQ( 0, mesh.NumberOfTriangles() );
+
+	indices[2] = 2;
+	EXPECT_TRUE( mesh.Create( vertices, indices ) );
+	EXPECT_EQ( 1, mesh.NumberOfTriangles() );
+	EXPECT_DOUBLE_EQ( 0.5, mesh.GetArea() );
+}
+
+/*!
+ * Checks that the closest intersection found through the hierarchy is the closest intersection of the triangles
+ * tested one by one. Each triangle is tested as a mesh of a single triangle, so both intersections use the same
+ * ray/triangle test.
+ */
+TEST( TriangleMeshTests, IntersectMatchesBruteForce )
+{
+	srand( 23 );
+	std::vector< Point3D > vertices;
+	std::vector< int > indices;
+	CreateTestMesh( 12, 40, &vertices, &indices );
+
+	TriangleMesh mesh;
+	ASSERT_TRUE( mesh.Create( vertices, indices ) );
+	ASSERT_EQ( 12 * 12 * 2 + 40, mesh.NumberOfTriangles() );
+
+	std::vector< TriangleMesh* > triangles( mesh.NumberOfTriangles() );
+	for( int t = 0; t < mesh.NumberOfTriangles(); ++t )
+	{
+		Point3D p0, p1, p2;
+		mesh.GetTriangle( t, &p0, &p1, &p2 );
+		std::vector< Point3D > triangleVertices;
+		triangleVertices.push_back( p0 );
+		triangleVertices.push_back( p1 );
+		triangleVertices.push_back( p2 );
+		std::vector< int > triangleIndices;
+		triangleIndices.push_back( 0 );
+		triangleIndices.push_back( 1 );
+		triangleIndices.push_back( 2 );
+
+		triangles[t] = new TriangleMesh;
+		ASSERT_TRUE( triangles[t]->Create( triangleVertices, triangleIndices ) );
+	}
+
+	int numberOfHits = 0;
+	for( int r = 0; r < 2000; ++r )
+	{
+		Point3D origin( taf::randomNumber( -1.5, 1.5 ), taf::randomNumber( -1.0, 2.0 ), taf::randomNumber( -1.5, 1.5 ) );
+		Vector3D direction = Normalize( Vector3D( taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ), taf::randomNumber( -1.0, 1.0 ) ) );
+		double maxt = ( r % 5 == 0 ) ? taf::randomNumber( 0.1, 1.5 ) : gc::Infinity;
+		Ray ray( origin, direction, gc::Epsilon, maxt );
+
+		int bruteForceTriangle = -1;
+		double bruteForceTHit = maxt;
+		double bruteForceB1 = 0.0;
+		double bruteForceB2 = 0.0;
+		for( int t = 0; t < int( triangles.size() ); ++t )
+		{
+			double tHit, b1, b2;
+			int triangle;
+			if( triangles[t]->Intersect( Ray( origin, direction, gc::Epsilon, bruteForceTHit ), &tHit, &triangle, &b1, &b2 )
+					&& ( tHit < bruteForceTHit || bruteForceTriangle < 0 ) )
+			{
+				bruteForceTriangle = t;
+				bruteForceTHit = tHit;
+				bruteForceB1 = b1;
+				bruteForceB2 = b2;
+			}
+		}
+
+		double tHit = 0.0;
+		double b1 = 0.0;
+		double b2 = 0.0;
+		int triangle = -1;
+		bool isHit = mesh.Intersect( ray, &tHit, &triangle, &b1, &b2 );
+
+		EXPECT_EQ( bruteForceTriangle >= 0, isHit );
+		EXPECT_EQ( isHit, mesh.IntersectP( ray ) );
+		if( isHit && bruteForceTriangle >= 0 )
+		{
+			EXPECT_EQ( bruteForceTriangle, triangle );
+			EXPECT_DOUBLE_EQ( bruteForceTHit, tHit );
+			EXPECT_NEAR( bruteForceB1, b1, 1.0e-12 );
+			EXPECT_NEAR( bruteForceB2, b2, 1.0e-12 );
+			++numberOfHits;
+		}
+	}
+	EXPECT_GT( numberOfHits, 0 );
+
+	for( int t = 0; t < int( triangles.size() ); ++t )
+		delete triangles[t];
+}
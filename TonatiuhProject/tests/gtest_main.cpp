@@ -46,6 +46,11 @@
 #include "TCube.h"
 #include "TLightKit.h"
 #include "TLightShape.h"
+#include "MaterialTabulatedSpecular.h"
+#include "ShapeFlatRectangle.h"
+#include "ShapeFlatTriangle.h"
+#include "ShapeParabolicRectangle.h"
+#include "ShapeTroughCHC.h"
 #include "TSeparatorKit.h"
 #include "TShapeKit.h"
 #include "TSquare.h"
@@ -65,12 +70,17 @@ int main(int argc, char **argv )
 	TSceneKit::initClass();
 	TMaterial::initClass();
 	TDefaultMaterial::initClass();
+	MaterialTabulatedSpecular::initClass();
 	TSeparatorKit::initClass();
 	TShape::initClass();
 	TCube::initClass();
 	TLightShape::initClass();
 	TShapeKit::initClass();
 	TSquare::initClass();
+	ShapeFlatRectangle::initClass();
+	ShapeFlatTriangle::initClass();
+	ShapeParabolicRectangle::initClass();
+	ShapeTroughCHC::initClass();
 	TLightKit::initClass();
 	TSunShape::initClass();
 	TDefaultSunShape::initClass();
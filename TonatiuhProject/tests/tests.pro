@@ -6,12 +6,36 @@ QT += xml opengl svg  script network
 
 DEFINES += TEST_DIR=\\\"PWD/../tests\\\"
 
-SOURCES += *.cpp 
+INCLUDEPATH += $$(TONATIUH_ROOT)/plugins/MaterialTabulatedSpecular/src \
+               $$(TONATIUH_ROOT)/plugins/PhotonMapExportFile/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeFlatRectangle/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeFlatTriangle/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeHeightField/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeParabolicRectangle/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeTriangleMesh/src \
+               $$(TONATIUH_ROOT)/plugins/ShapeTroughCHC/src \
+               $$(TONATIUH_ROOT)/plugins/SunshapeTabulated/src
+
+SOURCES += *.cpp \
+           $$(TONATIUH_ROOT)/plugins/MaterialTabulatedSpecular/src/MaterialTabulatedSpecular.cpp \
+           $$(TONATIUH_ROOT)/plugins/MaterialTabulatedSpecular/src/ReflectanceTable.cpp \
+           $$(TONATIUH_ROOT)/plugins/PhotonMapExportFile/src/PhotonMapExportFile.cpp \
+           $$(TONATIUH_ROOT)/plugins/PhotonMapExportFile/src/PhotonMapRawFile.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeFlatRectangle/src/ShapeFlatRectangle.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeFlatTriangle/src/ShapeFlatTriangle.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeHeightField/src/HeightFieldData.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeParabolicRectangle/src/ShapeParabolicRectangle.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeTriangleMesh/src/ShapeTriangleMesh.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeTriangleMesh/src/TriangleMesh.cpp \
+           $$(TONATIUH_ROOT)/plugins/ShapeTroughCHC/src/ShapeTroughCHC.cpp \
+           $$(TONATIUH_ROOT)/plugins/SunshapeTabulated/src/SunshapeProfile.cpp
            
 CONFIG(debug, debug|release) {
     OBJECTS       +=    $$(TONATIUH_ROOT)/debug/BBox.o \
                         $$(TONATIUH_ROOT)/debug/DifferentialGeometry.o \
                         $$(TONATIUH_ROOT)/debug/Document.o \
+                        $$(TONATIUH_ROOT)/debug/ErrorDistribution.o \
+                        $$(TONATIUH_ROOT)/debug/InstanceBVH.o \
                         $$(TONATIUH_ROOT)/debug/InstanceNode.o \
                         $$(TONATIUH_ROOT)/debug/Matrix4x4.o \
                         $$(TONATIUH_ROOT)/debug/moc_Document.o \
@@ -19,17 +43,24 @@ CONFIG(debug, debug|release) {
                         $$(TONATIUH_ROOT)/debug/moc_SceneModel.o \
                         $$(TONATIUH_ROOT)/debug/moc_ScriptRayTracer.o \
                         $$(TONATIUH_ROOT)/debug/NormalVector.o \
+                        $$(TONATIUH_ROOT)/debug/OrthonormalBasis.o \
                         $$(TONATIUH_ROOT)/debug/ParallelRandomDeviate.o \
                         $$(TONATIUH_ROOT)/debug/PathWrapper.o \
                         $$(TONATIUH_ROOT)/debug/Photon.o \
+                        $$(TONATIUH_ROOT)/debug/PhotonArena.o \
                         $$(TONATIUH_ROOT)/debug/PhotonMapExport.o \
+                        $$(TONATIUH_ROOT)/debug/PhotonMapExportThread.o \
                         $$(TONATIUH_ROOT)/debug/Point3D.o \
                         $$(TONATIUH_ROOT)/debug/PluginManager.o \
+                        $$(TONATIUH_ROOT)/debug/RayBatch.o \
+                        $$(TONATIUH_ROOT)/debug/RayPacket.o \
                         $$(TONATIUH_ROOT)/debug/RayTracer.o \
                         $$(TONATIUH_ROOT)/debug/RayTracerNoTr.o \
                         $$(TONATIUH_ROOT)/debug/RefCount.o \
                         $$(TONATIUH_ROOT)/debug/SceneModel.o \
                         $$(TONATIUH_ROOT)/debug/ScriptRayTracer.o \
+                        $$(TONATIUH_ROOT)/debug/SpectralWeights.o \
+                        $$(TONATIUH_ROOT)/debug/SunDirectionBank.o \
                         $$(TONATIUH_ROOT)/debug/sunpos.o \
                         $$(TONATIUH_ROOT)/debug/TAnalyzerKit.o \
                         $$(TONATIUH_ROOT)/debug/TAnalyzerLevel.o \
@@ -59,12 +90,15 @@ CONFIG(debug, debug|release) {
                         $$(TONATIUH_ROOT)/debug/TTracker.o \
                         $$(TONATIUH_ROOT)/debug/TTrackerForAiming.o \
                         $$(TONATIUH_ROOT)/debug/TTransmissivity.o \
+                        $$(TONATIUH_ROOT)/debug/UniqueNodeTable.o \
                         $$(TONATIUH_ROOT)/debug/Vector3D.o
 }                     
 else { 
     OBJECTS       +=    $$(TONATIUH_ROOT)/release/BBox.o \
                         $$(TONATIUH_ROOT)/release/DifferentialGeometry.o \
                         $$(TONATIUH_ROOT)/release/Document.o \
+                        $$(TONATIUH_ROOT)/release/ErrorDistribution.o \
+                        $$(TONATIUH_ROOT)/release/InstanceBVH.o \
                         $$(TONATIUH_ROOT)/release/InstanceNode.o \
                         $$(TONATIUH_ROOT)/release/Matrix4x4.o \
                         $$(TONATIUH_ROOT)/release/moc_Document.o \
@@ -72,17 +106,24 @@ else {
                         $$(TONATIUH_ROOT)/release/moc_SceneModel.o \
                         $$(TONATIUH_ROOT)/release/moc_ScriptRayTracer.o \
                         $$(TONATIUH_ROOT)/release/NormalVector.o \
+                        $$(TONATIUH_ROOT)/release/OrthonormalBasis.o \
                         $$(TONATIUH_ROOT)/release/ParallelRandomDeviate.o \
                         $$(TONATIUH_ROOT)/release/PathWrapper.o \
                         $$(TONATIUH_ROOT)/release/Photon.o \
+                        $$(TONATIUH_ROOT)/release/PhotonArena.o \
                         $$(TONATIUH_ROOT)/release/PhotonMapExport.o \
+                        $$(TONATIUH_ROOT)/release/PhotonMapExportThread.o \
                         $$(TONATIUH_ROOT)/release/Point3D.o \
                         $$(TONATIUH_ROOT)/release/PluginManager.o \
+                        $$(TONATIUH_ROOT)/release/RayBatch.o \
+                        $$(TONATIUH_ROOT)/release/RayPacket.o \
                         $$(TONATIUH_ROOT)/release/RayTracer.o \
                         $$(TONATIUH_ROOT)/release/RayTracerNoTr.o \
                         $$(TONATIUH_ROOT)/release/RefCount.o \
                         $$(TONATIUH_ROOT)/release/SceneModel.o \
                         $$(TONATIUH_ROOT)/release/ScriptRayTracer.o \
+                        $$(TONATIUH_ROOT)/release/SpectralWeights.o \
+                        $$(TONATIUH_ROOT)/release/SunDirectionBank.o \
                         $$(TONATIUH_ROOT)/release/sunpos.o \
                         $$(TONATIUH_ROOT)/release/TAnalyzerKit.o \
                         $$(TONATIUH_ROOT)/release/TAnalyzerLevel.o \
@@ -112,6 +153,7 @@ else {
                         $$(TONATIUH_ROOT)/release/TTracker.o \
                         $$(TONATIUH_ROOT)/release/TTrackerForAiming.o \
                         $$(TONATIUH_ROOT)/release/TTransmissivity.o \
+                        $$(TONATIUH_ROOT)/release/UniqueNodeTable.o \
                         $$(TONATIUH_ROOT)/release/Vector3D.o
 }
 